@@ -44,6 +44,16 @@ void ComponentBuilder::build(eProcessModes mode, OovStringRef const incDepsFileP
         }
     if(mode == PM_CovInstr)
         {
+        SharedFile covHeaderFile;
+        if(covHeaderFile.open(CoverageHeaderReader::getFn(mOutputPath),
+            M_ReadShared, OE_Binary) == OS_Opened)
+            {
+            status = mCovHeader.read(covHeaderFile);
+            if(status.needReport())
+                {
+                status.reported();      // All files are instrumented.
+                }
+            }
         sVerboseDump.logProgress("Instrument source");
         processSourceForComponents(PM_CovInstr);
         }
@@ -232,6 +242,10 @@ void ComponentBuilder::processSourceForComponents(eProcessModes pm)
     if(compNames.size() > 0)
         {
         setupQueue(getNumHardwareThreads());
+        if(pm == PM_CovInstr)
+            {
+            mCovInstrBatches.assign(getNumHardwareThreads(), OovString());
+            }
         for(const auto &name : compNames)
             {
             OovStringSet compileArgs = getComponentPackageCompileArgs(name);
@@ -276,6 +290,10 @@ void ComponentBuilder::processSourceForComponents(eProcessModes pm)
                 processJavaSourceFiles(pm, name, javaSources /*, compileArgs*/);
                 }
             }
+        if(pm == PM_CovInstr)
+            {
+            processCovInstrBatches();
+            }
         waitForCompletion();
         }
     }
@@ -489,6 +507,7 @@ bool ComponentTaskQueue::runProcess(OovStringRef const procPath,
             fprintf(stderr, "OovBuilder: Unable to execute process %s\n", procPath.getStr());
         if(!success || exitCode != 0)
             {
+            success = false;
             fprintf(stderr, "oovBuilder: Unable to build %s\n", outFile.getStr());
             if(workingDir)
                 { fprintf(stderr, "  Working dir: %s\n", workingDir.getStr()); }
@@ -517,11 +536,167 @@ bool ComponentTaskQueue::processItem(ProcessArgs const &item)
         }
     bool success = runProcess(item.mProcess, item.mOutputFile,
         item.mChildArgs, mListenerStdMutex, stdOutFn, workingDir);
+    if(!success && item.mCovInstrBatch.length() > 0)
+        {
+        success = retryCovInstrBatch(item);
+        }
     if(mListener)
         mListener->extraProcessing(success, item.mOutputFile, stdOutFn, item);
     return success;
     }
 
+bool ComponentTaskQueue::retryCovInstrBatch(ProcessArgs const &item)
+    {
+    bool success = true;
+    fprintf(stderr, "oovBuilder: Retrying each file in %s\n", item.mOutputFile.getStr());
+    // The arguments before "-batch batchFn" are used for each file.
+    char const * const *batchArgv = item.mChildArgs.getArgv();
+    size_t numOptionArgs = item.mChildArgs.getArgc() - 2;
+    for(auto const &line : item.mCovInstrBatch.split('\n'))
+        {
+        OovStringVec args = line.split('\t');
+        auto outIter = std::find(args.begin(), args.end(), "-o");
+        if(outIter != args.end() && outIter+1 != args.end())
+            {
+            OovString const &outFn = *(outIter+1);
+            OovStatus status(true, SC_File);
+            if(FileStat::isOutputOld(outFn, item.mOutputFile, status))
+                {
+                OovProcessChildArgs ca;
+                for(size_t i=0; i<numOptionArgs; i++)
+                    {
+                    ca.addArg(batchArgv[i]);
+                    }
+                for(auto const &arg : args)
+                    {
+                    ca.addArg(arg);
+                    }
+                if(!runProcess(item.mProcess, outFn, ca, mListenerStdMutex))
+                    {
+                    success = false;
+                    }
+                }
+            if(status.needReport())
+                {
+                status.reported();      // The file was instrumented again.
+                }
+            }
+        }
+    return success;
+    }
+
+bool ComponentBuilder::getCovInstrHash(OovStringRef const srcFile,
+        OovStringVec const &incFiles, uint64_t &hash)
+    {
+    OovStatus status(true, SC_File);
+    bool hitOnce = mComponentFinder.getProjectBuildArgs().getCovHitOnce();
+    hash = CoverageHeaderReader::hashBuf(&hitOnce, sizeof(hitOnce));
+    // The include files are from a set, so they are always in the same order.
+    for(size_t i=0; i<=incFiles.size() && status.ok(); i++)
+        {
+        OovString fn = (i == 0) ? OovString(srcFile) : incFiles[i-1];
+        auto iter = mCovFileHashes.find(fn);
+        if(iter == mCovFileHashes.end())
+            {
+            uint64_t fileHash = 0;
+            status = CoverageHeaderReader::getFileHash(fn, fileHash);
+            if(status.ok())
+                {
+                iter = mCovFileHashes.insert(std::make_pair(fn, fileHash)).first;
+                }
+            }
+        if(status.ok())
+            {
+            hash = CoverageHeaderReader::hashBuf(&(*iter).second,
+                sizeof((*iter).second), hash);
+            }
+        }
+    if(status.needReport())
+        {
+        status.reported();      // The file will be instrumented.
+        }
+    return status.ok();
+    }
+
+bool ComponentBuilder::isCovInstrUnchanged(OovStringRef const srcFile,
+        OovStringRef const outFileName, uint64_t hash)
+    {
+    OovStatus status(true, SC_File);
+    bool unchanged = FileIsFileOnDisk(outFileName, status);
+    if(unchanged)
+        {
+        unchanged = mCovHeader.isFileUnchanged(
+            CoverageHeaderReader::makeFileDefine(srcFile, mSrcRootDir), hash);
+        }
+    if(status.needReport())
+        {
+        status.reported();      // The file will be instrumented.
+        }
+    return unchanged;
+    }
+
+void ComponentBuilder::addCovInstrBatchArgs(OovProcessChildArgs const &ca)
+    {
+    OovString &batch = mCovInstrBatches[mCovInstrBatchIndex++ %
+        mCovInstrBatches.size()];
+    char const * const *argv = ca.getArgv();
+    // The first argument is the process path.
+    for(size_t i=1; i<ca.getArgc(); i++)
+        {
+        if(i > 1)
+            {
+            batch += '\t';
+            }
+        batch += argv[i];
+        }
+    batch += '\n';
+    }
+
+void ComponentBuilder::processCovInstrBatches()
+    {
+    OovString procPath = mComponentFinder.getProjectBuildArgs().getCovInstrToolPath();
+    OovStatus status = mOutputPath.ensurePathExists();
+    for(size_t i=0; i<mCovInstrBatches.size() && status.ok(); i++)
+        {
+        if(mCovInstrBatches[i].length() > 0)
+            {
+            FilePath batchFn(mOutputPath, FP_Dir);
+            OovString name = "oovCovInstrBatch";
+            name.appendInt(static_cast<int>(i));
+            name += ".txt";
+            batchFn.appendFile(name);
+            File batchFile;
+            status = batchFile.open(batchFn, "wb");
+            if(status.ok())
+                {
+                status = batchFile.putString(mCovInstrBatches[i]);
+                batchFile.close();
+                }
+            if(status.ok())
+                {
+                CppChildArgs ca;
+                ca.addArg(procPath);
+                if(mComponentFinder.getProjectBuildArgs().getCovHitOnce())
+                    {
+                    ca.addArg("-hitonce");
+                    }
+                ca.addArg("-batch");
+                ca.addArg(batchFn);
+                ProcessArgs args(procPath, batchFn, ca);
+                args.mCovInstrBatch = mCovInstrBatches[i];
+                addTask(args);
+                }
+            }
+        }
+    if(status.needReport())
+        {
+        OovString err = "Unable to write coverage batch file in ";
+        err += mOutputPath;
+        status.report(ET_Error, err);
+        }
+    mCovInstrBatches.clear();
+    }
+
 OovString ComponentBuilder::makeOutputObjectFileName(OovStringRef const srcFile)
     {
     OovString outFileName = Project::makeTreeOutBaseFileName(srcFile,
@@ -553,8 +728,20 @@ void ComponentBuilder::processCppSourceFile(eProcessModes pm, OovStringRef const
             outFileName = makeOutputObjectFileName(srcFile);
             }
         OovStatus status(true, SC_File);
-        if(FileStat::isOutputOld(outFileName, srcFile, status) ||
-                FileStat::isOutputOld(outFileName, incFiles, status, &incFileOlderIndex))
+        bool old = FileStat::isOutputOld(outFileName, srcFile, status) ||
+                FileStat::isOutputOld(outFileName, incFiles, status, &incFileOlderIndex);
+        // A file that is only newer would be instrumented the same way.
+        uint64_t covHash = 0;
+        bool haveCovHash = false;
+        if(old && pm == PM_CovInstr)
+            {
+            haveCovHash = getCovInstrHash(srcFile, incFiles, covHash);
+            if(haveCovHash && isCovInstrUnchanged(srcFile, outFileName, covHash))
+                {
+                old = false;
+                }
+            }
+        if(old)
             {
             OovString ownerComp = getComponentTypesFile().getComponentNameOwner(srcFile);
             mComponentFinder.setCompConfig(ownerComp);
@@ -570,6 +757,14 @@ void ComponentBuilder::processCppSourceFile(eProcessModes pm, OovStringRef const
                 procPath = mComponentFinder.getProjectBuildArgs().getCompilerPath();
                 }
             ca.addArg(procPath);
+            if(haveCovHash)
+                {
+                // oovCovInstr saves the hash in the coverage header.
+                char hashArg[30];
+                snprintf(hashArg, sizeof(hashArg), "-hash=%016llx",
+                    static_cast<unsigned long long>(covHash));
+                ca.addArg(hashArg);
+                }
             ca.addArg(srcFile);
             if(pm == PM_CovInstr)
                 {
@@ -585,7 +780,14 @@ void ComponentBuilder::processCppSourceFile(eProcessModes pm, OovStringRef const
             ca.addArg(outFileName);
 
             sVerboseDump.logProcess(srcFile, ca.getArgv(), static_cast<int>(ca.getArgc()));
-            addTask(ProcessArgs(procPath, outFileName, ca));
+            if(pm == PM_CovInstr)
+                {
+                addCovInstrBatchArgs(ca);
+                }
+            else
+                {
+                addTask(ProcessArgs(procPath, outFileName, ca));
+                }
             if(incFileOlderIndex != BadIndex)
                 sVerboseDump.logOutputOld(incFiles[static_cast<size_t>(incFileOlderIndex)]);
             }
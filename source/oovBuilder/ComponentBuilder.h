@@ -12,6 +12,7 @@
 #include "ObjSymbols.h"
 #include "OovThreadedWaitQueue.h"
 #include "IncludeMap.h"
+#include "CoverageHeaderReader.h"
 
 
 class ComponentPkgDeps
@@ -41,6 +42,7 @@ class ProcessArgs
         OovProcessChildArgs mChildArgs;
         OovString mStdOutFn;  // zero length will not use the name
         OovString mLibFilePath; // Only used for lib symbol processing.
+        OovString mCovInstrBatch; // Only used for coverage instrumentation.
     };
 
 class TaskQueueListener
@@ -72,6 +74,11 @@ class ComponentTaskQueue:public ThreadedWorkWaitQueue<ProcessArgs, ComponentTask
         InProcMutex mListenerStdMutex;
     private:
         TaskQueueListener *mListener;
+
+        /// Runs a process for each file in a coverage batch that was not
+        /// instrumented after the batch file was written.  This is used when
+        /// the batch fails, since a crash stops the rest of the batch.
+        bool retryCovInstrBatch(ProcessArgs const &item);
     };
 
 // Builds components. This recursively compiles source files
@@ -80,7 +87,7 @@ class ComponentBuilder:public ComponentTaskQueue
     {
     public:
         ComponentBuilder(ComponentFinder &compFinder):
-            mComponentFinder(compFinder)
+            mComponentFinder(compFinder), mCovInstrBatchIndex(0)
             {}
         void build(eProcessModes mode,
             OovStringRef const incDepsFilePath, OovStringRef const buildDirClass);
@@ -94,6 +101,15 @@ class ComponentBuilder:public ComponentTaskQueue
         IncDirDependencyMapReader mIncDirMap;
         /// A map of all packages required to build each component.
         ComponentPkgDeps mComponentPkgDeps;
+        /// The coverage header from the previous instrumentation.
+        CoverageHeaderReader mCovHeader;
+        /// The hashes of the source and include files that have been read
+        /// to check whether the source files must be instrumented.
+        std::map<OovString, uint64_t> mCovFileHashes;
+        /// The oovCovInstr arguments for each thread.  Each line contains the
+        /// tab separated arguments for one source file.
+        OovStringVec mCovInstrBatches;
+        size_t mCovInstrBatchIndex;
 
         const ComponentTypesFile &getComponentTypesFile() const
             { return mComponentFinder.getComponentTypesFile(); }
@@ -104,6 +120,21 @@ class ComponentBuilder:public ComponentTaskQueue
         /// the include paths to see if any came from any of the packages. The
         /// map that is saved is mComponentPkgDeps.
         void generateDependencies();
+        /// Gets the hash that identifies how a source file is instrumented.
+        /// This includes the contents of the source file and the files that
+        /// it includes, and the instrumentation options.
+        /// @return false if a file could not be read.
+        bool getCovInstrHash(OovStringRef const srcFile,
+            OovStringVec const &incFiles, uint64_t &hash);
+        /// Returns true if the hash is the same as when the coverage output
+        /// file was made.
+        /// @param hash The hash from getCovInstrHash.
+        bool isCovInstrUnchanged(OovStringRef const srcFile,
+            OovStringRef const outFileName, uint64_t hash);
+        /// Adds the arguments for one source file to one of the batches.
+        void addCovInstrBatchArgs(OovProcessChildArgs const &ca);
+        /// Writes the batch files and adds a task for each batch.
+        void processCovInstrBatches();
         void processCppSourceFile(eProcessModes pm, OovStringRef const srcFile,
             const OovStringVec &incDirs, const OovStringVec &incFiles,
             const OovStringSet &externPkgCompileArgs);
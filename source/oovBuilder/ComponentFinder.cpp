@@ -6,6 +6,7 @@
  */
 #include "ComponentFinder.h"
 #include "Project.h"
+#include "SymbolIndex.h"
 #include "Debug.h"
 #include "OovError.h"
 #include <set>
@@ -50,6 +51,10 @@ void ScannedComponent::saveComponentFileInfo(
                 OovString analysisFile = Project::makeAnalysisFileName(origFileName,
                         Project::getSrcRootDirectory(), analysisPath);
                 deleteFiles.insert(analysisFile);
+                OovString symbolFile = Project::makeOutBaseFileName(origFileName,
+                        Project::getSrcRootDirectory(), analysisPath);
+                symbolFile += SymbolIndex::getFileExtension();
+                deleteFiles.insert(symbolFile);
                 }
             }
         }
@@ -9,7 +9,12 @@
 #include "CoverageHeaderReader.h"
 #include "Components.h"
 #include "Project.h"
+#include "OovThreadedWaitQueue.h"
+#include "OperationProfile.h"
 #include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <algorithm>
 
 static bool makeCoverageProjectFile(OovStringRef const srcFn, OovStringRef const dstFn,
         OovStringRef const covSrcDir)
@@ -26,6 +31,22 @@ static bool makeCoverageProjectFile(OovStringRef const srcFn, OovStringRef const
         file.setNameValue(ComponentTypesFile::buildCompTypeVarFilterName(covLibName),
                 ComponentTypesFile::getShortComponentTypeName(CT_StaticLib));
 
+        // The profile probes are compiled with the build arguments so
+        // that the original project is not changed.
+        if(file.getValueBool(OptCovProfile))
+            {
+            BuildVariable buildVar;
+            buildVar.setVarName(OptCppArgs);
+            buildVar.setFunction(BuildVariable::F_Append);
+            buildVar.addFilter(OptFilterNameBuildMode, OptFilterValueBuildModeBuild);
+            CompoundValue args(file.getValue(buildVar.getVarFilterName()));
+            if(std::find(args.begin(), args.end(), "-DCOV_PROFILE") == args.end())
+                {
+                args.addArg("-DCOV_PROFILE");
+                }
+            file.setNameValue(buildVar.getVarFilterName(), args.getAsString());
+            }
+
         status = file.writeFile();
         }
     if(status.needReport())
@@ -107,49 +128,85 @@ bool makeCoverageBuildProject(ProjectReader &project)
     return status.ok() && success;
     }
 
+typedef uint64_t CoverageCount;
+
+/// This is the header of the binary counts and profile files that are
+/// written by the OovCoverage.cpp file that is generated by oovCovInstr.
+/// The header is followed by a record for each instrumented line.  The
+/// counts file has a 64 bit count, and the profile file has a ProfileRecord.
+struct CoverageCountsFileHeader
+    {
+    char mMagic[8];
+    uint64_t mSignature;
+    uint64_t mNumInstrs;
+    };
+
+/// This is a record of the profile file, which is only written when the
+/// coverage project is compiled with COV_PROFILE.
+struct ProfileRecord
+    {
+    uint64_t mCalls;
+    uint64_t mTicks;
+    };
+
+/// Reads a file that has a CoverageCountsFileHeader followed by records.
+/// @param magic The magic string that identifies the type of file.
+/// @param signature This is set to the signature of the file.
+/// @param records This is set to the records of the file, or is empty if
+///     the file is not found or is not valid.
+template<typename Record> static OovStatusReturn readRecordFile(
+        OovStringRef const fn, char const *magic, uint64_t &signature,
+        std::vector<Record> &records)
+    {
+    MappedFile file;
+    OovStatus status = file.open(fn);
+    records.clear();
+    signature = 0;
+    if(status.ok())
+        {
+        CoverageCountsFileHeader header;
+        if(file.getSize() >= sizeof(header))
+            {
+            memcpy(&header, file.getData(), sizeof(header));
+            size_t maxInstrs = (file.getSize() - sizeof(header)) / sizeof(Record);
+            if(memcmp(header.mMagic, magic, sizeof(header.mMagic)) == 0 &&
+                header.mNumInstrs <= maxInstrs)
+                {
+                signature = header.mSignature;
+                records.resize(header.mNumInstrs);
+                memcpy(records.data(), file.getData() + sizeof(header),
+                    header.mNumInstrs * sizeof(Record));
+                }
+            }
+        }
+    return status;
+    }
+
 class CoverageCountsReader
     {
     public:
     CoverageCountsReader():
-            mNumInstrumentedLines(0)
+            mNumInstrumentedLines(0), mSignature(0)
             {}
         void read(OovStringRef const fn);
         int getNumInstrumentedLines() const
             { return mNumInstrumentedLines; }
-        std::vector<int> const &getCounts() const
+        /// This must match the signature of the coverage header.
+        uint64_t getSignature() const
+            { return mSignature; }
+        std::vector<CoverageCount> const &getCounts() const
             { return mInstrCounts; }
 
     private:
         int mNumInstrumentedLines;
-        std::vector<int> mInstrCounts;
+        uint64_t mSignature;
+        std::vector<CoverageCount> mInstrCounts;
     };
 
 void CoverageCountsReader::read(OovStringRef const fn)
     {
-    File file;
-    OovStatus status = file.open(fn, "r");
-    mInstrCounts.clear();
-    if(status.ok())
-        {
-        char buf[100];
-        int lineCounter = 0;
-        while(file.getString(buf, sizeof(buf), status))
-            {
-            lineCounter++;
-            int val;
-            if(sscanf(buf, "%d", &val) == 1)
-                {
-                if(lineCounter == 1)
-                    {
-                    mNumInstrumentedLines = val;
-                    }
-                else
-                    {
-                    mInstrCounts.push_back(val);
-                    }
-                }
-            }
-        }
+    OovStatus status = readRecordFile(fn, "OovCov1", mSignature, mInstrCounts);
+    mNumInstrumentedLines = static_cast<int>(mInstrCounts.size());
     if(status.needReport())
         {
         status.report(ET_Error, "Unable to read coverage counts");
@@ -173,28 +230,356 @@ static std::string makeOrigCovFn(OovStringRef const fn)
     return covFn;
     }
 
+/// Finds a COV_IN(fileDefine, instrIndex), COV_FN(fileDefine, instrIndex, name),
+/// COV_BR(fileDefine, instrIndex, decision) or
+/// COV_BO(fileDefine, instrIndex, decision) probe in a line.
+/// @param decision This is set to -1 for a COV_IN or COV_FN probe.
+/// @param insertedOutcome This is set to true for a COV_BO probe.
+static bool parseProbe(char const *line, int &instrIndex, int &decision,
+        bool &insertedOutcome)
+    {
+    bool found = false;
+    char const *probe = strstr(line, "COV_IN(");
+    bool branch = false;
+    if(!probe)
+        {
+        probe = strstr(line, "COV_FN(");
+        }
+    if(!probe)
+        {
+        probe = strstr(line, "COV_BR(");
+        branch = (probe != nullptr);
+        }
+    insertedOutcome = false;
+    if(!probe)
+        {
+        probe = strstr(line, "COV_BO(");
+        branch = (probe != nullptr);
+        insertedOutcome = branch;
+        }
+    if(probe)
+        {
+        char const *arg = strchr(probe, ',');
+        if(arg)
+            {
+            char *end;
+            instrIndex = static_cast<int>(strtol(arg+1, &end, 10));
+            decision = -1;
+            found = (end != arg+1);
+            if(found && branch)
+                {
+                arg = strchr(end, ',');
+                found = (arg != nullptr);
+                if(found)
+                    {
+                    decision = static_cast<int>(strtol(arg+1, nullptr, 10));
+                    }
+                }
+            }
+        }
+    return found;
+    }
+/// The outcomes of an if, else if and else chain, or of a switch statement.
+struct DecisionStats
+    {
+    DecisionStats():
+        mLine(0), mOutcomes(0), mHitOutcomes(0)
+        {}
+    /// The line of the first outcome in the original source file.
+    int mLine;
+    int mOutcomes;
+    int mHitOutcomes;
+    };
+
+/// The location of each probe in one instrumented source file.
+class CoverageFileData
+    {
+    public:
+        CoverageFileData(OovStringRef const relSrcFn,
+                CoverageHeaderReader::FileDefine const &fileDef):
+            mRelSrcFn(relSrcFn), mFileDefine(fileDef),
+            mHaveLineMap(false),
+            mProbeLines(static_cast<size_t>(fileDef.mCount)),
+            mProbeOrigLines(static_cast<size_t>(fileDef.mCount)),
+            mProbeDecisions(static_cast<size_t>(fileDef.mCount), -1),
+            mProbeInserted(static_cast<size_t>(fileDef.mCount), false),
+            mProbeNames(static_cast<size_t>(fileDef.mCount))
+            {}
+        /// Reads the instrumented source file to find the line of each probe,
+        /// and then reads the line map to find the original line of each probe.
+        void readProbes();
+        /// Returns the path of the instrumented source file.
+        FilePath getSrcFn() const;
+        /// Returns the path of the original source file.  If the file was
+        /// instrumented without a line map, the original lines are not known,
+        /// so this returns the path of the instrumented source file.
+        FilePath getOrigSrcFn() const;
+        /// Returns the count for a probe.  Probes for files that were added
+        /// after the program was run have no counts.
+        CoverageCount getCount(std::vector<CoverageCount> const &counts,
+                int instrIndex) const;
+        /// Returns the probe indices ordered by line number.  Probes that
+        /// were not found are not returned.
+        std::vector<int> getProbesByLine() const;
+
+        OovString mRelSrcFn;
+        CoverageHeaderReader::FileDefine mFileDefine;
+        /// True if the original line of each probe was read from the line map.
+        bool mHaveLineMap;
+        /// The line number of each probe, or zero if the probe was not found.
+        std::vector<int> mProbeLines;
+        /// The line number of each probe in the file from getOrigSrcFn.
+        std::vector<int> mProbeOrigLines;
+        /// The decision index of each probe, or -1 if it is not a branch.
+        std::vector<int> mProbeDecisions;
+        /// True for the probe of an inserted else or default.  These are
+        /// decision outcomes that are not on a line of the source file.
+        std::vector<bool> mProbeInserted;
+        /// The function name of each COV_FN probe, or empty for other probes.
+        std::vector<OovString> mProbeNames;
+
+    private:
+        void readLineMap();
+    };
+
+FilePath CoverageFileData::getSrcFn() const
+    {
+    FilePath srcFn(Project::getCoverageSourceDirectory(), FP_Dir);
+    srcFn.appendFile(mRelSrcFn);
+    return srcFn;
+    }
+
+FilePath CoverageFileData::getOrigSrcFn() const
+    {
+    FilePath srcFn;
+    if(mHaveLineMap)
+        {
+        srcFn.setPath(Project::getSrcRootDirectory(), FP_Dir);
+        srcFn.appendFile(mRelSrcFn);
+        }
+    else
+        {
+        srcFn = getSrcFn();
+        }
+    return srcFn;
+    }
+
+void CoverageFileData::readProbes()
+    {
+    MappedFile file;
+    OovStatus status = file.open(getSrcFn());
+    if(status.ok() && file.getData())
+        {
+        static char const probePrefix[] = "COV_";
+        char const *data = file.getData();
+        char const *end = data + file.getSize();
+        char const *lineCountPos = data;
+        int lineNum = 1;
+        for(char const *pos = data; pos != end; )
+            {
+            pos = std::search(pos, end, probePrefix,
+                probePrefix + sizeof(probePrefix) - 1);
+            if(pos != end)
+                {
+                lineNum += static_cast<int>(std::count(lineCountPos, pos, '\n'));
+                lineCountPos = pos;
+                // The probe is copied so that it is null terminated.
+                char probe[250];
+                char const *probeEnd = pos;
+                // The function name of a COV_FN probe is quoted, and can
+                // contain parenthesis.
+                char const *nameStart = end;
+                char const *nameEnd = end;
+                if(end - pos > 7 && strncmp(pos, "COV_FN(", 7) == 0)
+                    {
+                    nameStart = std::find(pos, end, '"');
+                    if(nameStart != end)
+                        {
+                        nameStart++;
+                        nameEnd = std::find(nameStart, end, '"');
+                        probeEnd = nameEnd;
+                        }
+                    }
+                probeEnd = std::find(probeEnd, end, ')');
+                size_t len = static_cast<size_t>(probeEnd - pos);
+                int instrIndex;
+                int decision;
+                if(probeEnd != end && len < sizeof(probe))
+                    {
+                    memcpy(probe, pos, len);
+                    probe[len] = '\0';
+                    if(strncmp(probe, "COV_IN(", 7) == 0 ||
+                        strncmp(probe, "COV_FN(", 7) == 0 ||
+                        strncmp(probe, "COV_BR(", 7) == 0 ||
+                        strncmp(probe, "COV_BO(", 7) == 0)
+                        {
+                        bool insertedOutcome;
+                        if(parseProbe(probe, instrIndex, decision, insertedOutcome) &&
+                            instrIndex >= 0 && instrIndex < mFileDefine.mCount)
+                            {
+                            size_t probeIndex = static_cast<size_t>(instrIndex);
+                            mProbeLines[probeIndex] = lineNum;
+                            mProbeDecisions[probeIndex] = decision;
+                            mProbeInserted[probeIndex] = insertedOutcome;
+                            if(nameEnd != end)
+                                {
+                                mProbeNames[probeIndex].assign(nameStart, nameEnd);
+                                }
+                            }
+                        pos = probeEnd;
+                        }
+                    }
+                if(pos != probeEnd)
+                    {
+                    pos += sizeof(probePrefix) - 1;
+                    }
+                }
+            }
+        }
+    if(status.needReport())
+        {
+        OovString err = "Unable to read coverage source ";
+        err += getSrcFn();
+        status.report(ET_Error, err);
+        }
+    readLineMap();
+    }
+
+void CoverageFileData::readLineMap()
+    {
+    File file;
+    OovStatus status = file.open(CoverageHeaderReader::getLineMapFn(getSrcFn()), "r");
+    std::vector<int> origLines;
+    if(status.ok())
+        {
+        OovString line;
+        while(file.getLine(line, status))
+            {
+            int origLine = 0;
+            line.getInt(0, INT_MAX, origLine);
+            origLines.push_back(origLine);
+            }
+        }
+    else
+        {
+        // Files that were instrumented by older versions do not have a map.
+        status.clearError();
+        }
+    mHaveLineMap = (origLines.size() > 0);
+    for(size_t i=0; i<mProbeLines.size(); i++)
+        {
+        size_t lineIndex = static_cast<size_t>(mProbeLines[i]) - 1;
+        if(!mHaveLineMap)
+            {
+            mProbeOrigLines[i] = mProbeLines[i];
+            }
+        else if(mProbeLines[i] != 0 && lineIndex < origLines.size())
+            {
+            mProbeOrigLines[i] = origLines[lineIndex];
+            }
+        }
+    if(status.needReport())
+        {
+        OovString err = "Unable to read coverage line map for ";
+        err += getSrcFn();
+        status.report(ET_Error, err);
+        }
+    }
+
+CoverageCount CoverageFileData::getCount(std::vector<CoverageCount> const &counts,
+        int instrIndex) const
+    {
+    size_t countIndex = static_cast<size_t>(mFileDefine.mBase + instrIndex);
+    return(countIndex < counts.size() ? counts[countIndex] : 0);
+    }
+
+std::vector<int> CoverageFileData::getProbesByLine() const
+    {
+    std::vector<int> probes;
+    for(size_t i=0; i<mProbeLines.size(); i++)
+        {
+        if(mProbeLines[i] != 0)
+            {
+            probes.push_back(static_cast<int>(i));
+            }
+        }
+    std::stable_sort(probes.begin(), probes.end(),
+        [this](int probe1, int probe2)
+        { return mProbeLines[static_cast<size_t>(probe1)] <
+            mProbeLines[static_cast<size_t>(probe2)]; });
+    return probes;
+    }
+
+/// This reads the instrumented source files with a thread for each processor.
+class CoverageFileQueue:public ThreadedWorkWaitQueue<CoverageFileData*,
+    CoverageFileQueue>
+    {
+    public:
+        // Called by ThreadedWorkQueue
+        bool processItem(CoverageFileData *fileData)
+            {
+            fileData->readProbes();
+            return true;
+            }
+    };
+
+/// Get the decision statistics for a single file.
+static std::map<int, DecisionStats> getDecisionStats(
+        CoverageFileData const &fileData, std::vector<CoverageCount> const &counts)
+    {
+    std::map<int, DecisionStats> decisions;
+    for(int probe : fileData.getProbesByLine())
+        {
+        int decisionIndex = fileData.mProbeDecisions[static_cast<size_t>(probe)];
+        if(decisionIndex != -1)
+            {
+            DecisionStats &decision = decisions[decisionIndex];
+            if(decision.mOutcomes == 0)
+                {
+                decision.mLine = fileData.mProbeOrigLines[static_cast<size_t>(probe)];
+                }
+            decision.mOutcomes++;
+            if(fileData.getCount(counts, probe))
+                {
+                decision.mHitOutcomes++;
+                }
+            }
+        }
+    return decisions;
+    }
+
 /// Make a stats file that contains the percentage of instrumented
-/// lines that have been executed for each source file.
-static void makeCoverageStats(CoverageHeaderReader const &covHeader,
+/// lines that have been executed for each source file, and the decision
+/// file that contains a line for each decision with the source file name,
+/// the line number in the original source file, the outcomes that ran and
+/// the percentage.
+static void makeCoverageStats(std::vector<CoverageFileData> const &files,
         CoverageCountsReader const &covCounts)
     {
     FilePath statFn(Project::getCoverageProjectDirectory(), FP_Dir);
     statFn.appendFile("oovCovStats.txt");
+    FilePath decisionFn(Project::getCoverageProjectDirectory(), FP_Dir);
+    decisionFn.appendFile("oovCovDecisions.txt");
     File statFile;
+    File decisionFile;
     OovStatus status = statFile.open(statFn, "w");
     if(status.ok())
         {
-        size_t countIndex = 0;
-        std::vector<int> const &counts = covCounts.getCounts();
-        for(auto const &mapItem : covHeader.getMap())
+        status = decisionFile.open(decisionFn, "w");
+        }
+    if(status.ok())
+        {
+        std::vector<CoverageCount> const &counts = covCounts.getCounts();
+        for(auto const &fileData : files)
             {
-            int count = mapItem.second;
+            int count = 0;
             int hits = 0;
-            for(int i=0; i<count; i++)
+            for(int i=0; i<fileData.mFileDefine.mCount; i++)
                 {
-                if(countIndex < counts.size())
+                if(!fileData.mProbeInserted[static_cast<size_t>(i)])
                     {
-                    if(counts[countIndex++])
+                    count++;
+                    if(fileData.getCount(counts, i))
                         {
                         hits++;
                         }
@@ -209,27 +594,118 @@ static void makeCoverageStats(CoverageHeaderReader const &covHeader,
                 {
                 percent = 100;
                 }
-            OovString covFn = makeOrigCovFn(mapItem.first);
-            fprintf(statFile.getFp(), "%s %d\n", covFn.getStr(), percent);
+            fprintf(statFile.getFp(), "%s %d\n", fileData.mRelSrcFn.getStr(), percent);
+
+            for(auto const &decision : getDecisionStats(fileData, counts))
+                {
+                DecisionStats const &stats = decision.second;
+                fprintf(decisionFile.getFp(), "%s %d %d/%d %d\n",
+                    fileData.mRelSrcFn.getStr(), stats.mLine, stats.mHitOutcomes,
+                    stats.mOutcomes, (stats.mHitOutcomes * 100) / stats.mOutcomes);
+                }
             }
         }
     if(status.needReport())
         {
         OovString err = "Unable to open file ";
         err += statFn;
+        err += " or ";
+        err += decisionFn;
         status.report(ET_Error, err);
         }
     }
 
-/// Copy a single source file and make a comment that contains the hit count
-/// for each instrumented line.
-static void updateCovSourceCounts(OovStringRef const relSrcFn,
-        std::vector<int> &counts)
+/// Make an lcov trace file that contains the count for each probe line
+/// of the original source files.  Each decision outcome is a branch.
+static void makeCoverageTraceFile(std::vector<CoverageFileData> const &files,
+        CoverageCountsReader const &covCounts)
     {
-    FilePath srcFn(Project::getCoverageSourceDirectory(), FP_Dir);
-    srcFn.appendFile(relSrcFn);
+    FilePath traceFn(Project::getCoverageProjectDirectory(), FP_Dir);
+    traceFn.appendFile("oovCoverage.info");
+    File traceFile;
+    OovStatus status = traceFile.open(traceFn, "w");
+    if(status.ok())
+        {
+        std::vector<CoverageCount> const &counts = covCounts.getCounts();
+        FILE *fp = traceFile.getFp();
+        for(auto const &fileData : files)
+            {
+            std::vector<int> probes = fileData.getProbesByLine();
+            fprintf(fp, "TN:\nSF:%s\n", fileData.getOrigSrcFn().getStr());
+            std::map<int, DecisionStats> decisions;
+            int numBranches = 0;
+            int numHitBranches = 0;
+            for(int probe : probes)
+                {
+                int decisionIndex = fileData.mProbeDecisions[static_cast<size_t>(probe)];
+                if(decisionIndex != -1)
+                    {
+                    DecisionStats &decision = decisions[decisionIndex];
+                    if(decision.mOutcomes == 0)
+                        {
+                        decision.mLine = fileData.mProbeOrigLines[static_cast<size_t>(probe)];
+                        }
+                    CoverageCount count = fileData.getCount(counts, probe);
+                    fprintf(fp, "BRDA:%d,%d,%d,%llu\n", decision.mLine, decisionIndex,
+                        decision.mOutcomes++, static_cast<unsigned long long>(count));
+                    numBranches++;
+                    if(count)
+                        {
+                        numHitBranches++;
+                        }
+                    }
+                }
+            fprintf(fp, "BRF:%d\nBRH:%d\n", numBranches, numHitBranches);
+            int numLines = 0;
+            int numHitLines = 0;
+            int prevLine = 0;
+            for(int probe : probes)
+                {
+                // Only the first probe on a line is used.  The original lines
+                // are in the same order as the instrumented lines.  An inserted
+                // else or default is only a branch, since its line is the line
+                // of the closing brace.
+                int line = fileData.mProbeOrigLines[static_cast<size_t>(probe)];
+                if(line != prevLine &&
+                    !fileData.mProbeInserted[static_cast<size_t>(probe)])
+                    {
+                    CoverageCount count = fileData.getCount(counts, probe);
+                    fprintf(fp, "DA:%d,%llu\n", line, static_cast<unsigned long long>(count));
+                    numLines++;
+                    if(count)
+                        {
+                        numHitLines++;
+                        }
+                    prevLine = line;
+                    }
+                }
+            fprintf(fp, "LF:%d\nLH:%d\nend_of_record\n", numLines, numHitLines);
+            }
+        }
+    if(status.needReport())
+        {
+        OovString err = "Unable to open file ";
+        err += traceFn;
+        status.report(ET_Error, err);
+        }
+    }
+
+/// Copy a single original source file and make a comment that contains the
+/// hit counts for each instrumented line.  A line can have more than one
+/// count, for example when a decision and its outcome are on the same line.
+/// In hit once mode, the count is the number of program runs that ran the line.
+static void updateCovSourceCounts(CoverageFileData const &fileData,
+        std::vector<CoverageCount> const &counts, bool hitOnce)
+    {
+    std::multimap<int, int> lineProbes;
+    for(int probe : fileData.getProbesByLine())
+        {
+        lineProbes.insert(std::make_pair(
+            fileData.mProbeOrigLines[static_cast<size_t>(probe)], probe));
+        }
+    FilePath srcFn = fileData.getOrigSrcFn();
     FilePath dstFn(Project::getCoverageProjectDirectory(), FP_Dir);
-    dstFn.appendFile(relSrcFn);
+    dstFn.appendFile(fileData.mRelSrcFn);
     File srcFile;
     OovStatus status = srcFile.open(srcFn, "r");
     if(status.ok())
@@ -243,27 +719,34 @@ static void updateCovSourceCounts(OovStringRef const relSrcFn,
             status = dstFile.open(dstFn, "w");
             if(status.ok())
                 {
-                char buf[1000];
-                size_t instrCount = 0;
-                while(srcFile.getString(buf, sizeof(buf), status))
+                OovString line;
+                int lineNum = 0;
+                while(srcFile.getLine(line, status))
                     {
-                    if(strstr(buf, "COV_IN("))
+                    lineNum++;
+                    auto range = lineProbes.equal_range(lineNum);
+                    if(range.first != range.second)
                         {
-                        if(instrCount < counts.size())
+                        OovString countStr = "    //";
+                        for(auto iter = range.first; iter != range.second; ++iter)
                             {
-                            OovString countStr = "    // ";
-                            countStr.appendInt(counts[instrCount]);
-                            OovString newStr = buf;
-                            size_t pos = newStr.find('\n');
-                            newStr.insert(pos, countStr);
-                            if(newStr.length() < sizeof(buf)-1)
-                                {
-                                strcpy(buf, newStr.getStr());
-                                }
+                            countStr += ' ';
+                            countStr += std::to_string(fileData.getCount(counts,
+                                (*iter).second));
+                            }
+                        if(hitOnce)
+                            {
+                            countStr += " runs";
                             }
-                        instrCount++;
+                        size_t pos = line.length();
+                        if(pos > 0 && line[pos-1] == '\r')
+                            {
+                            pos--;
+                            }
+                        line.insert(pos, countStr);
                         }
-                    status = dstFile.putString(buf);
+                    line += '\n';
+                    status = dstFile.putString(line);
                     if(!status.ok())
                         {
                         break;
@@ -282,30 +765,96 @@ static void updateCovSourceCounts(OovStringRef const relSrcFn,
         }
     }
 
-/// Copy each source file and make a comment that contains the hit count
-/// for each instrumented line.
-static void updateCovSourceCounts(CoverageHeaderReader const &covHeader,
-        CoverageCountsReader const &covCounts)
+/// Makes the operation profile from the function probes.  The profile file
+/// is only written by the instrumented program when the coverage project
+/// was compiled with COV_PROFILE.  A profile from an earlier run is deleted
+/// if there is no profile that matches this build.
+static void makeOperationProfile(std::vector<CoverageFileData> const &files,
+        uint64_t signature)
     {
-    std::vector<int> const &counts = covCounts.getCounts();
-    size_t countIndex = 0;
-    for(auto const &mapItem : covHeader.getMap())
+    FilePath profileFn(Project::getCoverageProjectDirectory(), FP_Dir);
+    profileFn.appendDir("out-Debug");
+    profileFn.appendFile("OovProfile.bin");
+    OovStatus status(true, SC_File);
+    bool written = false;
+    if(FileIsFileOnDisk(profileFn, status))
         {
-        int count = mapItem.second;
-        std::vector<int> fileCounts;
-        for(int i=0; i<count; i++)
+        uint64_t profileSignature;
+        std::vector<ProfileRecord> records;
+        status = readRecordFile(profileFn, "OovPrf1", profileSignature, records);
+        if(status.ok() && profileSignature == signature)
             {
-            if(countIndex < counts.size())
+            OperationProfile profile;
+            for(auto const &fileData : files)
                 {
-                fileCounts.push_back(counts[countIndex++]);
+                for(size_t i=0; i<fileData.mProbeNames.size(); i++)
+                    {
+                    size_t recordIndex = static_cast<size_t>(
+                        fileData.mFileDefine.mBase) + i;
+                    if(!fileData.mProbeNames[i].empty() &&
+                        recordIndex < records.size())
+                        {
+                        ProfileRecord const &record = records[recordIndex];
+                        profile.add(fileData.mProbeNames[i], record.mCalls,
+                            record.mTicks);
+                        }
+                    }
                 }
+            status = profile.write();
+            written = status.ok();
+            }
+        }
+    if(status.needReport())
+        {
+        status.report(ET_Error, "Unable to make operation profile");
+        }
+    if(!written)
+        {
+        status = FileDelete(OperationProfile::getFn());
+        if(status.needReport())
+            {
+            status.report(ET_Error, "Unable to delete old operation profile");
+            }
+        }
+    }
+
+/// Reads the probe locations of all instrumented files, then makes the
+/// output files.  Only the source files that are requested are copied with
+/// the hit counts, since copying every file is slow for large projects.
+static void makeCoverageOutput(CoverageHeaderReader const &covHeader,
+        CoverageCountsReader const &covCounts, OovStringVec const &annotateFiles)
+    {
+    std::vector<CoverageFileData> files;
+    files.reserve(covHeader.getMap().size());
+    for(auto const &mapItem : covHeader.getMap())
+        {
+        files.push_back(CoverageFileData(makeOrigCovFn(mapItem.first),
+            mapItem.second));
+        }
+
+    CoverageFileQueue queue;
+    queue.setupQueue(queue.getNumHardwareThreads());
+    for(auto &fileData : files)
+        {
+        queue.addTask(&fileData);
+        }
+    queue.waitForCompletion();
+
+    makeCoverageStats(files, covCounts);
+    makeCoverageTraceFile(files, covCounts);
+    makeOperationProfile(files, covCounts.getSignature());
+    for(auto const &fileData : files)
+        {
+        if(std::find(annotateFiles.begin(), annotateFiles.end(),
+            fileData.mRelSrcFn) != annotateFiles.end())
+            {
+            updateCovSourceCounts(fileData, covCounts.getCounts(),
+                covHeader.isHitOnce());
             }
-        std::string covFn = makeOrigCovFn(mapItem.first);
-        updateCovSourceCounts(covFn, fileCounts);
         }
     }
 
-bool makeCoverageStats()
+bool makeCoverageStats(OovStringVec const &annotateFiles)
     {
     bool success = false;
     SharedFile covHeaderFile;
@@ -326,19 +875,20 @@ bool makeCoverageStats()
             success = true;
             FilePath covCountsFn(Project::getCoverageProjectDirectory(), FP_Dir);
             covCountsFn.appendDir("out-Debug");
-            static char const covCountsFnStr[] = "OovCoverageCounts.txt";
+            static char const covCountsFnStr[] = "OovCoverageCounts.bin";
             covCountsFn.appendFile(covCountsFnStr);
             CoverageCountsReader covCounts;
             covCounts.read(covCountsFn);
             int covInstrLines = covCounts.getNumInstrumentedLines();
-            if(headerInstrLines == covInstrLines)
+            // The program may not have been run since files were added.
+            if(covInstrLines <= headerInstrLines &&
+                covHeaderReader.getSignature() == covCounts.getSignature())
                 {
-                makeCoverageStats(covHeaderReader, covCounts);
-                updateCovSourceCounts(covHeaderReader, covCounts);
+                makeCoverageOutput(covHeaderReader, covCounts, annotateFiles);
                 }
             else
                 {
-                fprintf(stderr, "Number of OovCoverage.h lines %d don't match %s lines %d\n",
+                fprintf(stderr, "Number of OovCoverage.h lines %d or signature don't match %s lines %d\n",
                         headerInstrLines, covCountsFnStr, covInstrLines);
                 }
             }
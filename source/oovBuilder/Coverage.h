@@ -17,9 +17,13 @@ bool makeCoverageBuildProject(ProjectReader &project);
 
 /// This uses the coverage header file that was generated by oovCovInstr to
 /// get all of the source file names and number of instrumented lines in each file.
-/// Then it gets the OovCoverageCounts.txt file that matches the total
-/// number of instrumented lines to output the percentage of coverage in one file,
-/// and to update each source file coverage counts for each set of statements.
-bool makeCoverageStats();
+/// Then it gets the OovCoverageCounts.bin file that matches the
+/// signature to output the percentage of coverage in one file.
+/// The percentage of outcomes that ran for each if and switch decision is
+/// output to the oovCovDecisions.txt file, and the count for each line and
+/// decision outcome is output to the oovCoverage.info lcov trace file.
+/// @param annotateFiles The source files relative to the source root
+///     that are copied with a hit count comment for each set of statements.
+bool makeCoverageStats(OovStringVec const &annotateFiles);
 
 #endif /* COVERAGE_H_ */
@@ -35,9 +35,14 @@ class OovBuilder
     public:
         void process(eProcessModes processMode, OovStringRef oovProjDir,
             OovStringRef buildConfigName, bool verbose);
+        /// Adds a source file that is copied with hit counts in the coverage
+        /// stats mode.
+        void addCovSrcFile(OovStringRef const relSrcFn)
+            { mCovSrcFiles.push_back(relSrcFn); }
 
     private:
         ComponentFinder mCompFinder;
+        OovStringVec mCovSrcFiles;
 
         void analyze(BuildConfigWriter &cfg, eProcessModes procMode,
             OovStringRef const buildConfigName, OovStringRef const srcRootDir);
@@ -185,7 +190,7 @@ void OovBuilder::build(eProcessModes processMode, OovStringRef oovProjDir,
         {
         if(processMode == PM_CovStats)
             {
-            if(makeCoverageStats())
+            if(makeCoverageStats(mCovSrcFiles))
                 {
                 printf("Coverage output: %s",
                     Project::getCoverageProjectDirectory().getStr());
@@ -470,6 +475,10 @@ int main(int argc, char const * const argv[])
                     processMode = PM_Build;
                     }
                 }
+            else if(testArg.find("-covsrc-", 0, 8) == 0)
+                {
+                builder.addCovSrcFile(testArg.substr(8));
+                }
             else if(testArg.compare("-bv") == 0)
                 {
                 verbose = true;
@@ -486,6 +495,8 @@ int main(int argc, char const * const argv[])
             fprintf(stderr, "               buildconfig is Debug, Release or any custom name\n");
             fprintf(stderr, "    -mode-<analyze|build|clean-[abc]|cov-instr|cov-build|cov-stats>\n");
             fprintf(stderr, "               cov means coverage, [abc] means analyze, build, coverage \n");
+            fprintf(stderr, "    -covsrc-<srcfile>\n");
+            fprintf(stderr, "               copy the source file with hit counts in cov-stats mode\n");
             fprintf(stderr, "    -bv         builder verbose - OovBuilder.txt file\n");
         }
 
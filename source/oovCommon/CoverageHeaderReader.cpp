@@ -6,6 +6,9 @@
  */
 
 #include "CoverageHeaderReader.h"
+#include "Project.h"
+#include <string.h>
+#include <vector>
 
 FilePath CoverageHeaderReader::getFn(OovStringRef const outDir)
     {
@@ -22,38 +25,57 @@ FilePath CoverageHeaderReader::getFn(OovStringRef const outDir)
     return outFn;
     }
 
+OovString CoverageHeaderReader::getLineMapFn(OovStringRef const instrFn)
+    {
+    OovString fn = instrFn;
+    fn += "-lines.txt";
+    return fn;
+    }
+
 void CoverageHeaderReader::insertBufToMap(OovString const &buf)
     {
     size_t pos = 0;
     mInstrDefineMap.clear();
-    int lineCounter = 0;        // Base 1
+    mNumInstrumentedLines = 0;
+    mHitOnce = false;
+    mSignature = 0;
     while(pos != std::string::npos)
         {
-        lineCounter++;
         size_t endPos = buf.find('\n', pos);
         OovString line(buf, pos, endPos-pos);
 
-        if(lineCounter > 5)
+        // The header also contains the counter type and macro definitions,
+        // so only the lines that match the define formats are used.
+        char keyword[10];
+        char fnDef[250];
+        char commentChars[10];
+        int count;
+        int offset;
+        unsigned long long hash = 0;
+        int numItems = sscanf(line.getStr(), "%9s %249s %d %9s %d %llx", keyword,
+                fnDef, &offset, commentChars, &count, &hash);
+        if(numItems >= 3 && strcmp(keyword, "#define") == 0)
             {
-            // Insert line
-            char keyword[10];
-            char fnDef[250];
-            char commentChars[10];
-            int count;
-            int offset;
-            int numItems = sscanf(line.getStr(), "%10s %250s %d %10s %d", keyword, fnDef,
-                    &offset, commentChars, &count);
-            if(numItems >= 5)
+            if(strcmp(fnDef, "COV_TOTAL_INSTRS") == 0)
                 {
-                mInstrDefineMap.insert(std::pair<std::string, int>(fnDef, count));
+                mNumInstrumentedLines = offset;
+                }
+            else if(strcmp(fnDef, "COV_HIT_ONCE") == 0)
+                {
+                mHitOnce = (offset != 0);
+                }
+            else if(strcmp(fnDef, "COV_SIGNATURE") == 0)
+                {
+                unsigned long long sig = 0;
+                if(sscanf(line.getStr(), "%*s %*s %llx", &sig) == 1)
+                    {
+                    mSignature = sig;
+                    }
+                }
+            else if(numItems >= 5 && strcmp(commentChars, "//") == 0)
+                {
+                mInstrDefineMap[fnDef] = FileDefine(offset, count, hash);
                 }
-            }
-        else if(lineCounter == 4)
-            {
-            char keyword[10];
-            char def[100];
-            mNumInstrumentedLines = 0;
-            sscanf(line.getStr(), "%10s %100s %d", keyword, def, &mNumInstrumentedLines);
             }
 
         pos = endPos;
@@ -62,6 +84,57 @@ void CoverageHeaderReader::insertBufToMap(OovString const &buf)
         }
     }
 
+bool CoverageHeaderReader::isFileUnchanged(OovStringRef const fileDefine,
+        uint64_t hash) const
+    {
+    auto const &iter = mInstrDefineMap.find(fileDefine.getStr());
+    return(iter != mInstrDefineMap.end() && (*iter).second.mHash == hash);
+    }
+
+OovString CoverageHeaderReader::makeFileDefine(OovStringRef const fn,
+        OovStringRef const srcRootDir)
+    {
+    OovString relFn = Project::getSrcRootDirRelativeSrcFileName(fn, srcRootDir);
+    OovString fileDef = "COV_";
+    fileDef += relFn;
+    fileDef.replaceStrs("//", "_");
+    fileDef.replaceStrs("/", "_");
+    fileDef.replaceStrs(".", "_");
+    fileDef.replaceStrs(":", "");
+    return fileDef;
+    }
+
+uint64_t CoverageHeaderReader::hashBuf(void const *buf, size_t size,
+        uint64_t hash)
+    {
+    unsigned char const *bytes = static_cast<unsigned char const *>(buf);
+    for(size_t i=0; i<size; i++)
+        {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+        }
+    return hash;
+    }
+
+OovStatusReturn CoverageHeaderReader::getFileHash(OovStringRef const fn,
+        uint64_t &hash)
+    {
+    SimpleFile file;
+    eOpenStatus openStat = file.open(fn, M_ReadShared, OE_Binary);
+    OovStatus status(openStat == OS_Opened, SC_File);
+    if(status.ok())
+        {
+        std::vector<char> buf(file.getSize());
+        int actual = 0;
+        status = file.read(buf.data(), static_cast<int>(buf.size()), actual);
+        if(status.ok())
+            {
+            hash = hashBuf(buf.data(), static_cast<size_t>(actual));
+            }
+        }
+    return status;
+    }
+
 OovStatusReturn CoverageHeaderReader::read(SharedFile &outDefFile)
     {
     std::string buf(outDefFile.getSize(), 0);
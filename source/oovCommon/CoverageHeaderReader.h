@@ -11,42 +11,92 @@
 #include "File.h"
 #include "FilePath.h"
 #include <map>
+#include <stdint.h>
 
 /// This is for code coverage header source file that is included and added
 /// to the project being analyzed.  The coverage header file contains:
 ///     - An array of coverage counts for the whole project.  The array contains
-///       one entry for every instrumented line in the project.
+///       one entry for every instrumented line in the project.  The counter
+///       type and the COV_IN macro are also defined in the file.
 ///     - One #define macro for each instrumented source or header file, that
 ///       defines the starting index for the file.  Each macro looks something
-///       like:  "#define COV_file 42 // 20", where the 42 is the starting
-///       index into the array, and the 20 is the number of instrumented
-///       lines in that file.
+///       like:  "#define COV_file 42 // 20 1f2e...", where the 42 is the
+///       starting index into the array, the 20 is the number of instrumented
+///       lines in that file, and the last value is a hash that identifies
+///       how the file was instrumented.  oovBuilder makes the hash from the
+///       contents of the source file and its include files, and the options.
+///     - "#define COV_HIT_ONCE 1" if the probes only set a flag.
+///     - "#define COV_SIGNATURE 0x..." that identifies the layout of the
+///       array.  The starting index of a file does not change while the file
+///       contents do not change, so the signature stays the same as files are
+///       added or changed, and accumulated counts for other files stay valid.
 class CoverageHeaderReader
     {
     public:
+        /// The location of the counts for one instrumented file.
+        struct FileDefine
+            {
+            FileDefine(int base=0, int count=0, uint64_t hash=0):
+                mBase(base), mCount(count), mHash(hash)
+                {}
+            int mBase;          // The starting index into the counts array.
+            int mCount;         // The number of instrumented lines.
+            uint64_t mHash;     // Identifies how the file was instrumented.
+            };
+
         CoverageHeaderReader():
-            mNumInstrumentedLines(0)
+            mNumInstrumentedLines(0), mHitOnce(false), mSignature(0)
             {}
-        /// Returns the total number of instrumented lines in the project.
+        /// Returns the size of the coverage array.  This can include unused
+        /// entries from previous versions of changed files.
         int getNumInstrumentedLines() const
             { return mNumInstrumentedLines; }
+        /// Returns true if the probes only record whether each line was run.
+        /// The counts are then the number of program runs that ran each line.
+        bool isHitOnce() const
+            { return mHitOnce; }
         /// Get the name of the coverage header file.
         /// @param outDir The directory for the coverage files.  This will return
         ///     outDir + "/covLib/OovCoverage.h"
         static FilePath getFn(OovStringRef const outDir);
+        /// Get the name of the file that oovCovInstr writes beside each
+        /// instrumented source file.  Each line of the file contains the
+        /// line number in the original source file for the same line in the
+        /// instrumented source file.
+        /// @param instrFn The path of the instrumented source file.
+        static OovString getLineMapFn(OovStringRef const instrFn);
         /// Reads the coverage header file into memory
         /// @param outDefFile This must contain the full path to the coverage
         ///     header file.
         OovStatusReturn read(SharedFile &outDefFile);
         /// Returns the map where each item is a #define macro name for each
-        /// instrumented file and a count of the number of instrumented lines
-        /// for the instrumented file.
-        std::map<OovString, int> const &getMap() const
+        /// instrumented file and the location of the counts for the file.
+        std::map<OovString, FileDefine> const &getMap() const
             { return mInstrDefineMap; }
+        /// Returns the identifier of the layout of the coverage array.  This is
+        /// written into the coverage counts file so that counts from a different
+        /// layout are not used.
+        uint64_t getSignature() const
+            { return mSignature; }
+        /// Returns true if the file was instrumented with the same hash.
+        /// @param fileDefine The define made by makeFileDefine.
+        /// @param hash The hash that identifies how the file is instrumented.
+        bool isFileUnchanged(OovStringRef const fileDefine, uint64_t hash) const;
+
+        /// Makes the #define macro name for an instrumented file.
+        static OovString makeFileDefine(OovStringRef const fn,
+            OovStringRef const srcRootDir);
+        /// This is the FNV-1a hash.
+        static uint64_t hashBuf(void const *buf, size_t size,
+            uint64_t hash = 14695981039346656037ULL);
+        /// Gets the hash of the contents of a source file.
+        static OovStatusReturn getFileHash(OovStringRef const fn, uint64_t &hash);
 
     protected:
-        std::map<OovString, int> mInstrDefineMap;       // file define, count
-        int mNumInstrumentedLines;      // The total number of instrumented lines.
+        std::map<OovString, FileDefine> mInstrDefineMap;
+        int mNumInstrumentedLines;      // The size of the coverage array.
+        bool mHitOnce;
+        uint64_t mSignature;
 
         void insertBufToMap(OovString const &buf);
     };
@@ -11,6 +11,7 @@
 #include <fcntl.h>
 #ifdef __linux__
 #include <sys/file.h>   // for flock
+#include <sys/mman.h>   // for mmap
 #else
 #include <share.h>
 #include <io.h>         // For _sopen_s - in Windows, mingw-builds is required.
@@ -71,6 +72,25 @@ bool File::getString(char *buf, int bufBytes, OovStatus &status)
     return(keepGoing);
     }
 
+bool File::getLine(std::string &line, OovStatus &status)
+    {
+    line.clear();
+    char buf[1000];
+    bool gotLine = false;
+    // Long lines are read in pieces.
+    while(getString(buf, sizeof(buf), status))
+        {
+        gotLine = true;
+        line += buf;
+        if(line[line.length()-1] == '\n')
+            {
+            line.resize(line.length()-1);
+            break;
+            }
+        }
+    return gotLine;
+    }
+
 
 eOpenStatus BaseSimpleFile::open(OovStringRef const fn, eOpenModes mode, eOpenEndings oe)
     {
@@ -218,3 +238,63 @@ eOpenStatus SharedFile::open(OovStringRef const fn, eOpenModes mode,
         }
     return status;
     }
+
+OovStatusReturn MappedFile::open(OovStringRef const fn)
+    {
+    close();
+#ifdef __linux__
+    int fd = ::open(fn.getStr(), O_RDONLY);
+    OovStatus status(fd != -1, SC_File);
+    if(status.ok())
+        {
+        struct stat fileStat;
+        status.set(fstat(fd, &fileStat) == 0, SC_File);
+        if(status.ok() && fileStat.st_size > 0)
+            {
+            size_t size = static_cast<size_t>(fileStat.st_size);
+            void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            status.set(data != MAP_FAILED, SC_File);
+            if(status.ok())
+                {
+                madvise(data, size, MADV_SEQUENTIAL);
+                mData = static_cast<char const*>(data);
+                mSize = size;
+                }
+            }
+        ::close(fd);
+        }
+#else
+    File file;
+    OovStatus status = file.open(fn, "rb");
+    int size = 0;
+    if(status.ok())
+        {
+        status = file.getFileSize(size);
+        }
+    if(status.ok() && size > 0)
+        {
+        mBuf.resize(static_cast<size_t>(size));
+        status = file.read(mBuf.data(), size);
+        if(status.ok())
+            {
+            mData = mBuf.data();
+            mSize = mBuf.size();
+            }
+        }
+#endif
+    return status;
+    }
+
+void MappedFile::close()
+    {
+#ifdef __linux__
+    if(mData)
+        {
+        munmap(const_cast<char*>(mData), mSize);
+        }
+#else
+    mBuf.clear();
+#endif
+    mData = nullptr;
+    mSize = 0;
+    }
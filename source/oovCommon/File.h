@@ -12,6 +12,7 @@
 #include "OovError.h"
 #include <stdio.h>
 #include <sys/stat.h>
+#include <vector>
 #define __NO_MINGW_LFS 1
 
 
@@ -91,6 +92,12 @@ class File
         /// @param status True if no error was encountered.
         bool getString(char *buf, int bufBytes, OovStatus &status);
 
+        /// Read a line of any length. The end of line indicator is removed.
+        /// @param line The place to put the line.
+        /// @param status True if no error was encountered.
+        /// @return False if there are no more lines.
+        bool getLine(std::string &line, OovStatus &status);
+
         /// Set a file to the specified size.  This is meant for truncation and
         /// not for growing a file.
         /// @param size The size in bytes to set the file to.
@@ -210,4 +217,32 @@ class SharedFile: public BaseSimpleFile
                 eOpenEndings oe=OE_Text);
     };
 
+/// This provides a read only view of a whole file without text mode
+/// conversion. On linux, the file is memory mapped, so it is not copied
+/// into a buffer.
+class MappedFile
+    {
+    public:
+        MappedFile():
+            mData(nullptr), mSize(0)
+            {}
+        ~MappedFile()
+            { close(); }
+        /// Open and map the file.  An empty file has a null data pointer.
+        /// @param fn The name of the file to open
+        OovStatusReturn open(OovStringRef const fn);
+        void close();
+        char const *getData() const
+            { return mData; }
+        size_t getSize() const
+            { return mSize; }
+
+    private:
+        char const *mData;
+        size_t mSize;
+#ifndef __linux__
+        std::vector<char> mBuf;
+#endif
+    };
+
 #endif /* FILE_H_ */
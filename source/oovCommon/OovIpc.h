@@ -11,6 +11,7 @@
 enum EditorCommands
     {
     EC_ViewFile='v',            // arg1 = fileName, arg2 = lineNum
+    EC_AnalysisComplete='a',    // no args
     };
 
 /// The commands that the editor's container can perform.
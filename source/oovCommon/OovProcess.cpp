@@ -201,8 +201,18 @@ void OovPipeProcessLinux::linuxChildProcessListen(OovProcessListener &listener,
     sDbgFile.printflush("linuxChildProcessListen %d\n", mChildProcessId);
 #endif
     siginfo_t siginfo;
+    // The child is reaped by waitid, so the exit status must be saved here.
+    // The pid is only set if the child changed state.
+    bool reaped = false;
+    siginfo.si_pid = 0;
     while((pidStat = waitid(P_PID, mChildProcessId, &siginfo, WEXITED | WNOHANG)) != -1)
         {
+        if(!reaped && siginfo.si_pid == mChildProcessId)
+            {
+            reaped = true;
+            // A child that was killed, such as by a crash, is an error.
+            exitCode = (siginfo.si_code == CLD_EXITED) ? siginfo.si_status : -1;
+            }
 #if(DEBUG_PROC)
         sDbgFile.printflush("linuxChildProcessListen pidstat %d\n", pidStat);
         // 17 0 1 means exited.
@@ -278,14 +288,14 @@ void OovPipeProcessLinux::linuxChildProcessListen(OovProcessListener &listener,
     linuxClosePipe(mErrPipe[P_Read]);
     // If the error pipe has "Unable to run process..." then this should
     // actually return an error.
-    int waitStatus;
-    waitpid(mChildProcessId, &waitStatus, WEXITED);
-    if(WIFEXITED(waitStatus) == 0)
+    if(!reaped)
         {
-        exitCode = 0;
+        int waitStatus;
+        if(waitpid(mChildProcessId, &waitStatus, 0) == mChildProcessId)
+            {
+            exitCode = WIFEXITED(waitStatus) ? WEXITSTATUS(waitStatus) : -1;
+            }
         }
-    else
-        exitCode = waitStatus;
 #if(DEBUG_PROC)
     sDbgFile.printflush("linuxChildProcessListen - done\n");
 #endif
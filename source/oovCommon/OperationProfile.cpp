@@ -0,0 +1,131 @@
+/*
+ * OperationProfile.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#include "OperationProfile.h"
+#include "Project.h"
+#include "File.h"
+#include <algorithm>
+#include <vector>
+
+FilePath OperationProfile::getFn()
+    {
+    FilePath fn(Project::getCoverageProjectDirectory(), FP_Dir);
+    fn.appendFile("oovProfile.txt");
+    return fn;
+    }
+
+OovString OperationProfile::makeName(OovStringRef const className,
+        OovStringRef const operName)
+    {
+    OovString name = className;
+    if(name.length() != 0)
+        {
+        name += "::";
+        }
+    name += operName;
+    return name;
+    }
+
+void OperationProfile::add(OovStringRef const name, uint64_t calls,
+        uint64_t ticks)
+    {
+    Cost &cost = mCosts[name.getStr()];
+    cost.mCalls += calls;
+    cost.mTicks += ticks;
+    if(cost.mTicks > mMaxTicks)
+        {
+        mMaxTicks = cost.mTicks;
+        }
+    }
+
+OperationProfile::Cost const *OperationProfile::getCost(
+        OovStringRef const className, OovStringRef const operName) const
+    {
+    Cost const *cost = nullptr;
+    auto const &iter = mCosts.find(makeName(className, operName));
+    if(iter != mCosts.end() && (*iter).second.mCalls != 0)
+        {
+        cost = &(*iter).second;
+        }
+    return cost;
+    }
+
+/// Returns zero if the file does not exist.
+static time_t getFileTime(OovStringRef const fn)
+    {
+    time_t fileTime = 0;
+    OovStatus status = FileGetFileTime(fn, fileTime);
+    if(!status.ok())
+        {
+        status.clearError();
+        fileTime = 0;
+        }
+    return fileTime;
+    }
+
+OovStatusReturn OperationProfile::readIfChanged()
+    {
+    OovStatus status(true, SC_File);
+    FilePath fn = getFn();
+    if(fn != mReadFn || getFileTime(fn) != mReadTime)
+        {
+        status = read();
+        }
+    return status;
+    }
+
+OovStatusReturn OperationProfile::read()
+    {
+    mCosts.clear();
+    mMaxTicks = 0;
+    FilePath fn = getFn();
+    OovStatus status(true, SC_File);
+    mReadFn = fn;
+    mReadTime = getFileTime(fn);
+    if(FileIsFileOnDisk(fn, status))
+        {
+        File file;
+        status = file.open(fn, "r");
+        if(status.ok())
+            {
+            char buf[1000];
+            while(file.getString(buf, sizeof(buf), status))
+                {
+                unsigned long long calls;
+                unsigned long long ticks;
+                char name[sizeof(buf)];
+                if(sscanf(buf, "%llu %llu %999[^\n]", &calls, &ticks, name) == 3)
+                    {
+                    add(name, calls, ticks);
+                    }
+                }
+            }
+        }
+    return status;
+    }
+
+OovStatusReturn OperationProfile::write() const
+    {
+    typedef std::pair<OovString, Cost> NamedCost;
+    std::vector<NamedCost> costs(mCosts.begin(), mCosts.end());
+    std::stable_sort(costs.begin(), costs.end(),
+        [](NamedCost const &cost1, NamedCost const &cost2)
+        { return cost1.second.mTicks > cost2.second.mTicks; });
+    File file;
+    OovStatus status = file.open(getFn(), "w");
+    if(status.ok())
+        {
+        for(auto const &cost : costs)
+            {
+            fprintf(file.getFp(), "%llu %llu %s\n",
+                static_cast<unsigned long long>(cost.second.mCalls),
+                static_cast<unsigned long long>(cost.second.mTicks),
+                cost.first.getStr());
+            }
+        }
+    return status;
+    }
@@ -0,0 +1,71 @@
+/*
+ * OperationProfile.h
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#ifndef OPERATIONPROFILE_H_
+#define OPERATIONPROFILE_H_
+
+#include "FilePath.h"
+#include <map>
+#include <stdint.h>
+
+/// This is the measured cost of each function from a coverage build that
+/// was compiled with COV_PROFILE.  The file is written by oovBuilder when
+/// the coverage statistics are made, and contains one line for each
+/// function with the number of calls, the total time in ticks, and the
+/// name.  The name is the class name and the operation name separated by
+/// "::", so that it can be looked up with the model classifier and
+/// operation names.
+class OperationProfile
+    {
+    public:
+        struct Cost
+            {
+            Cost():
+                mCalls(0), mTicks(0)
+                {}
+            uint64_t mCalls;
+            uint64_t mTicks;    // The time including called functions.
+            };
+
+        OperationProfile():
+            mMaxTicks(0), mReadTime(0)
+            {}
+        /// Returns the file name in the coverage project directory.
+        static FilePath getFn();
+        /// Makes the name that is used to look up an operation.  Functions
+        /// that are not in a class or namespace only have the operation name.
+        static OovString makeName(OovStringRef const className,
+            OovStringRef const operName);
+        /// Adds the cost to any cost that has the same name.  Overloaded
+        /// operations have the same name.
+        void add(OovStringRef const name, uint64_t calls, uint64_t ticks);
+        /// Returns null if the operation was not called.
+        Cost const *getCost(OovStringRef const className,
+            OovStringRef const operName) const;
+        /// Returns the largest time of all operations.
+        uint64_t getMaxTicks() const
+            { return mMaxTicks; }
+        bool isEmpty() const
+            { return mCosts.empty(); }
+        /// Reads the file.  A missing file makes an empty profile.
+        OovStatusReturn read();
+        /// Reads the file only if it is a different file or it was changed
+        /// since it was read, so this can be called for every diagram update.
+        OovStatusReturn readIfChanged();
+        /// Writes the file with the most costly operations first.
+        OovStatusReturn write() const;
+
+    private:
+        std::map<OovString, Cost> mCosts;
+        uint64_t mMaxTicks;
+        /// The file and its time when it was read.  The time is zero if the
+        /// file did not exist.
+        FilePath mReadFn;
+        time_t mReadTime;
+    };
+
+#endif /* OPERATIONPROFILE_H_ */
@@ -323,6 +323,9 @@ void GuiOptions::setDefaultOptions()
     setNameValueBool(OptGuiShowOperParamRelations, true);
     setNameValueBool(OptGuiShowOperBodyVarRelations, true);
     setNameValueBool(OptGuiShowRelationKey, true);
+    setNameValueBool(OptGuiLayeredLayout, false);
+    setNameValueBool(OptGuiIncrementalLayout, true);
+    setNameValueBool(OptGuiDiagramTileCache, true);
 
     setNameValueBool(OptGuiShowCompImplicitRelations, false);
     /*
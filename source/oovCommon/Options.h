@@ -26,6 +26,9 @@
 #define OptGuiShowOperParamRelations "ShowOperParamRelations"
 #define OptGuiShowOperBodyVarRelations "ShowOperBodyVarRelations"
 #define OptGuiShowRelationKey "ShowRelationKey"
+#define OptGuiLayeredLayout "LayeredLayout"
+#define OptGuiIncrementalLayout "IncrementalLayout"
+#define OptGuiDiagramTileCache "DiagramTileCache"
 
 #define OptGuiShowCompImplicitRelations "ShowCompImplicitRelations"
 
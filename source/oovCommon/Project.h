@@ -16,6 +16,12 @@
 
 #define OptSourceRootDir "SourceRootDir"
 #define OptProjectExcludeDirs "ExcludeDirs"
+/// Set to "Yes" to make coverage probes that only record whether each
+/// line was run.
+#define OptCovHitOnce "CovHitOnce"
+/// Set to "Yes" to compile the coverage project with COV_PROFILE, which
+/// measures the calls and time of each function.
+#define OptCovProfile "CovProfile"
 
 // This is for user custom build configurations.
 #define OptBuildConfigs "BuildConfigs"
@@ -256,6 +262,8 @@ class ProjectBuildArgs
         const OovStringVec getAllCrcLinkArgs() const;
         /// These are absolute directories
         CompoundValue getProjectExcludeDirs() const;
+        bool getCovHitOnce() const
+            { return mProjectOptions.getValueBool(OptCovHitOnce); }
         BuildVariableEnvironment const &getBuildEnv() const
             { return mBuildEnv; }
         bool getVerbose() const
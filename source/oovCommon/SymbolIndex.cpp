@@ -0,0 +1,264 @@
+/*
+ * SymbolIndex.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#include "SymbolIndex.h"
+#include "FilePath.h"
+#include "DirList.h"
+#include "File.h"
+#include <algorithm>
+#include <iterator>
+#include <limits.h>
+
+static size_t const NumSymbolFields = 6;
+
+/// Removes the class and namespace names.
+static OovString getUnqualifiedName(OovStringRef const qualifiedName)
+    {
+    OovString name = qualifiedName;
+    size_t pos = name.rfind("::");
+    if(pos != std::string::npos)
+        {
+        name.erase(0, pos+2);
+        }
+    return name;
+    }
+
+OovString SymbolRecord::getName() const
+    {
+    return getUnqualifiedName(mQualifiedName);
+    }
+
+
+///////////
+
+void SymbolIndexWriter::add(SymbolRecord const &rec)
+    {
+    OovString line;
+    line += rec.mDefinition ? 'D' : 'd';
+    line += '\t';
+    line.appendInt(static_cast<int>(rec.mLine));
+    line += '\t';
+    line += rec.mFilename;
+    line += '\t';
+    line += rec.mUsr;
+    line += '\t';
+    line += rec.mParentUsr;
+    line += '\t';
+    line += rec.mQualifiedName;
+    line += '\n';
+    mLines.insert(line);
+    }
+
+OovStatusReturn SymbolIndexWriter::write(OovStringRef const fn)
+    {
+    File file;
+    OovStatus status = file.open(fn, "w");
+    for(auto const &line : mLines)
+        {
+        if(!status.ok())
+            {
+            break;
+            }
+        status = file.putString(line);
+        }
+    return status;
+    }
+
+
+///////////
+
+OovStatusReturn SymbolIndex::update(OovStringRef const analysisDir)
+    {
+    std::vector<std::string> fileNames;
+    OovStatus status = getDirListMatchExt(analysisDir,
+        FilePath(getFileExtension(), FP_File), fileNames);
+    FileTimes fileTimes;
+    for(auto const &fn : fileNames)
+        {
+        if(!status.ok())
+            {
+            break;
+            }
+        time_t fileTime = 0;
+        status = FileGetFileTime(fn, fileTime);
+        fileTimes[fn] = fileTime;
+        }
+    bool changed = false;
+    if(status.ok())
+        {
+        std::lock_guard<std::mutex> lock(mIndexMutex);
+        changed = (mAnalysisDir != analysisDir.getStr() || mFileTimes != fileTimes);
+        }
+    if(changed)
+        {
+        // The files are read without the lock, so that the lookups can use
+        // the old symbols until the new symbols are read.
+        SymbolIndex newIndex;
+        for(auto const &fn : fileNames)
+            {
+            status = newIndex.readFile(fn);
+            if(!status.ok())
+                {
+                break;
+                }
+            }
+        if(status.ok())
+            {
+            std::lock_guard<std::mutex> lock(mIndexMutex);
+            mSymbols.swap(newIndex.mSymbols);
+            mUsrMap.swap(newIndex.mUsrMap);
+            mNameMap.swap(newIndex.mNameMap);
+            mUnqualNameMap.swap(newIndex.mUnqualNameMap);
+            mParentMap.swap(newIndex.mParentMap);
+            mAnalysisDir = analysisDir;
+            mFileTimes = std::move(fileTimes);
+            }
+        }
+    return status;
+    }
+
+// The same header symbols are in many symbol files, so duplicates are
+// discarded.
+OovStatusReturn SymbolIndex::readFile(OovStringRef const fn)
+    {
+    File file;
+    OovStatus status = file.open(fn, "r");
+    if(status.ok())
+        {
+        OovString line;
+        while(file.getLine(line, status))
+            {
+            size_t fieldPos[NumSymbolFields];
+            size_t numFields = 0;
+            size_t pos = 0;
+            while(numFields < NumSymbolFields)
+                {
+                fieldPos[numFields++] = pos;
+                pos = line.find('\t', pos);
+                if(pos == std::string::npos)
+                    {
+                    break;
+                    }
+                pos++;
+                }
+            if(numFields == NumSymbolFields)
+                {
+                auto getField = [&line, &fieldPos](size_t field)
+                    {
+                    size_t end = (field+1 < NumSymbolFields) ?
+                        fieldPos[field+1]-1 : line.length();
+                    return OovString(line.substr(fieldPos[field], end-fieldPos[field]));
+                    };
+                SymbolRecord rec;
+                int lineNum = 0;
+                rec.mDefinition = (line[0] == 'D');
+                if(getField(1).getInt(0, INT_MAX, lineNum))
+                    {
+                    rec.mLine = static_cast<unsigned int>(lineNum);
+                    }
+                rec.mFilename = getField(2);
+                rec.mUsr = getField(3);
+                rec.mParentUsr = getField(4);
+                rec.mQualifiedName = getField(5);
+                bool duplicate = false;
+                auto range = mUsrMap.equal_range(rec.mUsr);
+                for(auto iter = range.first; iter != range.second; ++iter)
+                    {
+                    SymbolRecord const &other = mSymbols[(*iter).second];
+                    if(other.mLine == rec.mLine && other.mFilename == rec.mFilename)
+                        {
+                        duplicate = true;
+                        break;
+                        }
+                    }
+                if(!duplicate)
+                    {
+                    size_t index = mSymbols.size();
+                    mUsrMap.insert(SymbolMap::value_type(rec.mUsr, index));
+                    mNameMap.insert(SymbolMap::value_type(rec.mQualifiedName, index));
+                    mUnqualNameMap.insert(SymbolMap::value_type(rec.getName(), index));
+                    if(rec.mParentUsr.length() > 0)
+                        {
+                        mParentMap.insert(SymbolMap::value_type(rec.mParentUsr, index));
+                        }
+                    mSymbols.push_back(rec);
+                    }
+                }
+            }
+        }
+    return status;
+    }
+
+bool SymbolIndex::findLocation(SymbolMap const &map, OovStringRef const key,
+    bool definition, SymbolRecord &rec) const
+    {
+    bool found = false;
+    auto range = map.equal_range(key.getStr());
+    for(auto iter = range.first; iter != range.second; ++iter)
+        {
+        SymbolRecord const &sym = mSymbols[(*iter).second];
+        if(!found || (sym.mDefinition == definition && rec.mDefinition != definition))
+            {
+            rec = sym;
+            found = true;
+            }
+        }
+    return found;
+    }
+
+bool SymbolIndex::findUsr(OovStringRef const usr, bool definition,
+    SymbolRecord &rec) const
+    {
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    return findLocation(mUsrMap, usr, definition, rec);
+    }
+
+bool SymbolIndex::findQualifiedName(OovStringRef const name, bool definition,
+    SymbolRecord &rec) const
+    {
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    bool found = findLocation(mNameMap, name, definition, rec);
+    if(!found)
+        {
+        // The name may not have all of the namespace or class names, so
+        // check the symbols that have the same unqualified name.
+        OovString suffix = "::";
+        suffix += name;
+        auto range = mUnqualNameMap.equal_range(getUnqualifiedName(name));
+        for(auto iter = range.first; iter != range.second; ++iter)
+            {
+            SymbolRecord const &sym = mSymbols[(*iter).second];
+            OovString const &symName = sym.mQualifiedName;
+            if(symName.length() > suffix.length() &&
+                symName.compare(symName.length()-suffix.length(),
+                suffix.length(), suffix) == 0)
+                {
+                if(!found || (sym.mDefinition == definition &&
+                    rec.mDefinition != definition))
+                    {
+                    rec = sym;
+                    found = true;
+                    }
+                }
+            }
+        }
+    return found;
+    }
+
+OovStringVec SymbolIndex::getMembers(OovStringRef const classUsr) const
+    {
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    std::set<OovString> names;
+    auto range = mParentMap.equal_range(classUsr.getStr());
+    for(auto iter = range.first; iter != range.second; ++iter)
+        {
+        names.insert(mSymbols[(*iter).second].getName());
+        }
+    OovStringVec members;
+    std::copy(names.begin(), names.end(), std::back_inserter(members));
+    return members;
+    }
@@ -0,0 +1,111 @@
+/*
+ * SymbolIndex.h
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#ifndef SYMBOLINDEX_H_
+#define SYMBOLINDEX_H_
+
+#include "OovString.h"
+#include "OovError.h"
+#include <time.h>
+#include <map>
+#include <set>
+#include <vector>
+#include <mutex>
+
+/// A declaration or definition of a symbol.  The USR is the clang unified
+/// symbol resolution string, which is the same for a symbol in all
+/// translation units.
+struct SymbolRecord
+    {
+    SymbolRecord():
+        mLine(0), mDefinition(false)
+        {}
+    OovString mUsr;
+    /// The USR of the class or namespace that contains the symbol.
+    OovString mParentUsr;
+    /// The name with the class and namespace names such as "ns::cls::func".
+    OovString mQualifiedName;
+    OovString mFilename;
+    unsigned int mLine;
+    bool mDefinition;
+
+    OovString getName() const;
+    };
+
+/// The analysis directory contains a symbol file for each parsed source file.
+/// Each line of a symbol file is a symbol record with tab separated fields:
+///     <D|d> line filename USR parentUSR qualifiedName
+/// where D is a definition and d is a declaration.
+class SymbolIndexWriter
+    {
+    public:
+        void add(SymbolRecord const &rec);
+        OovStatusReturn write(OovStringRef const fn);
+
+    private:
+        // A set removes the duplicates from template instantiations and
+        // redeclarations.
+        std::set<OovString> mLines;
+    };
+
+/// This reads all symbol files in the analysis directory, and provides
+/// lookups of symbol locations without parsing the source files.
+///
+/// All functions are thread safe.
+class SymbolIndex
+    {
+    public:
+        static char const *getFileExtension()
+            { return ".sym"; }
+        /// Reads the symbol files if they have changed since the last read.
+        /// This gets the time of every symbol file, so it should only be
+        /// called after an analysis has been run.  The lookups use the old
+        /// symbols while the files are read.  This must not be called by
+        /// more than one thread at a time.
+        /// @param analysisDir The directory that contains the symbol files.
+        OovStatusReturn update(OovStringRef const analysisDir);
+        /// Find the location of a symbol using the USR.
+        /// @param usr The USR of the symbol.
+        /// @param definition True to find the definition, false to find
+        ///     the declaration. If the requested location is not found, the
+        ///     other location is returned.
+        bool findUsr(OovStringRef const usr, bool definition,
+            SymbolRecord &rec) const;
+        /// Find the location of a symbol using the qualified name. If there
+        /// is no exact match, the name can match the end of a qualified name,
+        /// so "cls::func" will find "ns::cls::func".
+        bool findQualifiedName(OovStringRef const name, bool definition,
+            SymbolRecord &rec) const;
+        /// Get the names of the members of a class.
+        /// @param classUsr The USR of the class.
+        OovStringVec getMembers(OovStringRef const classUsr) const;
+        size_t getNumSymbols() const
+            {
+            std::lock_guard<std::mutex> lock(mIndexMutex);
+            return mSymbols.size();
+            }
+
+    private:
+        typedef std::multimap<OovString, size_t> SymbolMap;
+        std::vector<SymbolRecord> mSymbols;
+        SymbolMap mUsrMap;
+        SymbolMap mNameMap;
+        // The names without the class and namespace names.
+        SymbolMap mUnqualNameMap;
+        SymbolMap mParentMap;
+        typedef std::map<OovString, time_t> FileTimes;
+        OovString mAnalysisDir;
+        // The modify times of the symbol files when they were read.
+        FileTimes mFileTimes;
+        mutable std::mutex mIndexMutex;
+
+        OovStatusReturn readFile(OovStringRef const fn);
+        bool findLocation(SymbolMap const &map, OovStringRef const key,
+            bool definition, SymbolRecord &rec) const;
+    };
+
+#endif
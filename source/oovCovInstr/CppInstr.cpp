@@ -10,6 +10,7 @@
 #include "Debug.h"
 #include "File.h"
 #include "CoverageHeaderReader.h"
+#include "OperationProfile.h"
 // Prevent "error: 'off64_t' does not name a type"
 #define __NO_MINGW_LFS 1
 // Prevent "error: 'off_t' has not been declared"
@@ -17,6 +18,7 @@
 #include <unistd.h>             // for unlink
 #include <limits.h>
 #include <algorithm>
+#include <chrono>
 #include "clang-c/Index.h"
 
 
@@ -123,6 +125,8 @@ bool CppFileContents::read(char const *fn)
         mFileContents.resize(size);
         int actual = 0;
         status = file.read(mFileContents.data(), size, actual);
+        mOrigHash = CoverageHeaderReader::hashBuf(mFileContents.data(),
+            static_cast<size_t>(actual));
         }
     if(!status.ok())
         {
@@ -139,6 +143,7 @@ bool CppFileContents::write(OovStringRef const fn)
     SimpleFile file;
     eOpenStatus openStat = file.open(fn, M_WriteExclusiveTrunc, OE_Binary);
     OovStatus status(openStat == OS_Opened, SC_File);
+    std::vector<int> origLines = getOrigLines();
     if(status.ok())
         {
         OovString includeCov = "#include \"OovCoverage.h\"";
@@ -150,6 +155,15 @@ bool CppFileContents::write(OovStringRef const fn)
         {
         status = file.write(mFileContents.data(), mFileContents.size());
         }
+    if(status.ok())
+        {
+        File mapFile;
+        status = mapFile.open(CoverageHeaderReader::getLineMapFn(fn), "w");
+        for(size_t i=0; i<origLines.size() && status.ok(); i++)
+            {
+            status.set(fprintf(mapFile.getFp(), "%d\n", origLines[i]) > 0, SC_File);
+            }
+        }
     if(!status.ok())
         {
         OovString str = "Unable to write %s ";
@@ -181,6 +195,32 @@ void CppFileContents::updateMemory()
         }
     }
 
+std::vector<int> CppFileContents::getOrigLines() const
+    {
+    // The first line is the include of the coverage header, and it is
+    // followed by the first original line.
+    std::vector<int> origLines(2, 1);
+    int origLine = 1;
+    auto insertIter = mInsertMap.begin();
+    for(size_t offset=0; offset<mFileContents.size(); offset++)
+        {
+        // These are inserted the same way as updateMemory.
+        for( ; insertIter != mInsertMap.end() &&
+            static_cast<size_t>((*insertIter).first) <= offset; ++insertIter)
+            {
+            int numLines = static_cast<int>(std::count((*insertIter).second.begin(),
+                (*insertIter).second.end(), '\n'));
+            origLines.insert(origLines.end(), static_cast<size_t>(numLines), origLine);
+            }
+        if(mFileContents[offset] == '\n')
+            {
+            origLine++;
+            origLines.push_back(origLine);
+            }
+        }
+    return origLines;
+    }
+
 void CppFileContents::insert(OovStringRef const str, int origFileOffset)
     {
     mInsertMap.insert(std::pair<int, OovString>(origFileOffset, str));
@@ -249,14 +289,7 @@ OovString sFileDefine;
 
 static void setFileDefine(OovStringRef const fn, OovStringRef const srcRootDir)
     {
-    OovString relFn = Project::getSrcRootDirRelativeSrcFileName(fn, srcRootDir);
-    OovString fileDef = "COV_";
-    fileDef += relFn;
-    fileDef.replaceStrs("//", "_");
-    fileDef.replaceStrs("/", "_");
-    fileDef.replaceStrs(".", "_");
-    fileDef.replaceStrs(":", "");
-    sFileDefine = fileDef;
+    sFileDefine = CoverageHeaderReader::makeFileDefine(fn, srcRootDir);
     }
 
 static std::string getFileDefine()
@@ -264,21 +297,74 @@ static std::string getFileDefine()
     return sFileDefine;
     }
 
-void CppInstr::makeCovInstr(OovString &covStr)
+void CppInstr::makeCovInstr(OovString &covStr, int decision, bool insertedOutcome)
     {
     appendLineEnding(covStr);
-    covStr += "COV_IN(";
+    if(decision == NoDecision)
+        {
+        covStr += "COV_IN(";
+        }
+    else
+        {
+        covStr += insertedOutcome ? "COV_BO(" : "COV_BR(";
+        }
     covStr += getFileDefine();
     covStr += ", ";
     covStr.appendInt(mInstrCount++);
+    if(decision != NoDecision)
+        {
+        covStr += ", ";
+        covStr.appendInt(decision);
+        }
     covStr += ");";
     appendLineEnding(covStr);
     }
 
-void CppInstr::insertCovInstr(int offset)
+void CppInstr::insertCovInstr(int offset, int decision)
     {
     OovString covStr;
-    makeCovInstr(covStr);
+    makeCovInstr(covStr, decision);
+    insertOutputText(covStr, offset);
+    }
+
+/// Get the class and function name the same way as the C++ parser, so that
+/// the profile can be found from the model.
+static OovString getProfileName(CXCursor funcCursor)
+    {
+    CXCursor classCursor = clang_getCursorSemanticParent(funcCursor);
+    OovString className;
+    if(classCursor.kind == CXCursor_Namespace)
+        {
+        CXStringDisposer nsName(clang_getCursorSpelling(classCursor));
+        className = nsName;
+        }
+    else
+        {
+        CXType classType = clang_getCursorType(classCursor);
+        if(classType.kind != CXType_Invalid)
+            {
+            CXStringDisposer typeName(clang_getTypeSpelling(classType));
+            className = typeName;
+            }
+        }
+    CXStringDisposer funcName(clang_getCursorSpelling(funcCursor));
+    OovString name = OperationProfile::makeName(className, funcName);
+    name.replaceStrs("\"", "'");
+    return name;
+    }
+
+void CppInstr::insertFuncInstr(int offset, CXCursor funcCursor)
+    {
+    OovString covStr;
+    appendLineEnding(covStr);
+    covStr += "COV_FN(";
+    covStr += getFileDefine();
+    covStr += ", ";
+    covStr.appendInt(mInstrCount++);
+    covStr += ", \"";
+    covStr += getProfileName(funcCursor);
+    covStr += "\");";
+    appendLineEnding(covStr);
     insertOutputText(covStr, offset);
     }
 
@@ -352,7 +438,7 @@ void CppInstr::instrChildNonCompoundStatements(CXCursor cursor)
     }
 */
 
-void CppInstr::insertNonCompoundInstr(CXCursor cursor)
+void CppInstr::insertNonCompoundInstr(CXCursor cursor, int decision)
     {
     if(!clang_Cursor_isNull(cursor))
         {
@@ -384,7 +470,7 @@ void CppInstr::insertNonCompoundInstr(CXCursor cursor)
 #endif
                 SourceRange range(cursor);
                 OovString covStr;
-                makeCovInstr(covStr);
+                makeCovInstr(covStr, decision);
                 covStr.insert(0, "{");
                 insertOutputText(covStr, range.getStartLocation().getOffset());
                 insertOutputText("\n}\n", range.getEndLocation().getOffset()+1);
@@ -393,6 +479,120 @@ void CppInstr::insertNonCompoundInstr(CXCursor cursor)
         }
     }
 
+void CppInstr::insertBranchOutcome(CXCursor cursor, int decision)
+    {
+    if(!clang_Cursor_isNull(cursor))
+        {
+        if(clang_getCursorKind(cursor) == CXCursor_CompoundStmt)
+            {
+            // The compound statement is instrumented when it is visited.
+            mBranchOutcomes[SourceLocation(cursor).getOffset()] = decision;
+            }
+        else
+            {
+            insertNonCompoundInstr(cursor, decision);
+            }
+        }
+    }
+
+void CppInstr::insertCaseInstr(CXCursor cursor)
+    {
+    if(!clang_Cursor_isNull(cursor))
+        {
+        CXCursorKind cursKind = clang_getCursorKind(cursor);
+        if(mSwitchDecisions.size() > 0)
+            {
+            // A statement is inserted after the label so that labels that
+            // fall through to other labels are also instrumented.
+            insertCovInstr(SourceLocation(cursor).getOffset(),
+                mSwitchDecisions.back());
+            }
+        else if(cursKind != CXCursor_CaseStmt && cursKind != CXCursor_DefaultStmt)
+            {
+            insertNonCompoundInstr(cursor);
+            }
+        }
+    }
+
+void CppInstr::makeMissingElse(CXCursor cursor, int decision, OovString &text,
+        int &offset)
+    {
+    CXCursor thenCursor = getNthChildCursor(cursor, 1);
+    CXCursor elseCursor = getNthChildCursor(cursor, 2);
+    // Only compound statements are used since the end of other statements
+    // may also be the end of the enclosing statement.
+    if(clang_Cursor_isNull(elseCursor) &&
+        clang_getCursorKind(thenCursor) == CXCursor_CompoundStmt &&
+        getFirstNonCommentToken(thenCursor) == "{")
+        {
+        SourceRange range(thenCursor);
+        offset = range.getEndLocation().getOffset();
+        text = "else {";
+        makeCovInstr(text, decision, true);
+        text += "}";
+        }
+    }
+
+struct DefaultStmtVisitor
+    {
+    DefaultStmtVisitor():
+        mFound(false)
+        {}
+    bool mFound;
+    };
+
+static CXChildVisitResult findDefaultStmt(CXCursor cursor, CXCursor /*parent*/,
+        CXClientData client_data)
+    {
+    DefaultStmtVisitor *context = static_cast<DefaultStmtVisitor*>(client_data);
+    CXChildVisitResult res = CXChildVisit_Recurse;
+    CXCursorKind cursKind = clang_getCursorKind(cursor);
+    if(cursKind == CXCursor_DefaultStmt)
+        {
+        context->mFound = true;
+        res = CXChildVisit_Break;
+        }
+    else if(cursKind == CXCursor_SwitchStmt)
+        {
+        // The default labels of nested switch statements are not used.
+        res = CXChildVisit_Continue;
+        }
+    return res;
+    }
+
+static CXChildVisitResult findLastChild(CXCursor cursor, CXCursor /*parent*/,
+        CXClientData client_data)
+    {
+    *static_cast<CXCursor*>(client_data) = cursor;
+    return CXChildVisit_Continue;
+    }
+
+void CppInstr::makeMissingDefault(CXCursor cursor, int decision, OovString &text,
+        int &offset)
+    {
+    // The body is the last child of the switch statement.
+    CXCursor body = clang_getNullCursor();
+    clang_visitChildren(cursor, findLastChild, &body);
+    if(clang_getCursorKind(body) == CXCursor_CompoundStmt &&
+        getFirstNonCommentToken(body) == "{")
+        {
+        DefaultStmtVisitor visitor;
+        clang_visitChildren(body, findDefaultStmt, &visitor);
+        if(!visitor.mFound)
+            {
+            // The default is inserted before the closing brace.  The break
+            // prevents the last case from falling through to the default.
+            SourceRange range(body);
+            offset = range.getEndLocation().getOffset() - 1;
+            appendLineEnding(text);
+            text += "break;";
+            appendLineEnding(text);
+            text += "default:";
+            makeCovInstr(text, decision, true);
+            }
+        }
+    }
+
 
 // Finds variable declarations inside function bodies.
 CXChildVisitResult CppInstr::visitFunctionAddInstr(CXCursor cursor, CXCursor parent)
@@ -406,6 +606,11 @@ CXChildVisitResult CppInstr::visitFunctionAddInstr(CXCursor cursor, CXCursor par
 
     sCrashDiagnostics.saveMostRecentParseLocation("FV", cursor);
     CXCursorKind cursKind = clang_getCursorKind(cursor);
+    // Text that is inserted after the children are instrumented, so that
+    // it is after any text inserted by the children at the same offset.
+    OovString postChildText;
+    int postChildOffset = 0;
+    bool switchDecision = false;
     switch(cursKind)
         {
         case CXCursor_DoStmt:
@@ -436,40 +641,61 @@ CXChildVisitResult CppInstr::visitFunctionAddInstr(CXCursor cursor, CXCursor par
                 }
             break;
 
+        case CXCursor_SwitchStmt:
+            // Each case label and the default label are outcomes of the decision.
+            if(isParseFile(cursor))
+                {
+                int decision = mDecisionCount++;
+                mSwitchDecisions.push_back(decision);
+                switchDecision = true;
+                makeMissingDefault(cursor, decision, postChildText, postChildOffset);
+                }
+            break;
+
         case CXCursor_CaseStmt:
             if(isParseFile(cursor))
                 {
-                CXCursor childCursor = getNthChildCursor(cursor, 1);
-                CXCursorKind childCursKind = clang_getCursorKind(childCursor);
-                if(childCursKind != CXCursor_CaseStmt && childCursKind != CXCursor_DefaultStmt)
-                    {
-                    insertNonCompoundInstr(childCursor);
-                    }
+                insertCaseInstr(getNthChildCursor(cursor, 1));
                 }
             break;
 
         case CXCursor_DefaultStmt:
             if(isParseFile(cursor))
                 {
-                CXCursor childCursor = getNthChildCursor(cursor, 0);
-                CXCursorKind childCursKind = clang_getCursorKind(childCursor);
-                if(childCursKind != CXCursor_CaseStmt && childCursKind != CXCursor_DefaultStmt)
-                    {
-                    insertNonCompoundInstr(childCursor);
-                    }
+                insertCaseInstr(getNthChildCursor(cursor, 0));
                 }
             break;
 
         case CXCursor_IfStmt:
             // An if statement has up to 3 children, test expr, if body, else body
             // The else body can be an if statement.
+            // The bodies of an if and its else if statements are all outcomes
+            // of one decision.
             if(isParseFile(cursor))
                 {
-                insertNonCompoundInstr(getNthChildCursor(cursor, 1));
+                int decision;
+                auto const &outcomeIter = mBranchOutcomes.find(
+                    SourceLocation(cursor).getOffset());
+                if(outcomeIter != mBranchOutcomes.end())
+                    {
+                    decision = (*outcomeIter).second;
+                    }
+                else
+                    {
+                    decision = mDecisionCount++;
+                    }
+                insertBranchOutcome(getNthChildCursor(cursor, 1), decision);
                 CXCursor childCursor = getNthChildCursor(cursor, 2);
                 CXCursorKind childCursKind = clang_getCursorKind(childCursor);
-                if(childCursKind != CXCursor_IfStmt)
-                    insertNonCompoundInstr(childCursor);
+                if(childCursKind == CXCursor_IfStmt)
+                    {
+                    mBranchOutcomes[SourceLocation(childCursor).getOffset()] = decision;
+                    }
+                else
+                    {
+                    insertBranchOutcome(childCursor, decision);
+                    }
+                makeMissingElse(cursor, decision, postChildText, postChildOffset);
                 }
             break;
 
@@ -493,14 +719,30 @@ CXChildVisitResult CppInstr::visitFunctionAddInstr(CXCursor cursor, CXCursor par
 #if(DEBUG_PARSE)
                         debugInstr(cursor, "insertCS", mInstrCount);
 #endif
-                        insertCovInstr(loc.getOffset()+1);
+                        int decision = NoDecision;
+                        auto const &outcomeIter = mBranchOutcomes.find(loc.getOffset());
+                        if(outcomeIter != mBranchOutcomes.end())
+                            {
+                            decision = (*outcomeIter).second;
+                            }
+                        if(parentKind == CXCursor_CXXMethod ||
+                            parentKind == CXCursor_FunctionDecl ||
+                            parentKind == CXCursor_Constructor ||
+                            parentKind == CXCursor_Destructor ||
+                            parentKind == CXCursor_ConversionFunction)
+                            {
+                            insertFuncInstr(loc.getOffset()+1, parent);
+                            }
+                        else
+                            {
+                            insertCovInstr(loc.getOffset()+1, decision);
+                            }
                         }
                     }
                 }
             }
             break;
 
-        // case CXCursor_SwitchStmt
         // case CXCursor_StmtExpr
         // case CXCursor_FirstStmt
         // case CXCursor_LabelStmt
@@ -521,6 +763,14 @@ CXChildVisitResult CppInstr::visitFunctionAddInstr(CXCursor cursor, CXCursor par
         {
         clang_visitChildren(cursor, ::visitFunctionAddInstr, this);
         }
+    if(postChildText.length() > 0)
+        {
+        insertOutputText(postChildText, postChildOffset);
+        }
+    if(switchDecision)
+        {
+        mSwitchDecisions.pop_back();
+        }
 //    return CXChildVisit_Recurse;
 #if(DEBUG_DUMP_CURSORS)
     level--;
@@ -561,18 +811,25 @@ class CoverageHeader:public CoverageHeaderReader
         /// a base define for each file that is used to index into the
         /// coverage array that is used for the hit counts for each instrumented
         /// line.
-        void update(OovStringRef const outMapFn, OovStringRef const srcFn,
-                int numInstrLines);
+        /// @param hitOnce True to make probes that only set a flag.
+        /// @param hash The hash that identifies how the file was instrumented.
+        void update(OovStringRef const outDefFn, int numInstrLines,
+                bool hitOnce, uint64_t hash);
 
     private:
+        /// Sets the location of the counts for the file. A changed file is
+        /// added at the end so that the indices for other files don't change.
+        /// @return true if the unused entries were removed, which changes the
+        ///     indices of other files.
+        bool addFile(OovString const &fnDef, int numInstrLines, uint64_t hash);
+        /// Makes a new signature that is different from previous signatures.
+        void makeSignature();
         /// Writes the instr def map to the file
-        /// @todo - srcFn isn't used.
-        void write(SharedFile &outDefFile, OovStringRef const srcFn,
-                int numInstrLines);
+        void write(SharedFile &outDefFile);
     };
 
-void CoverageHeader::update(OovStringRef const outDefFn, OovStringRef const srcFn,
-        int numInstrLines)
+void CoverageHeader::update(OovStringRef const outDefFn, int numInstrLines,
+        bool hitOnce, uint64_t hash)
     {
     SharedFile outDefFile;
     eOpenStatus stat = outDefFile.open(outDefFn, M_ReadWriteExclusive, OE_Binary);
@@ -581,7 +838,19 @@ void CoverageHeader::update(OovStringRef const outDefFn, OovStringRef const srcF
         OovStatus status = read(outDefFile);
         if(status.ok())
             {
-            write(outDefFile, srcFn, numInstrLines);
+            // The counts from the different modes cannot be added together.
+            bool newLayout = (mSignature == 0 || mHitOnce != hitOnce);
+            // The mode is for the whole project, so the latest mode is used.
+            mHitOnce = hitOnce;
+            if(addFile(getFileDefine(), numInstrLines, hash))
+                {
+                newLayout = true;
+                }
+            if(newLayout)
+                {
+                makeSignature();
+                }
+            write(outDefFile);
             }
         if(status.needReport())
             {
@@ -590,46 +859,185 @@ void CoverageHeader::update(OovStringRef const outDefFn, OovStringRef const srcF
         }
     }
 
-void CoverageHeader::write(SharedFile &outDefFile, OovStringRef const /*srcFn*/,
-        int numInstrLines)
+bool CoverageHeader::addFile(OovString const &fnDef, int numInstrLines,
+        uint64_t hash)
     {
-    std::string fnDef = getFileDefine();
-    mInstrDefineMap[fnDef] = numInstrLines;
+    auto const &iter = mInstrDefineMap.find(fnDef);
+    if(iter == mInstrDefineMap.end() || (*iter).second.mHash != hash ||
+        (*iter).second.mCount != numInstrLines)
+        {
+        mInstrDefineMap[fnDef] = FileDefine(mNumInstrumentedLines, numInstrLines,
+            hash);
+        mNumInstrumentedLines += numInstrLines;
+        }
 
-    int totalCount = 0;
+    int liveCount = 0;
     for(auto const &defItem : mInstrDefineMap)
         {
-        totalCount += defItem.second;
+        liveCount += defItem.second.mCount;
         }
+    // Once more than half of the array is unused, the files are packed
+    // together again, and the accumulated counts can't be used.
+    bool compact = (mNumInstrumentedLines - liveCount > liveCount);
+    if(compact)
+        {
+        int base = 0;
+        for(auto &defItem : mInstrDefineMap)
+            {
+            defItem.second.mBase = base;
+            base += defItem.second.mCount;
+            }
+        mNumInstrumentedLines = base;
+        }
+    return compact;
+    }
+
+void CoverageHeader::makeSignature()
+    {
+    uint64_t sig = mSignature;
+    long long now = std::chrono::high_resolution_clock::now().
+        time_since_epoch().count();
+    sig = hashBuf(&sig, sizeof(sig));
+    mSignature = hashBuf(&now, sizeof(now), sig);
+    }
+
+void CoverageHeader::write(SharedFile &outDefFile)
+    {
+    int totalCount = mNumInstrumentedLines;
 
     if(outDefFile.isOpen())
         {
         OovString buf;
+        static char const *hitOnceLines[] =
+            {
+            "// Automatically generated file by OovCovInstr\n",
+            "// This file should not normally be edited manually.\n",
+            "// Each probe is a flag that is only set the first time that it runs,\n",
+            "// so threads do not need separate counters.\n",
+            "#define COV_HIT_ONCE 1\n",
+            "#undef COV_THREADED\n",
+            "#undef COV_COUNTER_TYPE\n",
+            "#define COV_COUNTER_TYPE unsigned char\n",
+            "#define COV_COUNTER_MAX 1\n",
+            "#define COV_IN(fileIndex, instrIndex) do { \\\n",
+            "  if(!gCoverage[fileIndex+instrIndex]) \\\n",
+            "    gCoverage[fileIndex+instrIndex] = 1; } while(0)\n",
+            };
         static char const *lines[] =
             {
             "// Automatically generated file by OovCovInstr\n",
             "// This file should not normally be edited manually.\n",
-            "#define COV_IN(fileIndex, instrIndex) gCoverage[fileIndex+instrIndex]++;\n",
+            "// Define COV_COUNTER_TYPE in the build to change the counter size.\n",
+            "// Define COV_THREADED to count in a separate block for each thread.\n",
+            "#ifndef COV_COUNTER_TYPE\n",
+            "#define COV_COUNTER_TYPE unsigned int\n",
+            "#endif\n",
+            "// Counters stop at the maximum value instead of wrapping to zero.\n",
+            "#define COV_COUNTER_MAX ((COV_COUNTER_TYPE)~(COV_COUNTER_TYPE)0)\n",
+            "#ifdef COV_THREADED\n",
+            "extern thread_local COV_COUNTER_TYPE *gCoverageShard;\n",
+            "COV_COUNTER_TYPE *OovCoverageAllocShard();\n",
+            "#define COV_IN(fileIndex, instrIndex) do { \\\n",
+            "  COV_COUNTER_TYPE *covShard = gCoverageShard ? gCoverageShard : OovCoverageAllocShard(); \\\n",
+            "  if(covShard[fileIndex+instrIndex] != COV_COUNTER_MAX) \\\n",
+            "    covShard[fileIndex+instrIndex]++; } while(0)\n",
+            "#else\n",
+            "#define COV_IN(fileIndex, instrIndex) do { \\\n",
+            "  if(gCoverage[fileIndex+instrIndex] != COV_COUNTER_MAX) \\\n",
+            "    gCoverage[fileIndex+instrIndex]++; } while(0)\n",
+            "#endif\n",
             };
-        for(size_t i=0; i<sizeof(lines)/sizeof(lines[0]); i++)
+        if(mHitOnce)
+            {
+            for(size_t i=0; i<sizeof(hitOnceLines)/sizeof(hitOnceLines[0]); i++)
+                {
+                buf += hitOnceLines[i];
+                }
+            }
+        else
             {
-            buf += lines[i];
+            for(size_t i=0; i<sizeof(lines)/sizeof(lines[0]); i++)
+                {
+                buf += lines[i];
+                }
             }
+        // The decision index is only used when reporting decision coverage.
+        buf += "#define COV_BR(fileIndex, instrIndex, decision) COV_IN(fileIndex, instrIndex)\n";
+        // An inserted else or default has no source line, so it is only
+        // reported as a decision outcome.
+        buf += "#define COV_BO(fileIndex, instrIndex, decision) COV_IN(fileIndex, instrIndex)\n";
         buf += "#define COV_TOTAL_INSTRS ";
         buf.appendInt(totalCount);
         buf += "\n";
-        buf += "extern unsigned short gCoverage[COV_TOTAL_INSTRS];\n";
+        char sigBuf[40];
+        snprintf(sigBuf, sizeof(sigBuf), "0x%016llxULL",
+            static_cast<unsigned long long>(getSignature()));
+        buf += "#define COV_SIGNATURE ";
+        buf += sigBuf;
+        buf += "\n";
+        buf += "extern COV_COUNTER_TYPE gCoverage[COV_TOTAL_INSTRS];\n";
+        static char const *profileLines[] =
+            {
+            "// Define COV_PROFILE to measure the calls and time of each function.\n",
+            "#ifdef COV_PROFILE\n",
+            "#if defined(_M_IX86) || defined(_M_X64)\n",
+            "#include <intrin.h>\n",
+            "#define COV_PROFILE_TICKS() __rdtsc()\n",
+            "#elif defined(__i386__) || defined(__x86_64__)\n",
+            "#include <x86intrin.h>\n",
+            "#define COV_PROFILE_TICKS() __rdtsc()\n",
+            "#else\n",
+            "#include <chrono>\n",
+            "#define COV_PROFILE_TICKS() (unsigned long long) \\\n",
+            "  std::chrono::steady_clock::now().time_since_epoch().count()\n",
+            "#endif\n",
+            "struct OovProfileRecord\n",
+            "  {\n",
+            "  unsigned long long mCalls;\n",
+            "  unsigned long long mTicks;\n",
+            "  };\n",
+            "extern thread_local OovProfileRecord *gProfileShard;\n",
+            "OovProfileRecord *OovProfileAllocShard();\n",
+            "// The time is recorded when the function returns or throws.\n",
+            "class OovProfileScope\n",
+            "  {\n",
+            "  public:\n",
+            "  OovProfileScope(int index):\n",
+            "    mIndex(index), mStart(COV_PROFILE_TICKS())\n",
+            "    {}\n",
+            "  ~OovProfileScope()\n",
+            "    {\n",
+            "    OovProfileRecord *shard = gProfileShard ? gProfileShard : OovProfileAllocShard();\n",
+            "    shard[mIndex].mCalls++;\n",
+            "    shard[mIndex].mTicks += COV_PROFILE_TICKS() - mStart;\n",
+            "    }\n",
+            "  private:\n",
+            "  int mIndex;\n",
+            "  unsigned long long mStart;\n",
+            "  };\n",
+            "#define COV_FN(fileIndex, instrIndex, name) COV_IN(fileIndex, instrIndex); \\\n",
+            "  OovProfileScope covProfileScope(fileIndex+instrIndex)\n",
+            "#else\n",
+            "#define COV_FN(fileIndex, instrIndex, name) COV_IN(fileIndex, instrIndex)\n",
+            "#endif\n",
+            };
+        for(size_t i=0; i<sizeof(profileLines)/sizeof(profileLines[0]); i++)
+            {
+            buf += profileLines[i];
+            }
 
-        int coverageCount = 0;
         for(auto const &defItem : mInstrDefineMap)
             {
             OovString def = "#define ";
             def += defItem.first;
             def += " ";
-            def.appendInt(coverageCount);
-            coverageCount += defItem.second;
+            def.appendInt(defItem.second.mBase);
             def += " // ";
-            def.appendInt(defItem.second);
+            def.appendInt(defItem.second.mCount);
+            char hashStr[20];
+            snprintf(hashStr, sizeof(hashStr), " %016llx",
+                static_cast<unsigned long long>(defItem.second.mHash));
+            def += hashStr;
             def += "\n";
             buf += def;
             }
@@ -646,11 +1054,11 @@ void CoverageHeader::write(SharedFile &outDefFile, OovStringRef const /*srcFn*/,
         }
     }
 
-void CppInstr::updateCoverageHeader(OovStringRef const fn, OovStringRef const covDir,
-        int numInstrLines)
+void CppInstr::updateCoverageHeader(OovStringRef const covDir, int numInstrLines,
+        bool hitOnce, uint64_t hash)
     {
     CoverageHeader header;
-    header.update(header.getFn(covDir), fn, numInstrLines);
+    header.update(header.getFn(covDir), numInstrLines, hitOnce, hash);
     }
 
 // This is for updating coverage information.  An alternative is to create a
@@ -705,95 +1113,335 @@ void CppInstr::updateCoverageSource(OovStringRef const /*fn*/, OovStringRef cons
         {
         outFn.appendFile("OovCoverage.cpp");
 
-            if(!FileIsFileOnDisk(outFn, status))
+        static char const *lines[] = {
+            "// Automatically generated file by OovCovInstr\n",
+            "// This adds the coverage counts to either a new or existing counts file.\n"
+            "// The existing counts are cleared if the instrumentation has changed.\n"
+            "// This file must be compiled and linked into the project.\n",
+            "#include <string.h>\n",
+            "#include \"OovCoverage.h\"\n",
+            "#ifdef _WIN32\n",
+            "#include <windows.h>\n",
+            "#else\n",
+            "#include <fcntl.h>\n",
+            "#include <sys/file.h>\n",
+            "#include <sys/mman.h>\n",
+            "#include <sys/stat.h>\n",
+            "#include <unistd.h>\n",
+            "#endif\n",
+            "\n",
+            "COV_COUNTER_TYPE gCoverage[COV_TOTAL_INSTRS];\n",
+            "\n",
+            "#ifdef COV_THREADED\n",
+            "#include <mutex>\n",
+            "#include <vector>\n",
+            "\n",
+            "thread_local COV_COUNTER_TYPE *gCoverageShard;\n",
+            "\n",
+            "static COV_COUNTER_TYPE covAdd(COV_COUNTER_TYPE count, COV_COUNTER_TYPE val)\n",
+            "  {\n",
+            "  if(val > (COV_COUNTER_TYPE)(COV_COUNTER_MAX - count))\n",
+            "    return COV_COUNTER_MAX;\n",
+            "  return (COV_COUNTER_TYPE)(count + val);\n",
+            "  }\n",
+            "\n",
+            "// Each thread counts in its own block of counters so that the threads\n",
+            "// do not write to the same cache lines.  The blocks are added to\n",
+            "// gCoverage when the counts are written.  The blocks are never freed\n",
+            "// since threads may still be running while the program exits.\n",
+            "class cCoverageShards\n",
+            "  {\n",
+            "  public:\n",
+            "  COV_COUNTER_TYPE *alloc()\n",
+            "    {\n",
+            "    COV_COUNTER_TYPE *shard = new COV_COUNTER_TYPE[COV_TOTAL_INSTRS]();\n",
+            "    std::lock_guard<std::mutex> lock(mMutex);\n",
+            "    mShards.push_back(shard);\n",
+            "    return shard;\n",
+            "    }\n",
+            "  void merge()\n",
+            "    {\n",
+            "    std::lock_guard<std::mutex> lock(mMutex);\n",
+            "    for(size_t shardI=0; shardI<mShards.size(); shardI++)\n",
+            "      {\n",
+            "      COV_COUNTER_TYPE *shard = mShards[shardI];\n",
+            "      for(int i=0; i<COV_TOTAL_INSTRS; i++)\n",
+            "        {\n",
+            "        gCoverage[i] = covAdd(gCoverage[i], shard[i]);\n",
+            "        shard[i] = 0;\n",
+            "        }\n",
+            "      }\n",
+            "    }\n",
+            "\n",
+            "  private:\n",
+            "  std::mutex mMutex;\n",
+            "  std::vector<COV_COUNTER_TYPE *> mShards;\n",
+            "  };\n",
+            "\n",
+            "static cCoverageShards sCoverageShards;\n",
+            "\n",
+            "COV_COUNTER_TYPE *OovCoverageAllocShard()\n",
+            "  {\n",
+            "  gCoverageShard = sCoverageShards.alloc();\n",
+            "  return gCoverageShard;\n",
+            "  }\n",
+            "#endif\n",
+            "\n",
+            "#ifdef COV_PROFILE\n",
+            "#include <mutex>\n",
+            "#include <vector>\n",
+            "\n",
+            "thread_local OovProfileRecord *gProfileShard;\n",
+            "\n",
+            "// Each thread records the functions in its own block of records.  The\n",
+            "// blocks are added to the profile file when the counts are written.\n",
+            "class cProfileShards\n",
+            "  {\n",
+            "  public:\n",
+            "  OovProfileRecord *alloc()\n",
+            "    {\n",
+            "    OovProfileRecord *shard = new OovProfileRecord[COV_TOTAL_INSTRS]();\n",
+            "    std::lock_guard<std::mutex> lock(mMutex);\n",
+            "    mShards.push_back(shard);\n",
+            "    return shard;\n",
+            "    }\n",
+            "  void merge(OovProfileRecord *records)\n",
+            "    {\n",
+            "    std::lock_guard<std::mutex> lock(mMutex);\n",
+            "    for(size_t shardI=0; shardI<mShards.size(); shardI++)\n",
+            "      {\n",
+            "      OovProfileRecord *shard = mShards[shardI];\n",
+            "      for(int i=0; i<COV_TOTAL_INSTRS; i++)\n",
+            "        {\n",
+            "        records[i].mCalls += shard[i].mCalls;\n",
+            "        records[i].mTicks += shard[i].mTicks;\n",
+            "        shard[i].mCalls = 0;\n",
+            "        shard[i].mTicks = 0;\n",
+            "        }\n",
+            "      }\n",
+            "    }\n",
+            "\n",
+            "  private:\n",
+            "  std::mutex mMutex;\n",
+            "  std::vector<OovProfileRecord *> mShards;\n",
+            "  };\n",
+            "\n",
+            "static cProfileShards sProfileShards;\n",
+            "\n",
+            "OovProfileRecord *OovProfileAllocShard()\n",
+            "  {\n",
+            "  gProfileShard = sProfileShards.alloc();\n",
+            "  return gProfileShard;\n",
+            "  }\n",
+            "#endif\n",
+            "\n",
+            "// The counts file is a header followed by one 64 bit count for each\n",
+            "// instrumented line.  The file is locked while it is mapped so that\n",
+            "// multiple processes can add their counts at the same time.\n",
+            "struct cCoverageFileHeader\n",
+            "  {\n",
+            "  char mMagic[8];\n",
+            "  unsigned long long mSignature;\n",
+            "  unsigned long long mNumInstrs;\n",
+            "  };\n",
+            "\n",
+            "static char const sCoverageMagic[8] = \"OovCov1\";\n",
+            "static char const sProfileMagic[8] = \"OovPrf1\";\n",
+            "\n",
+            "class cCoverageFile\n",
+            "  {\n",
+            "  public:\n",
+            "#ifdef _WIN32\n",
+            "  cCoverageFile():\n",
+            "    mFile(INVALID_HANDLE_VALUE), mMap(0), mData(0)\n",
+            "    {}\n",
+            "#else\n",
+            "  cCoverageFile():\n",
+            "    mFd(-1), mData(0), mSize(0)\n",
+            "    {}\n",
+            "#endif\n",
+            "  ~cCoverageFile()\n",
+            "    { close(); }\n",
+            "  // Returns null if the file could not be mapped.\n",
+            "  cCoverageFileHeader *open(char const *fn, size_t size)\n",
+            "    {\n",
+            "#ifdef _WIN32\n",
+            "    mFile = CreateFileA(fn, GENERIC_READ | GENERIC_WRITE,\n",
+            "      FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);\n",
+            "    if(mFile != INVALID_HANDLE_VALUE)\n",
+            "      {\n",
+            "      OVERLAPPED overlapped = {};\n",
+            "      LockFileEx(mFile, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped);\n",
+            "      // This extends the file if it is too small.\n",
+            "      mMap = CreateFileMappingA(mFile, 0, PAGE_READWRITE, 0, (DWORD)size, 0);\n",
+            "      if(mMap)\n",
+            "        mData = MapViewOfFile(mMap, FILE_MAP_ALL_ACCESS, 0, 0, size);\n",
+            "      }\n",
+            "#else\n",
+            "    mFd = ::open(fn, O_RDWR | O_CREAT, 0644);\n",
+            "    if(mFd != -1)\n",
+            "      {\n",
+            "      struct stat fileStat;\n",
+            "      flock(mFd, LOCK_EX);\n",
+            "      if(fstat(mFd, &fileStat) == 0 &&\n",
+            "        ((size_t)fileStat.st_size >= size || ftruncate(mFd, (off_t)size) == 0))\n",
+            "        {\n",
+            "        void *data = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);\n",
+            "        if(data != MAP_FAILED)\n",
+            "          {\n",
+            "          mData = data;\n",
+            "          mSize = size;\n",
+            "          }\n",
+            "        }\n",
+            "      }\n",
+            "#endif\n",
+            "    return (cCoverageFileHeader *)mData;\n",
+            "    }\n",
+            "  void close()\n",
+            "    {\n",
+            "#ifdef _WIN32\n",
+            "    if(mData)\n",
+            "      UnmapViewOfFile(mData);\n",
+            "    if(mMap)\n",
+            "      CloseHandle(mMap);\n",
+            "    if(mFile != INVALID_HANDLE_VALUE)\n",
+            "      {\n",
+            "      OVERLAPPED overlapped = {};\n",
+            "      UnlockFileEx(mFile, 0, MAXDWORD, MAXDWORD, &overlapped);\n",
+            "      CloseHandle(mFile);\n",
+            "      }\n",
+            "    mFile = INVALID_HANDLE_VALUE;\n",
+            "    mMap = 0;\n",
+            "#else\n",
+            "    if(mData)\n",
+            "      munmap(mData, mSize);\n",
+            "    if(mFd != -1)\n",
+            "      {\n",
+            "      flock(mFd, LOCK_UN);\n",
+            "      ::close(mFd);\n",
+            "      }\n",
+            "    mFd = -1;\n",
+            "#endif\n",
+            "    mData = 0;\n",
+            "    }\n",
+            "\n",
+            "  private:\n",
+            "#ifdef _WIN32\n",
+            "  HANDLE mFile;\n",
+            "  HANDLE mMap;\n",
+            "  void *mData;\n",
+            "#else\n",
+            "  int mFd;\n",
+            "  void *mData;\n",
+            "  size_t mSize;\n",
+            "#endif\n",
+            "  };\n",
+            "\n",
+            "class cCoverageOutput\n",
+            "  {\n",
+            "  public:\n",
+            "  cCoverageOutput()\n",
+            "    {\n",
+            "    // Initialize because some compilers may not initialize statics (TI)\n",
+            "    for(int i=0; i<COV_TOTAL_INSTRS; i++)\n",
+            "      gCoverage[i] = 0;\n",
+            "    }\n",
+            "  ~cCoverageOutput()\n",
+            "    {\n",
+            "      update();\n",
+            "    }\n",
+            "  void update()\n",
+            "    {\n",
+            "#ifdef COV_THREADED\n",
+            "    sCoverageShards.merge();\n",
+            "#endif\n",
+            "    write();\n",
+            "    }\n",
+            "\n",
+            "  private:\n",
+            "  void write()\n",
+            "    {\n",
+            "    cCoverageFile file;\n",
+            "    cCoverageFileHeader *header = open(file, \"OovCoverageCounts.bin\",\n",
+            "      sCoverageMagic, sizeof(unsigned long long));\n",
+            "    if(header)\n",
+            "      {\n",
+            "      unsigned long long *counts = (unsigned long long *)(header + 1);\n",
+            "      for(int i=0; i<COV_TOTAL_INSTRS; i++)\n",
+            "        {\n",
+            "        unsigned long long count = counts[i] + gCoverage[i];\n",
+            "        counts[i] = (count < counts[i]) ? ~0ULL : count;\n",
+            "        gCoverage[i] = 0;\n",
+            "        }\n",
+            "      }\n",
+            "#ifdef COV_PROFILE\n",
+            "    cCoverageFile profileFile;\n",
+            "    header = open(profileFile, \"OovProfile.bin\", sProfileMagic,\n",
+            "      sizeof(OovProfileRecord));\n",
+            "    if(header)\n",
+            "      sProfileShards.merge((OovProfileRecord *)(header + 1));\n",
+            "#endif\n",
+            "    }\n",
+            "  // Opens a file that has a record for each instrumented line.  The\n",
+            "  // records are cleared if they are for a different layout, and the\n",
+            "  // records for files that changed since the last run are cleared.\n",
+            "  cCoverageFileHeader *open(cCoverageFile &file, char const *fn,\n",
+            "    char const *magic, size_t recordSize)\n",
+            "    {\n",
+            "    cCoverageFileHeader *header = file.open(fn,\n",
+            "      sizeof(cCoverageFileHeader) + COV_TOTAL_INSTRS * recordSize);\n",
+            "    if(header)\n",
+            "      {\n",
+            "      if(memcmp(header->mMagic, magic, sizeof(header->mMagic)) != 0 ||\n",
+            "        header->mSignature != COV_SIGNATURE || header->mNumInstrs > COV_TOTAL_INSTRS)\n",
+            "        {\n",
+            "        memcpy(header->mMagic, magic, sizeof(header->mMagic));\n",
+            "        header->mSignature = COV_SIGNATURE;\n",
+            "        header->mNumInstrs = 0;\n",
+            "        }\n",
+            "      // Files that changed since the last run are added at the end.\n",
+            "      if(header->mNumInstrs < COV_TOTAL_INSTRS)\n",
+            "        {\n",
+            "        memset((char *)(header + 1) + header->mNumInstrs * recordSize, 0,\n",
+            "          (COV_TOTAL_INSTRS - header->mNumInstrs) * recordSize);\n",
+            "        header->mNumInstrs = COV_TOTAL_INSTRS;\n",
+            "        }\n",
+            "      }\n",
+            "    return header;\n",
+            "    }\n",
+            "  };\n",
+            "\n",
+            "cCoverageOutput coverageOutput;\n"
+            "\n",
+            "void updateCoverage()\n",
+            "  { coverageOutput.update(); }\n"
+            };
+        OovString newSource;
+        for(size_t i=0; i<sizeof(lines)/sizeof(lines[0]); i++)
+            {
+            newSource += lines[i];
+            }
+
+        // The source is only written if it changed so that the coverage
+        // library is not rebuilt for every instrumented file.
+        OovString oldSource;
+        if(FileIsFileOnDisk(outFn, status))
+            {
+            File oldFile;
+            status = oldFile.open(outFn, "r");
+            char buf[1000];
+            while(status.ok() && oldFile.getString(buf, sizeof(buf), status))
+                {
+                oldSource += buf;
+                }
+            }
+        if(status.ok() && oldSource != newSource)
             {
             File file;
             status = file.open(outFn, "w");
-
-                static char const *lines[] = {
-                "// Automatically generated file by OovCovInstr\n",
-                "// This appends coverage data to either a new or existing file,\n"
-                "// although the number of instrumented lines in the project must match.\n"
-                "// This file must be compiled and linked into the project.\n",
-                "#include <stdio.h>\n",
-                "#include \"OovCoverage.h\"\n",
-                "\n",
-                "unsigned short gCoverage[COV_TOTAL_INSTRS];\n",
-                "\n",
-                "class cCoverageOutput\n",
-                "  {\n",
-                "  public:\n",
-                "  cCoverageOutput()\n",
-                "    {\n",
-                "    // Initialize because some compilers may not initialize statics (TI)\n",
-                "    for(int i=0; i<COV_TOTAL_INSTRS; i++)\n",
-                "      gCoverage[i] = 0;\n",
-                "    }\n",
-                "  ~cCoverageOutput()\n",
-                "    {\n",
-                "      update();\n",
-                "    }\n",
-                "  void update()\n",
-                "    {\n",
-                "    read();\n",
-                "    write();\n",
-                "    }\n",
-                "\n",
-                "  private:\n",
-                "  int getFirstIntFromLine(FILE *fp)\n",
-                "    {\n",
-                "   char buf[80];\n",
-                "   fgets(buf, sizeof(buf), fp);\n",
-                "   unsigned int tempInt = 0;\n",
-                "           sscanf(buf, \"%u\", &tempInt);\n",
-                "   return tempInt;\n",
-                "    }\n",
-                "  void read()\n",
-                "    {\n",
-                "    FILE *fp = fopen(\"OovCoverageCounts.txt\", \"r\");\n",
-                "    if(fp)\n",
-                "      {\n",
-                "      int numInstrs = getFirstIntFromLine(fp);\n",
-                "      if(numInstrs == COV_TOTAL_INSTRS)\n",
-                "        {\n",
-                "        for(int i=0; i<COV_TOTAL_INSTRS; i++)\n",
-                "          {\n",
-                "          gCoverage[i] += getFirstIntFromLine(fp);\n",
-                "          }\n",
-                "        }\n",
-                "      fclose(fp);\n",
-                "      }\n",
-                "    }\n",
-                "  void write()\n",
-                "    {\n",
-                "    FILE *fp = fopen(\"OovCoverageCounts.txt\", \"w\");\n",
-                "    if(fp)\n",
-                "      {\n",
-                "      fprintf(fp, \"%d   # Number of instrumented lines\\n\", COV_TOTAL_INSTRS);\n",
-                "      for(int i=0; i<COV_TOTAL_INSTRS; i++)\n",
-                "        {\n",
-                "        fprintf(fp, \"%u\", gCoverage[i]);\n",
-                "        gCoverage[i] = 0;\n",
-                "        fprintf(fp, \"\\n\");\n",
-                "        }\n",
-                "      fclose(fp);\n",
-                "      }\n",
-                "    }\n",
-                "  };\n",
-                "\n",
-                "cCoverageOutput coverageOutput;\n"
-                "\n",
-                "void updateCoverage()\n",
-                "  { coverageOutput.update(); }\n"
-
-                };
-            for(size_t i=0; i<sizeof(lines)/sizeof(lines[0]) && status.ok(); i++)
+            if(status.ok())
                 {
-                status = file.putString(lines[i]);
-                if(!status.ok())
-                    {
-                    break;
-                    }
+                status = file.putString(newSource);
                 }
             }
         }
@@ -815,8 +1463,10 @@ CppInstr::eErrorTypes CppInstr::parse(OovStringRef const srcFn, OovStringRef con
     mTopParseFn.setPath(srcFn, FP_File);
     FilePath rootDir(srcRootDir, FP_Dir);
     setFileDefine(mTopParseFn, rootDir);
+    sCrashDiagnostics = CrashDiagnostics();
 
-    CXIndex index = clang_createIndex(1, 1);
+    // The index is shared by all files that are parsed by this process.
+    static CXIndex index = clang_createIndex(1, 1);
 
 // This doesn't appear to change anything.
 //    clang_toggleCrashRecovery(true);
@@ -898,8 +1548,10 @@ CppInstr::eErrorTypes CppInstr::parse(OovStringRef const srcFn, OovStringRef con
             unlink(outErrFileName.c_str());
             }
         FilePath covDir(outDir, FP_Dir);
-        updateCoverageHeader(mTopParseFn, covDir, mInstrCount);
+        updateCoverageHeader(covDir, mInstrCount, mHitOnce,
+            (mInstrHash != 0) ? mInstrHash : mOutputFileContents.getOrigHash());
         updateCoverageSource(mTopParseFn, covDir);
+        clang_disposeTranslationUnit(tu);
         }
     else
         {
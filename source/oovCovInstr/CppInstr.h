@@ -10,6 +10,8 @@
 
 #include <map>
 #include <set>
+#include <vector>
+#include <stdint.h>
 #include "FilePath.h"
 #include "OovString.h"
 #include "clang-c/Index.h"
@@ -79,14 +81,25 @@ class SourceRange
 class CppFileContents
     {
     public:
+        CppFileContents():
+            mOrigHash(0)
+            {}
         bool read(char const *fn);
         bool write(OovStringRef const fn);
+        /// Returns the hash of the contents of the file before it was changed.
+        uint64_t getOrigHash() const
+            { return mOrigHash; }
         // The origFileOffset is the offset into the original file.
         void insert(OovStringRef const str, int origFileOffset);
+        /// Returns the line number in the original file for each line of
+        /// the written file.  Inserted lines have the number of the line
+        /// where they were inserted.  This must be called before updateMemory.
+        std::vector<int> getOrigLines() const;
 
     private:
         std::multimap<int, OovString> mInsertMap;
         std::vector<char> mFileContents;
+        uint64_t mOrigHash;
 
         /// Reads the mInsertMap and writes the mFileContents.
         void updateMemory();
@@ -97,10 +110,19 @@ class CppInstr
     {
     public:
         CppInstr():
-            mInstrCount(0)
+            mInstrCount(0), mDecisionCount(0), mHitOnce(false), mInstrHash(0)
             {}
         enum eErrorTypes { ET_None, ET_CompileWarnings, ET_CompileErrors,
             ET_CLangError, ET_ParseError };
+        /// Makes probes that only record whether a line was run instead of
+        /// counting each time the line was run.
+        void setHitOnce(bool hitOnce)
+            { mHitOnce = hitOnce; }
+        /// Sets the hash that is saved in the coverage header to identify
+        /// how the file was instrumented.  If this is not set, the hash of
+        /// the contents of the source file is used.
+        void setInstrHash(uint64_t hash)
+            { mInstrHash = hash; }
         /// Parses a C++ source file.
         eErrorTypes parse(OovStringRef const srcFn, OovStringRef const srcRootDir,
                 OovStringRef const outDir,
@@ -112,26 +134,56 @@ class CppInstr
     private:
         FilePath mTopParseFn;   /// The top level file that is being parsed.
         int mInstrCount;
+        int mDecisionCount;
+        bool mHitOnce;
+        uint64_t mInstrHash;
         CppFileContents mOutputFileContents;
+        /// The offsets of the compound statements and else if statements
+        /// that are outcomes of a decision, and the decision index.
+        std::map<int, int> mBranchOutcomes;
+        /// The decision indices of the switch statements that are being visited.
+        std::vector<int> mSwitchDecisions;
 
         bool isParseFile(SourceLocation const &loc) const;
         // DEAD CODE
         // bool isParseFile(CXFile const &file) const;
 
-        void makeCovInstr(OovString &covStr);
+        enum { NoDecision = -1 };
+        /// Makes a COV_IN, or a COV_BR if the probe is an outcome of a decision
+        /// such as an if or switch statement.  An outcome that was inserted,
+        /// such as a missing else or default, is a COV_BO.
+        void makeCovInstr(OovString &covStr, int decision=NoDecision,
+                bool insertedOutcome=false);
         void insertOutputText(OovString &covStr, int offset)
             { mOutputFileContents.insert(covStr, offset); }
         void insertOutputText(char const *covStr, int offset)
             { mOutputFileContents.insert(covStr, offset); }
-        void insertCovInstr(int offset);
-        void insertNonCompoundInstr(CXCursor cursor);
+        void insertCovInstr(int offset, int decision=NoDecision);
+        /// Inserts a COV_FN at the start of a function body.  This counts
+        /// the line, and measures the function when profiling.
+        /// @param funcCursor The function that contains the body.
+        void insertFuncInstr(int offset, CXCursor funcCursor);
+        void insertNonCompoundInstr(CXCursor cursor, int decision=NoDecision);
+        /// Instruments the body of an if or else as an outcome of the decision.
+        void insertBranchOutcome(CXCursor cursor, int decision);
+        /// Instruments the statement after a case or default label.
+        void insertCaseInstr(CXCursor cursor);
+        /// Returns the text and offset for instrumenting the outcomes of an
+        /// if statement that are not in the source.  This is an else if the
+        /// if statement does not have one.
+        void makeMissingElse(CXCursor cursor, int decision, OovString &text,
+                int &offset);
+        /// Returns the text and offset of a default label if the switch
+        /// statement does not have one.
+        void makeMissingDefault(CXCursor cursor, int decision, OovString &text,
+                int &offset);
 //      void instrChildNonCompoundStatements(CXCursor cursor);
 
         /// This will create a header file that will be included by the project
         /// that will be tested for coverage.  It defines a macro that will
         /// increment an offset into an array for a particular file and line index.
-        static void updateCoverageHeader(OovStringRef const fn, OovStringRef const covDir,
-                int numInstrLines);
+        static void updateCoverageHeader(OovStringRef const covDir,
+                int numInstrLines, bool hitOnce, uint64_t hash);
         /// This will create a source file that must be linked into the project
         /// that will be tested for coverage.  This file reads the existing
         /// coverage information, and updates it with the new coverage info.
@@ -11,34 +11,126 @@
 
 #include "CppInstr.h"
 #include "Version.h"
+#include "File.h"
 #include <stdlib.h>     /* exit, EXIT_FAILURE */
 #include <stdio.h>
+#include <string.h>
+#include <vector>
 
 
+static bool isError(CppInstr::eErrorTypes et)
+    {
+    return(et != CppInstr::ET_None && et != CppInstr::ET_CompileWarnings);
+    }
 
-static CppInstr sCppInstr;
+/// @param argv [-hash=hex] sourceFilePath sourceRootDir outputProjectFilesDir
+///     [cppArgs]...
+static CppInstr::eErrorTypes instrFile(bool hitOnce, int argc,
+        char const *const argv[])
+    {
+    CppInstr cppInstr;
+    cppInstr.setHitOnce(hitOnce);
+    if(argc > 0 && strncmp(argv[0], "-hash=", 6) == 0)
+        {
+        cppInstr.setInstrHash(strtoull(argv[0]+6, nullptr, 16));
+        argc--;
+        argv++;
+        }
+    CppInstr::eErrorTypes et = CppInstr::ET_ParseError;
+    if(argc >= 3)
+        {
+        et = cppInstr.parse(argv[0], argv[1], argv[2], &argv[3], argc-3);
+        }
+    if(isError(et))
+        {
+        fprintf(stderr, "oovCovInstr: Error analyzing file %s\n", argv[0]);
+        }
+    return et;
+    }
+
+/// The batch file contains one line for each file, and the arguments for
+/// the file are separated by tabs.  This prevents starting a process and
+/// loading the clang library for every file.
+static CppInstr::eErrorTypes instrBatch(bool hitOnce, char const *batchFn)
+    {
+    CppInstr::eErrorTypes batchEt = CppInstr::ET_None;
+    SimpleFile file;
+    eOpenStatus openStat = file.open(batchFn, M_ReadShared, OE_Binary);
+    OovStatus status(openStat == OS_Opened, SC_File);
+    std::string buf;
+    if(status.ok())
+        {
+        buf.resize(static_cast<size_t>(file.getSize()));
+        int actual = 0;
+        status = file.read(&buf[0], static_cast<int>(buf.size()), actual);
+        buf.resize(static_cast<size_t>(actual));
+        }
+    if(status.ok())
+        {
+        OovString batch = buf;
+        for(auto const &line : batch.split('\n'))
+            {
+            OovStringVec args = line.split('\t');
+            if(args.size() >= 3)
+                {
+                std::vector<char const *> argv;
+                for(auto const &arg : args)
+                    {
+                    argv.push_back(arg.getStr());
+                    }
+                CppInstr::eErrorTypes et = instrFile(hitOnce,
+                    static_cast<int>(argv.size()), argv.data());
+                if(isError(et))
+                    {
+                    batchEt = et;
+                    }
+                }
+            }
+        }
+    else
+        {
+        fprintf(stderr, "oovCovInstr: Unable to read batch file %s\n", batchFn);
+        batchEt = CppInstr::ET_ParseError;
+        }
+    if(status.needReport())
+        {
+        status.reported();
+        }
+    return batchEt;
+    }
 
 int main(int argc, char const *const argv[])
     {
     CppInstr::eErrorTypes et = CppInstr::ET_None;
     OovError::setComponent(EC_OovCovInstr);
-    if(argc >= 4)
+    int argIndex = 1;
+    bool hitOnce = false;
+    if(argc > 1 && strcmp(argv[1], "-hitonce") == 0)
+        {
+        hitOnce = true;
+        argIndex++;
+        }
+    if(argc-argIndex == 2 && strcmp(argv[argIndex], "-batch") == 0)
+        {
+        et = instrBatch(hitOnce, argv[argIndex+1]);
+        }
+    else if(argc-argIndex >= 3)
         {
         // This saves the CPP info in an XMI file.
-        et = sCppInstr.parse(argv[1], argv[2], argv[3], &argv[4], argc-4);
-        if(et != CppInstr::ET_None && et != CppInstr::ET_CompileWarnings)
-            {
-            fprintf(stderr, "oovCovInstr: Error analyzing file %s\n", argv[1]);
-            }
+        et = instrFile(hitOnce, argc-argIndex, &argv[argIndex]);
         }
     else
         {
         fprintf(stderr, "OovCovInstr version %s\n", OOV_VERSION);
-        fprintf(stderr, "oovCovInstr: Args are: sourceFilePath sourceRootDir outputProjectFilesDir [cppArgs]...\n");
+        fprintf(stderr, "oovCovInstr: Args are: [-hitonce] [-hash=hex] sourceFilePath sourceRootDir outputProjectFilesDir [cppArgs]...\n");
+        fprintf(stderr, "        or:  [-hitonce] -batch batchFilePath\n");
+        fprintf(stderr, "     -hitonce   Only record whether each line was run instead of counting\n");
+        fprintf(stderr, "     -hash      The hash that is saved in the coverage header for the source file\n");
+        fprintf(stderr, "     -batch     Each line of the file contains tab separated args for one source file\n");
         fprintf(stderr, "     cppArgs    Standard compile options. Use -o<filename> to specify the output file\n");
         }
     int exitCode = 0;
-    if(et != CppInstr::ET_None && et != CppInstr::ET_CompileWarnings)
+    if(isError(et))
         exitCode = EXIT_FAILURE;
     return exitCode;
     }
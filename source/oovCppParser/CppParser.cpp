@@ -175,6 +175,13 @@ static CXChildVisitResult visitTranslationUnitForIncludes(CXCursor cursor, CXCur
     return parser->visitTranslationUnitForIncludes(cursor, parent);
     }
 
+static CXChildVisitResult visitTranslationUnitForSymbols(CXCursor cursor, CXCursor parent,
+        CXClientData client_data)
+    {
+    CppParser *parser = static_cast<CppParser*>(client_data);
+    return parser->visitTranslationUnitForSymbols(cursor, parent);
+    }
+
 static CXChildVisitResult visitRecord(CXCursor cursor, CXCursor parent,
         CXClientData client_data)
     {
@@ -1239,6 +1246,91 @@ CXChildVisitResult CppParser::visitTranslationUnitForIncludes(CXCursor cursor,
     return CXChildVisit_Continue;
     }
 
+// Returns a name such as "ns::cls::func".
+static OovString getQualifiedName(CXCursor cursor)
+    {
+    OovString name = CXStringDisposer(clang_getCursorSpelling(cursor));
+    CXCursor parent = clang_getCursorSemanticParent(cursor);
+    while(!clang_Cursor_isNull(parent) &&
+        !clang_isInvalid(clang_getCursorKind(parent)) &&
+        clang_getCursorKind(parent) != CXCursor_TranslationUnit)
+        {
+        OovString parentName = CXStringDisposer(clang_getCursorSpelling(parent));
+        if(parentName.length() > 0)
+            {
+            name.insert(0, "::");
+            name.insert(0, parentName);
+            }
+        parent = clang_getCursorSemanticParent(parent);
+        }
+    return name;
+    }
+
+// This only saves declarations that are at namespace or class scope. The
+// function bodies are not visited, so local variables are not saved.
+CXChildVisitResult CppParser::visitTranslationUnitForSymbols(CXCursor cursor,
+    CXCursor /*parent*/)
+    {
+    CXChildVisitResult result = CXChildVisit_Continue;
+    CXCursorKind cursKind = clang_getCursorKind(cursor);
+    bool addSymbol = (clang_isDeclaration(cursKind) ||
+        cursKind == CXCursor_MacroDefinition);
+    switch(cursKind)
+        {
+        case CXCursor_Namespace:
+        case CXCursor_StructDecl:
+        case CXCursor_UnionDecl:
+        case CXCursor_ClassDecl:
+        case CXCursor_EnumDecl:
+        case CXCursor_ClassTemplate:
+        case CXCursor_ClassTemplatePartialSpecialization:
+            result = CXChildVisit_Recurse;
+            break;
+
+        case CXCursor_LinkageSpec:
+            addSymbol = false;
+            result = CXChildVisit_Recurse;
+            break;
+
+        case CXCursor_ParmDecl:
+        case CXCursor_CXXAccessSpecifier:
+        case CXCursor_TemplateTypeParameter:
+        case CXCursor_NonTypeTemplateParameter:
+        case CXCursor_TemplateTemplateParameter:
+        case CXCursor_UsingDirective:
+        case CXCursor_UsingDeclaration:
+            addSymbol = false;
+            break;
+
+        default:
+            break;
+        }
+    if(addSymbol)
+        {
+        SymbolRecord rec;
+        rec.mFilename = getFileLoc(cursor, &rec.mLine);
+        // Only save symbols in the project, not in external packages.
+        if(rec.mFilename.length() > 0 &&
+            rec.mFilename.compare(0, mSrcRootDir.length(), mSrcRootDir) == 0)
+            {
+            rec.mUsr = CXStringDisposer(clang_getCursorUSR(cursor));
+            if(rec.mUsr.length() > 0)
+                {
+                CXCursor parentCursor = clang_getCursorSemanticParent(cursor);
+                if(!clang_Cursor_isNull(parentCursor) &&
+                    clang_getCursorKind(parentCursor) != CXCursor_TranslationUnit)
+                    {
+                    rec.mParentUsr = CXStringDisposer(clang_getCursorUSR(parentCursor));
+                    }
+                rec.mQualifiedName = getQualifiedName(cursor);
+                rec.mDefinition = clang_isCursorDefinition(cursor);
+                mSymbolWriter.add(rec);
+                }
+            }
+        }
+    return result;
+    }
+
 #define LINE_STATS 1
 #if(LINE_STATS)
 static ModelModuleLineStats makeLineStats(CXCursor cursor)
@@ -1303,6 +1395,7 @@ CppParser::eErrorTypes CppParser::parse(bool lineHashes, char const * const srcF
     eErrorTypes errType = ET_None;
 
     mTopParseFn.setPath(srcFn, FP_File);
+    mSrcRootDir = srcRootDir;
     /// Create a module so the modelwriter has a filename.
     mParserModelData.addParsedModule(srcFn);
 
@@ -1357,6 +1450,7 @@ CppParser::eErrorTypes CppParser::parse(bool lineHashes, char const * const srcF
             {
             clang_visitChildren(rootCursor, ::visitTranslationUnit, this);
             clang_visitChildren(rootCursor, ::visitTranslationUnitForIncludes, this);
+            clang_visitChildren(rootCursor, ::visitTranslationUnitForSymbols, this);
 #if(LINE_STATS)
             mParserModelData.setLineStats(makeLineStats(rootCursor));
 #endif
@@ -1386,6 +1480,15 @@ CppParser::eErrorTypes CppParser::parse(bool lineHashes, char const * const srcF
             {
             errType = ET_ParseError;
             }
+        OovString outSymFileName = outBaseFileName;
+        outSymFileName += SymbolIndex::getFileExtension();
+        OovStatus symStatus = mSymbolWriter.write(outSymFileName);
+        if(symStatus.needReport())
+            {
+            OovString err = "Unable to write symbol file ";
+            err += outSymFileName;
+            symStatus.report(ET_Error, err);
+            }
         try
             {
             mIncDirDeps.write();
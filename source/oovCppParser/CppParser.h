@@ -10,6 +10,7 @@
 
 #include "IncDirMap.h"
 #include "ParserModelData.h"
+#include "SymbolIndex.h"
 #include <set>
 #include "OovString.h"
 #include "OovError.h"
@@ -143,6 +144,7 @@ class CppParser
         /// These are public for access by global functions callbacks.
         CXChildVisitResult visitTranslationUnit(CXCursor cursor, CXCursor parent);
         CXChildVisitResult visitTranslationUnitForIncludes(CXCursor cursor, CXCursor parent);
+        CXChildVisitResult visitTranslationUnitForSymbols(CXCursor cursor, CXCursor parent);
         CXChildVisitResult visitRecord(CXCursor cursor, CXCursor parent);
         CXChildVisitResult visitFunctionAddArgs(CXCursor cursor, CXCursor parent);
         CXChildVisitResult visitFunctionAddStatements(CXCursor cursor, CXCursor parent);
@@ -159,6 +161,10 @@ class CppParser
         FilePath mTopParseFn;   /// The top level file that is being parsed.
         Visibility mClassMemberAccess;
         IncDirDependencyMap mIncDirDeps;
+        /// The declarations in the project source files. These are used by
+        /// the editor to find symbols without parsing.
+        SymbolIndexWriter mSymbolWriter;
+        OovString mSrcRootDir;
 #if(DEBUG_PARSE)
         int mStatementRecurseLevel;
 #endif
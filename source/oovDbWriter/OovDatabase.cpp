@@ -7,6 +7,7 @@
 #include "OovDatabase.h"
 #include "DbString.h"
 #include <limits>
+#include <algorithm>
 
 
 bool OovDatabase::exec(OovStringRef sqlStr)
@@ -77,7 +78,8 @@ bool OovDatabase::createTables()
             "codeLines INT NOT NULL,"
             "commentlines INT NOT NULL,"
             "moduleLines INT NOT NULL,"
-            "idOwningComponent INTEGER"         // This is null because it is updated later.
+            "idOwningComponent INTEGER,"        // This is null because it is updated later.
+            "contentHash VARCHAR"               // This is null until the module is written.
             ");",
 
         // Types are either simple types or classes.
@@ -149,7 +151,13 @@ bool OovDatabase::createTables()
             "name VARCHAR NOT NULL"
             ");",
         };
-    bool success = exec("begin");
+    // The write ahead log is faster for many small transactions and allows
+    // reading while the database is written.
+    bool success = exec("PRAGMA journal_mode=WAL");
+    if(success)
+        {
+        success = exec("begin");
+        }
     if(success)
         {
         for(auto const *createStr : createStrs)
@@ -165,71 +173,599 @@ bool OovDatabase::createTables()
             success = exec("end");
             }
         }
+    // A database from an older version does not have content hashes, and
+    // this will fail.
+    if(success)
+        {
+        success = readRows("SELECT idModule, name, contentHash FROM Module",
+            [this](SQLiteStatement &stmt)
+            {
+            mModuleIds[stmt.getColumnText(1)] = stmt.getColumnInt(0);
+            mModuleHashes[stmt.getColumnText(1)] = stmt.getColumnText(2);
+            });
+        }
+    if(success)
+        {
+        success = readRows("SELECT idComponent, name FROM Component",
+            [this](SQLiteStatement &stmt)
+            { mComponentIds[stmt.getColumnText(1)] = stmt.getColumnInt(0); });
+        }
+    if(success)
+        {
+        success = readRows("SELECT idType, name FROM Type",
+            [this](SQLiteStatement &stmt)
+            {
+            int id = stmt.getColumnInt(0);
+            mTypeIds[stmt.getColumnText(1)] = id;
+            mMaxTypeId = std::max(mMaxTypeId, id);
+            });
+        }
+    if(success)
+        {
+        success = readRows("SELECT idMethod, idOwningType, name FROM Method",
+            [this](SQLiteStatement &stmt)
+            {
+            int id = stmt.getColumnInt(0);
+            mMethodIds[makeMethodKey(stmt.getColumnInt(1), stmt.getColumnText(2))] = id;
+            mMaxMethodId = std::max(mMaxMethodId, id);
+            });
+        }
     return success;
     }
 
-bool OovDatabase::addRecord(OovStringRef colIdName, OovStringRef tableName,
-    OovStringRef srchColName, OovStringRef srchColVal,
-    DbNames insertColNames, DbValues insertColValues, int &retId)
+// The order must match eStatements.
+static char const *sStatementStrs[] =
     {
-    bool success = execSelectId(colIdName, tableName, srchColName, srchColVal,
-        false, retId);
-    if(success && retId == UNDEFINED_INT)
+    "INSERT INTO Module(name,codeLines,commentLines,moduleLines) "
+        "VALUES(?,?,?,?)",
+    "INSERT INTO Component(name) VALUES(?)",
+    "UPDATE Module SET idOwningComponent=? WHERE idModule=?",
+    "UPDATE Module SET codeLines=?,commentLines=?,moduleLines=?,contentHash=? "
+        "WHERE idModule=?",
+    "DELETE FROM Module WHERE idModule=?",
+    "INSERT INTO ChangedModule(idModule) VALUES(?)",
+    "INSERT INTO RemovedType(idType) VALUES(?)",
+    "INSERT INTO RemovedMethod(idMethod) VALUES(?)",
+    // Removed types are replaced when they are added again.
+    "INSERT OR REPLACE INTO Type(idType,name,idOwningModule,lineNumber) VALUES(?,?,?,?)",
+    "INSERT INTO TypeRelation(typeRelationDescription,visibility,"
+        "idSupplierType,idConsumerType) VALUES(?,?,?,?)",
+    "INSERT INTO ModuleRelation(idSupplierModule,idConsumerModule) VALUES(?,?)",
+    "INSERT OR REPLACE INTO Method(idMethod,name,lineNumber,visibility,const,virtual,"
+        "idOwningType,idOwningModule) VALUES(?,?,?,?,?,?,?,?)",
+    "INSERT INTO MethodTypeRef(name,varRelationDescription,idOwningMethod,"
+        "idSupplierType) VALUES(?,?,?,?)",
+    "INSERT INTO Statement(statementDescription,lineNumber,idOwningMethod,"
+        "idSupplierClass,idSupplierMethod) VALUES(?,?,?,?,?)",
+    };
+
+SQLiteStatement *OovDatabase::getStatement(eStatements st)
+    {
+    SQLiteStatement *stmt = &mStatements[st];
+    if(!stmt->isPrepared())
         {
-        DbString ins;
-        ins.INSERT(tableName).INTO(insertColNames).VALUES(insertColValues);
-        success = exec(ins.getDbStr());
-        if(success)
+        mSqlError.clear();
+        if(!stmt->prepare(*this, sStatementStrs[st]))
             {
-            success = execSelectLastInsertedRowId(retId);
+            OovString errStr = sStatementStrs[st];
+            errStr += " : ";
+            errStr += mSqlError;
+            setLastError(errStr);
+            stmt = nullptr;
             }
         }
+    return stmt;
+    }
+
+bool OovDatabase::execInsert(SQLiteStatement &stmt, int *retId)
+    {
+    mSqlError.clear();
+    bool success = stmt.execStep();
+    if(success)
+        {
+        if(retId)
+            {
+            *retId = getLastInsertRowId();
+            }
+        }
+    else
+        {
+        setLastError(mSqlError);
+        }
+    return success;
+    }
+
+std::string OovDatabase::makeMethodKey(int idClass, OovStringRef name)
+    {
+    std::string key = std::to_string(idClass);
+    key += ':';
+    key += name.getStr();
+    return key;
+    }
+
+bool OovDatabase::readRows(char const *sql,
+        std::function<void(SQLiteStatement &stmt)> rowFunc)
+    {
+    SQLiteStatement stmt;
+    mSqlError.clear();
+    bool success = stmt.prepare(*this, sql);
+    bool haveRow = success;
+    while(success && haveRow)
+        {
+        success = stmt.step(haveRow);
+        if(success && haveRow)
+            {
+            rowFunc(stmt);
+            }
+        }
+    if(!success)
+        {
+        OovString errStr = sql;
+        errStr += " : ";
+        errStr += mSqlError;
+        setLastError(errStr);
+        }
+    return success;
+    }
+
+bool OovDatabase::getId(IdMap const &ids, IdSet const *removedIds,
+        char const *table, OovStringRef key, bool failMissing, int &id)
+    {
+    bool success = true;
+    auto const &iter = ids.find(key.getStr());
+    if(iter != ids.end() && !(removedIds &&
+        removedIds->find((*iter).second) != removedIds->end()))
+        {
+        id = (*iter).second;
+        }
+    else
+        {
+        id = UNDEFINED_INT;
+        if(failMissing)
+            {
+            OovString str = "Missing id for table ";
+            str += table;
+            str += " value ";
+            str += key;
+            setLastError(str);
+            success = false;
+            }
+        }
+    return success;
+    }
+
+int OovDatabase::getInsertId(IdMap const &ids, IdSet &removedIds,
+        std::string const &key, int &maxId)
+    {
+    int id = UNDEFINED_INT;
+    auto const &iter = ids.find(key);
+    if(iter != ids.end())
+        {
+        auto const &removedIter = removedIds.find((*iter).second);
+        if(removedIter != removedIds.end())
+            {
+            id = (*iter).second;
+            removedIds.erase(removedIter);
+            }
+        }
+    if(id == UNDEFINED_INT)
+        {
+        id = ++maxId;
+        }
+    return id;
+    }
+
+bool OovDatabase::beginTransaction()
+    {
+    bool success = true;
+    if(!mInTransaction)
+        {
+        success = exec("begin");
+        mInTransaction = success;
+        }
+    return success;
+    }
+
+bool OovDatabase::endTransaction()
+    {
+    bool success = true;
+    if(mInTransaction)
+        {
+        success = exec("end");
+        mInTransaction = false;
+        }
     return success;
     }
 
-bool OovDatabase::addName(OovStringRef colIdName, OovStringRef tableName,
-    OovStringRef nameColName, OovStringRef nameValName, int &retId)
+void OovDatabase::closeDatabase()
     {
-    return addRecord(colIdName, tableName, nameColName, nameValName,
-        {colIdName, nameColName}, {nullptr, nameValName.getStr()}, retId);
+    for(auto &stmt : mStatements)
+        {
+        stmt.finalize();
+        }
+    mModuleIds.clear();
+    mComponentIds.clear();
+    mTypeIds.clear();
+    mMethodIds.clear();
+    mRemovedTypeIds.clear();
+    mRemovedMethodIds.clear();
+    mMaxTypeId = 0;
+    mMaxMethodId = 0;
+    mModuleHashes.clear();
+    mInTransaction = false;
+    closeDb();
+    }
+
+bool OovDatabase::removeComponents()
+    {
+    bool success = exec("UPDATE Module SET idOwningComponent=NULL");
+    if(success)
+        {
+        success = exec("DELETE FROM Component");
+        }
+    if(success)
+        {
+        mComponentIds.clear();
+        }
+    return success;
     }
 
 bool OovDatabase::addComponent(OovStringRef name, int &componentId)
     {
-    return addName("idComponent", "Component", "name", name, componentId);
+    bool success = getId(mComponentIds, nullptr, "Component", name, false,
+        componentId);
+    if(success && componentId == UNDEFINED_INT)
+        {
+        SQLiteStatement *stmt = getStatement(S_InsertComponent);
+        success = (stmt != nullptr);
+        if(success)
+            {
+            stmt->bindText(1, name);
+            success = execInsert(*stmt, &componentId);
+            }
+        if(success)
+            {
+            mComponentIds[name.getStr()] = componentId;
+            }
+        }
+    return success;
     }
 
 bool OovDatabase::updateModuleWithComponent(OovStringRef name, int componentId)
     {
     int moduleId;
     bool success = getModuleId(name, false, moduleId);
-    if(success)
+    if(success && moduleId != UNDEFINED_INT)
         {
-        DbString dbStr;
-        dbStr.UPDATE("Module").SET({"idOwningComponent"},
-                {componentId}).WHERE("idModule", "=", moduleId);
-        success = exec(dbStr.getDbStr());
+        SQLiteStatement *stmt = getStatement(S_UpdateModuleComponent);
+        success = (stmt != nullptr);
+        if(success)
+            {
+            stmt->bindInt(1, componentId);
+            stmt->bindInt(2, moduleId);
+            success = execInsert(*stmt, nullptr);
+            }
         }
     return success;
     }
 
 bool OovDatabase::getModuleId(OovStringRef name, bool failMissing, int &moduleId)
     {
-    return execSelectId("idModule", "Module", "name", name, failMissing, moduleId);
+    return getId(mModuleIds, nullptr, "Module", name, failMissing, moduleId);
     }
 
 bool OovDatabase::addModule(OovStringRef name, int &moduleId, int codeLines,
     int commentLines, int moduleLines)
     {
-    return addRecord("idModule", "Module", "name", name,
-        {"idModule", "name", "codeLines", "commentLines", "moduleLines"},
-        { nullptr, name.getStr(), codeLines, commentLines, moduleLines },
-        moduleId);
+    bool success = getModuleId(name, false, moduleId);
+    if(success && moduleId == UNDEFINED_INT)
+        {
+        SQLiteStatement *stmt = getStatement(S_InsertModule);
+        success = (stmt != nullptr);
+        if(success)
+            {
+            stmt->bindText(1, name);
+            stmt->bindInt(2, codeLines);
+            stmt->bindInt(3, commentLines);
+            stmt->bindInt(4, moduleLines);
+            success = execInsert(*stmt, &moduleId);
+            }
+        if(success)
+            {
+            mModuleIds[name.getStr()] = moduleId;
+            }
+        }
+    return success;
+    }
+
+bool OovDatabase::updateModule(OovStringRef name, int codeLines,
+    int commentLines, int moduleLines, OovStringRef contentHash)
+    {
+    int moduleId;
+    bool success = getModuleId(name, true, moduleId);
+    if(success)
+        {
+        SQLiteStatement *stmt = getStatement(S_UpdateModule);
+        success = (stmt != nullptr);
+        if(success)
+            {
+            stmt->bindInt(1, codeLines);
+            stmt->bindInt(2, commentLines);
+            stmt->bindInt(3, moduleLines);
+            stmt->bindText(4, contentHash);
+            stmt->bindInt(5, moduleId);
+            success = execInsert(*stmt, nullptr);
+            }
+        if(success)
+            {
+            mModuleHashes[name.getStr()] = contentHash.getStr();
+            }
+        }
+    return success;
+    }
+
+OovString OovDatabase::getModuleContentHash(OovStringRef name) const
+    {
+    OovString hash;
+    auto const &iter = mModuleHashes.find(name.getStr());
+    if(iter != mModuleHashes.end())
+        {
+        hash = (*iter).second;
+        }
+    return hash;
+    }
+
+OovStringVec OovDatabase::getModuleNames() const
+    {
+    OovStringVec names;
+    for(auto const &mod : mModuleIds)
+        {
+        names.push_back(mod.first);
+        }
+    return names;
+    }
+
+bool OovDatabase::insertIds(eStatements st, std::vector<int> const &ids)
+    {
+    SQLiteStatement *stmt = getStatement(st);
+    bool success = (stmt != nullptr);
+    for(size_t i=0; i<ids.size() && success; i++)
+        {
+        stmt->bindInt(1, ids[i]);
+        success = execInsert(*stmt, nullptr);
+        }
+    return success;
+    }
+
+bool OovDatabase::setChangedModules(std::vector<int> const &moduleIds)
+    {
+    bool success = exec("CREATE TEMP TABLE IF NOT EXISTS ChangedModule("
+        "idModule INTEGER PRIMARY KEY NOT NULL)");
+    if(success)
+        {
+        success = exec("DELETE FROM ChangedModule");
+        }
+    if(success)
+        {
+        success = insertIds(S_InsertChangedModule, moduleIds);
+        }
+    return success;
+    }
+
+bool OovDatabase::removeModuleContents(std::vector<int> const &moduleIds)
+    {
+    bool success = setChangedModules(moduleIds);
+    // The removed IDs are kept so that they are used again when the types
+    // and methods are added again.
+    if(success)
+        {
+        success = readRows("SELECT idType FROM Type WHERE idOwningModule IN "
+            "(SELECT idModule FROM ChangedModule)",
+            [this](SQLiteStatement &stmt)
+            { mRemovedTypeIds.insert(stmt.getColumnInt(0)); });
+        }
+    if(success)
+        {
+        success = readRows("SELECT idMethod FROM Method WHERE idOwningModule IN "
+            "(SELECT idModule FROM ChangedModule)",
+            [this](SQLiteStatement &stmt)
+            { mRemovedMethodIds.insert(stmt.getColumnInt(0)); });
+        }
+    if(success)
+        {
+        success = removeChangedModuleRelations(moduleIds);
+        }
+    return success;
+    }
+
+bool OovDatabase::removeChangedModuleRelations(std::vector<int> const &moduleIds)
+    {
+    bool success = true;
+    char const *deleteStrs[] =
+        {
+        "DELETE FROM Statement WHERE idOwningMethod IN (SELECT idMethod FROM "
+            "Method WHERE idOwningModule IN (SELECT idModule FROM ChangedModule))",
+        "DELETE FROM MethodTypeRef WHERE idOwningMethod IN (SELECT idMethod FROM "
+            "Method WHERE idOwningModule IN (SELECT idModule FROM ChangedModule))",
+        "DELETE FROM TypeRelation WHERE idConsumerType IN (SELECT idType FROM "
+            "Type WHERE idOwningModule IN (SELECT idModule FROM ChangedModule))",
+        // If the export is stopped before the modules are written, they
+        // will be written again the next time.
+        "UPDATE Module SET contentHash=NULL WHERE idModule IN "
+            "(SELECT idModule FROM ChangedModule)",
+        };
+    for(size_t i=0; i<sizeof(deleteStrs)/sizeof(deleteStrs[0]) && success; i++)
+        {
+        success = exec(deleteStrs[i]);
+        }
+    if(success)
+        {
+        IdSet changedIds(moduleIds.begin(), moduleIds.end());
+        for(auto &hash : mModuleHashes)
+            {
+            auto const &iter = mModuleIds.find(hash.first);
+            if(iter != mModuleIds.end() &&
+                changedIds.find((*iter).second) != changedIds.end())
+                {
+                hash.second.clear();
+                }
+            }
+        }
+    return success;
+    }
+
+bool OovDatabase::removeUnusedRecords(std::vector<int> &refModuleIds)
+    {
+    refModuleIds.clear();
+    char const *createStrs[] =
+        {
+        "CREATE TEMP TABLE IF NOT EXISTS RemovedType("
+            "idType INTEGER PRIMARY KEY NOT NULL)",
+        "CREATE TEMP TABLE IF NOT EXISTS RemovedMethod("
+            "idMethod INTEGER PRIMARY KEY NOT NULL)",
+        "DELETE FROM RemovedType",
+        "DELETE FROM RemovedMethod",
+        };
+    bool success = true;
+    for(size_t i=0; i<sizeof(createStrs)/sizeof(createStrs[0]) && success; i++)
+        {
+        success = exec(createStrs[i]);
+        }
+    if(success)
+        {
+        success = insertIds(S_InsertRemovedType, std::vector<int>(
+            mRemovedTypeIds.begin(), mRemovedTypeIds.end()));
+        }
+    if(success)
+        {
+        success = insertIds(S_InsertRemovedMethod, std::vector<int>(
+            mRemovedMethodIds.begin(), mRemovedMethodIds.end()));
+        }
+    // The methods that were made for calls to a removed type are removed too.
+    if(success)
+        {
+        success = exec("INSERT OR IGNORE INTO RemovedMethod SELECT idMethod "
+            "FROM Method WHERE idOwningType IN (SELECT idType FROM RemovedType)");
+        }
+    // The methods that were made for calls to undefined methods are removed
+    // if the methods are now defined, so that the calls refer to them.
+    if(success)
+        {
+        success = exec("INSERT OR IGNORE INTO RemovedMethod SELECT made.idMethod "
+            "FROM Method AS made INNER JOIN Method AS defined ON "
+            "made.idOwningType=defined.idOwningType AND made.name=defined.name || '#'");
+        }
+    if(success)
+        {
+        success = readRows("SELECT idMethod FROM RemovedMethod",
+            [this](SQLiteStatement &stmt)
+            { mRemovedMethodIds.insert(stmt.getColumnInt(0)); });
+        }
+    if(success)
+        {
+        success = readRows(
+            "SELECT idOwningModule FROM Method WHERE idMethod IN "
+                "(SELECT idOwningMethod FROM Statement WHERE "
+                "idSupplierMethod IN (SELECT idMethod FROM RemovedMethod) OR "
+                "idSupplierClass IN (SELECT idType FROM RemovedType)) OR "
+                "idMethod IN (SELECT idOwningMethod FROM MethodTypeRef WHERE "
+                "idSupplierType IN (SELECT idType FROM RemovedType)) "
+            "UNION SELECT idOwningModule FROM Type WHERE idType IN "
+                "(SELECT idConsumerType FROM TypeRelation WHERE "
+                "idSupplierType IN (SELECT idType FROM RemovedType))",
+            [&refModuleIds](SQLiteStatement &stmt)
+            { refModuleIds.push_back(stmt.getColumnInt(0)); });
+        }
+    if(success && refModuleIds.size() > 0)
+        {
+        success = setChangedModules(refModuleIds);
+        if(success)
+            {
+            success = removeChangedModuleRelations(refModuleIds);
+            }
+        }
+    if(success)
+        {
+        success = exec("DELETE FROM Method WHERE idMethod IN "
+            "(SELECT idMethod FROM RemovedMethod)");
+        }
+    if(success)
+        {
+        success = exec("DELETE FROM Type WHERE idType IN "
+            "(SELECT idType FROM RemovedType)");
+        }
+    if(success)
+        {
+        eraseIds(mTypeIds, mRemovedTypeIds);
+        eraseIds(mMethodIds, mRemovedMethodIds);
+        mRemovedTypeIds.clear();
+        mRemovedMethodIds.clear();
+        }
+    return success;
+    }
+
+bool OovDatabase::removeUncalledMethods()
+    {
+    char const *whereStr = " WHERE name LIKE '%#' AND idMethod NOT IN "
+        "(SELECT idSupplierMethod FROM Statement)";
+    IdSet removedIds;
+    OovString sql = "SELECT idMethod FROM Method";
+    sql += whereStr;
+    bool success = readRows(sql.getStr(), [&removedIds](SQLiteStatement &stmt)
+        { removedIds.insert(stmt.getColumnInt(0)); });
+    if(success && removedIds.size() > 0)
+        {
+        sql = "DELETE FROM Method";
+        sql += whereStr;
+        success = exec(sql);
+        if(success)
+            {
+            eraseIds(mMethodIds, removedIds);
+            }
+        }
+    return success;
+    }
+
+void OovDatabase::eraseIds(IdMap &ids, IdSet const &removedIds)
+    {
+    for(auto iter = ids.begin(); iter != ids.end(); )
+        {
+        if(removedIds.find((*iter).second) != removedIds.end())
+            {
+            iter = ids.erase(iter);
+            }
+        else
+            {
+            ++iter;
+            }
+        }
+    }
+
+bool OovDatabase::removeModule(OovStringRef name)
+    {
+    int moduleId;
+    bool success = getModuleId(name, false, moduleId);
+    if(success && moduleId != UNDEFINED_INT)
+        {
+        SQLiteStatement *stmt = getStatement(S_DeleteModule);
+        success = (stmt != nullptr);
+        if(success)
+            {
+            stmt->bindInt(1, moduleId);
+            success = execInsert(*stmt, nullptr);
+            }
+        if(success)
+            {
+            mModuleIds.erase(name.getStr());
+            mModuleHashes.erase(name.getStr());
+            }
+        }
+    return success;
     }
 
 bool OovDatabase::getTypeId(OovStringRef name, bool failMissing, int &typeId)
     {
-    return execSelectId("idType", "Type", "name", name, failMissing, typeId);
+    return getId(mTypeIds, &mRemovedTypeIds, "Type", name, failMissing, typeId);
     }
 
 bool OovDatabase::addType(OovStringRef name, int moduleId, int lineNum,
@@ -238,13 +774,20 @@ bool OovDatabase::addType(OovStringRef name, int moduleId, int lineNum,
     bool success = getTypeId(name, false, typeId);
     if(success && typeId == UNDEFINED_INT)
         {
-        DbString ins;
-        ins.INSERT("Type").INTO({"idType","name","idOwningModule","lineNumber"}).
-                VALUES({nullptr, name.getStr(), moduleId, lineNum});
-        success = exec(ins.getDbStr());
+        SQLiteStatement *stmt = getStatement(S_InsertType);
+        success = (stmt != nullptr);
+        if(success)
+            {
+            stmt->bindInt(1, getInsertId(mTypeIds, mRemovedTypeIds, name.getStr(),
+                mMaxTypeId));
+            stmt->bindText(2, name);
+            stmt->bindInt(3, moduleId);
+            stmt->bindInt(4, lineNum);
+            success = execInsert(*stmt, &typeId);
+            }
         if(success)
             {
-            success = execSelectLastInsertedRowId(typeId);
+            mTypeIds[name.getStr()] = typeId;
             }
         }
     return success;
@@ -255,18 +798,23 @@ bool OovDatabase::addTypeRelation(OovStringRef supplierName, OovStringRef consum
     {
     int idSupplier = UNDEFINED_INT;
     int idConsumer = UNDEFINED_INT;
-    bool success = execSelectId("idType", "Type", "name", supplierName, true, idSupplier);
+    bool success = getTypeId(supplierName, true, idSupplier);
     if(success && idSupplier != UNDEFINED_INT)
         {
-        success = execSelectId("idType", "Type", "name", consumerName, true, idConsumer);
+        success = getTypeId(consumerName, true, idConsumer);
         }
     if(success && idSupplier != UNDEFINED_INT && idConsumer != UNDEFINED_INT)
         {
-        DbString ins;
-        ins.INSERT("TypeRelation").INTO({"idTypeRelation",
-            "typeRelationDescription","visibility","idSupplierType","idConsumerType"}).
-            VALUES({nullptr, tr, visibility, idSupplier, idConsumer});
-        success = exec(ins.getDbStr());
+        SQLiteStatement *stmt = getStatement(S_InsertTypeRelation);
+        success = (stmt != nullptr);
+        if(success)
+            {
+            stmt->bindInt(1, tr);
+            stmt->bindInt(2, visibility);
+            stmt->bindInt(3, idSupplier);
+            stmt->bindInt(4, idConsumer);
+            success = execInsert(*stmt, nullptr);
+            }
         }
     return success;
     }
@@ -277,43 +825,56 @@ bool OovDatabase::addModuleRelation(OovStringRef supplierName, OovStringRef cons
     int idConsumer = UNDEFINED_INT;
     // At the moment, the external project includes are not added previously,
     // so they will not be found to add relations.
-    bool success = execSelectId("idModule", "Module", "name", supplierName, false, idSupplier);
+    bool success = getModuleId(supplierName, false, idSupplier);
     if(success && idSupplier != UNDEFINED_INT)
         {
-        success = execSelectId("idModule", "Module", "name", consumerName, false, idConsumer);
+        success = getModuleId(consumerName, false, idConsumer);
         }
     if(success && idSupplier != UNDEFINED_INT && idConsumer != UNDEFINED_INT)
         {
-        DbString ins;
-        ins.INSERT("ModuleRelation").INTO({"idModuleRelation",
-            "idSupplierModule","idConsumerModule"}).
-            VALUES({nullptr, idSupplier, idConsumer});
-        success = exec(ins.getDbStr());
+        SQLiteStatement *stmt = getStatement(S_InsertModuleRelation);
+        success = (stmt != nullptr);
+        if(success)
+            {
+            stmt->bindInt(1, idSupplier);
+            stmt->bindInt(2, idConsumer);
+            success = execInsert(*stmt, nullptr);
+            }
         }
     return success;
     }
 
 bool OovDatabase::getMethodId(int idClass, OovStringRef name, bool failMissing, int &methodId)
     {
-    return execSelectId("idMethod", "Method", "name", name, failMissing, methodId);
+    return getId(mMethodIds, &mRemovedMethodIds, "Method",
+        makeMethodKey(idClass, name), failMissing, methodId);
     }
 
 bool OovDatabase::addMethod(OovStringRef name, int lineNum, int visibility,
     bool isConst, bool isVirt, int owningTypeId, int owningModuleId, int &methodId)
     {
-    DbString ins;
     methodId = UNDEFINED_INT;
     bool success = getMethodId(owningTypeId, name, false, methodId);
     if(success && methodId == UNDEFINED_INT)
         {
-        ins.INSERT("Method").INTO({"idMethod","name","lineNumber",
-            "visibility", "const", "virtual", "idOwningType", "idOwningModule"}).
-            VALUES({nullptr, name.getStr(), lineNum, visibility, isConst, isVirt,
-            owningTypeId, owningModuleId});
-        success = exec(ins.getDbStr());
+        SQLiteStatement *stmt = getStatement(S_InsertMethod);
+        success = (stmt != nullptr);
+        if(success)
+            {
+            stmt->bindInt(1, getInsertId(mMethodIds, mRemovedMethodIds,
+                makeMethodKey(owningTypeId, name), mMaxMethodId));
+            stmt->bindText(2, name);
+            stmt->bindInt(3, lineNum);
+            stmt->bindInt(4, visibility);
+            stmt->bindInt(5, isConst);
+            stmt->bindInt(6, isVirt);
+            stmt->bindInt(7, owningTypeId);
+            stmt->bindInt(8, owningModuleId);
+            success = execInsert(*stmt, &methodId);
+            }
         if(success)
             {
-            success = execSelectLastInsertedRowId(methodId);
+            mMethodIds[makeMethodKey(owningTypeId, name)] = methodId;
             }
         }
     return success;
@@ -322,22 +883,34 @@ bool OovDatabase::addMethod(OovStringRef name, int lineNum, int visibility,
 bool OovDatabase::addMethodTypeRef(OovStringRef identName, eVarRelations varRel,
     int idOwningMethod, int idSupplierType)
     {
-    DbString ins;
-    ins.INSERT("MethodTypeRef").INTO({"idMethodTypeRef","name",
-        "varRelationDescription","idOwningMethod", "idSupplierType"}).
-        VALUES({nullptr, identName.getStr(), varRel, idOwningMethod, idSupplierType});
-    return exec(ins.getDbStr());
+    SQLiteStatement *stmt = getStatement(S_InsertMethodTypeRef);
+    bool success = (stmt != nullptr);
+    if(success)
+        {
+        stmt->bindText(1, identName);
+        stmt->bindInt(2, varRel);
+        stmt->bindInt(3, idOwningMethod);
+        stmt->bindInt(4, idSupplierType);
+        success = execInsert(*stmt, nullptr);
+        }
+    return success;
     }
 
 bool OovDatabase::addStatement(int statementType, int lineNum, int idOwningMethod,
     int idSupplierClass, int idSupplierMethod)
     {
-    DbString ins;
-    ins.INSERT("Statement").INTO({"idStatement", "statementDescription",
-        "lineNumber","idOwningMethod","idSupplierClass", "idSupplierMethod"}).
-        VALUES({nullptr,statementType, lineNum, idOwningMethod,
-        idSupplierClass, idSupplierMethod});
-    return exec(ins.getDbStr());
+    SQLiteStatement *stmt = getStatement(S_InsertStatement);
+    bool success = (stmt != nullptr);
+    if(success)
+        {
+        stmt->bindInt(1, statementType);
+        stmt->bindInt(2, lineNum);
+        stmt->bindInt(3, idOwningMethod);
+        stmt->bindInt(4, idSupplierClass);
+        stmt->bindInt(5, idSupplierMethod);
+        success = execInsert(*stmt, nullptr);
+        }
+    return success;
     }
 
 
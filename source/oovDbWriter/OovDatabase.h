@@ -9,20 +9,47 @@
 
 #include "SQLiteImport.h"
 #include "DbString.h"           // For DbNames and DbValues
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <functional>
 
 #define UNDEFINED_INT -1
 
+/// The add functions use prepared statements that are compiled once, and
+/// the IDs of names are kept in memory so that adding records does not
+/// need to query the database.
+///
+/// The database is kept between exports.  Each module has a hash of its
+/// content, and only the records of modules that changed are removed and
+/// added again.  Removed types and methods get the same IDs when they are
+/// added again so that references from other modules are still valid.
 class OovDatabase:public SQLite, public SQLiteListener
     {
     public:
-        OovDatabase()
+        OovDatabase():
+            mMaxTypeId(0), mMaxMethodId(0), mInTransaction(false)
             {
             setListener(this);
             }
         virtual ~OovDatabase()
             {}
-        /// Create all of the tables needed for the database.
+        /// Create all of the tables needed for the database, and read the
+        /// IDs of any records that already exist.
         bool createTables();
+        /// Finalizes the statements and closes the database.
+        void closeDatabase();
+        /// Begins a transaction if one is not already started.  Many records
+        /// should be written in each transaction since each commit is slow.
+        bool beginTransaction();
+        /// Commits the transaction if one was started.
+        bool endTransaction();
+        /// Set true to stop waiting for the disk during a bulk load.  If the
+        /// program stops during the load, the database is still good, but a
+        /// power loss may corrupt it.  The database can be made again by
+        /// exporting the model.
+        bool setBulkLoad(bool bulk)
+            { return exec(bulk ? "PRAGMA synchronous=OFF" : "PRAGMA synchronous=FULL"); }
 //        bool initIntegrity()
 //            { return exec("PRAGMA foreign_keys = ON"); }
         /// Query the Module table by name to find the module ID.
@@ -38,7 +65,44 @@ class OovDatabase:public SQLite, public SQLiteListener
         /// @param moduleLines The total number of lines for the module.
         bool addModule(OovStringRef name, int &moduleId, int codeLines,
             int commentLines, int moduleLines);
+        /// Update the line counts and content hash of a module.  This should
+        /// be done after all records of the module are written.
+        /// @param contentHash The hash of the module content that was written.
+        bool updateModule(OovStringRef name, int codeLines, int commentLines,
+            int moduleLines, OovStringRef contentHash);
+        /// Returns the content hash that was written for the module, or an
+        /// empty string if the module is not in the database or if the
+        /// module records were removed.
+        OovString getModuleContentHash(OovStringRef name) const;
+        /// Returns the names of all modules in the database.
+        OovStringVec getModuleNames() const;
+        /// Remove all relations and statements that are owned by the modules,
+        /// and mark the types and methods of the modules as removed.  The
+        /// module records are kept, but the content hashes are cleared.
+        /// @param moduleIds The modules to remove.  UNDEFINED_INT can be used
+        ///     for types and methods that do not have a module.
+        bool removeModuleContents(std::vector<int> const &moduleIds);
+        /// Delete the types and methods that were removed and were not added
+        /// again.  This must be done after all types and methods are added.
+        /// Until then, the records are kept so that their IDs are not lost
+        /// if the export is stopped.
+        /// @param refModuleIds Returns the unchanged modules that referred
+        ///     to the deleted records.  Their relations and statements are
+        ///     removed, and must be written again.
+        bool removeUnusedRecords(std::vector<int> &refModuleIds);
+        /// Delete the methods that were made for calls to undefined methods
+        /// if they are no longer called.  This must be done after all
+        /// statements are added.
+        bool removeUncalledMethods();
+        /// Remove a module record.  The module contents should be removed first.
+        bool removeModule(OovStringRef name);
+        /// Remove all module relations so that they can be written again.
+        bool removeModuleRelations()
+            { return exec("DELETE FROM ModuleRelation"); }
 
+        /// Remove all components and the owning component of each module so
+        /// that the components can be written again.
+        bool removeComponents();
         /// Add a component to the Component table.
         /// @param name The component name to add.
         /// @param componentId The returned component ID.
@@ -76,7 +140,7 @@ class OovDatabase:public SQLite, public SQLiteListener
         /// @param consumerName The consumer of the relation. The consumer is
         ///     dependent on the supplier.
         bool addModuleRelation(OovStringRef supplierName, OovStringRef consumerName);
-        /// Query the Method table by name to find the method ID.
+        /// Query the Method table by class and name to find the method ID.
         /// @param idClass The ID of the class that defines the method.
         /// @param name The name of the method.
         /// @param failMissing Set true to set an error string and fail the return.
@@ -144,15 +208,65 @@ class OovDatabase:public SQLite, public SQLiteListener
             { return(mLastResults.size() > 0); }
 
     private:
+        enum eStatements
+            {
+            S_InsertModule, S_InsertComponent, S_UpdateModuleComponent,
+            S_UpdateModule, S_DeleteModule, S_InsertChangedModule,
+            S_InsertRemovedType, S_InsertRemovedMethod,
+            S_InsertType, S_InsertTypeRelation, S_InsertModuleRelation,
+            S_InsertMethod, S_InsertMethodTypeRef, S_InsertStatement,
+            S_NumStatements
+            };
+        typedef std::unordered_map<std::string, int> IdMap;
+        typedef std::unordered_set<int> IdSet;
         std::vector<OovString> mLastResults;
         OovString mLastError;
         OovString mSqlError;
+        SQLiteStatement mStatements[S_NumStatements];
+        IdMap mModuleIds;
+        IdMap mComponentIds;
+        IdMap mTypeIds;
+        /// The key is made with makeMethodKey.
+        IdMap mMethodIds;
+        /// These IDs are in the maps, but the records were removed.
+        IdSet mRemovedTypeIds;
+        IdSet mRemovedMethodIds;
+        /// New types and methods are given IDs above these so that SQLite
+        /// does not use the ID of a removed record for a new record.
+        int mMaxTypeId;
+        int mMaxMethodId;
+        std::unordered_map<std::string, std::string> mModuleHashes;
+        bool mInTransaction;
 
-        bool addName(OovStringRef colIdName, OovStringRef tableName,
-                OovStringRef nameColName, OovStringRef nameValName, int &retId);
-        bool addRecord(OovStringRef colIdName, OovStringRef tableName,
-            OovStringRef srchColName, OovStringRef srchColVal,
-            DbNames insertColNames, DbValues insertColValues, int &retId);
+        /// Returns the statement after preparing it if needed.  Returns
+        /// nullptr if the statement could not be prepared.
+        SQLiteStatement *getStatement(eStatements st);
+        /// Runs an insert statement and gets the ID of the new record.
+        /// @param retId The returned ID, or nullptr if it is not needed.
+        bool execInsert(SQLiteStatement &stmt, int *retId);
+        /// Fills a temporary table with IDs.
+        /// @param st The statement that inserts an ID into the table.
+        bool insertIds(eStatements st, std::vector<int> const &ids);
+        /// Fills the ChangedModule table with the module IDs.
+        bool setChangedModules(std::vector<int> const &moduleIds);
+        /// Removes the IDs of the deleted records from the ID map.
+        static void eraseIds(IdMap &ids, IdSet const &removedIds);
+        /// Removes the relations and statements of the modules in the
+        /// ChangedModule table, and clears their content hashes.
+        bool removeChangedModuleRelations(std::vector<int> const &moduleIds);
+        /// Runs a query and calls the function for each result row.
+        bool readRows(char const *sql,
+            std::function<void(SQLiteStatement &stmt)> rowFunc);
+        /// Find an ID in the map.
+        /// @param removedIds The IDs of records that were removed, or nullptr.
+        /// @param failMissing Set true to set an error string and fail the return.
+        bool getId(IdMap const &ids, IdSet const *removedIds, char const *table,
+            OovStringRef key, bool failMissing, int &id);
+        /// Returns the ID of a removed record so that it can be used again,
+        /// or a new ID if the record was not removed.
+        static int getInsertId(IdMap const &ids, IdSet &removedIds,
+            std::string const &key, int &maxId);
+        static std::string makeMethodKey(int idClass, OovStringRef name);
         virtual void SQLError(int retCode, char const *errMsg) override
             {
             mSqlError = errMsg;
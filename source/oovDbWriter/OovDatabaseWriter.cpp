@@ -12,6 +12,12 @@
 #include "ModelObjects.h"
 #include "FilePath.h"   // For FileDelete.
 #include "OovDatabaseWriter.h"
+#include "OovThreadedWaitQueue.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <atomic>
+#include <algorithm>
 
 // SQL possible order of evaluation:
 //    FROM
@@ -51,14 +57,150 @@
 
 /////////////////
 
+/// This makes a hash of the parts of the model that are written to the
+/// database for a module.  This uses the FNV-1a hash.
+class ContentHasher
+    {
+    public:
+        ContentHasher():
+            mHash(14695981039346656037ULL)
+            {}
+        void add(OovStringRef str)
+            {
+            // The null is added so that "ab","c" is different than "a","bc".
+            for(char const *p = str.getStr(); ; p++)
+                {
+                addByte(static_cast<unsigned char>(*p));
+                if(*p == '\0')
+                    {
+                    break;
+                    }
+                }
+            }
+        void add(int val)
+            {
+            for(size_t i=0; i<sizeof(val); i++)
+                {
+                addByte(static_cast<unsigned char>(val >> (i*8)));
+                }
+            }
+        void add(ModelType const *type)
+            { add(type ? type->getName() : ""); }
+        OovString getHashStr() const
+            {
+            char buf[20];
+            snprintf(buf, sizeof(buf), "%016llx",
+                static_cast<unsigned long long>(mHash));
+            return buf;
+            }
+
+    private:
+        uint64_t mHash;
+
+        void addByte(unsigned char byte)
+            {
+            mHash ^= byte;
+            mHash *= 1099511628211ULL;
+            }
+    };
+
+/// A method that is written in the first pass.
+struct DbMethodRow
+    {
+    OovString mName;
+    int mLineNum;
+    int mVisibility;
+    bool mConst;
+    bool mVirtual;
+    ModelModule const *mModule;
+    };
+
+/// A type and its methods that are written in the first pass.
+struct DbTypeRow
+    {
+    OovString mName;
+    int mLineNum;
+    ModelModule const *mModule;
+    std::vector<DbMethodRow> mMethods;
+    };
+
+/// A data member that is written in the second pass.
+struct DbMemberRow
+    {
+    OovString mTypeName;
+    int mVisibility;
+    };
+
+/// A parameter or body variable that is written in the second pass.
+struct DbVarRow
+    {
+    OovString mVarName;
+    OovString mTypeName;
+    OovDatabase::eVarRelations mVarRel;
+    };
+
+/// A statement that is written in the second pass.  For calls, the type
+/// is the class of the called method.
+struct DbStatementRow
+    {
+    eModelStatementTypes mStatementType;
+    bool mHaveType;
+    OovString mTypeName;
+    OovString mMethodName;
+    };
+
+/// The type references of a method that are written in the second pass.
+struct DbMethodRefsRow
+    {
+    OovString mName;
+    std::vector<DbVarRow> mVars;
+    std::vector<DbStatementRow> mStatements;
+    };
+
+/// The type references of a class that are written in the second pass.
+struct DbClassRefsRow
+    {
+    OovString mName;
+    std::vector<DbMemberRow> mMembers;
+    std::vector<DbMethodRefsRow> mMethods;
+    };
+
+/// The rows that a producer thread made from some of the model types.  The
+/// rows only contain names, and the writer thread finds the IDs.
+struct DbRowBatch
+    {
+    DbRowBatch():
+        mNumTypes(0)
+        {}
+    /// The number of model types that the rows were made from.
+    size_t mNumTypes;
+    std::vector<DbTypeRow> mTypeRows;
+    std::vector<DbClassRefsRow> mClassRefsRows;
+    };
+
+typedef std::shared_ptr<DbRowBatch> DbRowBatchPtr;
+
+/// Each pass is written by producer threads that make rows from separate
+/// slices of the model types, and a single writer thread that writes the
+/// rows to the database.  Only the writer thread uses the database while
+/// a pass is running.
 class DbWriter
     {
     public:
         DbWriter():
-            mModelData(nullptr)
+            mModelData(nullptr), mPassIndex(UNDEFINED_INT), mStopWriting(false),
+            mNumTypesWritten(0), mWriterDone(false), mWriterSuccess(true)
             {}
+        ~DbWriter()
+            { stopPass(); }
         // The project directory is used to find the place to store the output.
         bool openDatabase(char const *projectDir, ModelData const *modelData);
+        /// Starts the threads for the pass if needed, and waits until more
+        /// types are written.
+        /// @param typeIndex This is updated to the number of types that are
+        ///     written minus one.
+        /// @param maxTypesPerTransaction The number of types to wait for
+        ///     before returning so that progress can be displayed.
         bool writeTypes(int passIndex, int &typeIndex, int maxTypesPerTransaction);
         bool writeComponentsInfo(ComponentTypesFile const* compTypesFile,
                 ScannedComponentInfo const *scannedCompInfo);
@@ -70,21 +212,68 @@ class DbWriter
     private:
         OovDatabase mDb;
         ModelData const *mModelData;
+        /// The content hash of each module in the model.
+        std::unordered_map<ModelModule const *, OovString> mModuleHashes;
+        /// The modules that have the same content as the database.  The
+        /// records for these modules are not written again.
+        std::unordered_set<ModelModule const *> mUnchangedModules;
+        std::vector<std::thread> mProducerThreads;
+        std::thread mWriterThread;
+        OovThreadedWaitQueue<DbRowBatchPtr> mBatchQueue;
+        /// The pass that the threads are running, or UNDEFINED_INT.
+        int mPassIndex;
+        /// Set to stop the producer threads early.
+        std::atomic<bool> mStopWriting;
+        /// The progress is set by the writer thread.
+        std::mutex mProgressMutex;
+        std::condition_variable mProgressSignal;
+        size_t mNumTypesWritten;
+        bool mWriterDone;
+        bool mWriterSuccess;
 
-        bool writeTypesAndMethods(int &typeIndex, int maxTypesPerTransaction);
-        // Write all type refs for the types specified by the index. Except associations.
-        bool writeTypeRefs(int &typeIndex, int maxTypesPerTransaction);
+        bool openAndCreateTables(FilePath const &dbFn);
+        void makeModuleHashes();
+        static void addOperationHash(ContentHasher &hasher,
+            ModelOperation const &oper);
+        /// Removes the records of modules that are changed or are not in the
+        /// model.  Types and methods that do not have a module are always
+        /// written again.
+        bool removeChangedModules();
+        /// Deletes the types and methods that are not in the model after all
+        /// types and methods are written.  The unchanged modules that refer
+        /// to them are changed so that their references are written again.
+        bool removeUnusedRecords();
+        /// Writes the content hashes of the changed modules after all of
+        /// their records are written.
+        bool writeModuleHashes();
+        bool isModuleChanged(ModelModule const *module) const
+            {
+            return(module == nullptr ||
+                mUnchangedModules.find(module) == mUnchangedModules.end());
+            }
+
+        bool startPass(int passIndex);
+        /// Stops the producer threads if they are still running, and waits
+        /// for all threads to finish.  Returns the result of the writer.
+        bool stopPass();
+        /// This is run by each producer thread.
+        void makeRows(int passIndex, size_t beginIndex, size_t endIndex);
+        void makeTypeRow(ModelType const *type, DbTypeRow &row) const;
+        /// Returns false if there are no changed references for the class.
+        bool makeClassRefsRow(ModelClassifier const *cls, DbClassRefsRow &row) const;
+        static void makeVarRows(std::vector<std::unique_ptr<ModelDeclarator>> const &decls,
+            OovDatabase::eVarRelations varRel, std::vector<DbVarRow> &rows);
+        /// This is run by the writer thread.  The pass is written in one
+        /// transaction.
+        void writeRows(int passIndex);
+        void setProgress(size_t numTypesWritten, bool done, bool success);
+        bool writeModule(ModelModule const *module, int &moduleId);
+        bool writeTypeRow(DbTypeRow const &row);
+        bool writeClassRefsRow(DbClassRefsRow const &row);
+        bool writeStatement(DbStatementRow const &row, int idMethod,
+            int statementIndex);
         // Writes inheritance relations.
         bool writeAssociations();
-        // Write aggregation and composition.
-        bool writeDataMemberTypeRefs(ModelClassifier const *cls);
-        // Write params and body variables.
-        bool writeMethodTypeRefs(int idMethod, ModelOperation const *oper);
-        bool writeTypeRefs(int methodId,
-            std::vector<std::unique_ptr<ModelDeclarator>> const &decls,
-            OovDatabase::eVarRelations varRel);
-        bool writeStatement(ModelStatement const &stmt, int idMethod,
-            int statementIndex);
     };
 
 static DbWriter sDbWriter;
@@ -94,14 +283,10 @@ bool DbWriter::openDatabase(char const *projectDir, ModelData const *modelData)
     {
     Project::setProjectDirectory(projectDir);
     mModelData = modelData;
+    mDb.closeDatabase();
     mDb.close();
     FilePath dbFn = Project::getOutputDir();
     dbFn.appendFile("OovReports.db");
-    OovStatus status = FileDelete(dbFn);
-    if(status.needReport())
-        {
-        status.report(ET_Error, "Unable to clear database file");
-        }
 #ifdef __linux__
     char const *libName="libsqlite3.so.0";
 #else
@@ -110,16 +295,11 @@ bool DbWriter::openDatabase(char const *projectDir, ModelData const *modelData)
     bool success = mDb.loadDbLib(libName);
     if(success)
         {
-        success = mDb.openDb(dbFn.getStr());
+        success = openAndCreateTables(dbFn);
         if(success)
             {
-            success = mDb.createTables();
-            }
-        else
-            {
-            OovString errStr = "Unable to load ";
-            errStr += dbFn;
-            mDb.setLastError(errStr);
+            makeModuleHashes();
+            success = removeChangedModules();
             }
         }
     else
@@ -129,6 +309,218 @@ bool DbWriter::openDatabase(char const *projectDir, ModelData const *modelData)
         mDb.setLastError(errStr);
         }
     return success;
+    }
+
+bool DbWriter::openAndCreateTables(FilePath const &dbFn)
+    {
+    bool success = mDb.openDb(dbFn.getStr());
+    if(success)
+        {
+        success = mDb.createTables();
+        if(!success)
+            {
+            // The database may be from an older version, so start over.
+            mDb.closeDatabase();
+            OovStatus status = FileDelete(dbFn);
+            if(status.needReport())
+                {
+                status.report(ET_Error, "Unable to clear database file");
+                }
+            success = mDb.openDb(dbFn.getStr());
+            if(success)
+                {
+                success = mDb.createTables();
+                }
+            }
+        }
+    else
+        {
+        OovString errStr = "Unable to load ";
+        errStr += dbFn;
+        mDb.setLastError(errStr);
+        }
+    return success;
+    }
+
+void DbWriter::addOperationHash(ContentHasher &hasher, ModelOperation const &oper)
+    {
+    hasher.add(oper.getOverloadFuncName());
+    hasher.add(static_cast<int>(oper.getLineNum()));
+    hasher.add(oper.getAccess().getVis());
+    hasher.add(oper.isConst());
+    hasher.add(oper.isVirtual());
+    for(auto const &param : oper.getParams())
+        {
+        hasher.add(param->getName());
+        hasher.add(param->getDeclType());
+        }
+    for(auto const &var : oper.getBodyVarDeclarators())
+        {
+        hasher.add(var->getName());
+        hasher.add(var->getDeclType());
+        }
+    for(auto const &stmt : oper.getStatements())
+        {
+        hasher.add(stmt.getStatementType());
+        hasher.add(stmt.getFullName());
+        hasher.add(stmt.getClassDecl().getDeclType());
+        hasher.add(stmt.getVarDecl().getDeclType());
+        }
+    }
+
+void DbWriter::makeModuleHashes()
+    {
+    std::unordered_map<ModelModule const *, ContentHasher> hashers;
+    for(auto const &type : mModelData->mTypes)
+        {
+        ModelClassifier const *cls = ModelType::getClass(type.get());
+        if(cls)
+            {
+            ModelModule const *module = cls->getModule();
+            if(module)
+                {
+                ContentHasher &hasher = hashers[module];
+                hasher.add(cls->getName());
+                hasher.add(static_cast<int>(cls->getLineNum()));
+                for(auto const &attr : cls->getAttributes())
+                    {
+                    hasher.add(attr->getName());
+                    hasher.add(attr->getDeclType());
+                    hasher.add(attr->getAccess().getVis());
+                    }
+                }
+            for(auto const &oper : cls->getOperations())
+                {
+                module = oper->getModule();
+                if(module)
+                    {
+                    ContentHasher &hasher = hashers[module];
+                    hasher.add(cls->getName());
+                    addOperationHash(hasher, *oper);
+                    }
+                }
+            }
+        }
+    for(auto const &assoc : mModelData->mAssociations)
+        {
+        ModelModule const *module = assoc->getChild()->getModule();
+        if(module)
+            {
+            ContentHasher &hasher = hashers[module];
+            hasher.add(assoc->getParent()->getName());
+            hasher.add(assoc->getAccess().getVis());
+            }
+        }
+    mModuleHashes.clear();
+    for(auto &hasher : hashers)
+        {
+        ModelModuleLineStats const &stats = hasher.first->mLineStats;
+        hasher.second.add(stats.mNumCodeLines);
+        hasher.second.add(stats.mNumCommentLines);
+        hasher.second.add(stats.mNumModuleLines);
+        mModuleHashes[hasher.first] = hasher.second.getHashStr();
+        }
+    }
+
+bool DbWriter::removeChangedModules()
+    {
+    std::vector<int> changedIds;
+    changedIds.push_back(UNDEFINED_INT);
+    std::unordered_set<std::string> modelModuleNames;
+    mUnchangedModules.clear();
+    for(auto const &modHash : mModuleHashes)
+        {
+        OovString const &name = modHash.first->getName();
+        modelModuleNames.insert(name);
+        if(mDb.getModuleContentHash(name) == modHash.second)
+            {
+            mUnchangedModules.insert(modHash.first);
+            }
+        else
+            {
+            int moduleId;
+            mDb.getModuleId(name, false, moduleId);
+            if(moduleId != UNDEFINED_INT)
+                {
+                changedIds.push_back(moduleId);
+                }
+            }
+        }
+    OovStringVec removedNames;
+    for(auto const &name : mDb.getModuleNames())
+        {
+        if(modelModuleNames.find(name) == modelModuleNames.end())
+            {
+            int moduleId;
+            mDb.getModuleId(name, false, moduleId);
+            changedIds.push_back(moduleId);
+            removedNames.push_back(name);
+            }
+        }
+    bool success = mDb.beginTransaction();
+    if(success)
+        {
+        success = mDb.removeModuleContents(changedIds);
+        }
+    for(size_t i=0; i<removedNames.size() && success; i++)
+        {
+        success = mDb.removeModule(removedNames[i]);
+        }
+    if(success)
+        {
+        success = mDb.endTransaction();
+        }
+    return success;
+    }
+
+bool DbWriter::removeUnusedRecords()
+    {
+    std::vector<int> refModuleIds;
+    bool success = mDb.removeUnusedRecords(refModuleIds);
+    if(success && refModuleIds.size() > 0)
+        {
+        std::unordered_set<int> refIds(refModuleIds.begin(), refModuleIds.end());
+        for(auto iter = mUnchangedModules.begin(); iter != mUnchangedModules.end(); )
+            {
+            int moduleId;
+            mDb.getModuleId((*iter)->getName(), false, moduleId);
+            if(refIds.find(moduleId) != refIds.end())
+                {
+                iter = mUnchangedModules.erase(iter);
+                }
+            else
+                {
+                ++iter;
+                }
+            }
+        }
+    return success;
+    }
+
+bool DbWriter::writeModuleHashes()
+    {
+    bool success = true;
+    for(auto const &modHash : mModuleHashes)
+        {
+        if(isModuleChanged(modHash.first))
+            {
+            int moduleId;
+            success = mDb.getModuleId(modHash.first->getName(), false, moduleId);
+            // Modules are only in the database if they have types or methods.
+            if(success && moduleId != UNDEFINED_INT)
+                {
+                ModelModuleLineStats const &stats = modHash.first->mLineStats;
+                success = mDb.updateModule(modHash.first->getName(),
+                    stats.mNumCodeLines, stats.mNumCommentLines,
+                    stats.mNumModuleLines, modHash.second);
+                }
+            if(!success)
+                {
+                break;
+                }
+            }
+        }
+    return success;
     }
 
 bool DbWriter::writeComponentsInfo(ComponentTypesFile const* compTypesFile,
@@ -137,10 +529,15 @@ bool DbWriter::writeComponentsInfo(ComponentTypesFile const* compTypesFile,
     bool success = true;
     if(compTypesFile)
         {
-        success = mDb.exec("begin");
+        success = mDb.beginTransaction();
+        if(success)
+            {
+            success = mDb.removeComponents();
+            }
         OovStringVec compNames = compTypesFile->getDefinedComponentNames();
-        for(auto const &compName : compNames)
+        for(size_t i=0; i<compNames.size() && success; i++)
             {
+            OovString const &compName = compNames[i];
             OovStringVec sources = scannedCompInfo->getComponentFiles(
                 *compTypesFile, ScannedComponentInfo::CFT_CppSource, compName);
             OovStringVec includes = scannedCompInfo->getComponentFiles(
@@ -159,14 +556,10 @@ bool DbWriter::writeComponentsInfo(ComponentTypesFile const* compTypesFile,
                         }
                     }
                 }
-            if(!success)
-                {
-                break;
-                }
             }
         if(success)
             {
-            success = mDb.exec("end");
+            success = mDb.endTransaction();
             }
         }
     return success;
@@ -177,7 +570,11 @@ bool DbWriter::writeModuleRelations(IncDirDependencyMapReader const* incMapFile)
     bool success = true;
     if(incMapFile)
         {
-        success = mDb.exec("begin");
+        success = mDb.beginTransaction();
+        if(success)
+            {
+            success = mDb.removeModuleRelations();
+            }
         if(success)
             {
             std::set<OovString> allFiles = incMapFile->getAllFiles();
@@ -197,7 +594,7 @@ bool DbWriter::writeModuleRelations(IncDirDependencyMapReader const* incMapFile)
             }
         if(success)
             {
-            success = mDb.exec("end");
+            success = mDb.endTransaction();
             }
         }
     return success;
@@ -206,13 +603,32 @@ bool DbWriter::writeModuleRelations(IncDirDependencyMapReader const* incMapFile)
 bool DbWriter::writeTypes(int passIndex, int &typeIndex, int maxTypesPerTransaction)
     {
     bool success = true;
-    if(passIndex == 0)
+    if(passIndex == 0 || passIndex == 1)
         {
-        success = writeTypesAndMethods(typeIndex, maxTypesPerTransaction);
-        }
-    else if(passIndex == 1)
-        {
-        success = writeTypeRefs(typeIndex, maxTypesPerTransaction);
+        if(mPassIndex != passIndex)
+            {
+            success = startPass(passIndex);
+            }
+        size_t numTypes = mModelData->mTypes.size();
+        size_t waitTypes = std::min(numTypes,
+            static_cast<size_t>(typeIndex + maxTypesPerTransaction));
+        size_t numTypesWritten = 0;
+        bool done = false;
+            {
+            std::unique_lock<std::mutex> lock(mProgressMutex);
+            mProgressSignal.wait(lock, [this, waitTypes]
+                { return(mWriterDone || mNumTypesWritten >= waitTypes); });
+            numTypesWritten = mNumTypesWritten;
+            done = mWriterDone;
+            }
+        if(done)
+            {
+            success = stopPass();
+            }
+        if(success && numTypesWritten > 0)
+            {
+            typeIndex = numTypesWritten - 1;
+            }
         }
     else
         {
@@ -221,253 +637,371 @@ bool DbWriter::writeTypes(int passIndex, int &typeIndex, int maxTypesPerTransact
     return success;
     }
 
-bool DbWriter::writeTypesAndMethods(int &typeIndex, int maxTypesPerTransaction)
+bool DbWriter::startPass(int passIndex)
     {
-    bool success = mDb.exec("begin");
-    size_t highestIndex = 0;
-    for(size_t i=typeIndex; i<mModelData->mTypes.size() && success; i++)
+    bool success = stopPass();
+    mPassIndex = passIndex;
+    mStopWriting = false;
+    mNumTypesWritten = 0;
+    mWriterDone = false;
+    mWriterSuccess = true;
+    mBatchQueue.initThreadSafeQueue();
+    mWriterThread = std::thread(&DbWriter::writeRows, this, passIndex);
+    // One hardware thread is left for the writer.
+    size_t numProducers = std::thread::hardware_concurrency();
+    if(numProducers > 1)
         {
-        highestIndex = i;
-        ModelType *typePtr = mModelData->mTypes[i].get();
-        ModelClassifier *cls = ModelType::getClass(typePtr);
-        int lineNum = UNDEFINED_INT;
-        int classModuleId = UNDEFINED_INT;
-        if(cls)
-            {
-            ModelModule const *module = cls->getModule();
-            if(module)
-                {
-                ModelModuleLineStats const &stats = module->mLineStats;
-                success = mDb.addModule(module->getName(), classModuleId,
-                    stats.mNumCodeLines, stats.mNumCommentLines, stats.mNumModuleLines);
-                }
-            cls->getLineNum();
-            }
-        if(success)
+        numProducers--;
+        }
+    else
+        {
+        numProducers = 1;
+        }
+    size_t numTypes = mModelData->mTypes.size();
+    for(size_t i=0; i<numProducers; i++)
+        {
+        size_t beginIndex = numTypes * i / numProducers;
+        size_t endIndex = numTypes * (i+1) / numProducers;
+        if(beginIndex < endIndex)
             {
-            int typeId = 0;
-            success = mDb.addType(typePtr->getName(), classModuleId, lineNum, typeId);
-            if(success && cls)
-                {
-                for(auto const &oper : cls->getOperations())
-                    {
-                    ModelOperation *operPtr = oper.get();
-
-                    int methodModuleId = UNDEFINED_INT;
-                    ModelModule const *module = operPtr->getModule();
-                    if(module)
-                        {
-                        ModelModuleLineStats const &stats = module->mLineStats;
-                        success = mDb.addModule(module->getName(), methodModuleId,
-                            stats.mNumCodeLines, stats.mNumCommentLines, stats.mNumModuleLines);
-                        }
-                    if(success)
-                        {
-                        int unusedMethodId = UNDEFINED_INT;
-                        success = mDb.addMethod(
-                            operPtr->getOverloadFuncName(), operPtr->getLineNum(),
-                            operPtr->getAccess().getVis(), operPtr->isConst(),
-                            operPtr->isVirtual(), typeId, methodModuleId, unusedMethodId);
-                        }
-                    if(!success)
-                        {
-                        break;
-                        }
-                    }
-                }
-            }
-        if(--maxTypesPerTransaction <= 0)
-            {
-            break;
+            mProducerThreads.push_back(std::thread(&DbWriter::makeRows, this,
+                passIndex, beginIndex, endIndex));
             }
-        }
-    if(success)
-        {
-        success = mDb.exec("end");
-        }
-    if(success)
-        {
-        typeIndex = highestIndex;
         }
-    return success;
-    }
+    return success;
+    }
 
-bool DbWriter::writeDataMemberTypeRefs(ModelClassifier const *cls)
+bool DbWriter::stopPass()
     {
-    bool success = true;
-    for(size_t attri=0; attri<cls->getAttributes().size() && success; attri++)
+    mStopWriting = true;
+    ThreadedWorkWaitPrivate::joinThreads(mProducerThreads);
+    // The writer thread reads anything left in the queue.
+    mBatchQueue.quitPops();
+    if(mWriterThread.joinable())
         {
-        auto const &attr = cls->getAttributes()[attri].get();
-        ModelType const *type = attr->getDeclType();
-        if(type)
-            {
-            OovStringRef memberName = type->getName();
-            success = mDb.addTypeRelation(memberName, cls->getName(),
-                attr->getAccess().getVis(), OovDatabase::TR_Member);
-            }
+        mWriterThread.join();
         }
-    return success;
+    mPassIndex = UNDEFINED_INT;
+    return mWriterSuccess;
     }
 
-bool DbWriter::writeTypeRefs(int idMethod,
-        std::vector<std::unique_ptr<ModelDeclarator>> const &decls,
-        OovDatabase::eVarRelations varRel)
+void DbWriter::makeRows(int passIndex, size_t beginIndex, size_t endIndex)
     {
-    bool success = true;
-    for(auto const &var : decls)
+    // This is small enough so that the writer does not wait long.
+    const size_t typesPerBatch = 20;
+    DbRowBatchPtr batch = std::make_shared<DbRowBatch>();
+    for(size_t i=beginIndex; i<endIndex && !mStopWriting; i++)
         {
-        int idSupplierType = UNDEFINED_INT;
-        ModelType const *type = var->getDeclType();
-        if(type)
+        ModelType const *typePtr = mModelData->mTypes[i].get();
+        if(passIndex == 0)
             {
-            success = mDb.getTypeId(type->getName(), true, idSupplierType);
-            if(success)
+            batch->mTypeRows.push_back(DbTypeRow());
+            makeTypeRow(typePtr, batch->mTypeRows.back());
+            }
+        else
+            {
+            ModelClassifier const *cls = ModelType::getClass(typePtr);
+            if(cls)
                 {
-                success = mDb.addMethodTypeRef(var->getName(),
-                    varRel, idMethod, idSupplierType);
+                DbClassRefsRow row;
+                if(makeClassRefsRow(cls, row))
+                    {
+                    batch->mClassRefsRows.push_back(std::move(row));
+                    }
                 }
             }
-        if(!success)
+        batch->mNumTypes++;
+        if(batch->mNumTypes >= typesPerBatch || i+1 == endIndex)
             {
-            break;
+            mBatchQueue.waitPush(batch);
+            batch = std::make_shared<DbRowBatch>();
             }
         }
-    return success;
     }
 
-bool DbWriter::writeStatement(ModelStatement const &stmt, int idMethod, int statementIndex)
+void DbWriter::makeTypeRow(ModelType const *type, DbTypeRow &row) const
     {
-    bool success = true;
-    eModelStatementTypes stType = stmt.getStatementType();
-    int idSupplierType = UNDEFINED_INT;
-    int idSupplierMethod = UNDEFINED_INT;
-    switch(stType)
+    ModelClassifier const *cls = ModelType::getClass(type);
+    row.mName = type->getName();
+    row.mLineNum = UNDEFINED_INT;
+    row.mModule = nullptr;
+    if(cls)
         {
-        case ST_Call:
+        row.mModule = cls->getModule();
+        for(auto const &oper : cls->getOperations())
+            {
+            row.mMethods.push_back({ oper->getOverloadFuncName(),
+                static_cast<int>(oper->getLineNum()), oper->getAccess().getVis(),
+                oper->isConst(), oper->isVirtual(), oper->getModule() });
+            }
+        }
+    }
+
+bool DbWriter::makeClassRefsRow(ModelClassifier const *cls, DbClassRefsRow &row) const
+    {
+    row.mName = cls->getName();
+    if(isModuleChanged(cls->getModule()))
+        {
+        // Aggregation and composition.
+        for(auto const &attr : cls->getAttributes())
             {
-            ModelType const *type = stmt.getClassDecl().getDeclType();
+            ModelType const *type = attr->getDeclType();
             if(type)
                 {
-                // Hide the supplier type since the method will
-                // uniquely identify the class.
-                int idSupplierClassTemp;
-                success = mDb.getTypeId(type->getName(), true,
-                    idSupplierClassTemp);
-                success = mDb.getMethodId(idSupplierClassTemp,
-                    stmt.getOverloadFuncName(), false, idSupplierMethod);
-                // Some methods cannot be found in the class. For now, define
-                // them with an ending '#' to indicate they were created.
-                if(success && idSupplierMethod == UNDEFINED_INT)
+                row.mMembers.push_back({ type->getName(), attr->getAccess().getVis() });
+                }
+            }
+        }
+    for(auto const &oper : cls->getOperations())
+        {
+        if(isModuleChanged(oper->getModule()))
+            {
+            row.mMethods.push_back(DbMethodRefsRow());
+            DbMethodRefsRow &methodRow = row.mMethods.back();
+            methodRow.mName = oper->getOverloadFuncName();
+            makeVarRows(oper->getParams(), OovDatabase::VR_Parameter, methodRow.mVars);
+            makeVarRows(oper->getBodyVarDeclarators(), OovDatabase::VR_BodyVariable,
+                methodRow.mVars);
+            for(auto const &stmt : oper->getStatements())
+                {
+                DbStatementRow stmtRow;
+                stmtRow.mStatementType = stmt.getStatementType();
+                ModelType const *type = nullptr;
+                if(stmtRow.mStatementType == ST_Call)
                     {
-                    idSupplierMethod = 0;
-                    OovString name = stmt.getOverloadFuncName();
-                    name += '#';
-                    success = mDb.addMethod(name, 0, 0, 0, 0,
-                        idSupplierClassTemp, 0, idSupplierMethod);
+                    type = stmt.getClassDecl().getDeclType();
+                    stmtRow.mMethodName = stmt.getOverloadFuncName();
+                    }
+                else if(stmtRow.mStatementType == ST_VarRef)
+                    {
+                    type = stmt.getVarDecl().getDeclType();
+                    }
+                stmtRow.mHaveType = (type != nullptr);
+                if(type)
+                    {
+                    stmtRow.mTypeName = type->getName();
                     }
+                methodRow.mStatements.push_back(std::move(stmtRow));
                 }
             }
-            break;
+        }
+    return(row.mMembers.size() > 0 || row.mMethods.size() > 0);
+    }
 
-        case ST_VarRef:
+void DbWriter::makeVarRows(std::vector<std::unique_ptr<ModelDeclarator>> const &decls,
+        OovDatabase::eVarRelations varRel, std::vector<DbVarRow> &rows)
+    {
+    for(auto const &var : decls)
+        {
+        ModelType const *type = var->getDeclType();
+        if(type)
             {
-            ModelType const *type = stmt.getVarDecl().getDeclType();
-            if(type)
+            rows.push_back({ var->getName(), type->getName(), varRel });
+            }
+        }
+    }
+
+void DbWriter::writeRows(int passIndex)
+    {
+    bool success = true;
+    if(passIndex == 0)
+        {
+        success = mDb.setBulkLoad(true);
+        }
+    if(success)
+        {
+        success = mDb.beginTransaction();
+        }
+    if(success && passIndex == 1)
+        {
+        success = writeAssociations();
+        }
+    if(!success)
+        {
+        setProgress(0, true, success);
+        }
+    size_t numTypes = mModelData->mTypes.size();
+    size_t numTypesWritten = 0;
+    DbRowBatchPtr batch;
+    while(numTypesWritten < numTypes && mBatchQueue.waitPop(batch))
+        {
+        // After an error, the batches are still read so that the producer
+        // threads do not wait.
+        if(success)
+            {
+            for(size_t i=0; i<batch->mTypeRows.size() && success; i++)
+                {
+                success = writeTypeRow(batch->mTypeRows[i]);
+                }
+            for(size_t i=0; i<batch->mClassRefsRows.size() && success; i++)
                 {
-                success = mDb.getTypeId(type->getName(), true, idSupplierType);
+                success = writeClassRefsRow(batch->mClassRefsRows[i]);
                 }
+            numTypesWritten += batch->mNumTypes;
+            bool done = (numTypesWritten >= numTypes);
+            if(success && done && passIndex == 0)
+                {
+                success = removeUnusedRecords();
+                }
+            if(success && done && passIndex == 1)
+                {
+                success = mDb.removeUncalledMethods();
+                }
+            if(success && done && passIndex == 1)
+                {
+                success = writeModuleHashes();
+                }
+            if(success && done)
+                {
+                success = mDb.endTransaction();
+                }
+            if(success && done && passIndex == 1)
+                {
+                success = mDb.setBulkLoad(false);
+                }
+            setProgress(numTypesWritten, done || !success, success);
             }
-            break;
+        }
+    }
 
-        default:
-            break;
+void DbWriter::setProgress(size_t numTypesWritten, bool done, bool success)
+    {
+    if(!success)
+        {
+        mStopWriting = true;
         }
-    if(success)
         {
-        success = mDb.addStatement(stType, statementIndex, idMethod, idSupplierType,
-            idSupplierMethod);
+        std::lock_guard<std::mutex> lock(mProgressMutex);
+        mNumTypesWritten = numTypesWritten;
+        mWriterDone = done;
+        mWriterSuccess = success;
         }
-    return success;
+    mProgressSignal.notify_one();
     }
 
-bool DbWriter::writeMethodTypeRefs(int idMethod, ModelOperation const *oper)
+bool DbWriter::writeModule(ModelModule const *module, int &moduleId)
     {
     bool success = true;
-    success = writeTypeRefs(idMethod, oper->getParams(), OovDatabase::VR_Parameter);
-    if(success)
+    moduleId = UNDEFINED_INT;
+    if(module)
         {
-        success = writeTypeRefs(idMethod, oper->getBodyVarDeclarators(),
-            OovDatabase::VR_BodyVariable);
+        ModelModuleLineStats const &stats = module->mLineStats;
+        success = mDb.addModule(module->getName(), moduleId,
+            stats.mNumCodeLines, stats.mNumCommentLines, stats.mNumModuleLines);
         }
+    return success;
+    }
+
+bool DbWriter::writeTypeRow(DbTypeRow const &row)
+    {
+    int classModuleId = UNDEFINED_INT;
+    int typeId = 0;
+    bool success = writeModule(row.mModule, classModuleId);
     if(success)
         {
-        for(size_t i=0; i<oper->getStatements().size() && success; i++)
+        success = mDb.addType(row.mName, classModuleId, row.mLineNum, typeId);
+        }
+    for(size_t i=0; i<row.mMethods.size() && success; i++)
+        {
+        DbMethodRow const &methodRow = row.mMethods[i];
+        int methodModuleId = UNDEFINED_INT;
+        success = writeModule(methodRow.mModule, methodModuleId);
+        if(success)
             {
-            auto const &stmt = oper->getStatements()[i];
-            success = writeStatement(stmt, idMethod, i);
-            if(!success)
-                {
-                break;
-                }
+            int unusedMethodId = UNDEFINED_INT;
+            success = mDb.addMethod(methodRow.mName, methodRow.mLineNum,
+                methodRow.mVisibility, methodRow.mConst, methodRow.mVirtual,
+                typeId, methodModuleId, unusedMethodId);
             }
         }
     return success;
     }
 
-bool DbWriter::writeTypeRefs(int &typeIndex, int maxTypesPerTransaction)
+bool DbWriter::writeClassRefsRow(DbClassRefsRow const &row)
     {
-    bool success = mDb.exec("begin");
-    size_t highestIndex = 0;
-    if(success && typeIndex == 0)
+    bool success = true;
+    for(size_t i=0; i<row.mMembers.size() && success; i++)
         {
-        success = writeAssociations();
+        success = mDb.addTypeRelation(row.mMembers[i].mTypeName, row.mName,
+            row.mMembers[i].mVisibility, OovDatabase::TR_Member);
         }
-    if(success)
+    int idClass = UNDEFINED_INT;
+    if(success && row.mMethods.size() > 0)
         {
-        for(size_t typei=typeIndex; typei<mModelData->mTypes.size() && success; typei++)
+        success = mDb.getTypeId(row.mName, true, idClass);
+        }
+    for(size_t methi=0; methi<row.mMethods.size() && success; methi++)
+        {
+        DbMethodRefsRow const &methodRow = row.mMethods[methi];
+        int idMethod = UNDEFINED_INT;
+        success = mDb.getMethodId(idClass, methodRow.mName, true, idMethod);
+        for(size_t vari=0; vari<methodRow.mVars.size() && success; vari++)
             {
-            highestIndex = typei;
-            ModelType const *typePtr = mModelData->mTypes[typei].get();
-            ModelClassifier const *cls = ModelType::getClass(typePtr);
-            if(cls)
+            DbVarRow const &varRow = methodRow.mVars[vari];
+            int idSupplierType = UNDEFINED_INT;
+            success = mDb.getTypeId(varRow.mTypeName, true, idSupplierType);
+            if(success)
                 {
-                int idClass = UNDEFINED_INT;
-                success = writeDataMemberTypeRefs(cls);
+                success = mDb.addMethodTypeRef(varRow.mVarName,
+                    varRow.mVarRel, idMethod, idSupplierType);
+                }
+            }
+        for(size_t stmti=0; stmti<methodRow.mStatements.size() && success; stmti++)
+            {
+            success = writeStatement(methodRow.mStatements[stmti], idMethod, stmti);
+            }
+        }
+    return success;
+    }
+
+bool DbWriter::writeStatement(DbStatementRow const &row, int idMethod,
+        int statementIndex)
+    {
+    bool success = true;
+    int idSupplierType = UNDEFINED_INT;
+    int idSupplierMethod = UNDEFINED_INT;
+    switch(row.mStatementType)
+        {
+        case ST_Call:
+            if(row.mHaveType)
+                {
+                // Hide the supplier type since the method will
+                // uniquely identify the class.
+                int idSupplierClassTemp;
+                success = mDb.getTypeId(row.mTypeName, true,
+                    idSupplierClassTemp);
                 if(success)
                     {
-                    success = mDb.getTypeId(cls->getName(), true, idClass);
+                    success = mDb.getMethodId(idSupplierClassTemp,
+                        row.mMethodName, false, idSupplierMethod);
                     }
-                if(success)
+                // Some methods cannot be found in the class. For now, define
+                // them with an ending '#' to indicate they were created.
+                if(success && idSupplierMethod == UNDEFINED_INT)
                     {
-                    for(auto const &oper : cls->getOperations())
-                        {
-                        int idMethod = UNDEFINED_INT;
-                        success = mDb.getMethodId(idClass,
-                            oper->getOverloadFuncName(), true, idMethod);
-                        if(success)
-                            {
-                            success = writeMethodTypeRefs(idMethod, oper.get());
-                            }
-                        if(!success)
-                            {
-                            break;
-                            }
-                        }
+                    idSupplierMethod = 0;
+                    OovString name = row.mMethodName;
+                    name += '#';
+                    success = mDb.addMethod(name, 0, 0, 0, 0,
+                        idSupplierClassTemp, 0, idSupplierMethod);
                     }
                 }
-            if(--maxTypesPerTransaction <= 0)
+            break;
+
+        case ST_VarRef:
+            if(row.mHaveType)
                 {
-                break;
+                success = mDb.getTypeId(row.mTypeName, true, idSupplierType);
                 }
-            }
-        }
-    if(success)
-        {
-        success = mDb.exec("end");
+            break;
+
+        default:
+            break;
         }
     if(success)
         {
-        typeIndex = highestIndex;
+        success = mDb.addStatement(row.mStatementType, statementIndex, idMethod,
+            idSupplierType, idSupplierMethod);
         }
     return success;
     }
@@ -482,8 +1016,11 @@ bool DbWriter::writeAssociations()
         ModelAssociation *assoc = mModelData->mAssociations[i].get();
         const ModelClassifier *child = assoc->getChild();
         const ModelClassifier *parent = assoc->getParent();
-        success = mDb.addTypeRelation(parent->getName(), child->getName(),
-            assoc->getAccess().getVis(), OovDatabase::TR_Inheritance);
+        if(isModuleChanged(child->getModule()))
+            {
+            success = mDb.addTypeRelation(parent->getName(), child->getName(),
+                assoc->getAccess().getVis(), OovDatabase::TR_Inheritance);
+            }
         }
     if(success)
         {
@@ -494,7 +1031,10 @@ bool DbWriter::writeAssociations()
 
 void DbWriter::closeDatabase()
     {
-    mDb.closeDb();
+    stopPass();
+    // Commit anything that was written if the writing was stopped early.
+    mDb.endTransaction();
+    mDb.closeDatabase();
     }
 
 extern "C"
@@ -19,7 +19,9 @@
 extern "C"
 {
 SHAREDSHARED_EXPORT bool OpenDb(char const *projectDir, void const *modelData);
-/// typeIndex is updated to the last successfully written index.
+/// The types are written by other threads.  This waits until at least
+/// maxTypesPerTransaction more types are written, and typeIndex is updated
+/// to the number of types that are written minus one.
 SHAREDSHARED_EXPORT bool WriteDb(int passIndex, int &typeIndex,
     int maxTypesPerTransaction);
 SHAREDSHARED_EXPORT bool WriteDbComponentTypes(void const *compTypesFile,
@@ -17,7 +17,9 @@
 extern "C"
 {
 typedef struct sqlite3 sqlite3;
+typedef struct sqlite3_stmt sqlite3_stmt;
 typedef int (*SQLite_callback)(void*,int,char**,char**);
+typedef void (*SQLite_destructor)(void*);
 
 struct SQLiteInterface
     {
@@ -27,12 +29,29 @@ struct SQLiteInterface
         SQLite_callback callback, void *callback_data,
         char **errmsg);
     void (*sqlite3_free)(void*);
+    int (*sqlite3_prepare_v2)(sqlite3 *pDb, const char *sql, int numBytes,
+        sqlite3_stmt **ppStmt, const char **pzTail);
+    int (*sqlite3_bind_int)(sqlite3_stmt *pStmt, int index, int val);
+    int (*sqlite3_bind_null)(sqlite3_stmt *pStmt, int index);
+    int (*sqlite3_bind_text)(sqlite3_stmt *pStmt, int index, const char *val,
+        int numBytes, SQLite_destructor destructor);
+    int (*sqlite3_step)(sqlite3_stmt *pStmt);
+    int (*sqlite3_reset)(sqlite3_stmt *pStmt);
+    int (*sqlite3_finalize)(sqlite3_stmt *pStmt);
+    int (*sqlite3_column_int)(sqlite3_stmt *pStmt, int col);
+    const unsigned char *(*sqlite3_column_text)(sqlite3_stmt *pStmt, int col);
+    long long (*sqlite3_last_insert_rowid)(sqlite3 *pDb);
+    const char *(*sqlite3_errmsg)(sqlite3 *pDb);
     };
 };
 
 // This is normally defined in sqlite3.h, so if more error codes are needed,
 // get them from there.
 #define SQLITE_OK 0
+#define SQLITE_ROW 100
+#define SQLITE_DONE 101
+// This makes SQLite copy bound strings.
+#define SQLITE_TRANSIENT ((SQLite_destructor)-1)
 
 /// This loads the symbols from the DLL into the interface.
 class SQLiteImporter:public SQLiteInterface, public OovLibrary
@@ -45,6 +64,18 @@ class SQLiteImporter:public SQLiteInterface, public OovLibrary
             loadModuleSymbol("sqlite3_exec", (OovProcPtr*)&sqlite3_exec);
             // This must be called for returned error strings.
             loadModuleSymbol("sqlite3_free", (OovProcPtr*)&sqlite3_free);
+            loadModuleSymbol("sqlite3_prepare_v2", (OovProcPtr*)&sqlite3_prepare_v2);
+            loadModuleSymbol("sqlite3_bind_int", (OovProcPtr*)&sqlite3_bind_int);
+            loadModuleSymbol("sqlite3_bind_null", (OovProcPtr*)&sqlite3_bind_null);
+            loadModuleSymbol("sqlite3_bind_text", (OovProcPtr*)&sqlite3_bind_text);
+            loadModuleSymbol("sqlite3_step", (OovProcPtr*)&sqlite3_step);
+            loadModuleSymbol("sqlite3_reset", (OovProcPtr*)&sqlite3_reset);
+            loadModuleSymbol("sqlite3_finalize", (OovProcPtr*)&sqlite3_finalize);
+            loadModuleSymbol("sqlite3_column_int", (OovProcPtr*)&sqlite3_column_int);
+            loadModuleSymbol("sqlite3_column_text", (OovProcPtr*)&sqlite3_column_text);
+            loadModuleSymbol("sqlite3_last_insert_rowid",
+                (OovProcPtr*)&sqlite3_last_insert_rowid);
+            loadModuleSymbol("sqlite3_errmsg", (OovProcPtr*)&sqlite3_errmsg);
             }
     };
 
@@ -104,8 +135,12 @@ class SQLite:public SQLiteImporter
                 }
             return success;
             }
+        /// Returns the row ID of the last row that was inserted.
+        int getLastInsertRowId()
+            { return static_cast<int>(sqlite3_last_insert_rowid(mDb)); }
         /// This is called from the destructor, so does not need an additional
-        /// call unless it must be closed early.
+        /// call unless it must be closed early.  All statements must be
+        /// finalized first.
         void closeDb()
             {
             if(mDb)
@@ -116,6 +151,7 @@ class SQLite:public SQLiteImporter
             }
 
     private:
+        friend class SQLiteStatement;
         sqlite3 *mDb;
         SQLiteListener *mListener;
 
@@ -142,3 +178,94 @@ class SQLite:public SQLiteImporter
             return(retCode == SQLITE_OK);
             }
     };
+
+/// This is a wrapper for a prepared statement.  The SQL is compiled once,
+/// and then the statement can be run many times with different values
+/// bound to the parameters.  Parameter indices start at one.
+class SQLiteStatement
+    {
+    public:
+        SQLiteStatement():
+            mSQLite(nullptr), mStmt(nullptr)
+            {}
+        ~SQLiteStatement()
+            {
+            finalize();
+            }
+        bool isPrepared() const
+            { return(mStmt != nullptr); }
+        /// Compile the SQL. The database must be open.
+        bool prepare(SQLite &sqlite, char const *sql)
+            {
+            finalize();
+            mSQLite = &sqlite;
+            int retCode = sqlite.sqlite3_prepare_v2(sqlite.mDb, sql, -1,
+                &mStmt, nullptr);
+            return handleRetCode(retCode);
+            }
+        bool bindInt(int index, int val)
+            { return handleRetCode(mSQLite->sqlite3_bind_int(mStmt, index, val)); }
+        /// A null string binds an SQL NULL.
+        bool bindText(int index, char const *val)
+            {
+            int retCode;
+            if(val)
+                {
+                retCode = mSQLite->sqlite3_bind_text(mStmt, index, val, -1,
+                    SQLITE_TRANSIENT);
+                }
+            else
+                {
+                retCode = mSQLite->sqlite3_bind_null(mStmt, index);
+                }
+            return handleRetCode(retCode);
+            }
+        /// Run the statement until the next result row.
+        /// @param haveRow Set true if a result row can be read.
+        bool step(bool &haveRow)
+            {
+            int retCode = mSQLite->sqlite3_step(mStmt);
+            haveRow = (retCode == SQLITE_ROW);
+            return handleRetCode((retCode == SQLITE_ROW || retCode == SQLITE_DONE) ?
+                SQLITE_OK : retCode);
+            }
+        /// Run a statement that does not return results, and reset the
+        /// statement so that it can be run again.
+        bool execStep()
+            {
+            bool haveRow;
+            bool success = step(haveRow);
+            reset();
+            return success;
+            }
+        int getColumnInt(int col)
+            { return mSQLite->sqlite3_column_int(mStmt, col); }
+        char const *getColumnText(int col)
+            {
+            char const *text = reinterpret_cast<char const *>(
+                mSQLite->sqlite3_column_text(mStmt, col));
+            return(text ? text : "");
+            }
+        /// Allows the statement to be run again.  The bound values are kept.
+        void reset()
+            { mSQLite->sqlite3_reset(mStmt); }
+        void finalize()
+            {
+            if(mStmt)
+                {
+                mSQLite->sqlite3_finalize(mStmt);
+                mStmt = nullptr;
+                }
+            }
+
+    private:
+        SQLite *mSQLite;
+        sqlite3_stmt *mStmt;
+
+        bool handleRetCode(int retCode)
+            {
+            char const *errStr = (retCode != SQLITE_OK) ?
+                mSQLite->sqlite3_errmsg(mSQLite->mDb) : nullptr;
+            return mSQLite->handleRetCode(retCode, errStr);
+            }
+    };
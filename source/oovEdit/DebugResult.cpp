@@ -61,6 +61,17 @@ DebugResult::DebugResult(DebugResult &&src)
         }
     }
 
+DebugResult &DebugResult::operator=(DebugResult &&src)
+    {
+    if(this != &src)
+        {
+        mVarName = src.mVarName;
+        mValue = src.mValue;
+        mChildResults = std::move(src.mChildResults);
+        }
+    return *this;
+    }
+
 DebugResult &DebugResult::addResult()
     {
     DebugResult *newRes = new DebugResult();
@@ -33,6 +33,7 @@ class DebugResult
         DebugResult()
             {}
         DebugResult(DebugResult &&src);
+        DebugResult &operator=(DebugResult &&src);
         char const *parseResult(OovStringRef const resultStr);
         std::string getAsString(int level=0) const;
         void setVarName(OovStringRef name)
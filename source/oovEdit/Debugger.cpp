@@ -81,7 +81,12 @@ OovString DebuggerBase::getStack()
 DebugResult const DebuggerBase::getVarValue()
     {
     LockGuard lock(mStatusLock);
-    DebugResult res(std::move(mVarValue));
+    DebugResult res;
+    if(!mVarValues.empty())
+        {
+        res = std::move(mVarValues.front());
+        mVarValues.pop_front();
+        }
     return res;
     }
 
@@ -175,7 +180,7 @@ void DebuggerGdb::sendAddBreakpoint(const DebuggerBreakpoint &br)
     {
     OovString command = "-break-insert -f ";
     command += br.getAsString();
-    sendMiCommand(command);
+    sendMiCommand(command, MiCommand(MCT_Breakpoint));
     }
 
 void DebuggerGdb::sendDeleteBreakpoint(const DebuggerBreakpoint &br)
@@ -264,7 +269,7 @@ void DebuggerGdb::ensureGdbChildRunning()
         }
     }
 
-void DebuggerGdb::startGetVariable(OovStringRef const variable)
+OovString DebuggerGdb::makeEvaluateCommand(OovStringRef const variable) const
     {
     OovString cmd = "-data-evaluate-expression ";
     cmd += "--thread ";
@@ -273,13 +278,52 @@ void DebuggerGdb::startGetVariable(OovStringRef const variable)
     cmd.appendInt(mFrameNumber, 10);
     cmd += ' ';
     cmd += variable;
-    mGetVariableName = variable;
-    sendMiCommand(cmd);
+    return cmd;
+    }
+
+void DebuggerGdb::startGetVariable(OovStringRef const variable)
+    {
+        {
+        LockGuard lock(mStatusLock);
+        mWatchedValues.insert(std::make_pair(OovString(variable), std::string()));
+        }
+    sendMiCommand(makeEvaluateCommand(variable), MiCommand(MCT_Value, variable));
+    }
+
+void DebuggerGdb::removeWatchedVariable(OovStringRef const variable)
+    {
+    LockGuard lock(mStatusLock);
+    mWatchedValues.erase(variable.getStr());
+    }
+
+// All of the commands are sent with one write, and GDB returns the results
+// in order, so there is no wait between commands.
+void DebuggerGdb::startRefreshVariables()
+    {
+    OovStringVec variables;
+        {
+        LockGuard lock(mStatusLock);
+        for(auto const &watched : mWatchedValues)
+            {
+            variables.push_back(watched.first);
+            }
+        }
+    OovString cmds;
+    for(auto const &variable : variables)
+        {
+        cmds += makeMiCommand(makeEvaluateCommand(variable),
+            MiCommand(MCT_RefreshValue, variable));
+        cmds += "\r\n";
+        }
+    if(cmds.length() > 0)
+        {
+        sendCommand(cmds);
+        }
     }
 
 void DebuggerGdb::startGetStack()
     {
-    sendMiCommand("-stack-list-frames");
+    sendMiCommand("-stack-list-frames", MiCommand(MCT_Stack));
     }
 
 void DebuggerGdb::startGetMemory(OovStringRef const addr)
@@ -289,12 +333,37 @@ void DebuggerGdb::startGetMemory(OovStringRef const addr)
     sendMiCommand(cmd);
     }
 
-void DebuggerGdb::sendMiCommand(OovStringRef const command)
+OovString DebuggerGdb::makeMiCommand(OovStringRef const command,
+        MiCommand const &miCmd)
     {
+    int token = ++mCommandIndex;
+    if(miCmd.mType != MCT_Other)
+        {
+        LockGuard lock(mStatusLock);
+        mPendingCommands[token] = miCmd;
+        }
     OovString cmd;
-    cmd.appendInt(++mCommandIndex);
+    cmd.appendInt(token);
     cmd.append(command);
-    sendCommand(cmd);
+    return cmd;
+    }
+
+void DebuggerGdb::sendMiCommand(OovStringRef const command, MiCommand const &miCmd)
+    {
+    sendCommand(makeMiCommand(command, miCmd));
+    }
+
+DebuggerGdb::MiCommand DebuggerGdb::takePendingCommand(int token)
+    {
+    LockGuard lock(mStatusLock);
+    MiCommand miCmd;
+    auto iter = mPendingCommands.find(token);
+    if(iter != mPendingCommands.end())
+        {
+        miCmd = iter->second;
+        mPendingCommands.erase(iter);
+        }
+    return miCmd;
     }
 
 void DebuggerGdb::sendCommand(OovStringRef const command)
@@ -453,23 +522,36 @@ void DebuggerGdb::handleBreakpoint(const std::string &resultStr)
         }
     }
 
-void DebuggerGdb::handleValue(const std::string &resultStr)
+// A refreshed value is only returned if it changed since the last time
+// the variable value was returned, so that the variable tree is not
+// updated for values that did not change.
+void DebuggerGdb::handleValue(const std::string &resultStr, MiCommand const &miCmd)
     {
-    mVarValue.parseResult(resultStr);
-//    DebugResult debRes;
-//    debRes.parseResult(resultStr);
-//    mVarValue = mGetVariableName;
-//    mGetVariableName.clear();
-//    mVarValue += " : ";
-//    mVarValue += debRes.getAsString();
+    DebugResult value;
+    value.parseResult(resultStr);
 
     // The normal top level variable returned by GDB is "value", which seems
     // pretty useless, so just change it to the requested variable name.
-    mVarValue.setVarName(mGetVariableName);
-    mGetVariableName.clear();
-    updateChangeStatus(DCS_Value);
-//    if(mDebuggerListener)
-//        mDebuggerListener->DebugOutput(mVarValue.getAsString());
+    value.setVarName(miCmd.mVarName);
+    bool changed = true;
+        {
+        LockGuard lock(mStatusLock);
+        auto iter = mWatchedValues.find(miCmd.mVarName);
+        if(iter != mWatchedValues.end())
+            {
+            std::string valueStr = value.getAsString();
+            changed = (miCmd.mType == MCT_Value || iter->second != valueStr);
+            iter->second = valueStr;
+            }
+        if(changed)
+            {
+            mVarValues.push_back(std::move(value));
+            }
+        }
+    if(changed)
+        {
+        updateChangeStatus(DCS_Value);
+        }
     }
 
 // 99^done,stack=[
@@ -519,14 +601,19 @@ void DebuggerGdb::handleResult(const std::string &resultStr)
     if(isdigit(resultStr[0]))
         {
         size_t pos = 0;
+        int token = 0;
         while(isdigit(resultStr[pos]))
             {
+            token = token * 10 + (resultStr[pos] - '0');
             pos++;
             }
         switch(resultStr[pos+0])
             {
             case '^':
                 {
+                // The results may not be in the same order as the commands,
+                // so the token is used to find the command for the result.
+                MiCommand miCmd = takePendingCommand(token);
                 // After ^ is the "result-class":
                 //      running, done, connected, error, exit
                 if(compareSubstr(resultStr, pos+1, "running") == 0)
@@ -544,7 +631,8 @@ void DebuggerGdb::handleResult(const std::string &resultStr)
                     if(variableNamePos != std::string::npos)
                         {
                         variableNamePos++;
-                        if(compareSubstr(resultStr, variableNamePos, "bkpt=") == 0)
+                        if(miCmd.mType == MCT_Breakpoint &&
+                            compareSubstr(resultStr, variableNamePos, "bkpt=") == 0)
                             {
                             std::string typeStr = getTagValue(resultStr, "type");
                             if(typeStr.compare("breakpoint") == 0)
@@ -552,13 +640,16 @@ void DebuggerGdb::handleResult(const std::string &resultStr)
                                 handleBreakpoint(resultStr);
                                 }
                             }
-                        else if(compareSubstr(resultStr, variableNamePos, "stack=") == 0)
+                        else if(miCmd.mType == MCT_Stack &&
+                            compareSubstr(resultStr, variableNamePos, "stack=") == 0)
                             {
                             handleStack(resultStr);
                             }
-                        else if(compareSubstr(resultStr, variableNamePos, "value=") == 0)
+                        else if((miCmd.mType == MCT_Value ||
+                            miCmd.mType == MCT_RefreshValue) &&
+                            compareSubstr(resultStr, variableNamePos, "value=") == 0)
                             {
-                            handleValue(resultStr.substr(variableNamePos));
+                            handleValue(resultStr.substr(variableNamePos), miCmd);
                             }
                         }
                     }
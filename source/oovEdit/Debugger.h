@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <vector>
 #include <queue>
+#include <map>
 
 
 #define USE_LLDB 0
@@ -145,6 +146,7 @@ class DebuggerBase
         eDebuggerChangeStatus getChangeStatus();
         DebuggerChildStates getChildState();
         OovString getStack();
+        /// There is a value for each DCS_Value change status.
         DebugResult const getVarValue();
         // Returns empty filename if not stopped.
         DebuggerLocation getStoppedLocation();
@@ -161,7 +163,7 @@ class DebuggerBase
         // Thread protected data
         std::string mDebuggerOutputBuffer;
         OovString mStack;
-        DebugResult mVarValue;
+        std::deque<DebugResult> mVarValues;
         DebuggerChildStates mDebuggerChildState;
         InProcMutex mStatusLock;
         std::queue<eDebuggerChangeStatus> mChangeStatusQueue;
@@ -262,18 +264,44 @@ class DebuggerGdb:public OovProcessListener, public DebuggerBase
 
         /// This allows the user to send a typed in debugger command.
         void sendCommand(OovStringRef const command) override;
+        /// Get the value of a variable. The variable is added to the watched
+        /// variables that are updated by startRefreshVariables.
         void startGetVariable(OovStringRef const variable);
+        /// The variable will not be updated by startRefreshVariables.
+        void removeWatchedVariable(OovStringRef const variable);
+        /// Get the values of all watched variables. The commands are sent
+        /// together without waiting for results, and only the values that
+        /// changed since they were last returned are returned.
+        void startRefreshVariables();
         void startGetStack();
         void startGetMemory(OovStringRef const addr);
 
     private:
+        enum eMiCommandTypes { MCT_Other, MCT_Breakpoint, MCT_Stack,
+            MCT_Value, MCT_RefreshValue };
+        /// The information needed to handle the result of a command.
+        struct MiCommand
+            {
+            MiCommand(eMiCommandTypes type=MCT_Other,
+                OovStringRef const varName=""):
+                mType(type), mVarName(varName)
+                {}
+            eMiCommandTypes mType;
+            OovString mVarName;
+            };
         OovBackgroundPipeProcess mBkgPipeProc;
         int mCommandIndex;
         // Frame numbers start at 0
         int mFrameNumber;
         // Thread numbers start at 1
         int mCurrentThread;
-        std::string mGetVariableName;
+        // The commands that do not have results yet. The key is the token
+        // that is sent before the command, and that GDB puts before the
+        // result. Protected by mStatusLock.
+        std::map<int, MiCommand> mPendingCommands;
+        // The watched variables and their last values. Protected by
+        // mStatusLock.
+        std::map<OovString, std::string> mWatchedValues;
 
         void resetFrameNumber()
             { mFrameNumber = 0; }
@@ -281,11 +309,17 @@ class DebuggerGdb:public OovProcessListener, public DebuggerBase
         void ensureGdbChildRunning();
         void sendAddBreakpoint(const DebuggerBreakpoint &br);
         void sendDeleteBreakpoint(const DebuggerBreakpoint &br);
-        void sendMiCommand(OovStringRef const command);
+        void sendMiCommand(OovStringRef const command,
+            MiCommand const &miCmd=MiCommand());
+        /// Adds the command to the pending commands, and returns the command
+        /// with the token.
+        OovString makeMiCommand(OovStringRef const command, MiCommand const &miCmd);
+        OovString makeEvaluateCommand(OovStringRef const variable) const;
+        MiCommand takePendingCommand(int token);
         void handleResult(const std::string &resultStr);
         void handleBreakpoint(const std::string &resultStr);
         void handleStack(const std::string &resultStr);
-        void handleValue(const std::string &resultStr);
+        void handleValue(const std::string &resultStr, MiCommand const &miCmd);
         virtual void onStdOut(OovStringRef const out, size_t len) override;
         virtual void onStdErr(OovStringRef const out, size_t len) override;
     };
@@ -176,7 +176,9 @@ void EditFiles::onIdle()
     idleHighlight();
     for(auto &fv : mFileViews)
         {
-        if(fv->mDesiredLine != -1)
+        fv->mFileView.idleLoad();
+        // The line is not available until the file is loaded.
+        if(fv->mDesiredLine != -1 && !fv->mFileView.isLoading())
             {
 #if(DBG_EDITF)
             sDbgFile.printflush("onIdle file %s line %d\n",
@@ -582,6 +584,8 @@ void EditFiles::viewFile(OovStringRef const fn, int lineNum)
             /// @todo - use make_unique when supported.
             ScrolledFileView *scrolledView = new ScrolledFileView(mProject, mDebugger);
             scrolledView->mFileView.init(GTK_TEXT_VIEW(editView), this);
+            scrolledView->mFileView.setHistoryMemoryLimit(
+                mEditOptions.getUndoMemoryLimit());
             OovStatus status = scrolledView->mFileView.openTextFile(fp);
             if(status.needReport())
                 {
@@ -717,6 +721,10 @@ void EditFiles::viewModule(OovStringRef const fn, int lineNum)
 void EditFiles::setFocusEditTextView(GtkTextView *editTextView)
     {
     mLastFocusGtkTextView = editTextView;
+    if(getEditView())
+        {
+        getEditView()->getHighlighter().setFocus();
+        }
     }
 
 bool EditFiles::handleKeyPress(GdkEvent *event)
@@ -841,6 +849,18 @@ void EditFiles::textBufferModified(FileEditView *editView, bool modified)
     setTabText(editView, text);
     }
 
+void EditFiles::loadProgress(FileEditView *editView, int percent)
+    {
+    OovString text = editView->getFileName();
+    if(percent < 100)
+        {
+        text += ' ';
+        text.appendInt(percent);
+        text += '%';
+        }
+    setTabText(editView, text);
+    }
+
 void EditFiles::bufferInsertText(GtkTextBuffer *textbuffer, GtkTextIter *location,
         gchar *text, gint len)
     {
@@ -153,6 +153,7 @@ class EditFiles:public FileEditViewListener
         int getPageNumber(GtkNotebook *notebook, GtkTextView const *view) const;
         void setTabText(FileEditView *view, OovStringRef text);
         virtual void textBufferModified(FileEditView *view, bool modified) override;
+        virtual void loadProgress(FileEditView *view, int percent) override;
         GtkNotebook *getBook(FileEditView *view);
     };
 
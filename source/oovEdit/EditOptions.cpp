@@ -8,6 +8,8 @@
 #include "EditOptions.h"
 #include "FilePath.h"
 #include "OovString.h"
+#include "History.h"
+#include <limits.h>
 
 void EditOptions::setProjectDir(std::string projDir)
     {
@@ -79,3 +81,15 @@ bool EditOptions::getScreenSize(int &width, int &height)
     return gotPos;
     }
 
+
+size_t EditOptions::getUndoMemoryLimit() const
+    {
+    size_t limit = History::DefaultMemoryLimit;
+    OovString str = getValue(OptEditUndoMemoryLimitKB);
+    int limitKB;
+    if(str.length() > 0 && str.getInt(1, INT_MAX / 1024, limitKB))
+        {
+        limit = static_cast<size_t>(limitKB) * 1024;
+        }
+    return limit;
+    }
@@ -14,6 +14,7 @@
 #define OptEditDebuggee "Debuggee"
 #define OptEditDebuggeeArgs "DebuggeeArgs"
 #define OptEditDebuggerWorkingDir "DebuggerWorkDir"
+#define OptEditUndoMemoryLimitKB "UndoMemoryLimitKB"
 
 class EditOptions:public NameValueFile
     {
@@ -23,6 +24,8 @@ class EditOptions:public NameValueFile
         void saveScreenSize(int width, int height);
         bool getScreenCoord(char const * const tag, int &val);
         bool getScreenSize(int &width, int &height);
+        /// Get the number of bytes of undo history for each file.
+        size_t getUndoMemoryLimit() const;
     };
 
 
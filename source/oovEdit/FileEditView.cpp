@@ -12,6 +12,7 @@
 #include "Builder.h"
 #include "EditFiles.h"
 #include <string.h>
+#include <algorithm>
 
 
 #include "IncludeMap.h"
@@ -469,54 +470,128 @@ void FileEditView::init(GtkTextView *textView, FileEditViewListener *listener)
     g_signal_connect(G_OBJECT(mTextView), "draw", G_CALLBACK(draw), this);
     }
 
+// Files that are larger than this are loaded in parts during idle time.
+static size_t const BackgroundLoadFileSize = 1000000;
+// Files that are larger than this are not parsed by CLang.
+static size_t const LargeFileSize = 4000000;
+// The amount of the file that is loaded during each idle call.
+static size_t const LoadChunkSize = 256 * 1024;
+
 OovStatusReturn FileEditView::openTextFile(OovStringRef const fn)
     {
     DEB_EDIT(__FUNCTION__);
     mIsCppFile = isCppSource(fn) || isCppHeader(fn);
     setFileName(fn);
-    File file;
-    OovStatus status = file.open(fn, "rb");
+    OovStatus status = FileGetFileTime(fn, mOpenModifyTime);
     if(status.ok())
         {
-        status = file.seekEnd();
+        status = mLoadFile.open(fn);
         }
     if(status.ok())
         {
-        status = file.getModifyTime(mOpenModifyTime);
+        mLoadOffset = 0;
+        mLoading = true;
+        mLargeFile = (mLoadFile.getSize() > LargeFileSize);
+        gtk_text_view_set_editable(mTextView, FALSE);
+        if(mLoadFile.getSize() <= BackgroundLoadFileSize)
+            {
+            bool valid = true;
+            while(valid && mLoadOffset < mLoadFile.getSize())
+                {
+                valid = loadChunk();
+                }
+            finishLoad(valid);
+            }
         }
-    if(status.ok())
+    return(status);
+    }
+
+void FileEditView::idleLoad()
+    {
+    if(mLoading)
+        {
+        bool valid = loadChunk();
+        int percent = 100;
+        if(!valid || mLoadOffset >= mLoadFile.getSize())
+            {
+            finishLoad(valid);
+            }
+        else
+            {
+            percent = static_cast<int>(mLoadOffset * 100 / mLoadFile.getSize());
+            }
+        if(mListener)
+            {
+            mListener->loadProgress(this, percent);
+            }
+        }
+    }
+
+bool FileEditView::loadChunk()
+    {
+    char const *data = mLoadFile.getData() + mLoadOffset;
+    size_t len = std::min(mLoadFile.getSize() - mLoadOffset, LoadChunkSize);
+    if(mLoadOffset + len < mLoadFile.getSize())
         {
-        long fileSize = file.getFileSize();
-        if(fileSize >= 0 && fileSize < 10000000)
+        // End the part at the end of a line so that a UTF8 character or
+        // a "\r\n" is not split.
+        size_t lineLen = len;
+        while(lineLen > 0 && data[lineLen-1] != '\n')
+            {
+            lineLen--;
+            }
+        if(lineLen > 0)
+            {
+            len = lineLen;
+            }
+        else
             {
-            status = file.seekBegin();
-            if(status.ok())
+            while(len > 0 && (data[len] & 0xC0) == 0x80)
                 {
-                std::vector<char> buf(fileSize);
-                // actualCount can be less than fileSize on Windows due to /r/n
-                int actualCount = fread(&buf.front(), 1, fileSize, file.getFp());
-                if(actualCount > 0)
-                    {
-                    gtk_text_buffer_set_text(mTextBuffer, &buf.front(), actualCount);
-                    gtk_text_buffer_set_modified(mTextBuffer, FALSE);
-
-                    // text buffers can only handle UTF8 and will be empty in other cases
-                    // such as the copyright symbol (0xA9) in code.
-                    int bufCount = gtk_text_buffer_get_char_count(mTextBuffer);
-                    if(bufCount == 0)
-                        {
-                        OovStatus dummy(false, SC_File);
-                        OovString str = "File may contain non-ASCII or non-UTF8 characters: ";
-                        str += fn;
-                        dummy.report(ET_Error, str);
-//                        Gui::messageBox(str);
-                        }
-                    }
-                highlightRequest();
+                len--;
                 }
             }
         }
-    return(status);
+    // Text buffers can only handle UTF8, and will not insert text that
+    // has other characters such as the copyright symbol (0xA9) in code.
+    bool valid = g_utf8_validate(data, static_cast<gssize>(len), nullptr);
+    if(valid)
+        {
+        GtkTextIter endIter = GuiTextBuffer::getEndIter(mTextBuffer);
+        gtk_text_buffer_insert(mTextBuffer, &endIter, data, static_cast<gint>(len));
+        mLoadOffset += len;
+        }
+    return valid;
+    }
+
+void FileEditView::finishLoad(bool valid)
+    {
+    mLoadFile.close();
+    if(!valid)
+        {
+        // Do not allow a part of the file to be edited and saved.
+        gtk_text_buffer_set_text(mTextBuffer, "", 0);
+        OovStatus dummy(false, SC_File);
+        OovString str = "File may contain non-ASCII or non-UTF8 characters: ";
+        str += mFilePath;
+        dummy.report(ET_Error, str);
+        }
+    mLoading = false;
+    GtkTextIter startIter = GuiTextBuffer::getStartIter(mTextBuffer);
+    gtk_text_buffer_place_cursor(mTextBuffer, &startIter);
+    gtk_text_view_set_editable(mTextView, TRUE);
+    gtk_text_buffer_set_modified(mTextBuffer, FALSE);
+    if(mLargeFile)
+        {
+        OovString str = "The file is too large to parse, so only a simple "
+            "highlight is displayed: ";
+        str += mFilePath;
+        OovError::report(ET_Info, str);
+        }
+    else
+        {
+        highlightRequest();
+        }
     }
 
 std::string FileEditView::getFileName() const
@@ -557,7 +632,8 @@ bool FileEditView::viewChange(int &topOffset, int &botOffset)
     int height = gdk_window_get_height(textWindow);
     botOffset = textViewWindowToBufferOffset(textView, winX+width, winY+height);
     bool changed = (mLastViewTopOffset != topOffset ||
-            mLastViewBotOffset != botOffset || mHighlightTextContentChange);
+            mLastViewBotOffset != botOffset || mHighlightTextContentChange ||
+            mHighlighter.needsApplyTags());
     if(changed)
         {
         mLastViewTopOffset = topOffset;
@@ -577,7 +653,7 @@ GuiText FileEditView::getBuffer()
 void FileEditView::highlightRequest()
     {
     DEB_EDIT(__FUNCTION__);
-    if(mFilePath.length() && mIsCppFile)
+    if(mFilePath.length() && mIsCppFile && !mLargeFile)
         {
     //  int numArgs = 0;
     //  char const * cppArgv[40];
@@ -649,8 +725,19 @@ OovStatusReturn FileEditView::saveAsTextFile(OovStringRef const fn)
     OovString tempFn = fn;
     setFileName(fn);
     tempFn += ".tmp";
+    OovStatus status(true, SC_File);
+    if(mLoading)
+        {
+        // Saving a partly loaded file would remove the rest of the file.
+        Gui::messageBox("The file cannot be saved until it is loaded");
+        status.set(false, SC_User);
+        status.reported();
+        }
     File file;
-    OovStatus status = file.open(tempFn, "wb");
+    if(status.ok())
+        {
+        status = file.open(tempFn, "wb");
+        }
     if(status.ok())
         {
         int size = gtk_text_buffer_get_char_count(mTextBuffer);
@@ -810,26 +897,40 @@ void FileEditView::bufferInsertText(GtkTextBuffer *textbuffer, GtkTextIter *loca
         gchar *text, gint len)
     {
     DEB_EDIT(__FUNCTION__);
-    if(!doingHistory())
+    // The text that is inserted while loading is not an edit.
+    if(!mLoading)
         {
-        int offset = HistoryItem::getOffset(location);
-        addHistoryItem(HistoryItem(true, offset, text, len));
+        if(!doingHistory())
+            {
+            int offset = HistoryItem::getOffset(location);
+            addHistoryItem(true, offset, text, len);
+            }
+        mHighlighter.bufferChange(HistoryItem::getOffset(location), 0,
+            g_utf8_strlen(text, len), gtk_text_iter_get_line(location),
+            std::count(text, text+len, '\n'));
+        highlightRequest();
+        setModified(true);
         }
-    highlightRequest();
-    setModified(true);
     }
 
 void FileEditView::bufferDeleteRange(GtkTextBuffer *textbuffer, GtkTextIter *start,
         GtkTextIter *end)
     {
-    if(!doingHistory())
+    if(!mLoading)
         {
-        int offset = HistoryItem::getOffset(start);
-        GuiText str(gtk_text_buffer_get_text(textbuffer, start, end, false));
-        addHistoryItem(HistoryItem(false, offset, str, str.length()));
+        if(!doingHistory())
+            {
+            int offset = HistoryItem::getOffset(start);
+            GuiText str(gtk_text_buffer_get_text(textbuffer, start, end, false));
+            addHistoryItem(false, offset, str, str.length());
+            }
+        int startLine = gtk_text_iter_get_line(start);
+        mHighlighter.bufferChange(HistoryItem::getOffset(start),
+            HistoryItem::getOffset(end) - HistoryItem::getOffset(start), 0,
+            startLine, startLine - gtk_text_iter_get_line(end));
+        highlightRequest();
+        setModified(true);
         }
-    highlightRequest();
-    setModified(true);
     }
 
 void FileEditView::buttonPressSelect(int leftMarginWidth, double buttonX, double buttonY)
@@ -885,8 +986,18 @@ bool FileEditView::idleHighlight()
     {
 //    DEB_EDIT(__FUNCTION__);
     bool foundToken = false;
-    eHighlightTask task = mHighlighter.highlightUpdate(mTextView, getBuffer(),
-        gtk_text_buffer_get_char_count(mTextBuffer));
+    eHighlightTask task = HT_None;
+    if(mIsCppFile && !mLoading)
+        {
+        // The lexical tokens are displayed until the parse is complete.
+        mHighlighter.lexicalUpdate(mTextView);
+        // Large files are not parsed, so the buffer is not copied.
+        if(!mLargeFile)
+            {
+            task = mHighlighter.highlightUpdate(mTextView, getBuffer(),
+                gtk_text_buffer_get_char_count(mTextBuffer));
+            }
+        }
     if(task & HT_FindToken)
         {
         foundToken = true;
@@ -13,6 +13,7 @@
 #include "Indenter.h"
 #include "History.h"
 #include "Components.h"         // For isCppSource
+#include "File.h"
 
 
 #define USE_NEW_TIME 1
@@ -78,6 +79,10 @@ class FileEditViewListener
     {
     public:
         virtual void textBufferModified(class FileEditView *view, bool modified) = 0;
+        /// This is called while a file is loaded in the background.
+        /// @param percent The amount of the file that is loaded. This is 100
+        ///     when the load is complete.
+        virtual void loadProgress(class FileEditView *view, int percent) = 0;
     };
 
 class FileEditView
@@ -85,13 +90,22 @@ class FileEditView
     public:
         FileEditView(ProjectReader &project):
             mProject(project),
-            mTextView(nullptr), mTextBuffer(nullptr), mCurHistoryPos(0),
+            mTextView(nullptr), mTextBuffer(nullptr),
             mDoingHistory(false), mLastViewTopOffset(0), mLastViewBotOffset(0),
             mHighlightTextContentChange(false), mListener(nullptr),
-            mOpenModifyTime(0), mIsCppFile(false)
+            mOpenModifyTime(0), mIsCppFile(false), mLoadOffset(0),
+            mLoading(false), mLargeFile(false)
             {}
         void init(GtkTextView *textView, FileEditViewListener *listener);
+        /// Small files are loaded immediately. Larger files are loaded in
+        /// parts by idleLoad so that the GUI does not stop responding.
         OovStatusReturn openTextFile(OovStringRef const fn);
+        /// Loads the next part of a file that is being opened. This should be
+        /// called periodically from something like an idle function.
+        void idleLoad();
+        /// The view cannot be edited or saved while the file is loading.
+        bool isLoading() const
+            { return mLoading; }
         OovStatusReturn saveTextFile();
         OovStatusReturn saveAsTextFileWithDialog();
         bool checkExitSave();
@@ -135,25 +149,20 @@ class FileEditView
         void undo()
             {
             mDoingHistory = true;
-            if(mCurHistoryPos > 0)
-                { mHistoryItems[--mCurHistoryPos].undo(mTextBuffer); }
+            mHistory.undo(mTextBuffer);
             mDoingHistory = false;
             }
         void redo()
             {
             mDoingHistory = true;
-            if(mCurHistoryPos < mHistoryItems.size())
-                { mHistoryItems[mCurHistoryPos++].redo(mTextBuffer); }
+            mHistory.redo(mTextBuffer);
             mDoingHistory = false;
             }
-        void addHistoryItem(const HistoryItem &item)
-            {
-            if(mCurHistoryPos < mHistoryItems.size())
-                { mHistoryItems[mCurHistoryPos] = item; }
-            else
-                { mHistoryItems.push_back(item); }
-            mCurHistoryPos++;
-            }
+        void addHistoryItem(bool insert, size_t offset, char const *text, size_t len)
+            { mHistory.addItem(insert, offset, text, len); }
+        /// @param limit The number of bytes of undo history to keep.
+        void setHistoryMemoryLimit(size_t limit)
+            { mHistory.setMemoryLimit(limit); }
         bool doingHistory() const
             { return mDoingHistory; }
         GtkTextView *getTextView() const
@@ -209,8 +218,7 @@ class FileEditView
         std::string mFilePath;
         GtkTextView *mTextView;
         GtkTextBuffer *mTextBuffer;
-        std::vector<HistoryItem> mHistoryItems;
-        size_t mCurHistoryPos;          // Range is 0 to size()-1.
+        History mHistory;
         bool mDoingHistory;             // Doing undo or redo.
         int mLastViewTopOffset;
         int mLastViewBotOffset;
@@ -221,10 +229,20 @@ class FileEditView
         FileEditViewListener *mListener;
         time_t mOpenModifyTime;
         bool mIsCppFile;
+        // The file that is being loaded, and the amount that is loaded.
+        MappedFile mLoadFile;
+        size_t mLoadOffset;
+        bool mLoading;
+        // Large files are only highlighted with the lexical tokenizer
+        // since a CLang parse would take too long.
+        bool mLargeFile;
 
         void setFileName(OovStringRef const fn)
             { mFilePath = fn; }
         OovStatusReturn saveAsTextFile(OovStringRef const fn);
+        /// Returns false if the part of the file is not valid UTF8.
+        bool loadChunk();
+        void finishLoad(bool valid);
         void highlightRequest();
         void moveToIter(GtkTextIter startIter, GtkTextIter *endIter=NULL);
         GuiText getBuffer();
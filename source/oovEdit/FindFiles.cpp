@@ -0,0 +1,591 @@
+/*
+ * FindFiles.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#include "FindFiles.h"
+#include "FilePath.h"
+#include "DirList.h"
+#include "Components.h"
+#include "Project.h"
+#include "File.h"
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+static char const IndexFileHeader[] = "OOVTRI1\n";
+// Lines longer than this are truncated in the results.
+static size_t const MaxResultLineLength = 1000;
+// The results of a thread are moved to the shared results when they
+// are longer than this.
+static size_t const ResultBatchSize = 4096;
+
+
+FindPattern::FindPattern(OovStringRef const str, bool caseSensitive):
+    mStr(str), mCaseSensitive(caseSensitive), mFirstFold(0), mLastFold(0)
+    {
+    if(!mCaseSensitive)
+        {
+        for(auto &c : mStr)
+            {
+            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            }
+        if(mStr.length() > 0)
+            {
+            if(isalpha(static_cast<unsigned char>(mStr[0])))
+                mFirstFold = 0x20;
+            if(isalpha(static_cast<unsigned char>(mStr[mStr.length()-1])))
+                mLastFold = 0x20;
+            }
+        }
+    }
+
+bool FindPattern::matchAt(char const *buf) const
+    {
+    bool match = true;
+    if(mCaseSensitive)
+        {
+        match = (memcmp(buf, mStr.c_str(), mStr.length()) == 0);
+        }
+    else
+        {
+        for(size_t i=0; i<mStr.length(); i++)
+            {
+            if(tolower(static_cast<unsigned char>(buf[i])) != static_cast<unsigned char>(mStr[i]))
+                {
+                match = false;
+                break;
+                }
+            }
+        }
+    return match;
+    }
+
+char const *FindPattern::find(char const *buf, size_t len) const
+    {
+    char const *match = nullptr;
+    size_t patLen = mStr.length();
+    if(patLen > 0 && patLen <= len)
+        {
+        size_t lastStart = len - patLen;
+        size_t pos = 0;
+#if defined(__SSE2__)
+        // Compare the first and last characters of the pattern for 16
+        // positions at a time, and only check the whole pattern at the
+        // positions where both are equal.  When the search is not case
+        // sensitive, setting bit 0x20 converts upper case letters to lower
+        // case. This can cause some extra candidates, but those are rejected
+        // by matchAt.
+        __m128i first = _mm_set1_epi8(mStr[0]);
+        __m128i last = _mm_set1_epi8(mStr[patLen-1]);
+        __m128i firstFold = _mm_set1_epi8(mFirstFold);
+        __m128i lastFold = _mm_set1_epi8(mLastFold);
+        for(; pos + 16 <= lastStart + 1 && !match; pos += 16)
+            {
+            __m128i firstBlock = _mm_or_si128(firstFold, _mm_loadu_si128(
+                reinterpret_cast<__m128i const *>(&buf[pos])));
+            __m128i lastBlock = _mm_or_si128(lastFold, _mm_loadu_si128(
+                reinterpret_cast<__m128i const *>(&buf[pos + patLen - 1])));
+            unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(first, firstBlock),
+                _mm_cmpeq_epi8(last, lastBlock))));
+            for(int bit=0; mask != 0; bit++, mask >>= 1)
+                {
+                if((mask & 1) && matchAt(&buf[pos + bit]))
+                    {
+                    match = &buf[pos + bit];
+                    break;
+                    }
+                }
+            }
+#endif
+        for(; pos <= lastStart && !match; pos++)
+            {
+            if(matchAt(&buf[pos]))
+                {
+                match = &buf[pos];
+                }
+            }
+        }
+    return match;
+    }
+
+void FindPattern::getTrigrams(std::vector<uint32_t> &trigrams) const
+    {
+    FindTrigramIndex::getTrigrams(mStr.c_str(), mStr.length(), trigrams);
+    }
+
+
+///////////
+
+static inline uint8_t lowerByte(char c)
+    {
+    return static_cast<uint8_t>(tolower(static_cast<unsigned char>(c)));
+    }
+
+void FindTrigramIndex::getTrigrams(char const *buf, size_t len, Trigrams &trigrams)
+    {
+    trigrams.clear();
+    if(len >= 3)
+        {
+        trigrams.reserve(len - 2);
+        uint32_t tri = (lowerByte(buf[0]) << 8) | lowerByte(buf[1]);
+        for(size_t i=2; i<len; i++)
+            {
+            tri = ((tri << 8) | lowerByte(buf[i])) & 0xFFFFFF;
+            trigrams.push_back(tri);
+            }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+            trigrams.end());
+        }
+    }
+
+void FindTrigramIndex::startSearch()
+    {
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    for(auto &file : mFiles)
+        {
+        file.second.mFound = false;
+        }
+    }
+
+void FindTrigramIndex::removeNotFoundFiles()
+    {
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    for(auto iter = mFiles.begin(); iter != mFiles.end(); )
+        {
+        if(!(*iter).second.mFound)
+            {
+            iter = mFiles.erase(iter);
+            mModified = true;
+            }
+        else
+            {
+            ++iter;
+            }
+        }
+    }
+
+bool FindTrigramIndex::isSearchNeeded(OovStringRef const path, time_t modTime,
+    Trigrams const &searchTrigrams, bool &needIndex)
+    {
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    bool search = true;
+    auto iter = mFiles.find(path);
+    needIndex = (iter == mFiles.end() || (*iter).second.mModTime != modTime);
+    if(!needIndex)
+        {
+        FileEntry &entry = (*iter).second;
+        entry.mFound = true;
+        search = std::includes(entry.mTrigrams.begin(), entry.mTrigrams.end(),
+            searchTrigrams.begin(), searchTrigrams.end());
+        }
+    return search;
+    }
+
+void FindTrigramIndex::updateFile(OovStringRef const path, time_t modTime,
+    Trigrams &trigrams)
+    {
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    FileEntry &entry = mFiles[path];
+    entry.mModTime = modTime;
+    entry.mFound = true;
+    entry.mTrigrams.swap(trigrams);
+    mModified = true;
+    }
+
+// The file is a header, then for each file:
+//      uint32_t path length, path, int64_t modify time,
+//      uint32_t number of trigrams, uint32_t trigrams
+OovStatusReturn FindTrigramIndex::write(OovStringRef const fn)
+    {
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    File file;
+    OovStatus status = file.open(fn, "wb");
+    if(status.ok())
+        {
+        status = file.write(IndexFileHeader, sizeof(IndexFileHeader)-1);
+        for(auto const &fileEntry : mFiles)
+            {
+            if(!status.ok())
+                break;
+            uint32_t pathLen = static_cast<uint32_t>(fileEntry.first.length());
+            int64_t modTime = fileEntry.second.mModTime;
+            uint32_t numTrigrams = static_cast<uint32_t>(fileEntry.second.mTrigrams.size());
+            status = file.write(reinterpret_cast<char const*>(&pathLen), sizeof(pathLen));
+            if(status.ok())
+                status = file.write(fileEntry.first.c_str(), static_cast<int>(pathLen));
+            if(status.ok())
+                status = file.write(reinterpret_cast<char const*>(&modTime), sizeof(modTime));
+            if(status.ok())
+                status = file.write(reinterpret_cast<char const*>(&numTrigrams), sizeof(numTrigrams));
+            if(status.ok() && numTrigrams > 0)
+                {
+                status = file.write(reinterpret_cast<char const*>(
+                    fileEntry.second.mTrigrams.data()),
+                    static_cast<int>(numTrigrams * sizeof(uint32_t)));
+                }
+            }
+        }
+    if(status.ok())
+        {
+        mModified = false;
+        }
+    return status;
+    }
+
+template<typename T> static bool readIndexValue(char const *&pos,
+    char const *end, T &val)
+    {
+    bool success = (static_cast<size_t>(end - pos) >= sizeof(val));
+    if(success)
+        {
+        memcpy(&val, pos, sizeof(val));
+        pos += sizeof(val);
+        }
+    return success;
+    }
+
+// An index file that has a bad format is ignored, and will be rebuilt.
+OovStatusReturn FindTrigramIndex::read(OovStringRef const fn)
+    {
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    File file;
+    OovStatus status = file.open(fn, "rb");
+    std::vector<char> buf;
+    if(status.ok())
+        {
+        int size = 0;
+        status = file.getFileSize(size);
+        if(status.ok() && size > 0)
+            {
+            buf.resize(static_cast<size_t>(size));
+            status = file.read(buf.data(), size);
+            }
+        }
+    mFiles.clear();
+    mModified = false;
+    size_t headerLen = sizeof(IndexFileHeader)-1;
+    if(status.ok() && buf.size() >= headerLen &&
+        memcmp(buf.data(), IndexFileHeader, headerLen) == 0)
+        {
+        char const *pos = buf.data() + headerLen;
+        char const *end = buf.data() + buf.size();
+        bool success = true;
+        while(success && pos < end)
+            {
+            uint32_t pathLen = 0;
+            int64_t modTime = 0;
+            uint32_t numTrigrams = 0;
+            success = readIndexValue(pos, end, pathLen) &&
+                static_cast<size_t>(end - pos) >= pathLen;
+            if(success)
+                {
+                OovString path(pos, pathLen);
+                pos += pathLen;
+                success = readIndexValue(pos, end, modTime) &&
+                    readIndexValue(pos, end, numTrigrams) &&
+                    static_cast<size_t>(end - pos) / sizeof(uint32_t) >= numTrigrams;
+                if(success)
+                    {
+                    FileEntry &entry = mFiles[path];
+                    entry.mModTime = static_cast<time_t>(modTime);
+                    entry.mTrigrams.resize(numTrigrams);
+                    memcpy(entry.mTrigrams.data(), pos, numTrigrams * sizeof(uint32_t));
+                    pos += numTrigrams * sizeof(uint32_t);
+                    }
+                }
+            }
+        if(!success)
+            {
+            mFiles.clear();
+            }
+        }
+    return status;
+    }
+
+
+///////////
+
+/// This collects the names of the files to search.
+class FindFileCollector:public dirRecurser
+    {
+    public:
+        FindFileCollector(bool sourceOnly, std::atomic_bool const &cancel):
+            mSourceFilesOnly(sourceOnly), mCancel(cancel)
+            {}
+        std::vector<OovString> mPaths;
+
+    private:
+        bool mSourceFilesOnly;
+        std::atomic_bool const &mCancel;
+
+        virtual bool processFile(OovStringRef const filePath) override
+            {
+            FilePath ext(filePath, FP_File);
+            bool isSource = (isCppHeader(ext) || isCppSource(ext) || isJavaSource(ext));
+            if(mSourceFilesOnly ? isSource : true)
+                {
+                mPaths.push_back(filePath);
+                }
+            return !mCancel;
+            }
+    };
+
+
+///////////
+
+OovString FindFiles::getIndexFilename()
+    {
+    FilePath fn(Project::getProjectDirectory(), FP_Dir);
+    fn.appendFile("oovEditFindIndex.bin");
+    return fn;
+    }
+
+void FindFiles::startSearch(OovStringRef const srchStr, OovStringRef const path,
+    bool caseSensitive, bool sourceOnly, bool useIndex, GtkTextView *view)
+    {
+    cancel();
+    mView = view;
+    mSrchStr = srchStr;
+    mSrchPath = path;
+    mCaseSensitive = caseSensitive;
+    mSourceFilesOnly = sourceOnly;
+    mUseIndex = useIndex;
+    mNumMatches = 0;
+    mPathError = false;
+    if(mUseIndex && !mIndexRead)
+        {
+        mIndexRead = true;
+        OovString fn = getIndexFilename();
+        OovStatus status(true, SC_File);
+        if(FileIsFileOnDisk(fn, status))
+            {
+            status = mIndex.read(fn);
+            }
+        if(status.needReport())
+            {
+            OovString err = "Unable to read search index ";
+            err += fn;
+            status.report(ET_Error, err);
+            }
+        }
+    mShowedDone = false;
+    mSearching = true;
+    mSearchThread = std::thread(&FindFiles::searchThread, this);
+    }
+
+void FindFiles::cancel()
+    {
+    mCancel = true;
+    if(mSearchThread.joinable())
+        {
+        mSearchThread.join();
+        }
+    mCancel = false;
+    mSearching = false;
+    mShowedDone = true;
+    std::lock_guard<std::mutex> lock(mResultsMutex);
+    mResults.clear();
+    }
+
+void FindFiles::searchThread()
+    {
+    FindFileCollector collector(mSourceFilesOnly, mCancel);
+    OovStatus status = collector.recurseDirs(mSrchPath);
+    if(status.needReport())
+        {
+        // The error is reported from the GUI thread.
+        status.clearError();
+        mPathError = true;
+        }
+    if(mUseIndex)
+        {
+        mIndex.startSearch();
+        }
+    FindPattern pattern(mSrchStr, mCaseSensitive);
+    std::atomic_size_t nextFile(0);
+    unsigned int numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    numThreads = std::min<unsigned int>(numThreads,
+        std::max<size_t>(collector.mPaths.size(), 1));
+    std::vector<std::thread> workers;
+    for(unsigned int i=1; i<numThreads; i++)
+        {
+        workers.push_back(std::thread(&FindFiles::searchFiles, this,
+            std::cref(collector.mPaths), std::cref(pattern), std::ref(nextFile)));
+        }
+    searchFiles(collector.mPaths, pattern, nextFile);
+    for(auto &worker : workers)
+        {
+        worker.join();
+        }
+    if(mUseIndex && !mCancel && !mPathError)
+        {
+        mIndex.removeNotFoundFiles();
+        }
+    mSearching = false;
+    }
+
+void FindFiles::searchFiles(std::vector<OovString> const &paths,
+    FindPattern const &pattern, std::atomic_size_t &nextFile)
+    {
+    FindTrigramIndex::Trigrams searchTrigrams;
+    FindTrigramIndex::Trigrams fileTrigrams;
+    if(mUseIndex)
+        {
+        pattern.getTrigrams(searchTrigrams);
+        }
+    OovString results;
+    MappedFile fileBuf;
+    for(size_t fileIndex = nextFile++; fileIndex < paths.size() && !mCancel;
+        fileIndex = nextFile++)
+        {
+        OovString const &path = paths[fileIndex];
+        bool search = true;
+        bool needIndex = false;
+        time_t modTime = 0;
+        if(mUseIndex)
+            {
+            OovStatus status = FileGetFileTime(path, modTime);
+            if(status.ok())
+                {
+                search = mIndex.isSearchNeeded(path, modTime, searchTrigrams,
+                    needIndex);
+                }
+            status.clearError();
+            }
+        OovStatus status(true, SC_File);
+        if(search)
+            {
+            status = fileBuf.open(path);
+            // Errors are not reported. The file is simply not searched.
+            status.clearError();
+            }
+        if(search && fileBuf.getData())
+            {
+            if(needIndex)
+                {
+                FindTrigramIndex::getTrigrams(fileBuf.getData(),
+                    fileBuf.getSize(), fileTrigrams);
+                mIndex.updateFile(path, modTime, fileTrigrams);
+                }
+            searchBuffer(path, fileBuf.getData(), fileBuf.getSize(), pattern,
+                results);
+            fileBuf.close();
+            }
+        if(results.length() > ResultBatchSize)
+            {
+            std::lock_guard<std::mutex> lock(mResultsMutex);
+            mResults += results;
+            results.clear();
+            }
+        }
+    if(results.length() > 0)
+        {
+        std::lock_guard<std::mutex> lock(mResultsMutex);
+        mResults += results;
+        }
+    }
+
+// Each line that contains a match is added once to the results.
+void FindFiles::searchBuffer(OovStringRef const path, char const *buf,
+    size_t len, FindPattern const &pattern, OovString &results)
+    {
+    char const *end = buf + len;
+    char const *lineCountPos = buf;
+    int lineNum = 1;
+    char const *pos = buf;
+    while(pos < end)
+        {
+        char const *match = pattern.find(pos, static_cast<size_t>(end - pos));
+        if(!match)
+            {
+            break;
+            }
+        lineNum += static_cast<int>(std::count(lineCountPos, match, '\n'));
+        char const *lineStart = match;
+        while(lineStart > buf && lineStart[-1] != '\n')
+            {
+            lineStart--;
+            }
+        char const *lineEnd = static_cast<char const *>(memchr(match, '\n',
+            static_cast<size_t>(end - match)));
+        if(!lineEnd)
+            {
+            lineEnd = end;
+            }
+        size_t lineLen = std::min(static_cast<size_t>(lineEnd - lineStart),
+            MaxResultLineLength);
+        results += path;
+        results += ':';
+        results.appendInt(lineNum);
+        results += "   ";
+        results.append(lineStart, lineLen);
+        if(results.length() > 0 && results[results.length()-1] == '\r')
+            {
+            results.resize(results.length()-1);
+            }
+        results += '\n';
+        mNumMatches++;
+        lineCountPos = match;
+        pos = lineEnd;
+        }
+    }
+
+void FindFiles::idleUpdate()
+    {
+    OovString results;
+        {
+        std::lock_guard<std::mutex> lock(mResultsMutex);
+        results.swap(mResults);
+        }
+    if(results.length() > 0 && mView)
+        {
+        Gui::appendText(mView, results);
+        }
+    if(!mShowedDone && !mSearching)
+        {
+        mShowedDone = true;
+        if(mSearchThread.joinable())
+            {
+            mSearchThread.join();
+            }
+        // The last results may have been added after the swap above.
+        results.clear();
+        std::lock_guard<std::mutex> lock(mResultsMutex);
+        results.swap(mResults);
+        OovString matchStr = "Found ";
+        matchStr.appendInt(mNumMatches);
+        matchStr += " matches";
+        results += matchStr;
+        if(mView)
+            {
+            Gui::appendText(mView, results);
+            }
+        if(mPathError)
+            {
+            OovStatus status(false, SC_File);
+            OovString err = "Unable to search path ";
+            err += mSrchPath;
+            status.report(ET_Error, err);
+            }
+        if(mIndex.isModified())
+            {
+            OovString fn = getIndexFilename();
+            OovStatus status = mIndex.write(fn);
+            if(status.needReport())
+                {
+                OovString err = "Unable to write search index ";
+                err += fn;
+                status.report(ET_Error, err);
+                }
+            }
+        }
+    }
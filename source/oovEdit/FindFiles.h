@@ -0,0 +1,156 @@
+/*
+ * FindFiles.h
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#ifndef FINDFILES_H_
+#define FINDFILES_H_
+
+#include "OovString.h"
+#include "OovError.h"
+#include "Gui.h"
+#include <stdint.h>
+#include <time.h>
+#include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+
+/// The string to search for, and a fast function to find the string in
+/// a buffer.
+class FindPattern
+    {
+    public:
+        FindPattern(OovStringRef const str, bool caseSensitive);
+        /// Returns a pointer to the first match in the buffer, or nullptr if
+        /// there is no match.
+        char const *find(char const *buf, size_t len) const;
+        /// Get the lower case trigrams of the pattern.
+        void getTrigrams(std::vector<uint32_t> &trigrams) const;
+
+    private:
+        // This is lower case if the search is not case sensitive.
+        OovString mStr;
+        bool mCaseSensitive;
+        // This is set to the bit that makes a letter lower case when the
+        // first or last character of the pattern is a letter and the
+        // search is not case sensitive.
+        char mFirstFold;
+        char mLastFold;
+
+        bool matchAt(char const *buf) const;
+    };
+
+
+/// This keeps the lower case trigrams that are in each file, so that files
+/// that cannot contain the search string do not have to be read. A file that
+/// is not in the index, or that was modified since it was indexed, is always
+/// searched and the index is updated.
+///
+/// The functions that are used during a search are thread safe.
+class FindTrigramIndex
+    {
+    public:
+        typedef std::vector<uint32_t> Trigrams;
+        FindTrigramIndex():
+            mModified(false)
+            {}
+        OovStatusReturn read(OovStringRef const fn);
+        OovStatusReturn write(OovStringRef const fn);
+        bool isModified() const
+            { return mModified; }
+        bool isEmpty() const
+            { return mFiles.empty(); }
+        /// Marks all files as not found, so that files that are removed from
+        /// the directories can be removed from the index.
+        void startSearch();
+        /// Remove the files that were not found since startSearch.
+        void removeNotFoundFiles();
+        /// Returns true if the file must be searched. The file will not be
+        /// searched if the index is up to date and does not contain one of
+        /// the search trigrams.
+        /// @param needIndex Set to true if the trigrams for the file should be
+        ///     updated.
+        bool isSearchNeeded(OovStringRef const path, time_t modTime,
+            Trigrams const &searchTrigrams, bool &needIndex);
+        void updateFile(OovStringRef const path, time_t modTime,
+            Trigrams &trigrams);
+        /// Get the sorted unique lower case trigrams in the buffer.
+        static void getTrigrams(char const *buf, size_t len, Trigrams &trigrams);
+
+    private:
+        struct FileEntry
+            {
+            FileEntry():
+                mModTime(0), mFound(false)
+                {}
+            time_t mModTime;
+            bool mFound;
+            Trigrams mTrigrams;
+            };
+        std::map<OovString, FileEntry> mFiles;
+        std::mutex mIndexMutex;
+        bool mModified;
+    };
+
+
+/// This searches all files in a directory on worker threads. The results are
+/// collected in batches so that the view is updated with few GTK calls.
+///
+/// The idleUpdate function must be called periodically from the GUI thread
+/// to display the results.
+class FindFiles
+    {
+    public:
+        FindFiles():
+            mView(nullptr), mCaseSensitive(false), mSourceFilesOnly(false),
+            mUseIndex(false), mCancel(false), mSearching(false),
+            mPathError(false), mNumMatches(0), mShowedDone(true),
+            mIndexRead(false)
+            {}
+        ~FindFiles()
+            { cancel(); }
+        /// Start searching on a background thread. This cancels a search
+        /// that is in progress.
+        void startSearch(OovStringRef const srchStr, OovStringRef const path,
+            bool caseSensitive, bool sourceOnly, bool useIndex, GtkTextView *view);
+        /// Stop a search that is in progress, and wait for the threads.
+        void cancel();
+        /// Appends the results to the view. This must be called from the
+        /// GUI thread.
+        void idleUpdate();
+
+    private:
+        GtkTextView *mView;
+        OovString mSrchStr;
+        OovString mSrchPath;
+        bool mCaseSensitive;
+        bool mSourceFilesOnly;
+        bool mUseIndex;
+        std::thread mSearchThread;
+        std::atomic_bool mCancel;
+        std::atomic_bool mSearching;
+        std::atomic_bool mPathError;
+        std::atomic_int mNumMatches;
+        bool mShowedDone;
+        // The index is read once, and kept between searches.
+        bool mIndexRead;
+        FindTrigramIndex mIndex;
+
+        // These are protected by mResultsMutex.
+        std::mutex mResultsMutex;
+        OovString mResults;
+
+        void searchThread();
+        void searchFiles(std::vector<OovString> const &paths,
+            FindPattern const &pattern, std::atomic_size_t &nextFile);
+        void searchBuffer(OovStringRef const path, char const *buf, size_t len,
+            FindPattern const &pattern, OovString &results);
+        static OovString getIndexFilename();
+    };
+
+#endif
@@ -6,17 +6,18 @@
  */
 
 #include "Highlighter.h"
+#include "LexTokenizer.h"
 #include "Debug.h"
 #include "ModelObjects.h"       // for getBaseType
 #include "ControlWindow.h"
+#include "Project.h"
+#include "File.h"
+#include "FilePath.h"
+#include "BuildConfigReader.h"
 #include <chrono>
 #include <algorithm>
-
-
-#if(SHARED_QUEUE)
-HighlighterSharedQueue Highlighter::sSharedQueue;
-#endif
-
+#include <string.h>
+#include <stdint.h>
 
 
 #define DEBUG_LOCK 0
@@ -24,7 +25,6 @@ HighlighterSharedQueue Highlighter::sSharedQueue;
 #include <sstream>
 #endif
 
-std::mutex mTransUnitMutex;
 void CLangLock::lock(int line, class Tokenizer *tok)
     {
     mTransUnitMutex.lock();
@@ -58,6 +58,7 @@ static std::string getDisposedString(CXString const &xstr)
 
 #define DEBUG_PARSE 0
 #define DEBUG_HIGHLIGHT 0
+#define DEBUG_PARSE_STATS 0
 
 #if(DEBUG_PARSE)
 static DebugFile sLog("DebugEditParse.txt", false);
@@ -121,31 +122,335 @@ static void dump(char const * const str, int val)
 #define DUMP_THREAD(str)
 #endif
 
+#if(DEBUG_PARSE_STATS)
+static DebugFile sStatsLog("DebugEditParseStats.txt", false);
+static void dumpParseStats(HighlightParseStats const &stats)
+    {
+    fprintf(sStatsLog.mFp, "Parse time %d ms, parses %d, skipped %d, cancelled %d\n",
+        stats.mParseTimeMs, stats.mParses, stats.getSkippedParses(),
+        stats.mCancelledParses);
+    fflush(sStatsLog.mFp);
+    }
+#define DUMP_PARSE_STATS(stats) dumpParseStats(stats);
+#else
+#define DUMP_PARSE_STATS(stats)
+#endif
+
 
-void TokenRange::tokenize(CXTranslationUnit transUnit)
+void TokenRange::tokenize(CXTranslationUnit transUnit, CXFile file,
+        unsigned int startOffset, unsigned int endOffset)
     {
-    CXCursor cursor = clang_getTranslationUnitCursor(transUnit);
-    CXSourceRange range = clang_getCursorExtent(cursor);
+    CXSourceRange range = clang_getRange(
+        clang_getLocationForOffset(transUnit, file, startOffset),
+        clang_getLocationForOffset(transUnit, file, endOffset));
 
     CXToken *tokens = 0;
     unsigned int numTokens = 0;
     clang_tokenize(transUnit, range, &tokens, &numTokens);
-    resize(numTokens);
-    if(numTokens > 0)
+    clear();
+    reserve(numTokens);
+    for (size_t i = 0; i < numTokens; i++)
         {
-        for (size_t i = 0; i < numTokens-1; i++)
+        Token tok;
+        tok.setKind(clang_getTokenKind(tokens[i]));
+        CXSourceRange tokRange = clang_getTokenExtent(transUnit, tokens[i]);
+        clang_getExpansionLocation(clang_getRangeStart(tokRange), NULL, NULL,
+            NULL, &tok.mStartOffset);
+        clang_getExpansionLocation(clang_getRangeEnd(tokRange), NULL, NULL,
+            NULL, &tok.mEndOffset);
+        // The token at the end location is not in the range.
+        if(tok.mStartOffset < endOffset)
             {
-            at(i).setKind(clang_getTokenKind(tokens[i]));
-            CXSourceRange tokRange = clang_getTokenExtent(transUnit, tokens[i]);
-            clang_getExpansionLocation(clang_getRangeStart(tokRange), NULL, NULL,
-                NULL, &at(i).mStartOffset);
-            clang_getExpansionLocation(clang_getRangeEnd(tokRange), NULL, NULL,
-                NULL, &at(i).mEndOffset);
+            push_back(tok);
             }
         }
     clang_disposeTokens(transUnit, tokens, numTokens);
     }
 
+void TokenRange::replaceRange(TokenRange const &newTokens,
+        unsigned int startOffset, unsigned int endOffset)
+    {
+    // The last new token can extend past the end offset.
+    if(newTokens.size() > 0)
+        {
+        endOffset = std::max(endOffset, newTokens.back().mEndOffset);
+        }
+    auto first = begin() + findFirstToken(startOffset);
+    auto last = std::lower_bound(first, end(), endOffset,
+        [](Token const &tok, unsigned int offset)
+        { return(tok.mStartOffset < offset); });
+    size_t pos = erase(first, last) - begin();
+    insert(begin() + pos, newTokens.begin(), newTokens.end());
+    }
+
+void TokenRange::adjustForEdit(unsigned int offset, unsigned int deleteLen,
+        unsigned int insertLen)
+    {
+    // The tokens before the edit do not change, and the tokens that
+    // overlap the edit are removed.
+    size_t numTokens = findFirstToken(offset);
+    for(size_t i=numTokens; i<size(); i++)
+        {
+        Token tok = at(i);
+        if(tok.mStartOffset >= offset + deleteLen)
+            {
+            tok.mStartOffset = tok.mStartOffset - deleteLen + insertLen;
+            tok.mEndOffset = tok.mEndOffset - deleteLen + insertLen;
+            at(numTokens++) = tok;
+            }
+        }
+    resize(numTokens);
+    }
+
+size_t TokenRange::findFirstToken(unsigned int offset) const
+    {
+    auto iter = std::lower_bound(begin(), end(), offset,
+        [](Token const &tok, unsigned int off)
+        { return(tok.mEndOffset <= off); });
+    return(iter - begin());
+    }
+
+
+
+/// Get the include lines at the start of the buffer. Blank lines, comments,
+/// and an include guard are skipped.  The include of the header that has the
+/// same name as the source file is not returned since it is different for
+/// each source file, and would prevent sharing.
+static OovString getIncludePrefix(OovStringRef const srcFileName,
+        OovStringRef const buffer, size_t bufLen)
+    {
+    FilePath srcPath(srcFileName, FP_File);
+    OovString srcName = srcPath.getName();
+    OovString includes;
+    OovString guardName;
+    bool inComment = false;
+    char const * const buf = buffer.getStr();
+    size_t pos = 0;
+    while(pos < bufLen)
+        {
+        size_t endPos = pos;
+        while(endPos < bufLen && buf[endPos] != '\n')
+            {
+            endPos++;
+            }
+        OovString line = StringTrim(std::string(&buf[pos], endPos-pos).c_str());
+        pos = endPos + 1;
+        if(inComment)
+            {
+            inComment = (line.find("*/") == std::string::npos);
+            continue;
+            }
+        if(line.length() == 0 || line.compare(0, 2, "//") == 0)
+            {
+            continue;
+            }
+        if(line.compare(0, 2, "/*") == 0)
+            {
+            inComment = (line.find("*/") == std::string::npos);
+            continue;
+            }
+        if(line[0] != '#')
+            {
+            break;
+            }
+        OovStringVec words = StringSplit(line.substr(1).c_str(), ' ');
+        words.erase(std::remove(words.begin(), words.end(), ""), words.end());
+        if(words.size() == 0)
+            {
+            break;
+            }
+        if(words[0] == "include" && words.size() > 1)
+            {
+            FilePath incPath(words[1].substr(1, words[1].length()-2), FP_File);
+            if(incPath.getName() != srcName)
+                {
+                includes += line;
+                includes += '\n';
+                }
+            }
+        else if(includes.length() == 0 && guardName.length() == 0 &&
+                words[0] == "ifndef" && words.size() > 1)
+            {
+            guardName = words[1];
+            }
+        else if(words[0] == "define" && words.size() > 1 &&
+                words[1] == guardName)
+            {
+            guardName.clear();
+            }
+        else if(!(words[0] == "pragma" && words.size() > 1 && words[1] == "once"))
+            {
+            break;
+            }
+        }
+    return includes;
+    }
+
+static uint64_t getPreambleHash(OovStringRef const str)
+    {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for(char const *p = str.getStr(); *p; p++)
+        {
+        hash ^= static_cast<unsigned char>(*p);
+        hash *= 1099511628211ULL;
+        }
+    return hash;
+    }
+
+PreambleCache &PreambleCache::getCache()
+    {
+    static PreambleCache sCache;
+    return sCache;
+    }
+
+OovString PreambleCache::getPreamblePath(CXIndex index,
+        OovStringRef const srcFileName, OovStringRef const buffer, size_t bufLen,
+        char const * const clang_args[], size_t num_clang_args, bool rebuild)
+    {
+    OovString pchPath;
+    OovString includes = getIncludePrefix(srcFileName, buffer, bufLen);
+    if(includes.length() > 0)
+        {
+        // Quoted includes depend on the directory of the source file.
+        FilePath srcDir(srcFileName, FP_File);
+        srcDir.discardFilename();
+        OovString key = includes;
+        key += srcDir;
+        for(size_t i=0; i<num_clang_args; i++)
+            {
+            key += '\n';
+            key += clang_args[i];
+            }
+        char hashStr[20];
+        snprintf(hashStr, sizeof(hashStr), "%016llx",
+            static_cast<unsigned long long>(getPreambleHash(key)));
+        FilePath path(Project::getOutputDir(), FP_Dir);
+        path.appendDir("edit-pch");
+        path.appendFile(hashStr);
+        path.appendExtension("pch");
+
+        bool build = false;
+            {
+            std::unique_lock<std::mutex> lock(mCacheMutex);
+            // If another thread is building the same header, wait for it, and
+            // then use what it built instead of building it again.
+            if(mBuildingPaths.find(path) != mBuildingPaths.end())
+                {
+                mBuiltCondition.wait(lock, [this, &path]
+                    { return(mBuildingPaths.find(path) == mBuildingPaths.end()); });
+                rebuild = false;
+                }
+            if(mFailedPaths.find(path) == mFailedPaths.end())
+                {
+                OovStatus status(true, SC_File);
+                bool exists = path.isFileOnDisk(status);
+                if(status.needReport())
+                    {
+                    status.clearError();
+                    }
+                if(rebuild || !exists)
+                    {
+                    mBuildingPaths.insert(path);
+                    build = true;
+                    }
+                else
+                    {
+                    pchPath = path;
+                    }
+                }
+            }
+        if(build)
+            {
+            bool built = buildPreamble(index, srcFileName, includes, path,
+                clang_args, num_clang_args);
+                {
+                std::lock_guard<std::mutex> lock(mCacheMutex);
+                mBuildingPaths.erase(path);
+                if(built)
+                    {
+                    pchPath = path;
+                    }
+                else
+                    {
+                    mFailedPaths.insert(path);
+                    }
+                }
+            mBuiltCondition.notify_all();
+            }
+        }
+    return pchPath;
+    }
+
+bool PreambleCache::buildPreamble(CXIndex index, OovStringRef const srcFileName,
+        OovStringRef const includes, OovStringRef const pchPath,
+        char const * const clang_args[], size_t num_clang_args)
+    {
+    bool success = false;
+    FilePath hdrPath(pchPath, FP_File);
+    hdrPath.discardExtension();
+    hdrPath.appendExtension("h");
+    FilePath outDir(pchPath, FP_File);
+    outDir.discardFilename();
+    OovStatus status = FileEnsurePathExists(outDir);
+    if(status.ok())
+        {
+        File file;
+        status = file.open(hdrPath, "w");
+        if(status.ok())
+            {
+            status = file.putString(includes);
+            }
+        }
+    if(status.ok())
+        {
+        // The includes must be compiled as a header, and the quoted includes
+        // are found relative to the source file.
+        FilePath srcDir(srcFileName, FP_File);
+        srcDir.discardFilename();
+        OovStringVec args;
+        bool haveLang = false;
+        for(size_t i=0; i<num_clang_args; i++)
+            {
+            OovString arg = clang_args[i];
+            if(i > 0 && strcmp(clang_args[i-1], "-x") == 0)
+                {
+                if(arg.find("-header") == std::string::npos)
+                    {
+                    arg += "-header";
+                    }
+                haveLang = true;
+                }
+            args.push_back(arg);
+            }
+        if(!haveLang)
+            {
+            args.push_back("-x");
+            args.push_back("c++-header");
+            }
+        args.push_back(OovString("-I") + srcDir.getWithoutEndPathSep());
+        std::vector<char const *> argv;
+        for(auto const &arg : args)
+            {
+            argv.push_back(arg.getStr());
+            }
+        unsigned options = CXTranslationUnit_Incomplete |
+            CXTranslationUnit_ForSerialization;
+        CXTranslationUnit tu = clang_parseTranslationUnit(index, hdrPath.getStr(),
+            argv.data(), static_cast<int>(argv.size()), 0, 0, options);
+        if(tu)
+            {
+            success = (clang_saveTranslationUnit(tu, pchPath,
+                clang_defaultSaveOptions(tu)) == CXSaveError_None);
+            clang_disposeTranslationUnit(tu);
+            }
+        }
+    else
+        {
+        status.reported();
+        }
+    return success;
+    }
 
 
 Tokenizer::~Tokenizer()
@@ -173,16 +478,18 @@ void Tokenizer::parse(OovStringRef fileName, OovStringRef buffer, size_t bufLen,
             options |= CXTranslationUnit_DetailedPreprocessingRecord;
 
             mSourceFilename = fileName;
+            mSourceLength = bufLen;
             mContextIndex = clang_createIndex(1, 1);
-            mTransUnit = clang_parseTranslationUnit(mContextIndex, fileName,
-                clang_args, static_cast<int>(num_clang_args), 0, 0, options);
+            mTransUnit = parseWithPreamble(fileName, buffer, bufLen,
+                clang_args, num_clang_args, options);
             }
         else
             {
-            static CXUnsavedFile file;
+            CXUnsavedFile file;
             file.Filename = mSourceFilename.c_str();
             file.Contents = buffer;
             file.Length = bufLen;
+            mSourceLength = bufLen;
 
             unsigned options = clang_defaultReparseOptions(mTransUnit);
             int stat = clang_reparseTranslationUnit(mTransUnit, 1, &file, options);
@@ -200,18 +507,66 @@ void Tokenizer::parse(OovStringRef fileName, OovStringRef buffer, size_t bufLen,
         }
     }
 
-void Tokenizer::tokenize(/*int startLine, int endLine, */TokenRange &tokens)
+CXTranslationUnit Tokenizer::parseWithPreamble(OovStringRef fileName,
+        OovStringRef buffer, size_t bufLen, char const * const clang_args[],
+        size_t num_clang_args, unsigned options)
     {
+    CXTranslationUnit tu = nullptr;
+    // If the shared precompiled header is out of date, it is built again, and
+    // if that does not work, the file is parsed without it.  Clang returns
+    // CXError_ASTReadError when the precompiled header cannot be read, which
+    // usually means that a header changed after it was built.
+    bool readError = true;
+    for(int attempt=0; attempt<2 && readError; attempt++)
+        {
+        OovString pchPath = PreambleCache::getCache().getPreamblePath(
+            mContextIndex, fileName, buffer, bufLen, clang_args,
+            num_clang_args, attempt > 0);
+        if(pchPath.length() == 0)
+            {
+            break;
+            }
+        std::vector<char const *> args(clang_args, clang_args + num_clang_args);
+        args.push_back("-include-pch");
+        args.push_back(pchPath.getStr());
+        CXErrorCode errCode = clang_parseTranslationUnit2(mContextIndex,
+            fileName, args.data(), static_cast<int>(args.size()), 0, 0,
+            options, &tu);
+        readError = (errCode == CXError_ASTReadError);
+        if(errCode != CXError_Success)
+            {
+            tu = nullptr;
+            }
+        }
+    if(!tu)
+        {
+        tu = clang_parseTranslationUnit(mContextIndex, fileName,
+            clang_args, static_cast<int>(num_clang_args), 0, 0, options);
+        }
+    return tu;
+    }
+
+void Tokenizer::tokenize(TokenRange &tokens, size_t startOffset,
+        size_t endOffset)
+    {
+    tokens.clear();
+    CLangAutoLock lock(mCLangLock, __LINE__, this);
     if(mTransUnit)
         {
-        CLangAutoLock lock(mCLangLock, __LINE__, this);
-        tokens.tokenize(mTransUnit/*, mSourceFile, startLine, endLine*/);
+        endOffset = std::min(endOffset, mSourceLength);
+        if(mSourceFile && startOffset < endOffset)
+            {
+            tokens.tokenize(mTransUnit, mSourceFile,
+                static_cast<unsigned int>(startOffset),
+                static_cast<unsigned int>(endOffset));
+            }
         }
     }
 
 OovStringVec Tokenizer::getDiagResults()
     {
     OovStringVec diagResults;
+    CLangAutoLock lock(mCLangLock, __LINE__, this);
     if(mTransUnit)
         {
         int numDiags = clang_getNumDiagnostics(mTransUnit);
@@ -361,6 +716,72 @@ void Tokenizer::getLineColumn(size_t charOffset, unsigned int &line, unsigned in
     }
 
 
+SymbolIndex &Tokenizer::getSymbolIndex()
+    {
+    static SymbolIndex sSymbolIndex;
+    return sSymbolIndex;
+    }
+
+// The symbol files are read on a background thread when the editor starts,
+// and then only after the editor container indicates that an analysis was
+// run.  An error is reported by the GUI thread after the thread is done.
+static std::atomic<bool> sSymbolsChanged(true);
+static std::thread sSymbolThread;
+static std::atomic<bool> sSymbolThreadDone(false);
+static OovString sSymbolPath;
+static bool sSymbolError;
+
+static void readSymbols()
+    {
+    OovStatus status(true, SC_File);
+    // The analysis directory does not exist until an analysis is run.
+    if(FileIsDirOnDisk(sSymbolPath, status))
+        {
+        status = Tokenizer::getSymbolIndex().update(sSymbolPath);
+        }
+    sSymbolError = !status.ok();
+    if(status.needReport())
+        {
+        status.reported();
+        }
+    sSymbolThreadDone = true;
+    }
+
+void Tokenizer::setSymbolsChanged()
+    {
+    sSymbolsChanged = true;
+    }
+
+void Tokenizer::updateSymbolIndex()
+    {
+    if(sSymbolThread.joinable() && sSymbolThreadDone)
+        {
+        sSymbolThread.join();
+        if(sSymbolError)
+            {
+            OovStatus status(false, SC_File);
+            OovString err = "Unable to read symbols in ";
+            err += sSymbolPath;
+            status.report(ET_Error, err);
+            }
+        }
+    if(!sSymbolThread.joinable() && sSymbolsChanged.exchange(false))
+        {
+        BuildConfigReader cfg;
+        sSymbolPath = cfg.getAnalysisPath();
+        sSymbolThreadDone = false;
+        sSymbolThread = std::thread(readSymbols);
+        }
+    }
+
+void Tokenizer::stopSymbolIndex()
+    {
+    if(sSymbolThread.joinable())
+        {
+        sSymbolThread.join();
+        }
+    }
+
 // Desired functions:
 //      Go to definition of variable/function
 //      Go to declaration of function/class
@@ -423,7 +844,18 @@ bool Tokenizer::findToken(eFindTokenTypes ft, size_t origOffset, std::string &fn
             //  cursor = clang_getCursorSemanticParent(cursor);
             //  cursor = clang_getCursorLexicalParent(cursor);
             }
-        if(!clang_Cursor_isNull(cursor))
+        // The symbol index has the definitions from all translation
+        // units, so use it if the definition is not in this one.
+        SymbolRecord rec;
+        if(ft == FT_FindDef && !clang_Cursor_isNull(cursor) &&
+            !clang_isCursorDefinition(cursor) &&
+            getSymbolIndex().findUsr(getDisposedString(clang_getCursorUSR(cursor)),
+            true, rec) && rec.mDefinition)
+            {
+            fn = rec.mFilename;
+            line = rec.mLine;
+            }
+        else if(!clang_Cursor_isNull(cursor))
             {
             CXSourceLocation loc = clang_getCursorLocation(cursor);
 
@@ -615,6 +1047,13 @@ OovStringVec Tokenizer::getMembers(size_t offset)
             // CXCursor classCursor = clang_getCursorReferenced(startCursor);
             // classCursor = clang_getCursorDefinition(classCursor);
             clang_visitChildren(classCursor, ::visitClass, &data);
+            // If the class is only forward declared in this translation unit,
+            // get the members from the symbol index.
+            if(members.size() == 0)
+                {
+                members = getSymbolIndex().getMembers(
+                    getDisposedString(clang_getCursorUSR(classCursor)));
+                }
             }
         }
     else
@@ -642,13 +1081,172 @@ void HighlightTags::initTags(GtkTextBuffer *textBuffer)
 
 //////////////
 
+HighlighterThreadPool &HighlighterThreadPool::getPool()
+    {
+    // The pool is never deleted so that it is available to highlighters
+    // that are destroyed at exit.  The threads are stopped with stop().
+    static HighlighterThreadPool *sPool = new HighlighterThreadPool();
+    return *sPool;
+    }
+
+void HighlighterThreadPool::stop()
+    {
+        {
+        std::lock_guard<std::mutex> lock(mPoolMutex);
+        mStopping = true;
+        mTasks.clear();
+        }
+    mTaskAddedSignal.notify_all();
+    // The threads are not changed by addTask after mStopping is set.
+    for(auto &thread : mThreads)
+        {
+        thread.join();
+        }
+    mThreads.clear();
+    }
+
+void HighlighterThreadPool::addTask(HighlighterBackgroundThreadData *data,
+        HighlightTaskItem const &item)
+    {
+    std::lock_guard<std::mutex> lock(mPoolMutex);
+    bool merged = false;
+    if(item.getTask() == HT_Parse)
+        {
+        // The parse also tokenizes, so it replaces both.
+        mTasks.remove_if([data](PoolTask const &task)
+            {
+            return(task.mData == data && (task.mItem.getTask() == HT_Parse ||
+                task.mItem.getTask() == HT_Tokenize));
+            });
+        }
+    else if(item.getTask() == HT_Tokenize)
+        {
+        // A tokenize never replaces a parse, since the parse would be lost.
+        // The parse tokenizes the newer range instead.
+        for(auto &task : mTasks)
+            {
+            if(task.mData == data && task.mItem.getTask() == HT_Parse)
+                {
+                task.mItem.mTokenStartOffset = item.mTokenStartOffset;
+                task.mItem.mTokenEndOffset = item.mTokenEndOffset;
+                merged = true;
+                }
+            }
+        if(!merged)
+            {
+            mTasks.remove_if([data](PoolTask const &task)
+                {
+                return(task.mData == data &&
+                    task.mItem.getTask() == HT_Tokenize);
+                });
+            }
+        }
+    if(mThreads.size() == 0 && !mStopping)
+        {
+        // Parsing is mostly CPU bound, but a few threads are enough since
+        // usually only the visible views are active.
+        unsigned numThreads = std::max(std::min(
+            std::thread::hardware_concurrency(), 4u), 2u);
+        for(unsigned i=0; i<numThreads; i++)
+            {
+            mThreads.push_back(std::thread(&HighlighterThreadPool::workerThreadProc,
+                this));
+            }
+        }
+    if(!merged && !mStopping)
+        {
+        mTasks.push_back(PoolTask(data, item));
+        mTaskAddedSignal.notify_one();
+        }
+    }
+
+void HighlighterThreadPool::removeTasks(HighlighterBackgroundThreadData const *data)
+    {
+    std::unique_lock<std::mutex> lock(mPoolMutex);
+    mTasks.remove_if([data](PoolTask const &task)
+        { return(task.mData == data); });
+    if(mFocusData == data)
+        {
+        mFocusData = nullptr;
+        }
+    mTaskDoneSignal.wait(lock, [this, data]
+        { return(mBusyData.find(data) == mBusyData.end()); });
+    }
+
+bool HighlighterThreadPool::isBusy(HighlighterBackgroundThreadData const *data)
+    {
+    std::lock_guard<std::mutex> lock(mPoolMutex);
+    bool busy = (mBusyData.find(data) != mBusyData.end());
+    if(!busy)
+        {
+        busy = std::any_of(mTasks.begin(), mTasks.end(),
+            [data](PoolTask const &task)
+            { return(task.mData == data); });
+        }
+    return busy;
+    }
+
+void HighlighterThreadPool::setFocus(HighlighterBackgroundThreadData const *data)
+    {
+    std::lock_guard<std::mutex> lock(mPoolMutex);
+    mFocusData = data;
+    }
+
+bool HighlighterThreadPool::getNextTask(PoolTask &task)
+    {
+    auto foundIter = mTasks.end();
+    for(auto iter = mTasks.begin(); iter != mTasks.end(); ++iter)
+        {
+        if(mBusyData.find((*iter).mData) == mBusyData.end())
+            {
+            if(foundIter == mTasks.end())
+                {
+                foundIter = iter;
+                }
+            if((*iter).mData == mFocusData)
+                {
+                foundIter = iter;
+                break;
+                }
+            }
+        }
+    bool found = (foundIter != mTasks.end());
+    if(found)
+        {
+        task = *foundIter;
+        mTasks.erase(foundIter);
+        mBusyData.insert(task.mData);
+        }
+    return found;
+    }
+
+void HighlighterThreadPool::workerThreadProc()
+    {
+    std::unique_lock<std::mutex> lock(mPoolMutex);
+    while(!mStopping)
+        {
+        PoolTask task(nullptr, HighlightTaskItem());
+        mTaskAddedSignal.wait(lock, [this, &task]
+            { return(mStopping || getNextTask(task)); });
+        if(task.mData)
+            {
+            lock.unlock();
+            task.mData->processItem(task.mItem);
+            lock.lock();
+            mBusyData.erase(task.mData);
+            // Other tasks for the same highlighter may be waiting.
+            mTaskAddedSignal.notify_all();
+            mTaskDoneSignal.notify_all();
+            }
+        }
+    }
+
+
+//////////////
+
 HighlighterBackgroundThreadData::~HighlighterBackgroundThreadData()
     {
-#if(SHARED_QUEUE)
-    sSharedQueue.waitForCompletion();
-#else
-    stopAndWaitForCompletion();
-#endif
+    HighlighterThreadPool::getPool().removeTasks(this);
     }
 
 void HighlighterBackgroundThreadData::initArgs(OovStringRef const filename,
@@ -667,26 +1265,45 @@ void HighlighterBackgroundThreadData::initArgs(OovStringRef const filename,
 
 OovStringVec HighlighterBackgroundThreadData::getShowMembersResults()
     {
-    OovStringVec members = mShowMemberResults;
     std::lock_guard<std::mutex> lock(mResultsLock);
+    OovStringVec members = mShowMemberResults;
     mTaskResults = static_cast<eHighlightTask>(mTaskResults & ~HT_ShowMembers);
     return members;
     }
 
 TokenRange HighlighterBackgroundThreadData::getParseResults(
-    OovStringVec &diagStringResults)
+    OovStringVec &diagStringResults, size_t &startOffset, size_t &endOffset,
+    bool &parsed)
     {
     TokenRange retTokens;
     std::lock_guard<std::mutex> lock(mResultsLock);
+    parsed = false;
     if(mTaskResults & HT_Parse)
         {
         retTokens = std::move(mTokenResults);
-        diagStringResults = std::move(mDiagStringResults);
+        startOffset = mTokenResultStartOffset;
+        endOffset = mTokenResultEndOffset;
+        parsed = mParsedResults;
+        if(parsed)
+            {
+            diagStringResults = std::move(mDiagStringResults);
+            }
+        mParsedResults = false;
         mTaskResults = static_cast<eHighlightTask>(mTaskResults & ~HT_Parse);
         }
     return retTokens;
     }
 
+HighlightParseStats HighlighterBackgroundThreadData::getParseStats() const
+    {
+    HighlightParseStats stats;
+    stats.mRequests = mParseRequestCounter;
+    stats.mParses = mParseCount;
+    stats.mCancelledParses = mCancelledParseCount;
+    stats.mParseTimeMs = mParseTimeMs;
+    return stats;
+    }
+
 void HighlighterBackgroundThreadData::getFindTokenResults(std::string &fn,
     size_t &offset)
     {
@@ -696,22 +1313,109 @@ void HighlighterBackgroundThreadData::getFindTokenResults(std::string &fn,
     mTaskResults = static_cast<eHighlightTask>(mTaskResults & ~HT_FindToken);
     }
 
+/// Find the start of a line at or before the desired offset that is not
+/// within a comment or a string, so that tokenizing can start there.
+static size_t getTokenizeLineStart(OovString const &buf, size_t desiredOffset)
+    {
+    enum LexStates { LS_Code, LS_LineComment, LS_BlockComment, LS_String,
+        LS_Char };
+    LexStates state = LS_Code;
+    size_t lineStart = 0;
+    size_t endOffset = std::min(desiredOffset, buf.length());
+    for(size_t i=0; i<endOffset; i++)
+        {
+        char c = buf[i];
+        char nextC = (i+1 < buf.length()) ? buf[i+1] : '\0';
+        switch(state)
+            {
+            case LS_Code:
+                if(c == '/' && nextC == '/')
+                    { state = LS_LineComment; i++; }
+                else if(c == '/' && nextC == '*')
+                    { state = LS_BlockComment; i++; }
+                else if(c == '"')
+                    state = LS_String;
+                else if(c == '\'')
+                    state = LS_Char;
+                break;
+
+            case LS_LineComment:
+                if(c == '\\')
+                    i++;
+                else if(c == '\n')
+                    state = LS_Code;
+                break;
+
+            case LS_BlockComment:
+                if(c == '*' && nextC == '/')
+                    { state = LS_Code; i++; }
+                break;
+
+            case LS_String:
+            case LS_Char:
+                if(c == '\\')
+                    i++;
+                else if(c == '\n' || (c == '"' && state == LS_String) ||
+                        (c == '\'' && state == LS_Char))
+                    state = LS_Code;
+                break;
+            }
+        if(c == '\n' && state == LS_Code)
+            {
+            lineStart = i+1;
+            }
+        }
+    return lineStart;
+    }
+
 void HighlighterBackgroundThreadData::processItem(HighlightTaskItem const &item)
     {
     DUMP_THREAD("processItem");
     switch(item.getTask())
         {
         case HT_Parse:
+        case HT_Tokenize:
             {
             DUMP_THREAD("processItem-Parse");
-            int counter = mParseRequestCounter;
-            mTokenizer.parse(mFilename, item.mParseSourceBuffer,
-                item.mParseSourceBuffer.length(),
-                mClang_args.getArgv(), mClang_args.getArgc());
+            bool parse = (item.getTask() == HT_Parse);
+            if(parse)
+                {
+                mParseCount++;
+                auto startTime = std::chrono::steady_clock::now();
+                mParsedBuffer = item.mParseSourceBuffer;
+                mTokenizer.parse(mFilename, item.mParseSourceBuffer,
+                    item.mParseSourceBuffer.length(),
+                    mClang_args.getArgv(), mClang_args.getArgc());
+                int parseTimeMs = static_cast<int>(std::chrono::duration_cast<
+                    std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                    startTime).count());
+                mParseTimeMs = (mParseTimeMs == 0) ? parseTimeMs :
+                    (mParseTimeMs * 3 + parseTimeMs) / 4;
+                // The clang parse cannot be stopped, but if the buffer changed
+                // during the parse, the results are discarded so that the
+                // next parse can start sooner.
+                if(item.mParseRequestCounter != mParseRequestCounter)
+                    {
+                    mCancelledParseCount++;
+                    mParseFinishedCounter = item.mParseRequestCounter;
+                    break;
+                    }
+                }
+            size_t startOffset = getTokenizeLineStart(mParsedBuffer,
+                item.mTokenStartOffset);
+            size_t endOffset = std::min(item.mTokenEndOffset, mParsedBuffer.length());
+            TokenRange tokens;
+            mTokenizer.tokenize(tokens, startOffset, endOffset);
             std::lock_guard<std::mutex> lock(mResultsLock);
-            mParseFinishedCounter = counter;
-            mTokenizer.tokenize(mTokenResults);
-            mDiagStringResults = mTokenizer.getDiagResults();
+            mTokenResults = std::move(tokens);
+            mTokenResultStartOffset = startOffset;
+            mTokenResultEndOffset = endOffset;
+            if(parse)
+                {
+                mParseFinishedCounter = item.mParseRequestCounter;
+                mParsedResults = true;
+                mDiagStringResults = mTokenizer.getDiagResults();
+                }
             mTaskResults = static_cast<eHighlightTask>(mTaskResults | HT_Parse);
             DUMP_THREAD("processItem-Parse end");
             }
@@ -786,6 +1490,7 @@ void Highlighter::highlightRequest(
 //      startLineY = 1;
 
     mTokenState = TS_HighlightRequest;
+    mLastRequestTime = std::chrono::steady_clock::now();
     mBackgroundThreadData.initArgs(filename, clang_args, num_clang_args);
     mBackgroundThreadData.makeParseRequest();
     DUMP_THREAD("highlightRequest-end");
@@ -836,29 +1541,30 @@ eHighlightTask Highlighter::highlightUpdate(GtkTextView *textView,
         OovStringRef const buffer, size_t bufLen)
     {
     DUMP_THREAD("highlightUpdate");
-    if(mBackgroundThreadData.isParseNeeded())
+    int requestCounter = mBackgroundThreadData.getParseRequestCounter();
+    if(mBackgroundThreadData.isParseNeeded() && requestCounter != mQueuedParseCounter)
         {
-#if(SHARED_QUEUE)
-        if(!sSharedQueue.isQueueBusy())
-#else
-        if(!mBackgroundThreadData.isQueueBusy())
-#endif
+        // Wait for typing to pause. The delay is longer for files that take
+        // longer to parse, since each parse uses more of the CPU.
+        const int MinDelayMs = 30;
+        const int MaxDelayMs = 500;
+        int delayMs = std::max(MinDelayMs, std::min(
+            mBackgroundThreadData.getParseTimeMs() / 2, MaxDelayMs));
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - mLastRequestTime).count();
+        if(elapsedMs >= delayMs && bufLen > 0)
             {
             DUMP_THREAD("highlightUpdate - set parse task");
-#if(SHARED_QUEUE)
-            HighlightTaskItem task(this);
-#else
+            // This replaces a parse task that has not started, and a parse
+            // that is running will discard its results.
             HighlightTaskItem task;
-#endif
-            if(bufLen > 0)
-                {
-                task.setParseTask(buffer, bufLen);
-#if(SHARED_QUEUE)
-                sSharedQueue.addTask(task);
-#else
-                mBackgroundThreadData.addTask(task);
-#endif
-                }
+            size_t startOffset;
+            size_t endOffset;
+            getTokenizeRange(bufLen, startOffset, endOffset);
+            task.setParseTask(buffer, bufLen, startOffset, endOffset,
+                requestCounter);
+            mBackgroundThreadData.addTask(task);
+            mQueuedParseCounter = requestCounter;
             }
         }
 
@@ -866,25 +1572,60 @@ eHighlightTask Highlighter::highlightUpdate(GtkTextView *textView,
             mBackgroundThreadData.getTaskResults() & HT_Parse)
         {
         OovStringVec diagResults;
-        mHighlightTokens = mBackgroundThreadData.getParseResults(diagResults);
-        ControlWindow::showNotebookTab(ControlWindow::CT_Control);
-        GtkTextView *widget = GTK_TEXT_VIEW(ControlWindow::getTabView(
-            ControlWindow::CT_Control));
-        Gui::clear(widget);
-        for(auto const &str : diagResults)
-            {
-            OovError::report(ET_Info, str);
-            int endOffset;
-            int offset = getDiagBufferOffset(textView, str, endOffset);
-            Token token;
-            token.mStartOffset = offset;
-            token.mTokenKind = TK_Error;
-            token.mEndOffset = endOffset;
-            mHighlightTokens.push_back(token);
+        size_t startOffset = 0;
+        size_t endOffset = 0;
+        bool parsed;
+        TokenRange tokens = mBackgroundThreadData.getParseResults(diagResults,
+            startOffset, endOffset, parsed);
+        mHighlightTokens.replaceRange(tokens, startOffset, endOffset);
+        mTokenizedStartOffset = startOffset;
+        mTokenizedEndOffset = endOffset;
+        mTokenizeRequested = false;
+        if(parsed)
+            {
+            ControlWindow::showNotebookTab(ControlWindow::CT_Control);
+            GtkTextView *widget = GTK_TEXT_VIEW(ControlWindow::getTabView(
+                ControlWindow::CT_Control));
+            Gui::clear(widget);
+            mErrorTokens.clear();
+            for(auto const &str : diagResults)
+                {
+                OovError::report(ET_Info, str);
+                int endOffset;
+                int offset = getDiagBufferOffset(textView, str, endOffset);
+                if(offset != -1)
+                    {
+                    Token token;
+                    token.mStartOffset = offset;
+                    token.mTokenKind = TK_Error;
+                    token.mEndOffset = endOffset;
+                    mErrorTokens.push_back(token);
+                    }
+                }
+            std::sort(mErrorTokens.begin(), mErrorTokens.end(),
+                [](Token const &tok1, Token const &tok2)
+                { return(tok1.mStartOffset < tok2.mStartOffset); });
+            DUMP_PARSE_STATS(mBackgroundThreadData.getParseStats())
             }
         mTokenState = TS_GotTokens;
         gtk_widget_queue_draw(GTK_WIDGET(textView));
-//      applyTags(gtk_text_view_get_buffer(textView), );
+        }
+    else if(!mBackgroundThreadData.isParseNeeded() && !mTokenizeRequested &&
+            mTokenState != TS_HighlightRequest && mTokenizedEndOffset > 0 &&
+            !mBackgroundThreadData.isQueueBusy())
+        {
+        // The view has scrolled outside of the tokenized part of the buffer.
+        if(static_cast<size_t>(mVisibleTopOffset) < mTokenizedStartOffset ||
+                static_cast<size_t>(mVisibleBotOffset) > mTokenizedEndOffset)
+            {
+            HighlightTaskItem task;
+            size_t startOffset;
+            size_t endOffset;
+            getTokenizeRange(bufLen, startOffset, endOffset);
+            task.setTokenizeTask(startOffset, endOffset);
+            mTokenizeRequested = true;
+            mBackgroundThreadData.addTask(task);
+            }
         }
 
     DUMP_THREAD("highlightUpdate-end");
@@ -892,41 +1633,194 @@ eHighlightTask Highlighter::highlightUpdate(GtkTextView *textView,
     }
 
 
+void Highlighter::getTokenizeRange(size_t bufLen, size_t &startOffset,
+        size_t &endOffset) const
+    {
+    // The margin allows scrolling a bit without tokenizing again.
+    const size_t MinMargin = 4000;
+    size_t topOffset = static_cast<size_t>(std::max(mVisibleTopOffset, 0));
+    size_t botOffset = static_cast<size_t>(std::max(mVisibleBotOffset, 0));
+    size_t margin = MinMargin;
+    if(botOffset > topOffset)
+        {
+        margin = std::max(botOffset - topOffset, MinMargin);
+        }
+    startOffset = (topOffset > margin) ? topOffset - margin : 0;
+    endOffset = std::min(botOffset + margin, bufLen);
+    }
+
+void Highlighter::lexicalUpdate(GtkTextView *textView)
+    {
+    GtkTextBuffer *textBuffer = gtk_text_view_get_buffer(textView);
+    size_t bufLen = static_cast<size_t>(gtk_text_buffer_get_char_count(textBuffer));
+    if(mLexNeeded ||
+        static_cast<size_t>(mVisibleTopOffset) < mLexStartOffset ||
+        static_cast<size_t>(mVisibleBotOffset) > mLexEndOffset)
+        {
+        size_t startOffset;
+        size_t endOffset;
+        getTokenizeRange(bufLen, startOffset, endOffset);
+        // Start at the beginning of a line so that the lexer does not start
+        // within a token.
+        GtkTextIter startIter = GuiTextBuffer::getIterAtOffset(textBuffer,
+            static_cast<int>(startOffset));
+        gtk_text_iter_set_line_offset(&startIter, 0);
+        startOffset = GuiTextIter::getIterOffset(startIter);
+
+        // Only a limited part of the buffer before the start is checked to
+        // find whether the start is in a block comment.
+        const size_t CommentLookBack = 10000;
+        size_t lookStart = (startOffset > CommentLookBack) ?
+            startOffset - CommentLookBack : 0;
+        OovString prefix = GuiTextBuffer::getText(textBuffer,
+            static_cast<int>(lookStart), static_cast<int>(startOffset));
+        OovString text = GuiTextBuffer::getText(textBuffer,
+            static_cast<int>(startOffset), static_cast<int>(endOffset));
+        TokenRange tokens;
+        LexTokenizer::tokenize(text.getStr(), text.length(),
+            static_cast<unsigned int>(startOffset),
+            LexTokenizer::endsInComment(prefix.getStr(), prefix.length()), tokens);
+        // Only the tokens around the visible area are kept so that scrolling
+        // through a large file does not keep the tokens for the whole file.
+        mLexTokens = std::move(tokens);
+        mLexStartOffset = startOffset;
+        mLexEndOffset = endOffset;
+        mLexNeeded = false;
+        mLexApplyNeeded = true;
+        gtk_widget_queue_draw(GTK_WIDGET(textView));
+        }
+    }
+
+void Highlighter::bufferChange(int offset, int deleteLen, int insertLen,
+        int lineNum, int lineDelta)
+    {
+    mLexNeeded = true;
+    mHighlightTokens.adjustForEdit(offset, deleteLen, insertLen);
+    mLexTokens.adjustForEdit(offset, deleteLen, insertLen);
+    mErrorTokens.adjustForEdit(offset, deleteLen, insertLen);
+    auto moveOffset = [=](size_t off) -> size_t
+        {
+        size_t newOff = off;
+        if(off >= static_cast<size_t>(offset + deleteLen))
+            newOff = off - deleteLen + insertLen;
+        else if(off > static_cast<size_t>(offset))
+            newOff = offset;
+        return newOff;
+        };
+    mTokenizedStartOffset = moveOffset(mTokenizedStartOffset);
+    mTokenizedEndOffset = moveOffset(mTokenizedEndOffset);
+    mLexStartOffset = moveOffset(mLexStartOffset);
+    mLexEndOffset = moveOffset(mLexEndOffset);
+
+    // GTK moves the tags with the text, so the lines after the edit keep
+    // their tags, but the edited lines must be tagged again.
+    int lastEditLine = lineNum + std::max(-lineDelta, 0);
+    std::map<int, size_t> lineHashes;
+    for(auto const &lineHash : mAppliedLineHashes)
+        {
+        if(lineHash.first < lineNum)
+            {
+            lineHashes.insert(lineHash);
+            }
+        else if(lineHash.first > lastEditLine)
+            {
+            lineHashes[lineHash.first + lineDelta] = lineHash.second;
+            }
+        }
+    mAppliedLineHashes = std::move(lineHashes);
+    }
+
 void Highlighter::showMembers(size_t offset)
     {
     DUMP_THREAD("showMembers");
-#if(SHARED_QUEUE)
-    HighlightTaskItem task(this);
-#else
     HighlightTaskItem task;
-#endif
     task.setShowMembersTask(offset);
-#if(SHARED_QUEUE)
-    sSharedQueue.addTask(task);
-#else
     mBackgroundThreadData.addTask(task);
-#endif
     }
 
 void Highlighter::findToken(eFindTokenTypes ft, size_t origOffset)
     {
     DUMP_THREAD("findToken");
-#if(SHARED_QUEUE)
-    HighlightTaskItem task(this);
-#else
     HighlightTaskItem task;
-#endif
     task.setFindTokenTask(ft, origOffset);
-#if(SHARED_QUEUE)
-    sSharedQueue.addTask(task);
-#else
     mBackgroundThreadData.addTask(task);
-#endif
     }
 
-static bool isBetween(int offset, int top, int bot)
+/// Add the part of the token that is on the line.
+static void addLineToken(Token const &tok, unsigned int lineStart,
+        unsigned int lineEnd, TokenRange &lineTokens)
     {
-    return(offset > top && offset < bot);
+    if(tok.mStartOffset < lineEnd && tok.mEndOffset > lineStart)
+        {
+        Token lineTok = tok;
+        lineTok.mStartOffset = std::max(tok.mStartOffset, lineStart);
+        lineTok.mEndOffset = std::min(tok.mEndOffset, lineEnd);
+        lineTokens.push_back(lineTok);
+        }
+    }
+
+void Highlighter::applyLineTags(GtkTextBuffer *textBuffer, int lineNum)
+    {
+    GtkTextIter lineStartIter = GuiTextBuffer::getLineIter(textBuffer, lineNum);
+    GtkTextIter lineEndIter = lineStartIter;
+    // At the last line, this moves to the end of the buffer.
+    gtk_text_iter_forward_line(&lineEndIter);
+    unsigned int lineStart = GuiTextIter::getIterOffset(lineStartIter);
+    unsigned int lineEnd = GuiTextIter::getIterOffset(lineEndIter);
+
+    TokenRange lineTokens;
+    for(size_t i=mHighlightTokens.findFirstToken(lineStart);
+        i<mHighlightTokens.size() && mHighlightTokens[i].mStartOffset < lineEnd; i++)
+        {
+        addLineToken(mHighlightTokens[i], lineStart, lineEnd, lineTokens);
+        }
+    // The lexical tokens are only used for the text that does not have
+    // CLang tokens, such as text that has not been parsed or was edited.
+    size_t numCLangTokens = lineTokens.size();
+    for(size_t i=mLexTokens.findFirstToken(lineStart);
+        i<mLexTokens.size() && mLexTokens[i].mStartOffset < lineEnd; i++)
+        {
+        Token const &lexTok = mLexTokens[i];
+        bool overlap = std::any_of(lineTokens.begin(),
+            lineTokens.begin() + numCLangTokens, [&lexTok](Token const &tok)
+            {
+            return(tok.mStartOffset < lexTok.mEndOffset &&
+                tok.mEndOffset > lexTok.mStartOffset);
+            });
+        if(!overlap)
+            {
+            addLineToken(lexTok, lineStart, lineEnd, lineTokens);
+            }
+        }
+    for(auto const &tok : mErrorTokens)
+        {
+        addLineToken(tok, lineStart, lineEnd, lineTokens);
+        }
+
+    // The hash uses offsets from the start of the line so that lines that
+    // move do not have to be tagged again.
+    size_t hash = lineEnd - lineStart;
+    for(auto const &tok : lineTokens)
+        {
+        hash = hash * 31 + tok.mTokenKind;
+        hash = hash * 31 + (tok.mStartOffset - lineStart);
+        hash = hash * 31 + (tok.mEndOffset - lineStart);
+        }
+    auto iter = mAppliedLineHashes.find(lineNum);
+    if(iter == mAppliedLineHashes.end() || iter->second != hash)
+        {
+        gtk_text_buffer_remove_all_tags(textBuffer, &lineStartIter, &lineEndIter);
+        for(auto const &tok : lineTokens)
+            {
+            GtkTextIter start = GuiTextBuffer::getIterAtOffset(textBuffer,
+                static_cast<gint>(tok.mStartOffset));
+            GtkTextIter end = GuiTextBuffer::getIterAtOffset(textBuffer,
+                static_cast<gint>(tok.mEndOffset));
+            gtk_text_buffer_apply_tag(textBuffer,
+                mHighlightTags.getTag(tok.mTokenKind), &start, &end);
+            }
+        mAppliedLineHashes[lineNum] = hash;
+        }
     }
 
 // On Windows, when tags are applied, 38% of CPU time is used for
@@ -938,41 +1832,26 @@ bool Highlighter::applyTags(GtkTextBuffer *textBuffer,
     {
     DUMP_THREAD("applyTags");
     mHighlightTags.initTags(textBuffer);
-    const TokenRange &tokens = mHighlightTokens;
+    mVisibleTopOffset = topOffset;
+    mVisibleBotOffset = botOffset;
 
-    if(mTokenState != TS_HighlightRequest)
+    // The tags are also applied while waiting for a parse since the
+    // tokens are moved for edits, and the lexical tokens are current.
+    if(mTokenState == TS_GotTokens)
         {
-        if(mTokenState == TS_GotTokens)
-            {
-            mTokenState = TS_AppliedTokens;
-            }
-        GtkTextIter start;
-        GtkTextIter end;
-        gtk_text_buffer_get_bounds(textBuffer, &start, &end);
-        gtk_text_buffer_remove_all_tags(textBuffer, &start, &end);
-        for(size_t i=0; i<tokens.size(); i++)
-            {
-            if(isBetween(tokens[i].mStartOffset, topOffset, botOffset) ||
-                isBetween(tokens[i].mEndOffset, topOffset, botOffset) ||
-                isBetween(topOffset, tokens[i].mStartOffset, tokens[i].mEndOffset))
-                {
-                gtk_text_buffer_get_iter_at_offset(textBuffer, &start,
-                    static_cast<gint>(tokens[i].mStartOffset));
-                gtk_text_buffer_get_iter_at_offset(textBuffer, &end,
-                    static_cast<gint>(tokens[i].mEndOffset));
-                gtk_text_buffer_apply_tag(textBuffer,
-                    mHighlightTags.getTag(tokens[i].mTokenKind), &start, &end);
-                }
-            }
+        mTokenState = TS_AppliedTokens;
+        }
+    mLexApplyNeeded = false;
+    GtkTextIter iter = GuiTextBuffer::getIterAtOffset(textBuffer, topOffset);
+    int topLine = gtk_text_iter_get_line(&iter);
+    iter = GuiTextBuffer::getIterAtOffset(textBuffer, botOffset);
+    int botLine = gtk_text_iter_get_line(&iter);
+    for(int lineNum=topLine; lineNum<=botLine; lineNum++)
+        {
+        applyLineTags(textBuffer, lineNum);
         }
     DUMP_THREAD("applyTags-end");
     return(mTokenState == TS_AppliedTokens);
     }
 
 
-#if(SHARED_QUEUE)
-void HighlighterSharedQueue::processItem(HighlightTaskItem const &item)
-    {
-    item.mHighlighter->processItem(item);
-    }
-#endif
@@ -13,6 +13,15 @@
 #include "OovString.h"
 #include "OovThreadedBackgroundQueue.h"
 #include "OovProcess.h"
+#include "SymbolIndex.h"
+#include <map>
+#include <set>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
 
 #if(CINDEX_VERSION_MAJOR >= 6)
 #define CODE_COMPLETE 0
@@ -45,10 +54,24 @@ struct Token
     unsigned int mEndOffset;
     };
 
+/// The tokens are kept in offset order so that the tokens for a part of the
+/// buffer can be found with a binary search.
 class TokenRange:public std::vector<Token>
     {
     public:
-        void tokenize(CXTranslationUnit transUnit);
+        /// Tokenize the part of the file between the offsets.  The start offset
+        /// must not be within a token or comment.
+        void tokenize(CXTranslationUnit transUnit, CXFile file,
+            unsigned int startOffset, unsigned int endOffset);
+        /// Replace the tokens between the offsets with the new tokens.
+        void replaceRange(TokenRange const &newTokens, unsigned int startOffset,
+            unsigned int endOffset);
+        /// Move the tokens after an edit, and remove the tokens that were
+        /// in the edited text.
+        void adjustForEdit(unsigned int offset, unsigned int deleteLen,
+            unsigned int insertLen);
+        /// Return the index of the first token that ends after the offset.
+        size_t findFirstToken(unsigned int offset) const;
     };
 
 enum eFindTokenTypes { FT_FindDecl, FT_FindDef };
@@ -59,6 +82,9 @@ class CLangLock
     public:
         void lock(int line, class Tokenizer *tok);
         void unlock();
+
+    private:
+        std::mutex mTransUnitMutex;
     };
 
 // Similar to std::lock_guard except there is a line number for debugging.
@@ -75,23 +101,60 @@ class CLangAutoLock
         CLangLock &mLock;
     };
 
+/// This builds a precompiled header for the includes at the start of a source
+/// file, and shares it between all files that have the same includes and
+/// arguments.  The precompiled headers are saved in the project output
+/// directory so that they are also used the next time the editor is started.
+class PreambleCache
+    {
+    public:
+        static PreambleCache &getCache();
+        /// Get the path of the precompiled header to use for the source buffer.
+        /// This builds the precompiled header if it does not exist.
+        /// Returns an empty string if there are no includes at the start of
+        /// the buffer, or if the precompiled header could not be built.
+        /// @param rebuild Build the precompiled header even if it exists. This
+        ///     is used when a header changed after it was built.
+        OovString getPreamblePath(CXIndex index, OovStringRef const srcFileName,
+            OovStringRef const buffer, size_t bufLen,
+            char const * const clang_args[], size_t num_clang_args, bool rebuild);
+
+    private:
+        std::mutex mCacheMutex;
+        // This is signaled when a precompiled header is finished building.
+        std::condition_variable mBuiltCondition;
+        // The precompiled headers that are being built. The build is done
+        // without holding the cache mutex so that files that use other
+        // precompiled headers are not blocked.
+        std::set<OovString> mBuildingPaths;
+        // The precompiled headers that could not be built.
+        std::set<OovString> mFailedPaths;
+
+        bool buildPreamble(CXIndex index, OovStringRef const srcFileName,
+            OovStringRef const includes, OovStringRef const pchPath,
+            char const * const clang_args[], size_t num_clang_args);
+    };
+
 /// The CLang translation unit must be protected from multithreading.
 /// This class protects it using a mutex. All access to functions starting
 /// with "clang_" must be protected using the lock.  Remember that there is
 /// a separate tokenizer for each source file, so there are multiple locks.
+/// Each tokenizer has its own index and translation unit, so tokenizers for
+/// different files can be used at the same time by different threads.
 ///
 /// All public functions are protected with a lock.
 class Tokenizer
     {
     public:
         Tokenizer():
-            mTransUnit(0), mSourceFile(nullptr)
+            mTransUnit(0), mSourceFile(nullptr), mSourceLength(0)
             {}
         ~Tokenizer();
         void parse(OovStringRef fileName, OovStringRef buffer, size_t bufLen,
             char const * const clang_args[], size_t num_clang_args);
-        // line numbers are 1 based.
-        void tokenize(/*int startLine, int endLine,*/ TokenRange &highlight);
+        /// Tokenize the part of the last parsed buffer between the offsets.
+        /// The end offset is limited to the length of the buffer.
+        void tokenize(TokenRange &highlight, size_t startOffset, size_t endOffset);
         OovStringVec getDiagResults();
         bool findToken(eFindTokenTypes ft, size_t origOffset, std::string &fn,
             size_t &offset);
@@ -100,6 +163,20 @@ class Tokenizer
             OovString &methodName);
         OovString const &getSourceFileName()
             { return mSourceFilename; }
+        /// The symbols that were found during the analysis. This is shared by
+        /// all tokenizers.
+        static SymbolIndex &getSymbolIndex();
+        /// Starts reading the symbol files on a background thread if an
+        /// analysis was run since they were last read, and reports the errors
+        /// of a read that is done. This must be called from the GUI thread
+        /// since it can report errors, and is called when the GUI is idle.
+        static void updateSymbolIndex();
+        /// Waits for the symbol files to be read. This must be called before
+        /// the process exits.
+        static void stopSymbolIndex();
+        /// Indicates that an analysis was run, so the symbol files must be
+        /// read again.
+        static void setSymbolsChanged();
 #if(CODE_COMPLETE)
         OovStringVec codeComplete(size_t offset);
 #else
@@ -112,6 +189,10 @@ class Tokenizer
         CLangLock mCLangLock;
         CXFile mSourceFile;
         OovString mSourceFilename;
+        size_t mSourceLength;
+        CXTranslationUnit parseWithPreamble(OovStringRef fileName,
+            OovStringRef buffer, size_t bufLen, char const * const clang_args[],
+            size_t num_clang_args, unsigned options);
         CXCursor getCursorAtOffset(CXTranslationUnit tu, CXFile file,
             unsigned desiredOffset);
         void getLineColumn(size_t charOffset, unsigned int &line, unsigned int &column);
@@ -133,31 +214,35 @@ enum eHighlightTask
     {
     HT_None,
     // These can be ored together when they are used as result flags.
-    HT_Parse=0x01, HT_FindToken=0x02, HT_ShowMembers=0x04
+    HT_Parse=0x01, HT_FindToken=0x02, HT_ShowMembers=0x04,
+    // This tokenizes a different part of the buffer without a parse. The
+    // results are returned as HT_Parse results.
+    HT_Tokenize=0x08
     };
 
 
-// A shared queue was used between all highlighters, but didn't solve the
-// problem in Windows, that the CPU usage goes up as each file view is added in
-// the editor. It must be the parser in the mTokenizer.
-// This flag doesn't totally work yet. Probably the waitForCompletion.
-#define SHARED_QUEUE 0
-
 class HighlightTaskItem
     {
     public:
-#if(SHARED_QUEUE)
-        HighlightTaskItem(class Highlighter *highlighter=nullptr):
-            mHighlighter(highlighter),
-#else
         HighlightTaskItem():
-#endif
-            mTask(HT_None), mOffset(0), mFindTokenFt(FT_FindDecl)
+            mTask(HT_None), mOffset(0), mFindTokenFt(FT_FindDecl),
+            mTokenStartOffset(0), mTokenEndOffset(0), mParseRequestCounter(0)
             {}
-        void setParseTask(OovStringRef const buffer, size_t bufLen)
+        /// @param requestCounter The parse request counter for the buffer.
+        void setParseTask(OovStringRef const buffer, size_t bufLen,
+            size_t tokenStartOffset, size_t tokenEndOffset, int requestCounter)
             {
             mTask = HT_Parse;
+            mParseRequestCounter = requestCounter;
             mParseSourceBuffer.assign(buffer, bufLen);
+            mTokenStartOffset = tokenStartOffset;
+            mTokenEndOffset = tokenEndOffset;
+            }
+        void setTokenizeTask(size_t tokenStartOffset, size_t tokenEndOffset)
+            {
+            mTask = HT_Tokenize;
+            mTokenStartOffset = tokenStartOffset;
+            mTokenEndOffset = tokenEndOffset;
             }
         void setShowMembersTask(size_t offset)
             {
@@ -174,9 +259,6 @@ class HighlightTaskItem
             { return mTask; }
 
     public:
-#if(SHARED_QUEUE)
-        class Highlighter *mHighlighter;
-#endif
         eHighlightTask mTask;
 
         // Parameters needed for background thread parsing
@@ -185,45 +267,134 @@ class HighlightTaskItem
         size_t mOffset;
 
         eFindTokenTypes mFindTokenFt;
+
+        // The part of the buffer to tokenize for parse and tokenize tasks.
+        size_t mTokenStartOffset;
+        size_t mTokenEndOffset;
+        int mParseRequestCounter;
     };
 
 
-#if(SHARED_QUEUE)
-// This queue is shared by all highlighters. There is a highlighter for each
-// view.
-class HighlighterSharedQueue:public ThreadedWorkBackgroundQueue<
-    class HighlighterSharedQueue, HighlightTaskItem>
+/// This is a small pool of threads that is shared by all highlighters. There
+/// is a highlighter for each view.  The tasks for a highlighter are processed
+/// in order and by only one thread at a time, so a slow parse of one file
+/// does not prevent the other files from being processed.  The tasks of the
+/// highlighter that has the focus are processed first.
+class HighlighterThreadPool
     {
     public:
-        void processItem(HighlightTaskItem const &item);
+        HighlighterThreadPool():
+            mFocusData(nullptr), mStopping(false)
+            {}
+        static HighlighterThreadPool &getPool();
+        /// Discards the tasks that have not started, and waits for the
+        /// threads to finish.  This must be called before the process exits.
+        void stop();
+        /// A parse task replaces the parse and tokenize tasks for the same
+        /// highlighter that have not started.  A tokenize task replaces a
+        /// tokenize task, but is merged into a parse task that has not
+        /// started, so that the parse is never lost.
+        void addTask(class HighlighterBackgroundThreadData *data,
+            HighlightTaskItem const &item);
+        /// Remove the tasks that have not started, and wait for the task that
+        /// is being processed.
+        void removeTasks(class HighlighterBackgroundThreadData const *data);
+        /// Returns true if there are tasks that are queued or being processed.
+        bool isBusy(class HighlighterBackgroundThreadData const *data);
+        void setFocus(class HighlighterBackgroundThreadData const *data);
+
+    private:
+        struct PoolTask
+            {
+            PoolTask(class HighlighterBackgroundThreadData *data,
+                HighlightTaskItem const &item):
+                mData(data), mItem(item)
+                {}
+            class HighlighterBackgroundThreadData *mData;
+            HighlightTaskItem mItem;
+            };
+        std::mutex mPoolMutex;
+        /// Signals that a task was added.
+        std::condition_variable mTaskAddedSignal;
+        /// Signals that a task was completed.
+        std::condition_variable mTaskDoneSignal;
+        std::list<PoolTask> mTasks;
+        // The highlighters that have a task being processed.
+        std::set<class HighlighterBackgroundThreadData const*> mBusyData;
+        class HighlighterBackgroundThreadData const *mFocusData;
+        // Once this is set, no tasks are added and the threads exit.
+        bool mStopping;
+        std::vector<std::thread> mThreads;
+
+        void workerThreadProc();
+        /// Get the next task that can be processed.  Returns false if all
+        /// tasks are for highlighters that are busy.
+        bool getNextTask(PoolTask &task);
     };
-#endif
 
 
+/// Counters that show how much of the parse work was avoided.
+struct HighlightParseStats
+    {
+    HighlightParseStats():
+        mRequests(0), mParses(0), mCancelledParses(0), mParseTimeMs(0)
+        {}
+    /// The number of parses that were not started because a newer buffer
+    /// was parsed instead.
+    int getSkippedParses() const
+        { return(mRequests - mParses); }
+    // The number of times the buffer changed.
+    int mRequests;
+    // The number of parses that were started.
+    int mParses;
+    // The number of started parses that had results discarded because the
+    // buffer changed during the parse.
+    int mCancelledParses;
+    // The average time of a parse.
+    int mParseTimeMs;
+    };
+
 // This contains all data that is used by the background thread.
 // This means it also contains all data shared between the foreground and
 // background thread.
-class HighlighterBackgroundThreadData:public ThreadedWorkBackgroundQueue<
-    class HighlighterBackgroundThreadData, HighlightTaskItem>
+class HighlighterBackgroundThreadData
     {
     public:
         HighlighterBackgroundThreadData():
             mParseRequestCounter(0), mParseFinishedCounter(0),
-            mTaskResults(HT_None), mFindTokenResultOffset(0)
+            mParseCount(0), mCancelledParseCount(0), mParseTimeMs(0),
+            mTaskResults(HT_None), mTokenResultStartOffset(0),
+            mTokenResultEndOffset(0), mParsedResults(false),
+            mFindTokenResultOffset(0)
             {}
-        virtual ~HighlighterBackgroundThreadData();
+        ~HighlighterBackgroundThreadData();
+        void addTask(HighlightTaskItem const &item)
+            { HighlighterThreadPool::getPool().addTask(this, item); }
+        bool isQueueBusy()
+            { return HighlighterThreadPool::getPool().isBusy(this); }
+        void setFocus()
+            { HighlighterThreadPool::getPool().setFocus(this); }
         void initArgs(OovStringRef const filename,
             char const * const clang_args[], int num_clang_args);
         void makeParseRequest()
             { mParseRequestCounter++; }
         bool isParseNeeded() const
             { return(mParseRequestCounter != mParseFinishedCounter); }
-        TokenRange getParseResults(OovStringVec &diagStringResults);
+        int getParseRequestCounter() const
+            { return mParseRequestCounter; }
+        /// The average time of recent parses.
+        int getParseTimeMs() const
+            { return mParseTimeMs; }
+        HighlightParseStats getParseStats() const;
+        /// The start and end offsets are the part of the buffer that was
+        /// tokenized.  The diagnostics are only returned after a parse.
+        TokenRange getParseResults(OovStringVec &diagStringResults,
+            size_t &startOffset, size_t &endOffset, bool &parsed);
         OovStringVec getShowMembersResults();
         void getFindTokenResults(std::string &fn, size_t &offset);
         eHighlightTask getTaskResults() const
             { return mTaskResults; }
-        // Called by HighlighterSharedQueue on background thread.
+        // Called by HighlighterThreadPool on a background thread.
         void processItem(HighlightTaskItem const &item);
         Tokenizer &getTokenizer()
             { return mTokenizer; }
@@ -232,8 +403,14 @@ class HighlighterBackgroundThreadData:public ThreadedWorkBackgroundQueue<
         OovString mFilename;
         OovProcessChildArgs mClang_args;
         Tokenizer mTokenizer;
-        int mParseRequestCounter;
-        int mParseFinishedCounter;
+        std::atomic_int mParseRequestCounter;
+        std::atomic_int mParseFinishedCounter;
+        // The number of parses that were started.
+        std::atomic_int mParseCount;
+        std::atomic_int mCancelledParseCount;
+        std::atomic_int mParseTimeMs;
+        // The last parsed buffer, used to find where tokenizing can start.
+        OovString mParsedBuffer;
         std::mutex mResultsLock;
 
         // All results must be protected with mResultsLock.
@@ -241,6 +418,9 @@ class HighlighterBackgroundThreadData:public ThreadedWorkBackgroundQueue<
         // when a getxxxResults function is called.
         eHighlightTask mTaskResults;
         TokenRange mTokenResults;               // getParseResults returns this.
+        size_t mTokenResultStartOffset;
+        size_t mTokenResultEndOffset;
+        bool mParsedResults;
         OovStringVec mDiagStringResults;        // getParseResults returns this.
         OovStringVec mShowMemberResults;
         OovString mFindTokenResultFilename;
@@ -253,17 +433,32 @@ class HighlighterBackgroundThreadData:public ThreadedWorkBackgroundQueue<
 // area.  This makes a huge difference in how much processing time the
 // editor takes.  When about 10 files of size of 10K were viewed,  a
 // substantial amount of CPU power was taken (perhaps something like 50%)
+//
+// Only the visible area plus a margin is tokenized. The tokens are kept
+// between parses and are moved when the buffer is edited, and the tags are
+// only applied again to lines where the tokens have changed.
+//
+// A parse can take seconds, so the visible area is also tokenized with the
+// lexical tokenizer when the file is opened and after each edit. The CLang
+// tokens are used where they are available, and the lexical tokens are used
+// for the rest of the text.
 class Highlighter
     {
     public:
         /// This interface requires that no parameters change during
         /// the lifetime of this class.
         Highlighter():
-            mTokenState(TS_AppliedTokens)
+            mTokenState(TS_AppliedTokens), mTokenizedStartOffset(0),
+            mTokenizedEndOffset(0), mTokenizeRequested(false),
+            mVisibleTopOffset(0), mVisibleBotOffset(0), mQueuedParseCounter(0),
+            mLexStartOffset(0), mLexEndOffset(0), mLexNeeded(true),
+            mLexApplyNeeded(false)
             {}
         /// This can be called whenever the buffer for the file has changed.
         /// It will reparse the buffer.  It will initiate a parse of the
-        /// file on the background thread.
+        /// file on the background thread after a delay that depends on how
+        /// long the parse takes, so that fast typing does not cause many
+        /// parses.
         void highlightRequest(OovStringRef const filename,
             char const * const clang_args[], int num_clang_args);
 
@@ -275,7 +470,19 @@ class Highlighter
         ///      HT_ShowMembers, call getShowMembers().
         eHighlightTask highlightUpdate(GtkTextView *textView, OovStringRef const buffer,
             size_t bufLen);
+        /// The part of the buffer around the visible area is tokenized with
+        /// the lexical tokenizer whenever the buffer changes or the view
+        /// scrolls. This should be called periodically from something like
+        /// an idle function. For files that are too large to parse, this is
+        /// used instead of highlightRequest and highlightUpdate.
+        void lexicalUpdate(GtkTextView *textView);
         void showMembers(size_t offset);
+        /// The background tasks for the view that has the focus are done
+        /// before the tasks for other views.
+        void setFocus()
+            { mBackgroundThreadData.setFocus(); }
+        HighlightParseStats getParseStats() const
+            { return mBackgroundThreadData.getParseStats(); }
         OovStringVec getShowMembers()
             { return mBackgroundThreadData.getShowMembersResults(); }
         void findToken(eFindTokenTypes ft, size_t origOffset);
@@ -297,18 +504,50 @@ class Highlighter
         /// the tokens to the tags in the viewable area of the buffer.
         /// The viewable area is defined by topOffset and botOffset.
         bool applyTags(GtkTextBuffer *textBuffer, int topOffset, int botOffset);
+        /// Returns true when there are tokens that have not been applied.
+        bool needsApplyTags() const
+            { return(mTokenState == TS_GotTokens || mLexApplyNeeded); }
+
+        /// This must be called before the text buffer is changed so that the
+        /// tokens can be moved to match the text.
+        /// @param lineNum The line of the offset.
+        /// @param lineDelta The number of lines that are added or removed.
+        void bufferChange(int offset, int deleteLen, int insertLen,
+            int lineNum, int lineDelta);
 
     private:
         HighlighterBackgroundThreadData mBackgroundThreadData;
         HighlightTags mHighlightTags;
         TokenRange mHighlightTokens;
+        TokenRange mErrorTokens;
         enum TokenStates { TS_HighlightRequest, TS_GotTokens,
             TS_AppliedTokens };
         TokenStates mTokenState;
-
-#if(SHARED_QUEUE)
-        static HighlighterSharedQueue sSharedQueue;
-#endif
+        // The part of the buffer that was tokenized after the last parse.
+        size_t mTokenizedStartOffset;
+        size_t mTokenizedEndOffset;
+        bool mTokenizeRequested;
+        int mVisibleTopOffset;
+        int mVisibleBotOffset;
+        // The parse request counter of the last parse task that was added.
+        int mQueuedParseCounter;
+        std::chrono::steady_clock::time_point mLastRequestTime;
+        // The tokens from the lexical tokenizer, and the part of the buffer
+        // that they are for.
+        TokenRange mLexTokens;
+        size_t mLexStartOffset;
+        size_t mLexEndOffset;
+        // Set when the lexical tokens must be found again.
+        bool mLexNeeded;
+        bool mLexApplyNeeded;
+        // For each line that has tags applied, this is a hash of the tokens
+        // that were applied to the line.
+        std::map<int, size_t> mAppliedLineHashes;
+
+        /// Get the part of the buffer to tokenize that surrounds the visible area.
+        void getTokenizeRange(size_t bufLen, size_t &startOffset,
+            size_t &endOffset) const;
+        void applyLineTags(GtkTextBuffer *textBuffer, int lineNum);
     };
 
 #endif /* HIGHLIGHTER_H_ */
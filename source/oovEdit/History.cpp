@@ -7,22 +7,102 @@
 #include "History.h"
 
 
-void HistoryItem::setText(bool set, GtkTextBuffer *buffer)
+void HistoryText::discardBefore(size_t start)
+    {
+    size_t unused = start - mBaseOffset;
+    if(unused > mText.length() / 2)
+        {
+        mText.erase(0, unused);
+        mText.shrink_to_fit();
+        mBaseOffset = start;
+        }
+    }
+
+
+void HistoryItem::setText(bool set, GtkTextBuffer *buffer, HistoryText const &text)
     {
     GtkTextIter start;
     if(set)
         {
         HistoryItem::getIter(buffer, mOffset, &start);
-        gtk_text_buffer_insert(buffer, &start, mText.c_str(),
-            static_cast<gint>(mText.length()));
+        gtk_text_buffer_insert(buffer, &start, text.getText(mTextStart),
+            static_cast<gint>(mTextLen));
         }
     else
         {
         GtkTextIter end;
         HistoryItem::getIter(buffer, mOffset, &start);
-        HistoryItem::getIter(buffer, mOffset+mText.length(), &end);
+        HistoryItem::getIter(buffer, mOffset+mNumChars, &end);
         gtk_text_buffer_delete(buffer, &start, &end);
         }
     }
 
 
+void History::addItem(bool insert, size_t offset, char const *text, size_t len)
+    {
+    if(mCurPos < mItems.size())
+        {
+        mItems.erase(mItems.begin() + static_cast<std::ptrdiff_t>(mCurPos),
+            mItems.end());
+        if(mItems.empty())
+            {
+            mText.clear();
+            }
+        else
+            {
+            mText.truncate(mItems.back().mTextStart + mItems.back().mTextLen);
+            }
+        mCoalesceInsert = false;
+        }
+    size_t numChars = static_cast<size_t>(g_utf8_strlen(text,
+        static_cast<gssize>(len)));
+    // A typed character is added to the previous typed characters if it
+    // follows them. A new line starts a new item.
+    bool typedChar = (insert && numChars == 1 && text[0] != '\n');
+    if(typedChar && mCoalesceInsert &&
+        mItems.back().mOffset + mItems.back().mNumChars == offset)
+        {
+        mText.append(text, len);
+        mItems.back().mTextLen += len;
+        mItems.back().mNumChars += numChars;
+        }
+    else
+        {
+        size_t textStart = mText.append(text, len);
+        mItems.push_back(HistoryItem(insert, offset, textStart, len, numChars));
+        mCurPos = mItems.size();
+        }
+    mCoalesceInsert = typedChar;
+    limitMemory();
+    }
+
+void History::undo(GtkTextBuffer *buffer)
+    {
+    mCoalesceInsert = false;
+    if(mCurPos > 0)
+        {
+        mItems[--mCurPos].undo(buffer, mText);
+        }
+    }
+
+void History::redo(GtkTextBuffer *buffer)
+    {
+    mCoalesceInsert = false;
+    if(mCurPos < mItems.size())
+        {
+        mItems[mCurPos++].redo(buffer, mText);
+        }
+    }
+
+// The most recent item is always kept so that the last edit can be undone.
+void History::limitMemory()
+    {
+    while(getMemorySize() > mMemoryLimit && mItems.size() > 1 && mCurPos > 0)
+        {
+        mItems.pop_front();
+        mCurPos--;
+        // The text of the remaining items is after the text of the
+        // discarded item.
+        mText.discardBefore(mItems.front().mTextStart);
+        }
+    }
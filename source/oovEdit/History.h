@@ -9,23 +9,68 @@
 #define HISTORY_H_
 
 #include "Gui.h"
+#include <deque>
+#include <string>
+
+/// This holds the text for all history items. Text is only appended, and the
+/// items refer to a span of the text, so the text is not copied for each
+/// item.  The offsets into the text do not change when the text for the
+/// oldest items is discarded.
+class HistoryText
+    {
+    public:
+        HistoryText():
+            mBaseOffset(0)
+            {}
+        /// Returns the offset of the start of the appended text.
+        size_t append(char const *text, size_t len)
+            {
+            size_t start = getEnd();
+            mText.append(text, len);
+            return start;
+            }
+        size_t getEnd() const
+            { return(mBaseOffset + mText.length()); }
+        char const *getText(size_t start) const
+            { return(mText.c_str() + (start - mBaseOffset)); }
+        /// Discard the text after the end offset.
+        void truncate(size_t end)
+            { mText.resize(end - mBaseOffset); }
+        /// Discard all text. The offsets of new text continue after the
+        /// discarded text.
+        void clear()
+            {
+            mBaseOffset = getEnd();
+            mText.clear();
+            mText.shrink_to_fit();
+            }
+        /// Discard the text before the start offset. The memory is only
+        /// reclaimed when more than half of the text is not used.
+        void discardBefore(size_t start);
+
+    private:
+        std::string mText;
+        size_t mBaseOffset;
+    };
 
 /// This is for undo and redo.
 class HistoryItem
     {
     public:
-        HistoryItem(bool insert, size_t offset, OovStringRef const text, size_t len):
-            mInsert(insert), mOffset(offset), mText(text, len)
+        HistoryItem(bool insert, size_t offset, size_t textStart, size_t textLen,
+                size_t numChars):
+            mInsert(insert), mOffset(offset), mTextStart(textStart),
+            mTextLen(textLen), mNumChars(numChars)
             {}
-        void undo(GtkTextBuffer *buffer)
+        void undo(GtkTextBuffer *buffer, HistoryText const &text)
             {
-            setText(!mInsert, buffer);
+            setText(!mInsert, buffer, text);
             }
-        void redo(GtkTextBuffer *buffer)
+        void redo(GtkTextBuffer *buffer, HistoryText const &text)
             {
-            setText(mInsert, buffer);
+            setText(mInsert, buffer, text);
             }
-        void setText(bool set, GtkTextBuffer *buffer);
+        void setText(bool set, GtkTextBuffer *buffer, HistoryText const &text);
         static gint getOffset(const GtkTextIter *iter)
             { return gtk_text_iter_get_offset(iter); }
         static void getIter(GtkTextBuffer *buffer, size_t offset, GtkTextIter *iter)
@@ -35,11 +80,50 @@ class HistoryItem
             }
 
     protected:
+        friend class History;
         bool mInsert;
-        size_t mOffset;
-        OovString mText;
+        size_t mOffset;         // The character offset in the GTK buffer.
+        size_t mTextStart;      // The offset in the HistoryText.
+        size_t mTextLen;        // The number of bytes.
+        size_t mNumChars;       // The number of UTF-8 characters.
     };
 
+/// This keeps the undo and redo items for one buffer. Typing is coalesced so
+/// that each typed character does not make a new item. When the memory used
+/// is more than the limit, the oldest items are discarded.
+class History
+    {
+    public:
+        static size_t const DefaultMemoryLimit = 32 * 1024 * 1024;
+        History():
+            mCurPos(0), mMemoryLimit(DefaultMemoryLimit), mCoalesceInsert(false)
+            {}
+        /// @param limit The number of bytes of text and items to keep.
+        void setMemoryLimit(size_t limit)
+            {
+            mMemoryLimit = limit;
+            limitMemory();
+            }
+        /// Add an insert or delete. This discards all items that can be redone.
+        void addItem(bool insert, size_t offset, char const *text, size_t len);
+        void undo(GtkTextBuffer *buffer);
+        void redo(GtkTextBuffer *buffer);
+        /// Get the size of the text used by the items and the items.
+        size_t getMemorySize() const
+            {
+            return(mItems.empty() ? 0 : (mText.getEnd() - mItems.front().mTextStart +
+                mItems.size() * sizeof(HistoryItem)));
+            }
 
+    private:
+        std::deque<HistoryItem> mItems;
+        size_t mCurPos;                 // Range is 0 to size().
+        HistoryText mText;
+        size_t mMemoryLimit;
+        // True when the last item is a typed insert that can be extended.
+        bool mCoalesceInsert;
+
+        void limitMemory();
+    };
 
 #endif /* HISTORY_H_ */
@@ -0,0 +1,365 @@
+/*
+ * LexTokenizer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#include "LexTokenizer.h"
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+
+enum eCharClasses
+    {
+    CC_Other, CC_Space, CC_Newline, CC_Ident, CC_Digit, CC_Quote,
+    CC_Slash, CC_Hash, CC_Dot, CC_Less
+    };
+
+class CharClassTable
+    {
+    public:
+        CharClassTable();
+        eCharClasses getClass(char c) const
+            { return static_cast<eCharClasses>(mClasses[static_cast<unsigned char>(c)]); }
+
+    private:
+        unsigned char mClasses[256];
+    };
+
+CharClassTable::CharClassTable()
+    {
+    for(int i=0; i<256; i++)
+        {
+        eCharClasses cc = CC_Other;
+        // Characters above 0x80 are parts of UTF-8 characters, and are
+        // only allowed in identifiers outside of comments and literals.
+        if(isalpha(i) || i == '_' || i >= 0x80)
+            cc = CC_Ident;
+        else if(isdigit(i))
+            cc = CC_Digit;
+        else if(i == '\n')
+            cc = CC_Newline;
+        else if(isspace(i))
+            cc = CC_Space;
+        else if(i == '"' || i == '\'')
+            cc = CC_Quote;
+        else if(i == '/')
+            cc = CC_Slash;
+        else if(i == '#')
+            cc = CC_Hash;
+        else if(i == '.')
+            cc = CC_Dot;
+        else if(i == '<')
+            cc = CC_Less;
+        mClasses[i] = static_cast<unsigned char>(cc);
+        }
+    }
+
+static CharClassTable const sCharClasses;
+
+// This must be sorted for the binary search.
+static char const * const sKeywords[] =
+    {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor",
+    "bool", "break", "case", "catch", "char", "char16_t", "char32_t", "class",
+    "compl", "const", "const_cast", "constexpr", "continue", "decltype",
+    "default", "delete", "do", "double", "dynamic_cast", "else", "enum",
+    "explicit", "export", "extern", "false", "float", "for", "friend", "goto",
+    "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept",
+    "not", "not_eq", "nullptr", "operator", "or", "or_eq", "private",
+    "protected", "public", "register", "reinterpret_cast", "return", "short",
+    "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+    "switch", "template", "this", "thread_local", "throw", "true", "try",
+    "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual",
+    "void", "volatile", "wchar_t", "while", "xor", "xor_eq"
+    };
+
+static bool isKeyword(char const *str, size_t len)
+    {
+    auto iter = std::lower_bound(std::begin(sKeywords), std::end(sKeywords), str,
+        [len](char const *keyword, char const *s)
+        { return(strncmp(keyword, s, len) < 0); });
+    return(iter != std::end(sKeywords) && strncmp(*iter, str, len) == 0 &&
+        (*iter)[len] == '\0');
+    }
+
+// Encoding prefixes of string and character literals such as u8 or LR.
+static bool isLiteralPrefix(char const *str, size_t len)
+    {
+    static char const * const prefixes[] =
+        { "L", "u", "U", "u8", "R", "LR", "uR", "UR", "u8R" };
+    return std::any_of(std::begin(prefixes), std::end(prefixes),
+        [str, len](char const *prefix)
+        { return(strlen(prefix) == len && strncmp(prefix, str, len) == 0); });
+    }
+
+static inline bool isIdentChar(char c)
+    {
+    eCharClasses cc = sCharClasses.getClass(c);
+    return(cc == CC_Ident || cc == CC_Digit);
+    }
+
+static size_t skipIdent(char const *buf, size_t len, size_t pos)
+    {
+    while(pos < len && isIdentChar(buf[pos]))
+        {
+        pos++;
+        }
+    return pos;
+    }
+
+// This includes hex, floating point, and digit separators.
+static size_t skipNumber(char const *buf, size_t len, size_t pos)
+    {
+    while(++pos < len)
+        {
+        char c = buf[pos];
+        char prev = buf[pos-1];
+        bool exponent = (prev == 'e' || prev == 'E' || prev == 'p' || prev == 'P');
+        if(!(isIdentChar(c) || c == '.' || c == '\'' ||
+            ((c == '+' || c == '-') && exponent)))
+            {
+            break;
+            }
+        }
+    return pos;
+    }
+
+// An unterminated literal ends at the end of the line.
+static size_t skipQuoted(char const *buf, size_t len, size_t pos)
+    {
+    char quote = buf[pos++];
+    while(pos < len)
+        {
+        char c = buf[pos];
+        if(c == '\\')
+            {
+            pos++;
+            }
+        else if(c == quote)
+            {
+            pos++;
+            break;
+            }
+        else if(c == '\n')
+            {
+            break;
+            }
+        pos++;
+        }
+    return std::min(pos, len);
+    }
+
+// A raw string such as R"delim(text)delim".
+static size_t skipRawString(char const *buf, size_t len, size_t pos)
+    {
+    char const *delimStart = buf + pos + 1;
+    char const *bufEnd = buf + len;
+    char const *paren = std::find(delimStart, bufEnd, '(');
+    size_t endPos = len;
+    if(paren != bufEnd)
+        {
+        std::string terminator = ")";
+        terminator.append(delimStart, paren);
+        terminator += '"';
+        char const *end = std::search(paren, bufEnd, terminator.begin(),
+            terminator.end());
+        if(end != bufEnd)
+            {
+            endPos = (end - buf) + terminator.length();
+            }
+        }
+    return endPos;
+    }
+
+static size_t skipBlockComment(char const *buf, size_t len, size_t pos)
+    {
+    static char const commentEnd[] = "*/";
+    char const *end = std::search(buf + pos, buf + len, commentEnd, commentEnd + 2);
+    return((end == buf + len) ? len : (end - buf) + 2);
+    }
+
+static size_t skipToLineEnd(char const *buf, size_t len, size_t pos)
+    {
+    char const *end = static_cast<char const *>(memchr(buf + pos, '\n', len - pos));
+    return(end ? end - buf : len);
+    }
+
+/// Converts byte positions in the UTF-8 buffer to character offsets. The
+/// positions must be requested in increasing order.
+class CharOffsetCounter
+    {
+    public:
+        CharOffsetCounter(char const *buf, unsigned int startOffset):
+            mBuf(buf), mBytePos(0), mCharOffset(startOffset)
+            {}
+        unsigned int getOffset(size_t bytePos)
+            {
+            for(; mBytePos < bytePos; mBytePos++)
+                {
+                if((mBuf[mBytePos] & 0xC0) != 0x80)
+                    {
+                    mCharOffset++;
+                    }
+                }
+            return mCharOffset;
+            }
+
+    private:
+        char const *mBuf;
+        size_t mBytePos;
+        unsigned int mCharOffset;
+    };
+
+void LexTokenizer::tokenize(char const *buf, size_t len, unsigned int startOffset,
+        bool inComment, TokenRange &tokens)
+    {
+    CharOffsetCounter counter(buf, startOffset);
+    auto addToken = [&tokens, &counter](TokenKinds kind, size_t start, size_t end)
+        {
+        if(end > start)
+            {
+            Token tok;
+            tok.mTokenKind = kind;
+            tok.mStartOffset = counter.getOffset(start);
+            tok.mEndOffset = counter.getOffset(end);
+            tokens.push_back(tok);
+            }
+        };
+    size_t pos = 0;
+    if(inComment)
+        {
+        pos = skipBlockComment(buf, len, 0);
+        addToken(TK_Comment, 0, pos);
+        }
+    bool lineStart = true;
+    bool includeLine = false;
+    while(pos < len)
+        {
+        size_t start = pos;
+        eCharClasses cc = sCharClasses.getClass(buf[pos]);
+        switch(cc)
+            {
+            case CC_Newline:
+                lineStart = true;
+                includeLine = false;
+                pos++;
+                break;
+
+            case CC_Space:
+                pos++;
+                break;
+
+            case CC_Ident:
+                pos = skipIdent(buf, len, pos);
+                if(pos < len && sCharClasses.getClass(buf[pos]) == CC_Quote &&
+                    isLiteralPrefix(buf + start, pos - start))
+                    {
+                    if(buf[pos-1] == 'R' && buf[pos] == '"')
+                        pos = skipRawString(buf, len, pos);
+                    else
+                        pos = skipQuoted(buf, len, pos);
+                    addToken(TK_Literal, start, pos);
+                    }
+                else if(isKeyword(buf + start, pos - start))
+                    {
+                    addToken(TK_Keyword, start, pos);
+                    }
+                break;
+
+            case CC_Digit:
+                pos = skipNumber(buf, len, pos);
+                addToken(TK_Literal, start, pos);
+                break;
+
+            case CC_Dot:
+                if(pos + 1 < len && sCharClasses.getClass(buf[pos+1]) == CC_Digit)
+                    {
+                    pos = skipNumber(buf, len, pos);
+                    addToken(TK_Literal, start, pos);
+                    }
+                else
+                    pos++;
+                break;
+
+            case CC_Quote:
+                pos = skipQuoted(buf, len, pos);
+                addToken(TK_Literal, start, pos);
+                break;
+
+            case CC_Slash:
+                if(pos + 1 < len && buf[pos+1] == '/')
+                    {
+                    pos = skipToLineEnd(buf, len, pos);
+                    addToken(TK_Comment, start, pos);
+                    }
+                else if(pos + 1 < len && buf[pos+1] == '*')
+                    {
+                    pos = skipBlockComment(buf, len, pos + 2);
+                    addToken(TK_Comment, start, pos);
+                    }
+                else
+                    pos++;
+                break;
+
+            case CC_Hash:
+                pos++;
+                if(lineStart)
+                    {
+                    // The directive is highlighted as a keyword.
+                    while(pos < len && sCharClasses.getClass(buf[pos]) == CC_Space)
+                        {
+                        pos++;
+                        }
+                    size_t nameStart = pos;
+                    pos = skipIdent(buf, len, pos);
+                    addToken(TK_Keyword, start, pos);
+                    OovString name(buf + nameStart, pos - nameStart);
+                    includeLine = (name == "include" || name == "include_next" ||
+                        name == "import");
+                    }
+                break;
+
+            case CC_Less:
+                pos++;
+                if(includeLine)
+                    {
+                    size_t end = skipToLineEnd(buf, len, pos);
+                    char const *close = std::find(buf + pos, buf + end, '>');
+                    if(close != buf + end)
+                        {
+                        pos = (close - buf) + 1;
+                        addToken(TK_Literal, start, pos);
+                        }
+                    }
+                break;
+
+            default:
+                pos++;
+                break;
+            }
+        if(cc != CC_Newline && cc != CC_Space)
+            {
+            lineStart = false;
+            }
+        }
+    }
+
+bool LexTokenizer::endsInComment(char const *buf, size_t len)
+    {
+    bool inComment = false;
+    for(size_t i=len; i>=2; i--)
+        {
+        if(buf[i-2] == '*' && buf[i-1] == '/')
+            {
+            break;
+            }
+        else if(buf[i-2] == '/' && buf[i-1] == '*')
+            {
+            inComment = true;
+            break;
+            }
+        }
+    return inComment;
+    }
@@ -0,0 +1,39 @@
+/*
+ * LexTokenizer.h
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#ifndef LEXTOKENIZER_H_
+#define LEXTOKENIZER_H_
+
+#include "Highlighter.h"
+
+/// This is a fast C++ lexer that does not need a parse, so it can be used
+/// to highlight text that CLang has not parsed, or that is too large to
+/// parse. It only finds keywords, literals, comments and preprocessor
+/// directives. Identifiers and punctuation are not returned since they
+/// are not highlighted.
+///
+/// The lexer uses a character class table and a sorted keyword table.
+class LexTokenizer
+    {
+    public:
+        /// Find the tokens in the text.
+        /// @param buf The UTF-8 text to tokenize. This should start at the
+        ///     start of a line.
+        /// @param len The number of bytes in the buffer.
+        /// @param startOffset The character offset of the start of the text in
+        ///     the text buffer. The token offsets are character offsets.
+        /// @param inComment Set to true if the text starts in a block comment.
+        /// @param tokens The tokens are appended to this.
+        static void tokenize(char const *buf, size_t len, unsigned int startOffset,
+            bool inComment, TokenRange &tokens);
+        /// Returns true if the text ends inside of a block comment. This only
+        /// looks for the last comment start or end, so it can be wrong if
+        /// the comment characters are in a string or line comment.
+        static bool endsInComment(char const *buf, size_t len);
+    };
+
+#endif
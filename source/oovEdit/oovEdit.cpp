@@ -9,8 +9,6 @@
 #include "Debugger.h"
 #include "oovEdit.h"
 #include "Project.h"
-#include "Components.h"
-#include "DirList.h"
 #include "ControlWindow.h"
 #include <string.h>
 #include <vector>
@@ -154,125 +152,12 @@ void Editor::findAgain(bool forward)
     }
 
 
-class FindFiles:public dirRecurser
-    {
-    public:
-        ~FindFiles()
-            {}
-        FindFiles(char const *srchStr, bool caseSensitive, bool sourceOnly,
-            GtkTextView *view):
-            mSrchStr(srchStr), mCaseSensitive(caseSensitive),
-            mSourceFilesOnly(sourceOnly), mView(view), mNumMatches(0)
-            {}
-        OovStatusReturn recurseDirs(char const * const srcDir)
-            {
-            mNumMatches = 0;
-            return dirRecurser::recurseDirs(srcDir);
-            }
-        int getNumMatches() const
-            { return mNumMatches; }
-
-    private:
-        virtual bool processFile(OovStringRef const filePath) override;
-
-    private:
-        std::string mSrchStr;
-        bool mCaseSensitive;
-        bool mSourceFilesOnly;
-        GtkTextView *mView;
-        int mNumMatches;
-    };
-
-#ifndef __linux__
-static int my_strnicmp(char const *str1, char const *str2, int len)
-    {
-    int val = 0;
-    for(int i=0; i<len; i++)
-        {
-        val = toupper(str1[i]) - toupper(str2[i]);
-        if(val != 0)
-            break;
-        }
-    return val;
-    }
-
-static char const *strcasestr(char const *haystack, char const *needle)
-    {
-    int needleLen = strlen(needle);
-    char const *retp = nullptr;
-    while(*haystack)
-        {
-        // strncasecmp, strnicmp, _strnicmp not working under mingw with some flags
-        if(my_strnicmp(haystack, needle, needleLen) == 0)
-            {
-            retp = haystack;
-            break;
-            }
-        haystack++;
-        }
-    return retp;
-    }
-#endif
-
-// Return true while success.
-bool FindFiles::processFile(OovStringRef const filePath)
-    {
-    bool success = true;
-    FilePath ext(filePath, FP_File);
-
-    bool isSource = (isCppHeader(ext) || isCppSource(ext) || isJavaSource(ext));
-    if(mSourceFilesOnly ? isSource : true)
-        {
-        FILE *fp = fopen(filePath.getStr(), "r");
-        if(fp)
-            {
-            char buf[1000];
-            int lineNum = 0;
-            while(fgets(buf, sizeof(buf), fp))
-                {
-                lineNum++;
-                char const *match=NULL;
-                if(mCaseSensitive)
-                    {
-                    match = strstr(buf, mSrchStr.c_str());
-                    }
-                else
-                    {
-                    match = strcasestr(buf, mSrchStr.c_str());
-                    }
-                if(match)
-                    {
-                    mNumMatches++;
-                    OovString matchStr = filePath;
-                    matchStr += ':';
-                    matchStr.appendInt(lineNum);
-                    matchStr += "   ";
-                    matchStr += buf;
-//                  matchStr += '\n';
-                    Gui::appendText(mView, matchStr);
-                    }
-                }
-            fclose(fp);
-            }
-        }
-    return success;
-    }
-
+// The results are added to the view from onIdle.
 void Editor::findInFiles(char const * const srchStr, char const * const path,
-        bool caseSensitive, bool sourceOnly, GtkTextView *view)
+        bool caseSensitive, bool sourceOnly, bool useIndex, GtkTextView *view)
     {
-    FindFiles findFiles(srchStr, caseSensitive, sourceOnly, view);
-    OovStatus status = findFiles.recurseDirs(path);
-    if(status.needReport())
-        {
-        OovString err = "Unable to search path ";
-        err += path;
-        status.report(ET_Error, err);
-        }
-    OovString matchStr = "Found ";
-    matchStr.appendInt(findFiles.getNumMatches());
-    matchStr += " matches";
-    Gui::appendText(view, matchStr);
+    mFindFiles.startSearch(srchStr, path, caseSensitive, sourceOnly, useIndex,
+        view);
     }
 
 void Editor::findInFilesDialog()
@@ -282,8 +167,11 @@ void Editor::findInFilesDialog()
         "FindDownCheckbutton"));
     GtkToggleButton *sourceOnlyCheck = GTK_TOGGLE_BUTTON(getBuilder().getWidget(
         "SourceOnlyCheckbutton"));
+    GtkToggleButton *indexCheck = GTK_TOGGLE_BUTTON(getBuilder().getWidget(
+        "FindIndexCheckbutton"));
     Gui::setVisible(GTK_WIDGET(downCheck), false);
     Gui::setVisible(GTK_WIDGET(sourceOnlyCheck), true);
+    Gui::setVisible(GTK_WIDGET(indexCheck), true);
     if(dialog.run(true))
         {
         GtkToggleButton *caseCheck = GTK_TOGGLE_BUTTON(getBuilder().getWidget(
@@ -296,10 +184,35 @@ void Editor::findInFilesDialog()
         findInFiles(gtk_entry_get_text(entry), Project::getSrcRootDirectory().getStr(),
             gtk_toggle_button_get_active(caseCheck),
             gtk_toggle_button_get_active(sourceOnlyCheck),
+            gtk_toggle_button_get_active(indexCheck),
             findView);
         }
     Gui::setVisible(GTK_WIDGET(downCheck), true);
     Gui::setVisible(GTK_WIDGET(sourceOnlyCheck), false);
+    Gui::setVisible(GTK_WIDGET(indexCheck), false);
+    }
+
+// The symbol index is used if the method is found, otherwise the location
+// is requested from oovaide.  Without a class name, the index could find a
+// method of any class, so oovaide is asked.
+void Editor::goToMethod()
+    {
+    OovString className;
+    OovString methodName;
+    mEditFiles.getEditView()->getMethodNameAtLocation(className, methodName);
+    OovString name = className;
+    name += "::";
+    name += methodName;
+    SymbolRecord rec;
+    if(className.length() > 0 &&
+        Tokenizer::getSymbolIndex().findQualifiedName(name, true, rec))
+        {
+        mEditFiles.viewFile(rec.mFilename, static_cast<int>(rec.mLine));
+        }
+    else
+        {
+        mEditorIpc.goToMethod(className, methodName);
+        }
     }
 
 void Editor::gotoFileLine(std::string const &lineBuf)
@@ -389,12 +302,17 @@ gboolean Editor::onIdle(gpointer data)
         Gui::scrollToCursor(view);
         mDebugOut.clear();
         }
+    // All of the changes are handled so that many variable values do not
+    // take many idle calls.
     eDebuggerChangeStatus dbgStatus = mDebugger.getChangeStatus();
-    if(dbgStatus != DCS_None)
+    while(dbgStatus != DCS_None)
         {
         idleDebugStatusChange(dbgStatus);
+        dbgStatus = mDebugger.getChangeStatus();
         }
     getEditFiles().onIdle();
+    mFindFiles.idleUpdate();
+    Tokenizer::updateSymbolIndex();
     OovIpcMsg msg;
     if(mEditorIpc.getMessage(msg))
         {
@@ -414,6 +332,10 @@ gboolean Editor::onIdle(gpointer data)
                 }
             gEditor->getEditFiles().viewModule(fn, lineNum);
             }
+        else if(cmd[0] == EC_AnalysisComplete)
+            {
+            Tokenizer::setSymbolsChanged();
+            }
         }
     sleepMs(5);
     return true;
@@ -450,7 +372,10 @@ static void appendTree(GuiTree &varView, GuiTreeItem &parentItem,
         }
     if(foundItem)
         {
-        varView.setText(item, str);
+        if(varView.getText(item) != str)
+            {
+            varView.setText(item, str);
+            }
         }
     else
         {
@@ -481,17 +406,34 @@ static void appendTree(GuiTree &varView, GuiTreeItem &parentItem,
     varView.expandRow(path);
     }
 
+// The variable tree items are displayed as "name : value".
+static OovString getTreeVarName(OovStringRef const itemText)
+    {
+    OovString name = itemText;
+    size_t pos = name.find(" : ");
+    if(pos != std::string::npos)
+        {
+        name.resize(pos);
+        }
+    return name;
+    }
+
 void Editor::updateDebugDataValue()
     {
     OovStringVec strs = mVarView.getSelected();
     if(strs.size() > 0)
         {
-        mEditFiles.getDebugger().startGetVariable(strs[0]);
+        mEditFiles.getDebugger().startGetVariable(getTreeVarName(strs[0]));
         }
     }
 
 void Editor::removeDebugDataValue()
     {
+    OovStringVec strs = mVarView.getSelected();
+    if(strs.size() > 0)
+        {
+        mEditFiles.getDebugger().removeWatchedVariable(getTreeVarName(strs[0]));
+        }
     mVarView.removeSelected();
     }
 
@@ -505,6 +447,7 @@ void Editor::idleDebugStatusChange(eDebuggerChangeStatus st)
             auto const &loc = mDebugger.getStoppedLocation();
             mEditFiles.viewModule(loc.getFilename(), loc.getLine());
             mDebugger.startGetStack();
+            mDebugger.startRefreshVariables();
             }
         }
     else if(st == DCS_Stack)
@@ -793,6 +736,8 @@ int main(int argc, char **argv)
 #endif
     int status = g_application_run(gapp, argc, argv);
     g_object_unref(app);
+    HighlighterThreadPool::getPool().stop();
+    Tokenizer::stopSymbolIndex();
     return status;
     }
 
@@ -921,6 +866,8 @@ int main(int argc, char *argv[])
         {
         Gui::messageBox("The file oovEdit.glade must be in the executable directory.");
         }
+    HighlighterThreadPool::getPool().stop();
+    Tokenizer::stopSymbolIndex();
     return 0;
     }
 #endif
@@ -12,6 +12,7 @@
 #include "EditOptions.h"
 #include "EditorIpc.h"
 #include "ControlWindow.h"
+#include "FindFiles.h"
 
 
 class Editor:public DebuggerListener, public OovErrorListener
@@ -33,7 +34,7 @@ class Editor:public DebuggerListener, public OovErrorListener
         void findAgain(bool forward);
         void findInFilesDialog();
         void findInFiles(char const * const srchStr, char const * const path,
-                bool caseSensitive, bool sourceOnly, GtkTextView *view);
+                bool caseSensitive, bool sourceOnly, bool useIndex, GtkTextView *view);
 //      void setTabs(int numSpaces);
         void setStyle();
         void cut()
@@ -88,13 +89,7 @@ class Editor:public DebuggerListener, public OovErrorListener
             {
             gotoToken(FT_FindDef);
             }
-        void goToMethod()
-            {
-            OovString className;
-            OovString methodName;
-            mEditFiles.getEditView()->getMethodNameAtLocation(className, methodName);
-            mEditorIpc.goToMethod(className, methodName);
-            }
+        void goToMethod();
         void viewClassDiagram()
             {
             mEditorIpc.viewClassDiagram(
@@ -156,6 +151,7 @@ class Editor:public DebuggerListener, public OovErrorListener
         EditOptions mEditOptions;
         GuiTree mVarView;
         EditorIpc mEditorIpc;
+        FindFiles mFindFiles;
 
         void find(OovStringRef const findStr, bool forward, bool caseSensitive);
         void findAndReplace(OovStringRef const findStr, bool forward, bool caseSensitive,
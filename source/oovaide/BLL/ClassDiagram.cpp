@@ -21,10 +21,21 @@ void ClassDiagram::initialize(ModelData const &modelData,
     mModelData = &modelData;
     mClassGraph.initialize(options, nullDrawer, graphListener,
             foregroundTaskStatusListener, backgroundTaskStatusListener);
+    readOperationProfile();
+    }
+
+void ClassDiagram::readOperationProfile()
+    {
+    OovStatus status = mOperationProfile.readIfChanged();
+    if(status.needReport())
+        {
+        status.report(ET_Error, "Unable to read operation profile");
+        }
     }
 
 void ClassDiagram::updateGraph(bool reposition)
     {
+    readOperationProfile();
     mClassGraph.updateGraph(getModelData(), reposition);
     }
 
@@ -53,6 +64,7 @@ void ClassDiagram::drawDiagram(DiagramDrawer &diagDrawer)
     {
     ClassDrawer drawer(*this, diagDrawer);
     drawer.setZoom(getDesiredZoom());
+    drawer.setOperationProfile(&mOperationProfile);
     drawer.drawDiagram(mClassGraph);
     }
 
@@ -64,6 +76,7 @@ OovStatusReturn ClassDiagram::saveDiagram(File &file)
     CompoundValue names;
     CompoundValue xPositions;
     CompoundValue yPositions;
+    CompoundValue pinned;
     OovString drawingName;
     for(auto const &node : mClassGraph.getNodes())
         {
@@ -86,6 +99,10 @@ OovStatusReturn ClassDiagram::saveDiagram(File &file)
         num.clear();
         num.appendInt(node.getPosition().y);
         yPositions.addArg(num);
+
+        num.clear();
+        num.appendInt(node.isPinned());
+        pinned.addArg(num);
         }
 
     if(drawingName.length() > 0)
@@ -94,6 +111,7 @@ OovStatusReturn ClassDiagram::saveDiagram(File &file)
         nameValFile.setNameValue("Names", names.getAsString());
         nameValFile.setNameValue("XPositions", xPositions.getAsString());
         nameValFile.setNameValue("YPositions", yPositions.getAsString());
+        nameValFile.setNameValue("Pinned", pinned.getAsString());
         status = nameValFile.writeFile(file);
         }
     return status;
@@ -111,6 +129,9 @@ OovStatusReturn ClassDiagram::loadDiagram(File &file)
         xPositions.parseString(nameValFile.getValue("XPositions"));
         CompoundValue yPositions;
         yPositions.parseString(nameValFile.getValue("YPositions"));
+        // Older files do not have the pinned values.
+        CompoundValue pinned;
+        pinned.parseString(nameValFile.getValue("Pinned"));
         std::vector<ClassNode> &nodes = getNodes();
         for(size_t i=0; i<names.size(); i++)
             {
@@ -135,6 +156,7 @@ OovStatusReturn ClassDiagram::loadDiagram(File &file)
                 if(nodes.size() > 0)
                     {
                     nodes[0].setPosition(GraphPoint(x, y));
+                    nodes[0].setPinned(i < pinned.size() && pinned[i] == "1");
                     }
                 }
             else
@@ -155,6 +177,7 @@ OovStatusReturn ClassDiagram::loadDiagram(File &file)
                 xPositions[i].getInt(0, INT_MAX, x);
                 yPositions[i].getInt(0, INT_MAX, y);
                 nodeIter->setPosition(GraphPoint(x, y));
+                nodeIter->setPinned(i < pinned.size() && pinned[i] == "1");
                 }
             }
         }
@@ -9,6 +9,7 @@
 #define CLASSDIAGRAM_H_
 
 #include "ClassGraph.h"
+#include "OperationProfile.h"
 
 
 /// This defines functions used to interact with a class diagram. The
@@ -68,6 +69,9 @@ class ClassDiagram:public Diagram
             { mClassGraph.changeOptions(options); }
         /// This repositions nodes, and can be slow.
         void updateGraph(bool resposition);
+        /// Allows the next updateGraph to move all nodes except pinned nodes.
+        void clearNodePositions()
+            { mClassGraph.clearNodePositions(); }
 
         /// Redraw the graph. Does not change the graph or change or access the model.
         /// This can be used to paint to a window, or to an SVG file.
@@ -104,6 +108,11 @@ class ClassDiagram:public Diagram
         ClassGraph mClassGraph;
         OovString mLastSelectedClassName;
         double mDesiredZoom;
+        /// This is read from the coverage project when the diagram is
+        /// initialized, and read again if the file changed when the graph
+        /// is updated.
+        OperationProfile mOperationProfile;
+        void readOperationProfile();
         void setLastSelectedClassName(OovStringRef const name)
             { mLastSelectedClassName = name; }
     };
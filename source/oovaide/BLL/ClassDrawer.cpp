@@ -31,9 +31,12 @@ static void getLeafPath(std::string &moduleStr)
         }
     }
 
-static void getStrings(const ClassNode &node,
+/// @param operCosts The fraction of the most costly operation in the
+///     profile for each operation, or -1 if the operation was not called.
+static void getStrings(const ClassNode &node, OperationProfile const *profile,
     OovStringVec &nodeStrs, OovStringVec &attrStrs,
-    OovStringVec &operStrs, std::vector<bool> &virtOpers)
+    OovStringVec &operStrs, std::vector<bool> &virtOpers,
+    std::vector<float> &operCosts)
     {
     const ModelType *type = node.getType();
     OovStringRef const typeName = type->getName();
@@ -115,6 +118,18 @@ static void getStrings(const ClassNode &node,
 
                 operStrs.push_back(operStr);
                 virtOpers.push_back(oper->isVirtual());
+                float cost = -1;
+                if(profile && profile->getMaxTicks() != 0)
+                    {
+                    OperationProfile::Cost const *operCost = profile->getCost(
+                        classifier->getName(), oper->getName());
+                    if(operCost)
+                        {
+                        cost = static_cast<float>(operCost->mTicks) /
+                            profile->getMaxTicks();
+                        }
+                    }
+                operCosts.push_back(cost);
                 }
             }
         }
@@ -244,8 +259,12 @@ GraphSize ClassDrawer::drawNode(const ClassNode &node)
         OovStringVec operStrs;
         std::vector<size_t> originalOperStrIndices;
         std::vector<bool> virtOpers;
+        std::vector<float> operCosts;
+        // The vertical position and cost of each operation string.
+        std::vector<std::pair<float, float>> operCostPositions;
 
-        getStrings(node, nodeStrs, attrStrs, operStrs, virtOpers);
+        getStrings(node, mOperationProfile, nodeStrs, attrStrs, operStrs,
+            virtOpers, operCosts);
         splitClassStrings(nodeStrs, attrStrs, operStrs, fontHeight,
         	originalOperStrIndices);
         float y = startpos.y;
@@ -273,6 +292,10 @@ GraphSize ClassDrawer::drawNode(const ClassNode &node)
                 {
                 index = i;
                 }
+            if(operCosts[index] >= 0)
+                {
+                operCostPositions.push_back(std::make_pair(y, operCosts[index]));
+                }
             if(!virtOpers[index])
                 {
                 addDrawString(operStrs[i], GraphPoint(startpos.x+pad, y),
@@ -309,6 +332,16 @@ GraphSize ClassDrawer::drawNode(const ClassNode &node)
         mDrawer.drawLine(GraphPoint(startpos.x, line1), GraphPoint(startpos.x+maxWidth, line1));
         mDrawer.drawLine(GraphPoint(startpos.x, line2), GraphPoint(startpos.x+maxWidth, line2));
         mDrawer.groupShapes(false, 0, 0);
+        // The most costly operations are the most red.
+        for(auto const &costPos : operCostPositions)
+            {
+            int fade = 255 - static_cast<int>(costPos.second * 175);
+            Color color(255, fade, fade);
+            mDrawer.groupShapes(true, color, color);
+            mDrawer.drawRect(GraphRect(startpos.x+1, costPos.first+pad,
+                maxWidth-2, fontHeight+pad2));
+            mDrawer.groupShapes(false, 0, 0);
+            }
         mDrawer.groupText(true, false);
         for(const auto &dstr : drawStrings)
             {
@@ -757,7 +790,11 @@ void ClassDrawer::drawDiagram(const ClassGraph &graph)
         mDrawer.setDiagramSize(graph.getGraphSize().getZoomed(mActualZoom));
         for(size_t ni1=0; ni1<graph.getNodes().size(); ni1++)
             {
-            drawNode(graph.getNodes()[ni1]);
+            ClassNode const &node = graph.getNodes()[ni1];
+            if(mDrawer.isVisible(node.getRect().getZoomed(mActualZoom)))
+                {
+                drawNode(node);
+                }
             }
         mDrawer.groupShapes(true, Color(0,0,0), Color(245,245,255));
         // Prevent duplicate dashed lines since multiple dashed lines can
@@ -767,6 +804,18 @@ void ClassDrawer::drawDiagram(const ClassGraph &graph)
             {
             for(size_t ni2=ni1+1; ni2<graph.getNodes().size(); ni2++)
                 {
+                if(mDrawer.hasVisibleRect())
+                    {
+                    // The connection is within the area of both nodes, except
+                    // that symbols can be slightly wider than the line.
+                    GraphRect connectRect = graph.getNodes()[ni1].getRect();
+                    connectRect.unionRect(graph.getNodes()[ni2].getRect());
+                    if(!mDrawer.isVisible(connectRect.getZoomed(mActualZoom).
+                            getExpanded(mDrawer.getPad(1))))
+                        {
+                        continue;
+                        }
+                    }
                 const ClassConnectItem *ci1 = graph.getNodeConnection(ni1, ni2);
                 const ClassConnectItem *ci2 = graph.getNodeConnection(ni2, ni1);
                 GraphPoint p1 = graph.getNodes()[ni1].getPosition();
@@ -10,15 +10,21 @@
 
 #include "DiagramDrawer.h"
 #include "ClassGraph.h"
+#include "OperationProfile.h"
 
 /// This is used to draw a class diagram.
 class ClassDrawer
     {
     public:
         ClassDrawer(Diagram const &diagram, DiagramDrawer &drawer):
-            mDiagram(diagram), mDrawer(drawer), mActualZoom(1.0)
+            mDiagram(diagram), mDrawer(drawer), mActualZoom(1.0),
+            mOperationProfile(nullptr)
             {}
         void setZoom(double zoom);
+        /// The operations that have a measured cost are highlighted.  This
+        /// must remain while the diagram is drawn.
+        void setOperationProfile(OperationProfile const *profile)
+            { mOperationProfile = profile; }
 // DEAD CODE
 //        double getActualZoom() const
 //                { return(mActualZoom); }
@@ -31,6 +37,7 @@ class ClassDrawer
         Diagram const &mDiagram;
         DiagramDrawer &mDrawer;
         double mActualZoom;
+        OperationProfile const *mOperationProfile;
 
         // Typically node1 is consumer, and node2 is producer
         /// @todo - should make this constant and clear
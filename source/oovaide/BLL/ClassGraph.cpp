@@ -76,8 +76,34 @@ void ClassGraph::updateGenes(const ModelData &modelData,
     updateConnections(modelData);
     if(mNodes.size() > 1)
         {
-        mGenes.initialize(*this, getAvgNodeSize());
-        mGenes.updatePositionsInGraph(*this, mBackgroundTaskStatusListener, *this);
+        std::vector<GraphPoint> oldPositions;
+        for(auto const &node : mNodes)
+            {
+            oldPositions.push_back(node.getPosition());
+            }
+        if(mGraphOptions.layeredLayout)
+            {
+            mLayout.updatePositionsInGraph(*this, mBackgroundTaskStatusListener, *this);
+            }
+        else
+            {
+            mGenes.initialize(*this, getAvgNodeSize());
+            mGenes.updatePositionsInGraph(*this, mBackgroundTaskStatusListener, *this);
+            }
+        // The layouts may move pinned nodes, so put them back.
+        bool anyPinned = false;
+        for(size_t i=0; i<mNodes.size(); i++)
+            {
+            if(mNodes[i].isPinned())
+                {
+                mNodes[i].setPosition(oldPositions[i]);
+                anyPinned = true;
+                }
+            }
+        if(anyPinned)
+            {
+            mLayout.moveNodesFromPinned(*this);
+            }
         }
     else
         {
@@ -594,9 +620,35 @@ GraphSize ClassGraph::getNodeSizeWithPadding(int nodeIndex) const
     return size;
     }
 
+bool ClassGraph::isIncrementalPlacement() const
+    {
+    bool anyPositioned = false;
+    bool anyNew = false;
+    for(auto const &node : mNodes)
+        {
+        if(node.isPositioned() || node.isPinned())
+            anyPositioned = true;
+        else
+            anyNew = true;
+        }
+    return(anyPositioned && anyNew);
+    }
+
+void ClassGraph::clearNodePositions()
+    {
+    for(auto &node : mNodes)
+        {
+        if(!node.isPinned())
+            {
+            node.clearPositioned();
+            }
+        }
+    }
+
 GraphSize ClassGraph::updateGraph(const ModelData &modelData, bool geneRepositioning)
     {
-    if(geneRepositioning)
+    bool incremental = mGraphOptions.incrementalLayout && isIncrementalPlacement();
+    if(geneRepositioning && !incremental)
         {
         stopAndWaitForCompletion();
         updateNodeSizes();
@@ -604,8 +656,17 @@ GraphSize ClassGraph::updateGraph(const ModelData &modelData, bool geneRepositio
         }
     else
         {
+        if(incremental)
+            {
+            stopAndWaitForCompletion();
+            }
         updateNodeSizes();
         updateConnections(modelData);
+        if(incremental)
+            {
+            // This is fast, so it is done in the foreground.
+            mLayout.placeNewNodes(*this);
+            }
         mGraphListener->doneRepositioning();
         }
     return(getGraphSize());
@@ -10,6 +10,7 @@
 
 #include "ModelObjects.h"
 #include "ClassGenes.h"
+#include "ClassLayout.h"
 #include "DiagramDrawer.h"
 #include "OovThreadedBackgroundQueue.h"
 #include <map>
@@ -47,6 +48,13 @@ struct ClassRelationDrawOptions
 
 struct ClassDrawOptions:public ClassNodeDrawOptions, public ClassRelationDrawOptions
     {
+    ClassDrawOptions():
+        layeredLayout(false), incrementalLayout(true)
+        {}
+    // Use the deterministic ClassLayout instead of the genetic ClassGenes.
+    bool layeredLayout;
+    // Only place new nodes when nodes are added to a positioned graph.
+    bool incrementalLayout;
     };
 
 
@@ -58,7 +66,7 @@ class ClassNode
     public:
         // @param type Is null for relation key.
         ClassNode(const ModelType *type, const ClassNodeDrawOptions &options):
-            mType(type),  mNodeOptions(options)
+            mType(type),  mNodeOptions(options), mPositioned(false), mPinned(false)
             {}
         bool isKey() const
             { return(mType == nullptr);}
@@ -68,9 +76,23 @@ class ClassNode
         GraphSize getSize() const
             { return rect.size; }
         void setPosition(const GraphPoint &pos)
-            { rect.start = pos; }
+            {
+            rect.start = pos;
+            mPositioned = true;
+            }
         GraphPoint getPosition() const
             { return rect.start; }
+        /// Returns false for new nodes that have not been placed yet.
+        bool isPositioned() const
+            { return mPositioned; }
+        /// This allows the node to be placed again by the next layout.
+        void clearPositioned()
+            { mPositioned = false; }
+        /// Pinned nodes are never moved by the layouts.
+        void setPinned(bool pinned)
+            { mPinned = pinned; }
+        bool isPinned() const
+            { return mPinned; }
         void setSize(GraphSize &size)
             { rect.size = size; }
         GraphRect const &getRect() const
@@ -84,6 +106,8 @@ class ClassNode
         const ModelType *mType;
         GraphRect rect;
         ClassNodeDrawOptions mNodeOptions;
+        bool mPositioned;
+        bool mPinned;
     };
 
 struct nodePair
@@ -190,8 +214,13 @@ class ClassGraph:public ThreadedWorkBackgroundQueue<ClassGraph, ClassGraphBackgr
         /// Updates node sizes and node connections in the graph.
         /// Initializes genes from the model.
         /// The nodes generally must have been added with the same modelData.
+        /// If the incrementalLayout option is set and nodes were added to a
+        /// graph that already has positions, only the new nodes are placed.
         GraphSize updateGraph(const ModelData &modelData, bool geneRepositioning);
 
+        /// Allows the next updateGraph to move all nodes except pinned nodes.
+        void clearNodePositions();
+
         void clearGraph()
             {
             mNodes.clear();
@@ -269,6 +298,7 @@ class ClassGraph:public ThreadedWorkBackgroundQueue<ClassGraph, ClassGraphBackgr
         std::vector<ClassNode> mNodes;
         std::map<nodePair_t, ClassConnectItem> mConnectMap;
         ClassGenes mGenes;
+        ClassLayout mLayout;
         GraphSize mPad;
         bool mModified;
         int mBackgroundTaskLevel;
@@ -282,10 +312,12 @@ class ClassGraph:public ThreadedWorkBackgroundQueue<ClassGraph, ClassGraphBackgr
 
         void removeNode(const ClassNode &node);
 
-        /// This updates quality information, runs the genetic algorithm for
-        /// placing the nodes, and then draws them.
+        /// This updates quality information, runs the genetic algorithm or
+        /// the layered layout for placing the nodes, and then draws them.
         void updateGenes(const ModelData &modelData,
             DiagramDrawer &nullDrawer);
+        /// Returns true if some nodes are positioned and some are new.
+        bool isIncrementalPlacement() const;
 
         /// Update connections between nodes.
         void updateConnections(const ModelData &modelData);
@@ -0,0 +1,875 @@
+/*
+ * ClassLayout.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#include "ClassLayout.h"
+#include "ClassGraph.h"
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <math.h>       // For sqrt
+
+
+static const int NumColdIterations = 60;
+static const int NumWarmIterations = 20;
+static const int NumIncrementalIterations = 10;
+// Larger values are faster, but less accurate.
+static const double BarnesHutTheta = 0.8;
+// The amount that the nodes are pulled toward the center of the graph so
+// that unconnected nodes do not drift away.
+static const double GravityFactor = 0.02;
+
+
+/// A quad tree used for the Barnes-Hut approximation of the repulsion
+/// between all nodes.
+class LayoutQuadTree
+    {
+    public:
+        struct Point
+            {
+            double x;
+            double y;
+            };
+        void build(std::vector<Point> const &points);
+        /// Add the repulsion of all points on the point at pointIndex.
+        void addRepulsion(size_t pointIndex, double idealDistSquared,
+                double &dx, double &dy) const;
+
+    private:
+        struct Cell
+            {
+            Cell(double cellX, double cellY, double cellSize):
+                minx(cellX), miny(cellY), size(cellSize), massx(0), massy(0),
+                count(0), firstPoint(NoIndex)
+                {
+                for(auto &ch : child)
+                    ch = NoIndex;
+                }
+            double minx;
+            double miny;
+            double size;
+            double massx;
+            double massy;
+            int count;
+            int child[4];
+            int firstPoint;
+            };
+        static const int NoIndex = -1;
+        static const int MaxDepth = 16;
+        std::vector<Cell> mCells;
+        std::vector<int> mNextPoint;
+        std::vector<Point> const *mPoints;
+
+        void insert(int cellIndex, int pointIndex, int depth);
+        int getChildIndex(int cellIndex, int pointIndex) const;
+        void computeMass(int cellIndex);
+    };
+
+void LayoutQuadTree::build(std::vector<Point> const &points)
+    {
+    mPoints = &points;
+    mCells.clear();
+    mNextPoint.assign(points.size(), NoIndex);
+    if(points.size() > 0)
+        {
+        double minx = points[0].x;
+        double miny = points[0].y;
+        double maxx = minx;
+        double maxy = miny;
+        for(auto const &pt : points)
+            {
+            minx = std::min(minx, pt.x);
+            miny = std::min(miny, pt.y);
+            maxx = std::max(maxx, pt.x);
+            maxy = std::max(maxy, pt.y);
+            }
+        double size = std::max(maxx - minx, maxy - miny) + 1;
+        mCells.push_back(Cell(minx, miny, size));
+        for(size_t i=0; i<points.size(); i++)
+            {
+            insert(0, static_cast<int>(i), 0);
+            }
+        computeMass(0);
+        }
+    }
+
+int LayoutQuadTree::getChildIndex(int cellIndex, int pointIndex) const
+    {
+    Cell const &cell = mCells[cellIndex];
+    Point const &pt = (*mPoints)[pointIndex];
+    double half = cell.size / 2;
+    int quadrant = 0;
+    if(pt.x >= cell.minx + half)
+        quadrant |= 1;
+    if(pt.y >= cell.miny + half)
+        quadrant |= 2;
+    return cell.child[quadrant];
+    }
+
+// The cell vector can be reallocated while inserting, so only indices are
+// used for cells.
+void LayoutQuadTree::insert(int cellIndex, int pointIndex, int depth)
+    {
+    if(mCells[cellIndex].child[0] == NoIndex)
+        {
+        if(mCells[cellIndex].firstPoint == NoIndex || depth >= MaxDepth)
+            {
+            mNextPoint[pointIndex] = mCells[cellIndex].firstPoint;
+            mCells[cellIndex].firstPoint = pointIndex;
+            return;
+            }
+        // Split the leaf, and move the single point into a child.
+        int existingPoint = mCells[cellIndex].firstPoint;
+        mCells[cellIndex].firstPoint = NoIndex;
+        double half = mCells[cellIndex].size / 2;
+        for(int quadrant=0; quadrant<4; quadrant++)
+            {
+            Cell child(mCells[cellIndex].minx + ((quadrant & 1) ? half : 0),
+                    mCells[cellIndex].miny + ((quadrant & 2) ? half : 0), half);
+            mCells.push_back(child);
+            mCells[cellIndex].child[quadrant] = static_cast<int>(mCells.size()-1);
+            }
+        insert(getChildIndex(cellIndex, existingPoint), existingPoint, depth+1);
+        }
+    insert(getChildIndex(cellIndex, pointIndex), pointIndex, depth+1);
+    }
+
+void LayoutQuadTree::computeMass(int cellIndex)
+    {
+    double massx = 0;
+    double massy = 0;
+    int count = 0;
+    if(mCells[cellIndex].child[0] == NoIndex)
+        {
+        for(int pi=mCells[cellIndex].firstPoint; pi!=NoIndex; pi=mNextPoint[pi])
+            {
+            massx += (*mPoints)[pi].x;
+            massy += (*mPoints)[pi].y;
+            count++;
+            }
+        }
+    else
+        {
+        for(int quadrant=0; quadrant<4; quadrant++)
+            {
+            int childIndex = mCells[cellIndex].child[quadrant];
+            computeMass(childIndex);
+            Cell const &child = mCells[childIndex];
+            massx += child.massx * child.count;
+            massy += child.massy * child.count;
+            count += child.count;
+            }
+        }
+    Cell &cell = mCells[cellIndex];
+    cell.count = count;
+    if(count > 0)
+        {
+        cell.massx = massx / count;
+        cell.massy = massy / count;
+        }
+    }
+
+// The force is idealDist^2 / dist, and is split into x and y parts.
+static void addRepulsionForce(double distx, double disty, double idealDistSquared,
+        int count, double &dx, double &dy)
+    {
+    double distSquared = distx*distx + disty*disty;
+    if(distSquared > 0)
+        {
+        double factor = idealDistSquared * count / distSquared;
+        dx += distx * factor;
+        dy += disty * factor;
+        }
+    }
+
+void LayoutQuadTree::addRepulsion(size_t pointIndex, double idealDistSquared,
+        double &dx, double &dy) const
+    {
+    if(mCells.size() == 0)
+        return;
+    Point const &pt = (*mPoints)[pointIndex];
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(stack.size() > 0)
+        {
+        Cell const &cell = mCells[stack.back()];
+        stack.pop_back();
+        if(cell.count == 0)
+            continue;
+        if(cell.child[0] == NoIndex)
+            {
+            for(int pi=cell.firstPoint; pi!=NoIndex; pi=mNextPoint[pi])
+                {
+                if(static_cast<size_t>(pi) != pointIndex)
+                    {
+                    Point const &other = (*mPoints)[pi];
+                    double distx = pt.x - other.x;
+                    double disty = pt.y - other.y;
+                    if(distx == 0 && disty == 0)
+                        {
+                        // Separate identical positions in a repeatable direction.
+                        distx = (static_cast<size_t>(pi) < pointIndex) ? 1 : -1;
+                        }
+                    addRepulsionForce(distx, disty, idealDistSquared, 1, dx, dy);
+                    }
+                }
+            }
+        else
+            {
+            double distx = pt.x - cell.massx;
+            double disty = pt.y - cell.massy;
+            double dist = sqrt(distx*distx + disty*disty);
+            if(dist > 0 && cell.size / dist < BarnesHutTheta)
+                {
+                addRepulsionForce(distx, disty, idealDistSquared, cell.count, dx, dy);
+                }
+            else
+                {
+                for(int quadrant=0; quadrant<4; quadrant++)
+                    stack.push_back(cell.child[quadrant]);
+                }
+            }
+        }
+    }
+
+
+/// This keeps a grid of rectangles so that free positions for new nodes can
+/// be found quickly.
+class LayoutOccupancy
+    {
+    public:
+        LayoutOccupancy(int cellSize):
+            mCellSize(std::max(cellSize, 1)), mMaxEndx(0)
+            {}
+        void addRect(GraphRect const &rect);
+        bool isOverlapped(GraphRect const &rect) const;
+        /// Search outward from the rect position for a position where the
+        /// rect does not overlap any other rect.
+        GraphPoint findFreePosition(GraphRect const &rect, int step) const;
+
+    private:
+        typedef std::pair<int, int> CellKey;
+        int mCellSize;
+        std::vector<GraphRect> mRects;
+        std::map<CellKey, std::vector<size_t>> mCells;
+        // The right edge of all rects.
+        int mMaxEndx;
+
+        int getCell(int pos) const
+            { return static_cast<int>(floor(static_cast<double>(pos) / mCellSize)); }
+    };
+
+static bool rectsOverlap(GraphRect const &rect1, GraphRect const &rect2)
+    {
+    return(rect1.start.x < rect2.endx() && rect2.start.x < rect1.endx() &&
+        rect1.start.y < rect2.endy() && rect2.start.y < rect1.endy());
+    }
+
+void LayoutOccupancy::addRect(GraphRect const &rect)
+    {
+    mRects.push_back(rect);
+    for(int cy=getCell(rect.start.y); cy<=getCell(rect.endy()); cy++)
+        {
+        for(int cx=getCell(rect.start.x); cx<=getCell(rect.endx()); cx++)
+            {
+            mCells[CellKey(cx, cy)].push_back(mRects.size()-1);
+            }
+        }
+    mMaxEndx = std::max(mMaxEndx, rect.endx());
+    }
+
+bool LayoutOccupancy::isOverlapped(GraphRect const &rect) const
+    {
+    for(int cy=getCell(rect.start.y); cy<=getCell(rect.endy()); cy++)
+        {
+        for(int cx=getCell(rect.start.x); cx<=getCell(rect.endx()); cx++)
+            {
+            auto cell = mCells.find(CellKey(cx, cy));
+            if(cell != mCells.end())
+                {
+                for(auto const &ri : cell->second)
+                    {
+                    if(rectsOverlap(rect, mRects[ri]))
+                        return true;
+                    }
+                }
+            }
+        }
+    return false;
+    }
+
+// The search goes around rings of increasing size, so the closest
+// positions are tried first.
+GraphPoint LayoutOccupancy::findFreePosition(GraphRect const &rect, int step) const
+    {
+    const int maxRings = 100;
+    for(int ring=0; ring<maxRings; ring++)
+        {
+        for(int dy=-ring; dy<=ring; dy++)
+            {
+            bool edgeRow = (dy == -ring || dy == ring);
+            for(int dx=-ring; dx<=ring; dx += (edgeRow || ring == 0) ? 1 : 2*ring)
+                {
+                GraphRect testRect(rect.start.x + dx * step, rect.start.y + dy * step,
+                    rect.size.x, rect.size.y);
+                if(testRect.start.x >= 0 && testRect.start.y >= 0 &&
+                        !isOverlapped(testRect))
+                    {
+                    return testRect.start;
+                    }
+                }
+            }
+        }
+    return GraphPoint(mMaxEndx, std::max(rect.start.y, 0));
+    }
+
+
+void ClassLayout::initNodes(ClassGraph const &graph)
+    {
+    std::vector<ClassNode> const &nodes = graph.getNodes();
+    mNodes.clear();
+    mNodes.resize(nodes.size());
+    mEdges.clear();
+    mNodeEdges.clear();
+    mNodeEdges.resize(nodes.size());
+    mLayers.clear();
+
+    int totalSize = 0;
+    int maxHeight = 0;
+    for(size_t i=0; i<nodes.size(); i++)
+        {
+        LayoutNode &node = mNodes[i];
+        node.size = graph.getNodeSizeWithPadding(static_cast<int>(i));
+        node.warm = nodes[i].isPositioned() || nodes[i].isPinned();
+        GraphRect rect(nodes[i].getPosition().x, nodes[i].getPosition().y,
+                node.size.x, node.size.y);
+        node.x = rect.centerx();
+        node.y = rect.centery();
+        totalSize += (node.size.x + node.size.y) / 2;
+        maxHeight = std::max(maxHeight, node.size.y);
+        }
+    int avgSize = (nodes.size() > 0) ? totalSize / static_cast<int>(nodes.size()) : 0;
+    mIdealDist = avgSize * 1.5 + 1;
+    mRowPitch = std::max(static_cast<int>(avgSize * 1.5), maxHeight / 2) + 1;
+
+    // The map is ordered, so the edges are always in the same order.
+    for(auto const &conn : graph.getConnections())
+        {
+        size_t n1 = conn.first.n1;
+        size_t n2 = conn.first.n2;
+        if(n1 != n2 && n1 < mNodes.size() && n2 < mNodes.size())
+            {
+            bool inherit = (conn.second.mConnectType & ctIneritance) != 0;
+            mEdges.push_back(LayoutEdge(n1, n2, inherit));
+            mNodeEdges[n1].push_back(mEdges.size()-1);
+            mNodeEdges[n2].push_back(mEdges.size()-1);
+            if(inherit)
+                {
+                mNodes[n1].inheritNode = true;
+                mNodes[n2].inheritNode = true;
+                }
+            }
+        }
+    }
+
+// This uses the longest path from the roots so that children are always
+// below all of their parents. If there is a cycle, the lowest index node
+// in the cycle is used as a root.
+void ClassLayout::assignInheritanceLayers()
+    {
+    std::vector<int> parentCount(mNodes.size(), 0);
+    for(auto const &edge : mEdges)
+        {
+        if(edge.inheritance)
+            parentCount[edge.n2]++;
+        }
+    std::deque<size_t> ready;
+    for(size_t ni=0; ni<mNodes.size(); ni++)
+        {
+        if(mNodes[ni].inheritNode && parentCount[ni] == 0)
+            ready.push_back(ni);
+        }
+    size_t nextCycleCheck = 0;
+    while(true)
+        {
+        if(ready.size() == 0)
+            {
+            for(; nextCycleCheck<mNodes.size(); nextCycleCheck++)
+                {
+                LayoutNode const &node = mNodes[nextCycleCheck];
+                if(node.inheritNode && !node.layered && parentCount[nextCycleCheck] > 0)
+                    {
+                    parentCount[nextCycleCheck] = 0;
+                    ready.push_back(nextCycleCheck);
+                    break;
+                    }
+                }
+            if(ready.size() == 0)
+                break;
+            }
+        size_t ni = ready.front();
+        ready.pop_front();
+        mNodes[ni].layered = true;
+        for(auto const &ei : mNodeEdges[ni])
+            {
+            LayoutEdge const &edge = mEdges[ei];
+            if(edge.inheritance && edge.n1 == ni && !mNodes[edge.n2].layered)
+                {
+                LayoutNode &child = mNodes[edge.n2];
+                child.layer = std::max(child.layer, mNodes[ni].layer + 1);
+                if(--parentCount[edge.n2] == 0)
+                    ready.push_back(edge.n2);
+                }
+            }
+        }
+    }
+
+// Nodes that are not in an inheritance hierarchy are placed relative to
+// connected nodes. Members are placed below owners.
+void ClassLayout::assignRelationLayers()
+    {
+    std::deque<size_t> ready;
+    for(size_t ni=0; ni<mNodes.size(); ni++)
+        {
+        if(mNodes[ni].layered)
+            ready.push_back(ni);
+        }
+    size_t nextUnlayered = 0;
+    while(true)
+        {
+        if(ready.size() == 0)
+            {
+            for(; nextUnlayered<mNodes.size(); nextUnlayered++)
+                {
+                if(!mNodes[nextUnlayered].layered)
+                    {
+                    mNodes[nextUnlayered].layered = true;
+                    ready.push_back(nextUnlayered);
+                    break;
+                    }
+                }
+            if(ready.size() == 0)
+                break;
+            }
+        size_t ni = ready.front();
+        ready.pop_front();
+        for(auto const &ei : mNodeEdges[ni])
+            {
+            LayoutEdge const &edge = mEdges[ei];
+            size_t other = getOtherNode(edge, ni);
+            if(!mNodes[other].layered)
+                {
+                mNodes[other].layer = mNodes[ni].layer + ((edge.n1 == ni) ? 1 : -1);
+                mNodes[other].layered = true;
+                ready.push_back(other);
+                }
+            }
+        }
+    int minLayer = 0;
+    int maxLayer = 0;
+    for(auto const &node : mNodes)
+        {
+        minLayer = std::min(minLayer, node.layer);
+        maxLayer = std::max(maxLayer, node.layer);
+        }
+    mLayers.resize(maxLayer - minLayer + 1);
+    for(size_t ni=0; ni<mNodes.size(); ni++)
+        {
+        mNodes[ni].layer -= minLayer;
+        mLayers[mNodes[ni].layer].push_back(ni);
+        }
+    }
+
+// Each sweep sorts the nodes in a layer by the average position of the
+// connected nodes in the neighboring layer. The sort is stable so that the
+// result is repeatable.
+void ClassLayout::orderLayers()
+    {
+    std::vector<double> order(mNodes.size(), 0);
+    for(auto const &layer : mLayers)
+        {
+        for(size_t pos=0; pos<layer.size(); pos++)
+            order[layer[pos]] = pos;
+        }
+    // Only the entries for the nodes of the sorted layer are set and used.
+    std::vector<double> bary(mNodes.size(), 0);
+    const int numSweeps = 4;
+    for(int sweep=0; sweep<numSweeps; sweep++)
+        {
+        bool down = (sweep % 2 == 0);
+        for(size_t li=0; li<mLayers.size(); li++)
+            {
+            size_t layerIndex = down ? li : mLayers.size() - 1 - li;
+            int neighborLayer = static_cast<int>(layerIndex) + (down ? -1 : 1);
+            std::vector<size_t> &layer = mLayers[layerIndex];
+            for(auto const &ni : layer)
+                {
+                double total = 0;
+                int count = 0;
+                for(auto const &ei : mNodeEdges[ni])
+                    {
+                    size_t other = getOtherNode(mEdges[ei], ni);
+                    if(mNodes[other].layer == neighborLayer)
+                        {
+                        total += order[other];
+                        count++;
+                        }
+                    }
+                bary[ni] = (count > 0) ? total / count : order[ni];
+                }
+            std::stable_sort(layer.begin(), layer.end(),
+                [&bary](size_t n1, size_t n2)
+                { return(bary[n1] < bary[n2]); });
+            for(size_t pos=0; pos<layer.size(); pos++)
+                order[layer[pos]] = pos;
+            }
+        }
+    }
+
+void ClassLayout::setInitialPositions()
+    {
+    double warmRight = 0;
+    bool anyWarm = false;
+    for(auto const &node : mNodes)
+        {
+        if(node.warm)
+            {
+            warmRight = std::max(warmRight, node.x + node.size.x / 2);
+            anyWarm = true;
+            }
+        }
+    for(auto const &layer : mLayers)
+        {
+        double left = anyWarm ? warmRight : 0;
+        for(auto const &ni : layer)
+            {
+            LayoutNode &node = mNodes[ni];
+            if(!node.warm)
+                {
+                node.x = left + node.size.x / 2;
+                node.y = node.layer * mRowPitch + mRowPitch / 2;
+                // New nodes start near existing related nodes.
+                double total = 0;
+                double totaly = 0;
+                int count = 0;
+                for(auto const &ei : mNodeEdges[ni])
+                    {
+                    LayoutNode const &other = mNodes[getOtherNode(mEdges[ei], ni)];
+                    if(other.warm)
+                        {
+                        total += other.x;
+                        totaly += other.y + ((mEdges[ei].n1 == ni) ? -mRowPitch : mRowPitch);
+                        count++;
+                        }
+                    }
+                if(count > 0)
+                    {
+                    node.x = total / count;
+                    node.y = totaly / count;
+                    }
+                }
+            left += node.size.x;
+            }
+        }
+    }
+
+void ClassLayout::addRepulsion()
+    {
+    std::vector<LayoutQuadTree::Point> points(mNodes.size());
+    for(size_t ni=0; ni<mNodes.size(); ni++)
+        {
+        points[ni].x = mNodes[ni].x;
+        points[ni].y = mNodes[ni].y;
+        }
+    LayoutQuadTree tree;
+    tree.build(points);
+    double idealDistSquared = mIdealDist * mIdealDist;
+    for(size_t ni=0; ni<mNodes.size(); ni++)
+        {
+        tree.addRepulsion(ni, idealDistSquared, mNodes[ni].dx, mNodes[ni].dy);
+        }
+    }
+
+// The attraction is dist^2 / idealDist. Inheritance only attracts
+// horizontally so that the layers are kept.
+void ClassLayout::addAttraction()
+    {
+    for(auto const &edge : mEdges)
+        {
+        LayoutNode &node1 = mNodes[edge.n1];
+        LayoutNode &node2 = mNodes[edge.n2];
+        double distx = node1.x - node2.x;
+        double disty = edge.inheritance ? 0 : node1.y - node2.y;
+        double dist = sqrt(distx*distx + disty*disty);
+        double factor = dist / mIdealDist;
+        node1.dx -= distx * factor;
+        node1.dy -= disty * factor;
+        node2.dx += distx * factor;
+        node2.dy += disty * factor;
+        }
+    }
+
+void ClassLayout::forceIteration(double temperature)
+    {
+    double centerx = 0;
+    double centery = 0;
+    for(auto &node : mNodes)
+        {
+        node.dx = 0;
+        node.dy = 0;
+        centerx += node.x;
+        centery += node.y;
+        }
+    centerx /= mNodes.size();
+    centery /= mNodes.size();
+    addRepulsion();
+    addAttraction();
+    for(auto &node : mNodes)
+        {
+        // Existing nodes are only used as anchors for the new nodes.
+        if(node.warm)
+            continue;
+        node.dx += (centerx - node.x) * GravityFactor;
+        node.dy += (centery - node.y) * GravityFactor;
+        if(node.inheritNode)
+            {
+            // Keep inheritance layers.
+            node.dy = 0;
+            }
+        double dist = sqrt(node.dx*node.dx + node.dy*node.dy);
+        if(dist > temperature)
+            {
+            node.dx = node.dx * temperature / dist;
+            node.dy = node.dy * temperature / dist;
+            }
+        node.x += node.dx;
+        node.y += node.dy;
+        }
+    }
+
+// Rows that are wider than the wrap width are continued below so that
+// the diagram does not become very wide when there are few layers. Existing
+// rows are not wrapped so that they are not rearranged.
+void ClassLayout::packRows(bool warmStart)
+    {
+    double minx = mNodes[0].x - mNodes[0].size.x / 2;
+    double totalArea = 0;
+    int maxWidth = 0;
+    // The rows are keyed by the top of the row. Existing nodes were already
+    // packed, so they keep their rows.
+    std::map<int, std::vector<size_t>> rows;
+    for(size_t ni=0; ni<mNodes.size(); ni++)
+        {
+        LayoutNode const &node = mNodes[ni];
+        minx = std::min(minx, node.x - node.size.x / 2);
+        totalArea += static_cast<double>(node.size.x) * node.size.y;
+        maxWidth = std::max(maxWidth, node.size.x);
+        if(node.warm)
+            rows[static_cast<int>(node.y) - node.size.y / 2].push_back(ni);
+        }
+    for(size_t ni=0; ni<mNodes.size(); ni++)
+        {
+        LayoutNode const &node = mNodes[ni];
+        if(!node.warm)
+            {
+            int rowTop = static_cast<int>(floor(node.y / mRowPitch)) * mRowPitch;
+            // Join an existing row if the node is close to it.
+            auto existingRow = rows.upper_bound(static_cast<int>(node.y));
+            if(existingRow != rows.begin())
+                {
+                --existingRow;
+                if(node.y < existingRow->first + mRowPitch)
+                    rowTop = existingRow->first;
+                }
+            rows[rowTop].push_back(ni);
+            }
+        }
+    int wrapWidth = std::max(static_cast<int>(sqrt(totalArea) * 2), maxWidth);
+
+    bool firstRow = true;
+    int top = 0;
+    int minLeft = 0;
+    int minTop = 0;
+    for(auto &row : rows)
+        {
+        std::vector<size_t> &rowNodes = row.second;
+        std::stable_sort(rowNodes.begin(), rowNodes.end(),
+            [this](size_t n1, size_t n2)
+            { return(mNodes[n1].x < mNodes[n2].x); });
+        // Rows keep their vertical position unless they would overlap the
+        // previous row.
+        top = firstRow ? row.first : std::max(top, row.first);
+        if(firstRow)
+            minTop = top;
+        int wrapIndex = 0;
+        int rowHeight = 0;
+        bool firstInRow = true;
+        int right = 0;
+        for(auto const &ni : rowNodes)
+            {
+            LayoutNode &node = mNodes[ni];
+            int left = static_cast<int>(node.x - node.size.x / 2 - minx);
+            if(!firstInRow)
+                {
+                left = std::max(left, right);
+                if(!warmStart && left + node.size.x > (wrapIndex + 1) * wrapWidth)
+                    {
+                    wrapIndex = (left + node.size.x) / wrapWidth;
+                    left = std::max(left, wrapIndex * wrapWidth);
+                    top += rowHeight;
+                    rowHeight = 0;
+                    }
+                }
+            right = left + node.size.x;
+            left -= wrapIndex * wrapWidth;
+            node.x = left + node.size.x / 2;
+            node.y = top + node.size.y / 2;
+            rowHeight = std::max(rowHeight, node.size.y);
+            if((firstRow && firstInRow) || left < minLeft)
+                minLeft = left;
+            firstInRow = false;
+            }
+        top += rowHeight;
+        firstRow = false;
+        }
+    // Only move existing nodes if new nodes are outside of the graph.
+    int graphLeft = static_cast<int>(floor(minx));
+    int shiftx = graphLeft + minLeft;
+    int shifty = minTop;
+    if(warmStart)
+        {
+        shiftx = std::min(shiftx, 0);
+        shifty = std::min(shifty, 0);
+        }
+    for(auto &node : mNodes)
+        {
+        node.x += graphLeft - shiftx;
+        node.y -= shifty;
+        }
+    }
+
+void ClassLayout::runForceLayout(int numIterations, double startTemperature,
+        OovTaskStatusListener *listener, OovTaskContinueListener *contListener)
+    {
+    assignInheritanceLayers();
+    assignRelationLayers();
+    orderLayers();
+    setInitialPositions();
+
+    OovTaskStatusListenerId taskId = 0;
+    if(listener)
+        {
+        taskId = listener->startTask("Optimizing layout.", numIterations);
+        }
+    for(int i=0; i<numIterations; i++)
+        {
+        if(contListener && !contListener->continueProcessingItem())
+            {
+            break;
+            }
+        forceIteration(startTemperature * (numIterations - i) / numIterations);
+        if(listener && !listener->updateProgressIteration(taskId, i, nullptr))
+            {
+            break;
+            }
+        }
+    if(listener)
+        {
+        listener->endTask(taskId);
+        }
+    }
+
+void ClassLayout::updatePositionsInGraph(ClassGraph &graph,
+        OovTaskStatusListener *listener, OovTaskContinueListener &contListener)
+    {
+    initNodes(graph);
+    if(mNodes.size() == 0)
+        return;
+    bool anyWarm = std::any_of(mNodes.begin(), mNodes.end(),
+        [](LayoutNode const &node) { return node.warm; });
+    if(anyWarm)
+        {
+        runForceLayout(NumWarmIterations, mIdealDist / 4, listener, &contListener);
+        }
+    else
+        {
+        runForceLayout(NumColdIterations, mIdealDist, listener, &contListener);
+        }
+    packRows(anyWarm);
+    std::vector<ClassNode> &nodes = graph.getNodes();
+    for(size_t ni=0; ni<nodes.size(); ni++)
+        {
+        LayoutNode const &node = mNodes[ni];
+        nodes[ni].setPosition(GraphPoint(static_cast<int>(node.x) - node.size.x / 2,
+                static_cast<int>(node.y) - node.size.y / 2));
+        }
+    }
+
+void ClassLayout::placeNewNodes(ClassGraph &graph)
+    {
+    initNodes(graph);
+    if(mNodes.size() == 0)
+        return;
+    runForceLayout(NumIncrementalIterations, mIdealDist / 4, nullptr, nullptr);
+
+    std::vector<ClassNode> &nodes = graph.getNodes();
+    LayoutOccupancy occupancy(static_cast<int>(mIdealDist));
+    for(size_t ni=0; ni<nodes.size(); ni++)
+        {
+        if(mNodes[ni].warm)
+            {
+            occupancy.addRect(GraphRect(nodes[ni].getPosition().x,
+                nodes[ni].getPosition().y, mNodes[ni].size.x, mNodes[ni].size.y));
+            }
+        }
+    for(size_t ni=0; ni<nodes.size(); ni++)
+        {
+        LayoutNode const &node = mNodes[ni];
+        if(!node.warm)
+            {
+            GraphRect rect(static_cast<int>(node.x) - node.size.x / 2,
+                static_cast<int>(node.y) - node.size.y / 2, node.size.x, node.size.y);
+            rect.start = occupancy.findFreePosition(rect, getSearchStep());
+            occupancy.addRect(rect);
+            nodes[ni].setPosition(rect.start);
+            }
+        }
+    }
+
+void ClassLayout::moveNodesFromPinned(ClassGraph &graph)
+    {
+    initNodes(graph);
+    std::vector<ClassNode> &nodes = graph.getNodes();
+    LayoutOccupancy pinnedOccupancy(static_cast<int>(mIdealDist));
+    for(size_t ni=0; ni<nodes.size(); ni++)
+        {
+        if(nodes[ni].isPinned())
+            {
+            pinnedOccupancy.addRect(GraphRect(nodes[ni].getPosition().x,
+                nodes[ni].getPosition().y, graph.getNodeSizeWithPadding(ni).x,
+                graph.getNodeSizeWithPadding(ni).y));
+            }
+        }
+    std::vector<size_t> movedNodes;
+    LayoutOccupancy occupancy(static_cast<int>(mIdealDist));
+    for(size_t ni=0; ni<nodes.size(); ni++)
+        {
+        GraphRect rect(nodes[ni].getPosition().x, nodes[ni].getPosition().y,
+            graph.getNodeSizeWithPadding(ni).x, graph.getNodeSizeWithPadding(ni).y);
+        if(!nodes[ni].isPinned() && pinnedOccupancy.isOverlapped(rect))
+            movedNodes.push_back(ni);
+        else
+            occupancy.addRect(rect);
+        }
+    for(auto const &ni : movedNodes)
+        {
+        GraphRect rect(nodes[ni].getPosition().x, nodes[ni].getPosition().y,
+            graph.getNodeSizeWithPadding(ni).x, graph.getNodeSizeWithPadding(ni).y);
+        rect.start = occupancy.findFreePosition(rect, getSearchStep());
+        occupancy.addRect(rect);
+        nodes[ni].setPosition(rect.start);
+        }
+    }
@@ -0,0 +1,113 @@
+/*
+ * ClassLayout.h
+ *
+ *  Created on: Oct 19, 2026
+ *  \copyright 2026 DCBlaha.  Distributed under the GPL.
+ */
+
+#ifndef CLASSLAYOUT_H_
+#define CLASSLAYOUT_H_
+
+#include "Graph.h"
+#include "OovProcess.h"
+#include <algorithm>
+#include <vector>
+
+
+/// This defines a deterministic layout for the class diagram that can be
+/// used instead of the genetic algorithm in ClassGenes.
+///
+/// The inheritance relations are placed into layers (Sugiyama style) so that
+/// parents are above children, and the order within each layer is found using
+/// the barycenter of the connected nodes.  Then a force directed pass that uses
+/// a Barnes-Hut quad tree for the repulsion pulls classes with aggregation and
+/// other relations together.  Finally the nodes are packed into rows so that
+/// they do not overlap.
+///
+/// Each pass is O((N+E) log N) for N nodes and E connections, and the same
+/// input always produces the same layout. Nodes that already have a position
+/// are used as the starting point, so adding a few classes to an existing
+/// diagram does not reshuffle the diagram.
+class ClassLayout
+    {
+    public:
+        ClassLayout():
+            mIdealDist(0), mRowPitch(0)
+            {}
+        /// Move the positions of the nodes in the graph.
+        void updatePositionsInGraph(class ClassGraph &graph,
+                OovTaskStatusListener *listener, OovTaskContinueListener &contListener);
+        /// Place only the nodes that have not been positioned. The existing
+        /// and pinned nodes are not moved, and the new nodes are placed near
+        /// related nodes where they do not overlap other nodes.
+        void placeNewNodes(class ClassGraph &graph);
+        /// Move unpinned nodes that overlap pinned nodes to a nearby free
+        /// position. This is used after the genetic or layered layout.
+        void moveNodesFromPinned(class ClassGraph &graph);
+
+    private:
+        struct LayoutNode
+            {
+            LayoutNode():
+                x(0), y(0), dx(0), dy(0), layer(0), layered(false),
+                warm(false), inheritNode(false)
+                {}
+            // The center of the node.
+            double x;
+            double y;
+            // The displacement for the current iteration.
+            double dx;
+            double dy;
+            // The padded size of the node.
+            GraphSize size;
+            int layer;
+            // True when the layer has been assigned.
+            bool layered;
+            // True when the node had a position before the layout started,
+            // or the node is pinned.
+            bool warm;
+            // True when the node is a parent or child of an inheritance relation.
+            bool inheritNode;
+            };
+        struct LayoutEdge
+            {
+            LayoutEdge(size_t node1, size_t node2, bool inherit):
+                n1(node1), n2(node2), inheritance(inherit)
+                {}
+            // For inheritance, n1 is the parent. For aggregation, n1 is the owner.
+            size_t n1;
+            size_t n2;
+            bool inheritance;
+            };
+        std::vector<LayoutNode> mNodes;
+        std::vector<LayoutEdge> mEdges;
+        // For each node, the indices into mEdges.
+        std::vector<std::vector<size_t>> mNodeEdges;
+        std::vector<std::vector<size_t>> mLayers;
+        double mIdealDist;
+        int mRowPitch;
+
+        void initNodes(class ClassGraph const &graph);
+        /// Run all of the layout steps before packing the nodes.
+        void runForceLayout(int numIterations, double startTemperature,
+                OovTaskStatusListener *listener, OovTaskContinueListener *contListener);
+        void assignInheritanceLayers();
+        void assignRelationLayers();
+        void orderLayers();
+        void setInitialPositions();
+        /// Move the nodes by a single step of the force directed algorithm.
+        /// @param temperature The maximum distance that a node can move.
+        void forceIteration(double temperature);
+        void addRepulsion();
+        void addAttraction();
+        /// Snap the nodes into rows and remove overlap within each row.
+        /// @param warmStart Prevents moving all nodes to the graph origin.
+        void packRows(bool warmStart);
+        /// The distance between positions when searching for a free position.
+        int getSearchStep() const
+            { return std::max(static_cast<int>(mIdealDist / 4), 1); }
+        size_t getOtherNode(LayoutEdge const &edge, size_t nodeIndex) const
+            { return((edge.n1 == nodeIndex) ? edge.n2 : edge.n1); }
+    };
+
+#endif
@@ -147,6 +147,63 @@ double Diagram::getGlobalFontSize()
 DiagramDrawer::~DiagramDrawer()
     {}
 
+TextExtentCache &TextExtentCache::getCache()
+    {
+    static TextExtentCache sCache;
+    return sCache;
+    }
+
+bool TextExtentCache::getExtent(double fontSize, bool italics,
+        OovStringRef const text, TextExtent &extent)
+    {
+    std::lock_guard<std::mutex> lock(mMutex);
+    bool found = false;
+    auto iter = mMap.find(Key(fontSize, italics, text));
+    if(iter != mMap.end())
+        {
+        // Move the entry to the front.
+        mLruList.splice(mLruList.begin(), mLruList, iter->second);
+        extent = iter->second->second;
+        found = true;
+        mHits++;
+        }
+    else
+        {
+        mMisses++;
+        }
+    return found;
+    }
+
+void TextExtentCache::addExtent(double fontSize, bool italics,
+        OovStringRef const text, TextExtent const &extent)
+    {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Key key(fontSize, italics, text);
+    auto iter = mMap.find(key);
+    if(iter != mMap.end())
+        {
+        iter->second->second = extent;
+        mLruList.splice(mLruList.begin(), mLruList, iter->second);
+        }
+    else
+        {
+        mLruList.push_front(std::make_pair(key, extent));
+        mMap[key] = mLruList.begin();
+        if(mLruList.size() > mMaxEntries)
+            {
+            mMap.erase(mLruList.back().first);
+            mLruList.pop_back();
+            }
+        }
+    }
+
+void TextExtentCache::clear()
+    {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMap.clear();
+    mLruList.clear();
+    }
+
 int DiagramDrawer::getPad(int div) const
     {
     int pad = static_cast<int>(getTextExtentHeight("W"));
@@ -9,6 +9,9 @@
 #define DIAGRAMDRAWER_H_
 
 #include <vector>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 #include "OovString.h"
 #include "Graph.h"
 #include "FastGene.h"
@@ -57,6 +60,74 @@ class DiagramArrow
 #define MIN_FONT_SIZE 5
 #define MAX_FONT_SIZE 30
 
+struct TextExtent
+    {
+    TextExtent(float w=0, float h=0):
+        width(w), height(h)
+        {}
+    float width;
+    float height;
+    };
+
+/// This caches the sizes of text so that the node sizes can be updated
+/// without measuring every string again. The entries are keyed by font size,
+/// italics and the text, and the least recently used entries are removed when
+/// the cache is full.
+/// There is a single cache that is shared by all drawers, and it can be used
+/// from the background threads.
+class TextExtentCache
+    {
+    public:
+        TextExtentCache(size_t maxEntries=DefaultMaxEntries):
+            mMaxEntries(maxEntries), mHits(0), mMisses(0)
+            {}
+        static TextExtentCache &getCache();
+        /// Returns true and fills in the extent if the text was found.
+        bool getExtent(double fontSize, bool italics, OovStringRef const text,
+                TextExtent &extent);
+        void addExtent(double fontSize, bool italics, OovStringRef const text,
+                TextExtent const &extent);
+        void clear();
+        size_t getNumHits() const
+            { return mHits; }
+        size_t getNumMisses() const
+            { return mMisses; }
+
+        static const size_t DefaultMaxEntries = 20000;
+
+    private:
+        struct Key
+            {
+            Key(double size, bool ital, OovStringRef const txt):
+                fontSize(size), italics(ital), text(txt)
+                {}
+            bool operator==(Key const &rhs) const
+                {
+                return(fontSize == rhs.fontSize && italics == rhs.italics &&
+                    text == rhs.text);
+                }
+            double fontSize;
+            bool italics;
+            std::string text;
+            };
+        struct KeyHash
+            {
+            size_t operator()(Key const &key) const
+                {
+                return std::hash<std::string>()(key.text) ^
+                    (std::hash<double>()(key.fontSize) << 1) ^ key.italics;
+                }
+            };
+        typedef std::list<std::pair<Key, TextExtent>> LruList;
+        // The most recently used entries are at the front of the list.
+        LruList mLruList;
+        std::unordered_map<Key, LruList::iterator, KeyHash> mMap;
+        std::mutex mMutex;
+        size_t mMaxEntries;
+        size_t mHits;
+        size_t mMisses;
+    };
+
 /// Each diagram can have its own font / font size.  When a diagram is saved,
 /// the font is saved with the diagram.
 /// If the global font is set, it applies to future diagrams, except if a
@@ -94,7 +165,8 @@ class DiagramDrawer
     public:
         DiagramDrawer(Diagram &diagram):
             mDiagram(diagram),
-            mCurrentDrawingFontSize(diagram.getDiagramBaseFontSize())
+            mCurrentDrawingFontSize(diagram.getDiagramBaseFontSize()),
+            mHasVisibleRect(false)
             {}
         virtual ~DiagramDrawer();
         /// These must be called before any other drawing function.
@@ -128,11 +200,31 @@ class DiagramDrawer
         double getCurrentDrawingFontSize() const
             { return mCurrentDrawingFontSize; }
 
+        /// Sets the part of the diagram that must be drawn. Shapes that are
+        /// completely outside of this rectangle can be skipped. The default
+        /// is to draw everything, which is needed for files (svg).
+        void setVisibleRect(GraphRect const &rect)
+            {
+            mVisibleRect = rect;
+            mHasVisibleRect = true;
+            }
+        void clearVisibleRect()
+            { mHasVisibleRect = false; }
+        bool hasVisibleRect() const
+            { return mHasVisibleRect; }
+        GraphRect const &getVisibleRect() const
+            { return mVisibleRect; }
+        /// Returns true if any part of the rect is visible.
+        bool isVisible(GraphRect const &rect) const
+            { return(!mHasVisibleRect || mVisibleRect.isOverlapped(rect)); }
+
     private:
         Diagram &mDiagram;
         // This can be affected by zoom, or by relative font sizes from the base font size.
         // This is not the base diagram font size. See the Diagram class.
         double mCurrentDrawingFontSize;
+        GraphRect mVisibleRect;
+        bool mHasVisibleRect;
     };
 
 class DiagramDependencyDrawer
@@ -115,6 +115,15 @@ void EditorContainer::viewFile(OovStringRef const procPath, char const * const *
         }
     }
 
+void EditorContainer::analysisComplete()
+    {
+    if(mBackgroundProcess.isRunning())
+        {
+        OovIpcMsg msg(EC_AnalysisComplete);
+        mBackgroundProcess.childProcessSend(msg);
+        }
+    }
+
 void EditorContainer::handleMessage(OovIpcMsg const &cmd)
     {
     OovString retStr;
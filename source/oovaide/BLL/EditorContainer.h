@@ -35,6 +35,8 @@ class EditorContainer:public OovProcessListener
             { mListener = listener; }
         void viewFile(OovStringRef const procPath, char const * const *argv,
             OovStringRef const fn, int lineNum);
+        /// Tells the editor that the analysis files changed.
+        void analysisComplete();
         bool okToExit();
 
     private:
@@ -7,6 +7,7 @@
 #include "Graph.h"
 #include <stdlib.h>     // for abs
 #include <math.h>       // for fabs
+#include <algorithm>
 
 static double slope(GraphPoint p1, GraphPoint p2)
 {
@@ -86,15 +87,14 @@ void GraphRect::findConnectPoints(GraphRect const &rect2, GraphPoint &p1e, Graph
 
 void GraphRect::unionRect(GraphRect const &rect2)
     {
-    GraphRect &rect1 = *this;
-    if(rect2.start.x < rect1.start.x)
-        rect1.start.x = rect2.start.x;
-    if(rect2.start.y < rect1.start.y)
-        rect1.start.y = rect2.start.y;
-    if(rect2.endx() > rect1.endx())
-        rect1.size.x = rect2.endx() - rect1.start.x;
-    if(rect2.endy() > rect1.endy())
-        rect1.size.y = rect2.endy() - rect1.start.y;
+    // The ends are found before the start is moved so that moving the
+    // start left or up grows the size.
+    int endX = std::max(endx(), rect2.endx());
+    int endY = std::max(endy(), rect2.endy());
+    start.x = std::min(start.x, rect2.start.x);
+    start.y = std::min(start.y, rect2.start.y);
+    size.x = endX - start.x;
+    size.y = endY - start.y;
     }
 
 bool GraphRect::isPointIn(GraphPoint point) const
@@ -117,3 +117,51 @@ GraphRect GraphRect::getZoomed(double zoom) const
     rect.size = size.getZoomed(zoom);
     return rect;
     }
+
+
+void GraphRectIndex::clear(int cellSize)
+    {
+    mCellSize = (cellSize > 0) ? cellSize : DefaultCellSize;
+    mCells.clear();
+    mRects.clear();
+    }
+
+void GraphRectIndex::addRect(GraphRect const &rect, size_t id)
+    {
+    size_t rectIndex = mRects.size();
+    mRects.push_back(std::make_pair(rect, id));
+    for(int cy=getCellIndex(rect.start.y); cy<=getCellIndex(rect.endy()); cy++)
+        {
+        for(int cx=getCellIndex(rect.start.x); cx<=getCellIndex(rect.endx()); cx++)
+            {
+            mCells[CellPos(cy, cx)].push_back(rectIndex);
+            }
+        }
+    }
+
+void GraphRectIndex::getOverlapped(GraphRect const &area,
+        std::vector<size_t> &ids) const
+    {
+    ids.clear();
+    int startCellX = getCellIndex(area.start.x);
+    int endCellX = getCellIndex(area.endx());
+    for(int cy=getCellIndex(area.start.y); cy<=getCellIndex(area.endy()); cy++)
+        {
+        // The cells are keyed by row first, so each row is a single range.
+        auto iter = mCells.lower_bound(CellPos(cy, startCellX));
+        auto endIter = mCells.upper_bound(CellPos(cy, endCellX));
+        for(; iter != endIter; ++iter)
+            {
+            for(size_t rectIndex : iter->second)
+                {
+                if(mRects[rectIndex].first.isOverlapped(area))
+                    {
+                    ids.push_back(mRects[rectIndex].second);
+                    }
+                }
+            }
+        }
+    // A rectangle that spans several cells is found more than once.
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
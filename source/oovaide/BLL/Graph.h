@@ -9,6 +9,9 @@
 #define GRAPH_H_
 
 #include <stdint.h>     // For uint..._t
+#include <stddef.h>     // For size_t
+#include <map>
+#include <vector>
 
 #ifndef M_PI
 #define M_PI 3.14159265
@@ -134,6 +137,18 @@ class GraphRect
             { return start.y+(size.y/2); }
         bool isPointIn(GraphPoint point) const;
         bool isXOverlapped(GraphRect const &rect) const;
+        /// Returns true if any part of the rectangles overlap.
+        bool isOverlapped(GraphRect const &rect) const
+            {
+            return(start.x <= rect.endx() && rect.start.x <= endx() &&
+                start.y <= rect.endy() && rect.start.y <= endy());
+            }
+        /// Grows the rectangle by the margin on all sides.
+        GraphRect getExpanded(int margin) const
+            {
+            return GraphRect(start.x-margin, start.y-margin,
+                size.x+margin*2, size.y+margin*2);
+            }
         GraphPoint getCenter() const
             { return GraphPoint(start.x+size.x/2, start.y+size.y/2); }
         // Given two rectangles, find the points at the edges of the rectangles
@@ -148,5 +163,39 @@ class GraphRect
         GraphSize size;
     };
 
+/// This is a spatial index that is used to quickly find the rectangles that
+/// overlap an area, such as the visible part of a diagram. The rectangles are
+/// stored in the cells of a uniform grid.
+class GraphRectIndex
+    {
+    public:
+        GraphRectIndex(int cellSize=DefaultCellSize):
+            mCellSize(cellSize)
+            {}
+        void clear(int cellSize=DefaultCellSize);
+        /// The id is typically the index of a node in a graph.
+        void addRect(GraphRect const &rect, size_t id);
+        /// Gets the ids of the rectangles that overlap the area. The ids are
+        /// in increasing order so that the drawing order is not changed.
+        void getOverlapped(GraphRect const &area, std::vector<size_t> &ids) const;
+        size_t size() const
+            { return mRects.size(); }
+
+        static const int DefaultCellSize = 256;
+
+    private:
+        // The row (y) is first so that the cells of a row are adjacent.
+        typedef std::pair<int, int> CellPos;
+        std::map<CellPos, std::vector<size_t>> mCells;
+        // Each cell refers to indices of mRects.
+        std::vector<std::pair<GraphRect, size_t>> mRects;
+        int mCellSize;
+
+        int getCellIndex(int pos) const
+            {
+            // Round down for negative positions.
+            return((pos >= 0) ? pos / mCellSize : (pos - mCellSize + 1) / mCellSize);
+            }
+    };
 
 #endif /* GRAPH_H_ */
@@ -426,6 +426,16 @@ void ZoneDrawer::updateGraph(DiagramDrawer &drawer, ZoneGraph const &graph,
     GraphDrawOffset.y = -(graphRect.start.y - margin);
     mDrawingSize.x = graphRect.size.x + GraphDrawOffset.x + margin;
     mDrawingSize.y = graphRect.size.y + GraphDrawOffset.y + margin;
+
+    // The node radius depends on the font of the drawer, so only the centers
+    // are saved, and the radius is added to the visible area when drawing.
+    mNodeCenterIndex.clear();
+    for(size_t i=0; i<mGraph->getNodes().size(); i++)
+        {
+        GraphPoint pos = getNodePosition(drawer, i);
+        pos.add(GraphDrawOffset);
+        mNodeCenterIndex.addRect(GraphRect(pos, pos), i);
+        }
     }
 
 GraphSize ZoneDrawer::getDrawingSize() const
@@ -448,9 +458,22 @@ void ZoneDrawer::drawGraph(DiagramDrawer &drawer)
         drawer.groupShapes(true, Color(0,0,0), Color(245,245,255));
         if(mGraph->getDrawOptions().mDrawAllClasses)
             {
-            for(size_t i=0; i<mGraph->getNodes().size(); i++)
+            if(drawer.hasVisibleRect())
                 {
-                drawNode(drawer, i);
+                std::vector<size_t> nodeIndices;
+                mNodeCenterIndex.getOverlapped(drawer.getVisibleRect().getExpanded(
+                    getNodeRadius(drawer)), nodeIndices);
+                for(auto nodeIndex : nodeIndices)
+                    {
+                    drawNode(drawer, nodeIndex);
+                    }
+                }
+            else
+                {
+                for(size_t i=0; i<mGraph->getNodes().size(); i++)
+                    {
+                    drawNode(drawer, i);
+                    }
                 }
             }
         else
@@ -676,6 +699,10 @@ void ZoneDrawer::drawConnection(DiagramDrawer &drawer,
     GraphPoint secondPoint = getNodePosition(drawer, secondNodeIndex);
     firstPoint.add(GraphDrawOffset);
     secondPoint.add(GraphDrawOffset);
+    if(!drawer.isVisible(GraphRect(firstPoint, secondPoint)))
+        {
+        return;
+        }
 
     int size = getNodeRadius(drawer);
     secondPoint = findIntersect(firstPoint, secondPoint, size);
@@ -69,6 +69,9 @@ class ZoneDrawer
         GraphPoint GraphDrawOffset;
         GraphSize mDrawingSize;
         bool mDrawNodeText;
+        // The node centers including the draw offset. This is used to find
+        // the nodes that are in the visible area.
+        GraphRectIndex mNodeCenterIndex;
 
         void updateNodePositions();
         void drawNode(DiagramDrawer &drawer, size_t nodeIndex);
@@ -6,6 +6,8 @@
  */
 
 #include "CairoDrawer.h"
+#include <algorithm>
+#include <math.h>
 
 
 #include "Gui.h"        // For Dialog
@@ -28,18 +30,35 @@ bool setFontDialog(int &fontSize)
 
 
 
+TextExtent getCairoTextExtent(cairo_t *cr, OovStringRef const text)
+    {
+    // The key is taken from the cairo context instead of the drawer since
+    // the SVG drawer does not set the font size of the context.
+    cairo_matrix_t fontMatrix;
+    cairo_get_font_matrix(cr, &fontMatrix);
+    bool italics = (cairo_toy_font_face_get_slant(cairo_get_font_face(cr)) !=
+        CAIRO_FONT_SLANT_NORMAL);
+    TextExtentCache &cache = TextExtentCache::getCache();
+    TextExtent extent;
+    if(!cache.getExtent(fontMatrix.xx, italics, text, extent))
+        {
+        cairo_text_extents_t extents;
+        cairo_text_extents(cr, text, &extents);
+        extent.width = extents.width;
+        extent.height = extents.height;
+        cache.addExtent(fontMatrix.xx, italics, text, extent);
+        }
+    return extent;
+    }
+
 float NullDrawer::getTextExtentWidth(OovStringRef const name) const
     {
-    cairo_text_extents_t extents;
-    cairo_text_extents(cr, name, &extents);
-    return extents.width;
+    return getCairoTextExtent(cr, name).width;
     }
 
 float NullDrawer::getTextExtentHeight(OovStringRef const name) const
     {
-    cairo_text_extents_t extents;
-    cairo_text_extents(cr, name, &extents);
-    return extents.height;
+    return getCairoTextExtent(cr, name).height;
     }
 
 
@@ -51,8 +70,11 @@ void NullDrawer::setCurrentDrawingFontSize(double size)
 
 void CairoDrawer::drawRect(const GraphRect &rect)
     {
-    cairo_rectangle(cr, rect.start.x, rect.start.y, rect.size.x, rect.size.y);
-    setFillAndLine(cr, mFillColor, mLineColor);
+    if(isVisible(rect))
+        {
+        cairo_rectangle(cr, rect.start.x, rect.start.y, rect.size.x, rect.size.y);
+        setFillAndLine(cr, mFillColor, mLineColor);
+        }
     }
 
 void CairoDrawer::setFillAndLine(cairo_t *cr, Color fillColor, Color lineColor)
@@ -65,6 +87,10 @@ void CairoDrawer::setFillAndLine(cairo_t *cr, Color fillColor, Color lineColor)
 
 void CairoDrawer::drawLine(const GraphPoint &p1, const GraphPoint &p2, bool dashed)
     {
+    if(!isVisible(GraphRect(p1, p2)))
+        {
+        return;
+        }
     setColor(mLineColor);
     cairo_move_to(cr, p1.x, p1.y);
     cairo_line_to(cr, p2.x, p2.y);
@@ -82,12 +108,19 @@ void CairoDrawer::drawLine(const GraphPoint &p1, const GraphPoint &p2, bool dash
 
 void CairoDrawer::drawCircle(const GraphPoint &p, int radius, Color fillColor)
     {
-    cairo_arc(cr, p.x, p.y, radius, 0, 2 * M_PI);
-    setFillAndLine(cr, fillColor, mLineColor);
+    if(isVisible(GraphRect(p.x-radius, p.y-radius, radius*2, radius*2)))
+        {
+        cairo_arc(cr, p.x, p.y, radius, 0, 2 * M_PI);
+        setFillAndLine(cr, fillColor, mLineColor);
+        }
     }
 
 void CairoDrawer::drawEllipse(const GraphRect &rect)
     {
+    if(!isVisible(rect))
+        {
+        return;
+        }
     cairo_save(cr);
     int halfX = rect.size.x / 2.0;
     int halfY = rect.size.y / 2.0;
@@ -98,9 +131,19 @@ void CairoDrawer::drawEllipse(const GraphRect &rect)
     cairo_stroke(cr);
     }
 
+static GraphRect getPolyRect(const OovPolygon &poly)
+    {
+    GraphRect rect(poly[0], poly[0]);
+    for(auto const &pt : poly)
+        {
+        rect.unionRect(GraphRect(pt, pt));
+        }
+    return rect;
+    }
+
 void CairoDrawer::drawPoly(const OovPolygon &poly, Color fillColor)
     {
-    if(poly.size() > 0)
+    if(poly.size() > 0 && isVisible(getPolyRect(poly)))
         {
         cairo_move_to(cr, poly[0].x, poly[0].y);
         for(size_t i=1; i<poly.size(); i++)
@@ -114,8 +157,20 @@ void CairoDrawer::drawPoly(const OovPolygon &poly, Color fillColor)
 
 void CairoDrawer::drawText(const GraphPoint &p, OovStringRef const text)
     {
-    cairo_move_to(cr, p.x, p.y);
-    cairo_show_text(cr, text);
+    bool visible = true;
+    if(hasVisibleRect())
+        {
+        TextExtent extent = getCairoTextExtent(cr, text);
+        int height = static_cast<int>(extent.height);
+        // The point is at the baseline, so allow room for descenders.
+        visible = isVisible(GraphRect(p.x, p.y - height,
+            static_cast<int>(extent.width), height + height/2));
+        }
+    if(visible)
+        {
+        cairo_move_to(cr, p.x, p.y);
+        cairo_show_text(cr, text);
+        }
     }
 
 void CairoDrawer::groupShapes(bool start, Color lineColor, Color fillColor)
@@ -177,3 +232,103 @@ void CairoDrawer::clearAndSetDefaults()
     cairo_set_source_rgb(cr, 0,0,0);
     cairo_set_line_width(cr, 1.0);
     }
+
+void CairoDrawer::setVisibleRectFromClip()
+    {
+    double x1, y1, x2, y2;
+    cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+    GraphRect clipRect(GraphPoint(floor(x1), floor(y1)),
+        GraphPoint(ceil(x2), ceil(y2)));
+    // Allow for the width of lines at the edges.
+    setVisibleRect(clipRect.getExpanded(2));
+    }
+
+
+DiagramTileListener::~DiagramTileListener()
+    {
+    }
+
+void DiagramTileCache::invalidate()
+    {
+    for(auto &tile : mTiles)
+        {
+        cairo_surface_destroy(tile.second);
+        }
+    mTiles.clear();
+    }
+
+void DiagramTileCache::draw(cairo_t *cr, Diagram &diagram,
+        DiagramTileListener &listener)
+    {
+    double x1, y1, x2, y2;
+    cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+    // The diagrams are never at negative positions.
+    int startCol = std::max(static_cast<int>(x1), 0) / mTileSize;
+    int startRow = std::max(static_cast<int>(y1), 0) / mTileSize;
+    int endCol = std::max(static_cast<int>(ceil(x2)), 0) / mTileSize;
+    int endRow = std::max(static_cast<int>(ceil(y2)), 0) / mTileSize;
+    for(int row=startRow; row<=endRow; row++)
+        {
+        for(int col=startCol; col<=endCol; col++)
+            {
+            GraphPoint tilePos(col, row);
+            GraphRect tileRect(col*mTileSize, row*mTileSize, mTileSize, mTileSize);
+            auto iter = mTiles.find(tilePos);
+            cairo_surface_t *surface;
+            if(iter == mTiles.end())
+                {
+                surface = drawTile(cr, diagram, listener, tileRect);
+                mTiles[tilePos] = surface;
+                }
+            else
+                {
+                surface = iter->second;
+                }
+            cairo_set_source_surface(cr, surface, tileRect.start.x, tileRect.start.y);
+            cairo_rectangle(cr, tileRect.start.x, tileRect.start.y,
+                tileRect.size.x, tileRect.size.y);
+            cairo_fill(cr);
+            }
+        }
+    removeTiles(GraphRect(GraphPoint(startCol, startRow), GraphPoint(endCol, endRow)));
+    }
+
+cairo_surface_t *DiagramTileCache::drawTile(cairo_t *cr, Diagram &diagram,
+        DiagramTileListener &listener, GraphRect const &tileRect)
+    {
+    cairo_surface_t *surface = cairo_surface_create_similar(cairo_get_target(cr),
+        CAIRO_CONTENT_COLOR, tileRect.size.x, tileRect.size.y);
+    cairo_t *tileCr = cairo_create(surface);
+    // Use the same font as the window so that the sizes match.
+    cairo_set_font_face(tileCr, cairo_get_font_face(cr));
+    cairo_matrix_t fontMatrix;
+    cairo_get_font_matrix(cr, &fontMatrix);
+    cairo_set_font_matrix(tileCr, &fontMatrix);
+    cairo_translate(tileCr, -tileRect.start.x, -tileRect.start.y);
+
+    CairoDrawer drawer(diagram, tileCr);
+    drawer.clearAndSetDefaults();
+    drawer.setVisibleRect(tileRect.getExpanded(2));
+    listener.drawTile(drawer);
+    cairo_destroy(tileCr);
+    return surface;
+    }
+
+void DiagramTileCache::removeTiles(GraphRect const &visibleTiles)
+    {
+    if(mTiles.size() > MaxTiles)
+        {
+        for(auto iter = mTiles.begin(); iter != mTiles.end(); )
+            {
+            if(!visibleTiles.isPointIn(iter->first))
+                {
+                cairo_surface_destroy(iter->second);
+                iter = mTiles.erase(iter);
+                }
+            else
+                {
+                ++iter;
+                }
+            }
+        }
+    }
@@ -10,12 +10,17 @@
 
 #include "DiagramDrawer.h"
 #include <gtk/gtk.h>
+#include <map>
 
 
 // This isn't the place for this, but there is no diagram view base class
 // at the moment.
 bool setFontDialog(int &fontSize);
 
+/// Gets the size of the text using the current font of the cairo context.
+/// The TextExtentCache is used so that the same text is only measured once.
+TextExtent getCairoTextExtent(cairo_t *cr, OovStringRef const text);
+
 
 
 /// Defines a basic context for drawing that can be used for screen or
@@ -118,6 +123,10 @@ class CairoDrawer:public NullDrawer
         void setColor(Color c)
             { cairo_set_source_rgb(cr, c.red/255.0, c.green/255.0, c.blue/255.0); }
         void clearAndSetDefaults();
+        /// Sets the visible rect from the clip area of the cairo context.
+        /// When drawing from an expose event, this is the exposed area, so
+        /// shapes that are outside of the scrolled window are not drawn.
+        void setVisibleRectFromClip();
 
     private:
         Color mFillColor;
@@ -127,5 +136,45 @@ class CairoDrawer:public NullDrawer
         void setFillAndLine(cairo_t *cr, Color fillColor, Color lineColor);
     };
 
+class DiagramTileListener
+    {
+    public:
+        virtual ~DiagramTileListener();
+        /// Draw the diagram. The visible rect of the drawer is set to the
+        /// area of the tile.
+        virtual void drawTile(CairoDrawer &drawer) = 0;
+    };
+
+/// Keeps images of the parts (tiles) of a diagram that have been drawn, so
+/// that when the diagram is scrolled, only the newly exposed tiles are drawn.
+/// The tiles must be invalidated whenever anything in the diagram changes.
+class DiagramTileCache
+    {
+    public:
+        DiagramTileCache():
+            mTileSize(DefaultTileSize)
+            {}
+        ~DiagramTileCache()
+            { invalidate(); }
+        void invalidate();
+        /// Draws the tiles that are in the clip area of the cairo context.
+        /// Tiles that have not been drawn yet are drawn by the listener.
+        void draw(cairo_t *cr, Diagram &diagram, DiagramTileListener &listener);
+
+        static const int DefaultTileSize = 256;
+        // This is about 64MB at the default tile size.
+        static const size_t MaxTiles = 256;
+
+    private:
+        // The key is the tile column and row.
+        std::map<GraphPoint, cairo_surface_t*> mTiles;
+        int mTileSize;
+
+        cairo_surface_t *drawTile(cairo_t *cr, Diagram &diagram,
+            DiagramTileListener &listener, GraphRect const &tileRect);
+        /// Removes tiles that are not visible when there are too many tiles.
+        void removeTiles(GraphRect const &visibleTiles);
+    };
+
 
 #endif /* CAIRODRAWER_H_ */
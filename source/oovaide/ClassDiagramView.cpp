@@ -29,6 +29,8 @@ static const ClassDrawOptions &getDrawOptions(GuiOptions const &guiOptions)
     dopts.drawOperParamRelations = guiOptions.getValueBool(OptGuiShowOperParamRelations);
     dopts.drawOperBodyVarRelations = guiOptions.getValueBool(OptGuiShowOperBodyVarRelations);
     dopts.drawRelationKey = guiOptions.getValueBool(OptGuiShowRelationKey);
+    dopts.layeredLayout = guiOptions.getValueBool(OptGuiLayeredLayout);
+    dopts.incrementalLayout = guiOptions.getValueBool(OptGuiIncrementalLayout);
     return dopts;
     }
 
@@ -105,6 +107,7 @@ void ClassDiagramView::drawToDrawingArea()
         setCairoContext();
         CairoDrawer cairoDrawer(mClassDiagram, cr);
         cairoDrawer.clearAndSetDefaults();
+        cairoDrawer.setVisibleRectFromClip();
 
         mClassDiagram.drawDiagram(cairoDrawer);
         updateDrawingAreaSize();
@@ -112,9 +115,9 @@ void ClassDiagramView::drawToDrawingArea()
     requestRedraw();
     }
 
-OovStatusReturn ClassDiagramView::drawSvgDiagram(File &file)
+OovStatusReturn ClassDiagramView::drawSvgDiagram(File &file, bool compress)
     {
-    SvgDrawer svgDrawer(mClassDiagram, file, mCairoContext.getCairo());
+    SvgDrawer svgDrawer(mClassDiagram, file, mCairoContext.getCairo(), compress);
     mClassDiagram.drawDiagram(svgDrawer);
     return svgDrawer.writeFile();
     }
@@ -151,7 +154,12 @@ void ClassDiagramView::displayAddClassDialog()
         {
         getDiagram().addRelatedNodesRecurse(getDiagram().getModelData(),
             dialog.getSelectedType(), dialog.getSelectedAddType());
-        updateGraph(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(relayout)));
+        bool relayoutAll = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(relayout));
+        if(relayoutAll)
+            {
+            getDiagram().clearNodePositions();
+            }
+        updateGraph(relayoutAll);
         }
     }
 
@@ -189,7 +197,7 @@ void ClassDiagramView::displayDrawContextMenu(guint button, guint32 acttime, gpo
         "AddTemplateMenuItem",
         "AddFuncParamsUsingMenuitem", "AddFuncParamUsersMenuitem",
         "AddFuncBodyVarUsingMenuitem", "AddFuncBodyVarUsersMenuitem",
-        "RemoveClassMenuitem", "ViewSourceMenuitem"
+        "RemoveClassMenuitem", "ViewSourceMenuitem", "PinClassMenuitem"
         };
     Builder *builder = Builder::getBuilder();
     for(size_t i=0; i<sizeof(nodeMenus)/sizeof(nodeMenus[i]); i++)
@@ -271,9 +279,21 @@ extern "C" G_MODULE_EXPORT void on_RestartMenuitem_activate(
 extern "C" G_MODULE_EXPORT void on_RelayoutMenuitem_activate(
     GtkWidget * /*widget*/, gpointer /*data*/)
     {
+    gClassDiagramView->getDiagram().clearNodePositions();
     gClassDiagramView->updateGraph(true);
     }
 
+extern "C" G_MODULE_EXPORT void on_PinClassMenuitem_activate(
+    GtkWidget * /*widget*/, gpointer /*data*/)
+    {
+    ClassNode *node = gClassDiagramView->getNode(gStartPosInfo.x, gStartPosInfo.y);
+    if(node)
+        {
+        node->setPinned(!node->isPinned());
+        gClassDiagramView->getDiagram().setModified();
+        }
+    }
+
 void handlePopup(ClassGraph::eAddNodeTypes addType)
     {
     static int depth = 0;
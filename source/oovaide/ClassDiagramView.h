@@ -94,7 +94,7 @@ class ClassDiagramView:public ClassGraphListener
         void buttonPressEvent(const GdkEventButton *event);
         void buttonReleaseEvent(const GdkEventButton *event);
         void drawToDrawingArea();
-        OovStatusReturn drawSvgDiagram(File &file);
+        OovStatusReturn drawSvgDiagram(File &file, bool compress);
         OovStatusReturn saveDiagram(File &file)
             { return mClassDiagram.saveDiagram(file); }
         OovStatusReturn loadDiagram(File &file)
@@ -36,9 +36,9 @@ void ComponentDiagramView::drawToDrawingArea()
     updateDrawingAreaSize();
     }
 
-OovStatusReturn ComponentDiagramView::drawSvgDiagram(File &file)
+OovStatusReturn ComponentDiagramView::drawSvgDiagram(File &file, bool compress)
     {
-    SvgDrawer svgDrawer(mComponentDiagram, file, mCairoContext.getCairo());
+    SvgDrawer svgDrawer(mComponentDiagram, file, mCairoContext.getCairo(), compress);
     mComponentDiagram.drawDiagram(svgDrawer);
     return svgDrawer.writeFile();
     }
@@ -38,7 +38,7 @@ class ComponentDiagramView
             { return mComponentDiagram; }
 
         void drawToDrawingArea();
-        OovStatusReturn drawSvgDiagram(File &file);
+        OovStatusReturn drawSvgDiagram(File &file, bool compress);
         void restart();
         void relayout()
             {
@@ -260,6 +260,7 @@ void Contexts::updateContextAfterAnalysisCompletes()
     {
     mComponentList.updateComponentList();
     mProject.loadAnalysisFiles();
+    mEditorContainer.analysisComplete();
     }
 
 void Contexts::updateContextAfterProjectLoaded()
@@ -80,8 +80,8 @@ class Contexts:public JournalListener, public EditorListener
             }
         OovStatusReturn saveFile(File &drawFile)
             { return mJournal.saveFile(drawFile); }
-        OovStatusReturn exportFile(File &svgFile)
-            { return mJournal.exportFile(svgFile); }
+        OovStatusReturn exportFile(File &svgFile, bool compress)
+            { return mJournal.exportFile(svgFile, compress); }
         void cppArgOptionsChangedUpdateDrawings()
             { mJournal.cppArgOptionsChangedUpdateDrawings(); }
         const JournalRecord *getCurrentJournalRecord() const
@@ -133,6 +133,12 @@ class Contexts:public JournalListener, public EditorListener
             {
             return mClassList.getSelected();
             }
+        /// Returns the path of the file that is selected in the component
+        /// list, or an empty string if no file is selected.
+        std::string getSelectedComponentFile() const
+            {
+            return mComponentList.getSelectedFileName();
+            }
         void clearSelectedComponent()
             {
             mComponentList.clearSelection();
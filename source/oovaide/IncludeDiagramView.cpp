@@ -43,9 +43,9 @@ void IncludeDiagramView::updateDrawingAreaSize()
     gtk_widget_set_size_request(getDiagramWidget(), size.x, size.y);
     }
 
-OovStatusReturn IncludeDiagramView::drawSvgDiagram(File &file)
+OovStatusReturn IncludeDiagramView::drawSvgDiagram(File &file, bool compress)
     {
-    SvgDrawer svgDrawer(mIncludeDiagram, file, mCairoContext.getCairo());
+    SvgDrawer svgDrawer(mIncludeDiagram, file, mCairoContext.getCairo(), compress);
     mIncludeDiagram.drawDiagram(svgDrawer);
     return svgDrawer.writeFile();
     }
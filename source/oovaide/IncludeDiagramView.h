@@ -41,7 +41,7 @@ class IncludeDiagramView
             { return mIncludeDiagram; }
 
         void drawToDrawingArea();
-        OovStatusReturn drawSvgDiagram(File &file);
+        OovStatusReturn drawSvgDiagram(File &file, bool compress);
         void restart();
         void relayout()
             {
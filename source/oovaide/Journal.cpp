@@ -325,13 +325,13 @@ OovStatusReturn Journal::saveFile(File &drawFp)
     return status;
     }
 
-OovStatusReturn Journal::exportFile(File &svgFile)
+OovStatusReturn Journal::exportFile(File &svgFile, bool compress)
     {
     OovStatus status(true, SC_File);
     JournalRecord *rec = getCurrentRecord();
     if(rec)
         {
-        status = rec->exportFile(svgFile);
+        status = rec->exportFile(svgFile, compress);
         }
     return status;
     }
@@ -46,7 +46,8 @@ class JournalRecord
         virtual void cppArgOptionsChangedUpdateDrawings()
             {}
         virtual OovStatusReturn saveFile(File &drawFile) = 0;
-        virtual OovStatusReturn exportFile(File &svgFile) = 0;
+        /// @param compress Set to true to write gzip compressed svg (.svgz).
+        virtual OovStatusReturn exportFile(File &svgFile, bool compress) = 0;
         virtual OovStatusReturn loadFile(File &drawFile) = 0;
         virtual bool isModified() const = 0;
         OovStringRef const getName() const
@@ -104,8 +105,8 @@ class JournalRecordClassDiagram:public JournalRecord, public ClassDiagramListene
             { mClassDiagram.updateGraph(true); }
         virtual OovStatusReturn saveFile(File &drawFile) override
             { return mClassDiagram.saveDiagram(drawFile); }
-        virtual OovStatusReturn exportFile(File &svgFile) override
-            { return mClassDiagram.drawSvgDiagram(svgFile); }
+        virtual OovStatusReturn exportFile(File &svgFile, bool compress) override
+            { return mClassDiagram.drawSvgDiagram(svgFile, compress); }
         virtual OovStatusReturn loadFile(File &drawFile) override
             { return mClassDiagram.loadDiagram(drawFile); }
         virtual bool isModified() const override
@@ -146,8 +147,8 @@ class JournalRecordOperationDiagram:public JournalRecord, public OperationDiagra
             Gui::messageBox("Saving this drawing type is not supported yet, but exporting is.");
             return status;
             }
-        virtual OovStatusReturn exportFile(File &svgFile) override
-            { return mOperationDiagram.drawSvgDiagram(svgFile); }
+        virtual OovStatusReturn exportFile(File &svgFile, bool compress) override
+            { return mOperationDiagram.drawSvgDiagram(svgFile, compress); }
         virtual OovStatusReturn loadFile(File &drawFile) override
             { return OovStatus(false, SC_Logic); }
         virtual bool isModified() const override
@@ -184,8 +185,8 @@ class JournalRecordComponentDiagram:public JournalRecord
             Gui::messageBox("Saving this drawing type is not supported yet, but exporting is.");
             return status;
             }
-        virtual OovStatusReturn exportFile(File &svgFile) override
-            { return mComponentDiagram.drawSvgDiagram(svgFile); }
+        virtual OovStatusReturn exportFile(File &svgFile, bool compress) override
+            { return mComponentDiagram.drawSvgDiagram(svgFile, compress); }
         virtual OovStatusReturn loadFile(File &drawFile) override
             { return OovStatus(false, SC_Logic); }
         // Indicate it is always modified so the single diagram is kept around.
@@ -231,8 +232,8 @@ class JournalRecordZoneDiagram:public JournalRecord, public ZoneDiagramListener
             Gui::messageBox("Saving this drawing type is not supported yet, but exporting is.");
             return status;
             }
-        virtual OovStatusReturn exportFile(File &svgFile) override
-            { return mZoneDiagram.drawSvgDiagram(svgFile); }
+        virtual OovStatusReturn exportFile(File &svgFile, bool compress) override
+            { return mZoneDiagram.drawSvgDiagram(svgFile, compress); }
         virtual OovStatusReturn loadFile(File &drawFile) override
             { return OovStatus(false, SC_Logic); }
         // Indicate it is always modified so the single diagram is kept around.
@@ -265,8 +266,8 @@ class JournalRecordPortionDiagram:public JournalRecord
             { mPortionDiagram.drawToDrawingArea(); }
         virtual OovStatusReturn saveFile(File &drawFile) override
             { return mPortionDiagram.saveDiagram(drawFile); }
-        virtual OovStatusReturn exportFile(File &svgFile) override
-            { return mPortionDiagram.drawSvgDiagram(svgFile); }
+        virtual OovStatusReturn exportFile(File &svgFile, bool compress) override
+            { return mPortionDiagram.drawSvgDiagram(svgFile, compress); }
         virtual OovStatusReturn loadFile(File &drawFile) override
             { return mPortionDiagram.loadDiagram(drawFile); }
         // Indicate it is always modified so the single diagram is kept around.
@@ -305,8 +306,8 @@ class JournalRecordIncludeDiagram:public JournalRecord
             Gui::messageBox("Saving this drawing type is not supported yet, but exporting is.");
             return status;
             }
-        virtual OovStatusReturn exportFile(File &drawFile) override
-            { return mIncludeDiagram.drawSvgDiagram(drawFile); }
+        virtual OovStatusReturn exportFile(File &drawFile, bool compress) override
+            { return mIncludeDiagram.drawSvgDiagram(drawFile, compress); }
         virtual OovStatusReturn loadFile(File &drawFile) override
             { return OovStatus(false, SC_Logic); }
         // Indicate it is always modified so the single diagram is kept around.
@@ -351,7 +352,7 @@ class Journal
         void displayInclude(OovStringRef const incName);
         OovStatusReturn loadFile(File &drawFile);
         OovStatusReturn saveFile(File &drawFile);
-        OovStatusReturn exportFile(File &svgFile);
+        OovStatusReturn exportFile(File &svgFile, bool compress);
         void cppArgOptionsChangedUpdateDrawings();
         void setCurrentRecord(size_t index)
             {
@@ -290,7 +290,7 @@ static OovString makeBuildConfigArgName(OovStringRef const baseName,
     }
 
 bool OovProject::runSrcManager(OovStringRef const buildConfigName,
-        OovStringRef const runStr, eProcessModes pm)
+        OovStringRef const runStr, eProcessModes pm, OovStringVec const &covSrcFiles)
     {
     bool success = true;
     OovString procPath = Project::getBinDirectory();
@@ -323,6 +323,10 @@ bool OovProject::runSrcManager(OovStringRef const buildConfigName,
         case PM_CovStats:
             args.addArg("-mode-cov-stats");
             args.addArg(makeBuildConfigArgName("-cfg", BuildConfigDebug));
+            for(auto const &fn : covSrcFiles)
+                {
+                args.addArg(OovString("-covsrc-") + fn);
+                }
             break;
 
         default:
@@ -109,8 +109,11 @@ class OovProject:public ThreadedWorkBackgroundQueue<OovProject, ProjectBackgroun
         bool loadAnalysisFiles();
 
         /// Returns true if process started.
+        /// @param covSrcFiles The source files relative to the source root
+        ///     that are copied with the hit counts for PM_CovStats.
         bool runSrcManager(OovStringRef const buildConfigName,
-                OovStringRef const runStr, eProcessModes smo);
+                OovStringRef const runStr, eProcessModes smo,
+                OovStringVec const &covSrcFiles);
         void stopSrcManager();
 
         ModelData &getModelData()
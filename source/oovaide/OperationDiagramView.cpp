@@ -24,14 +24,15 @@ void OperationDiagramView::drawToDrawingArea()
     setCairoContext();
     CairoDrawer cairoDrawer(mOperationDiagram, mCairoContext.getCairo());
     cairoDrawer.clearAndSetDefaults();
+    cairoDrawer.setVisibleRectFromClip();
 
     mOperationDiagram.drawDiagram(cairoDrawer);
     updateDrawingAreaSize();
     }
 
-OovStatusReturn OperationDiagramView::drawSvgDiagram(File &file)
+OovStatusReturn OperationDiagramView::drawSvgDiagram(File &file, bool compress)
     {
-    SvgDrawer svgDrawer(mOperationDiagram, file, mCairoContext.getCairo());
+    SvgDrawer svgDrawer(mOperationDiagram, file, mCairoContext.getCairo(), compress);
     mOperationDiagram.drawDiagram(svgDrawer);
     return svgDrawer.writeFile();
     }
@@ -59,7 +59,7 @@ class OperationDiagramView
             { return mOperationDiagram; }
 
         void drawToDrawingArea();
-        OovStatusReturn drawSvgDiagram(File &file);
+        OovStatusReturn drawSvgDiagram(File &file, bool compress);
         void gotoClass(OovStringRef const className);
         void addVarRefs(OperationNode const *node)
             {
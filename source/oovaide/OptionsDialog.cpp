@@ -237,6 +237,18 @@ ScreenOptions::ScreenOptions(OovStringRef const buildConfig, ProjectReader &proj
         OptGuiShowOperBodyVarRelations, "ShowOperBodyVarRelationsCheckbutton")));
     mGuiOptionLookup.push_back(std::unique_ptr<Option>(new CheckOption(
         OptGuiShowRelationKey, "ShowRelationKeyCheckbutton")));
+    mGuiOptionLookup.push_back(std::unique_ptr<Option>(new CheckOption(
+        OptGuiLayeredLayout, "LayeredLayoutCheckbutton")));
+    mGuiOptionLookup.push_back(std::unique_ptr<Option>(new CheckOption(
+        OptGuiIncrementalLayout, "IncrementalLayoutCheckbutton")));
+    mGuiOptionLookup.push_back(std::unique_ptr<Option>(new CheckOption(
+        OptGuiDiagramTileCache, "DiagramTileCacheCheckbutton")));
+
+    // Coverage
+    mProjectOptionLookup.push_back(std::unique_ptr<Option>(new CheckOption(
+        OptCovHitOnce, "CovHitOnceCheckbutton")));
+    mProjectOptionLookup.push_back(std::unique_ptr<Option>(new CheckOption(
+        OptCovProfile, "CovProfileCheckbutton")));
     }
 
 void ScreenOptions::optionsToScreen() const
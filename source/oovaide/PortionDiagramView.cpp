@@ -20,9 +20,9 @@ void PortionDiagramView::drawToDrawingArea()
     updateDrawingAreaSize();
     }
 
-OovStatusReturn PortionDiagramView::drawSvgDiagram(File &file)
+OovStatusReturn PortionDiagramView::drawSvgDiagram(File &file, bool compress)
     {
-    SvgDrawer svgDrawer(mPortionDiagram, file, mCairoContext.getCairo());
+    SvgDrawer svgDrawer(mPortionDiagram, file, mCairoContext.getCairo(), compress);
     mPortionDiagram.drawDiagram(svgDrawer);
     return svgDrawer.writeFile();
     }
@@ -46,7 +46,7 @@ class PortionDiagramView
             }
 
         void drawToDrawingArea();
-        OovStatusReturn drawSvgDiagram(File &file);
+        OovStatusReturn drawSvgDiagram(File &file, bool compress);
         OovStatusReturn saveDiagram(File &file)
             { return mPortionDiagram.saveDiagram(file); }
         OovStatusReturn loadDiagram(File &file)
@@ -7,6 +7,7 @@
 
 
 #include "Svg.h"
+#include "CairoDrawer.h"
 #include "DiagramDrawer.h"
 #include "OovString.h"
 
@@ -21,81 +22,178 @@ Simple SVG example.
 </svg>
 */
 
-static void addArg(std::string &str, OovStringRef const argName, OovStringRef const value)
+#if(USE_ZLIB)
+static const size_t CompressBufSize = 64*1024;
+#endif
+
+SvgOutput::SvgOutput(File &file, bool compress):
+    mFile(file), mCompress(compress), mCompressInitOk(true)
     {
-    str += " ";
-    str += argName;
-    str += "=\"";
-    str += value;
-    str += "\"";
+    if(mCompress)
+        {
+#if(USE_ZLIB)
+        mZStream.zalloc = Z_NULL;
+        mZStream.zfree = Z_NULL;
+        mZStream.opaque = Z_NULL;
+        // Adding 16 to the window bits writes a gzip header instead of zlib.
+        mCompressInitOk = (deflateInit2(&mZStream, Z_DEFAULT_COMPRESSION,
+            Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+        mCompressBuf.resize(CompressBufSize);
+#else
+        // Without zlib, a compressed file cannot be written.
+        mCompressInitOk = false;
+#endif
+        }
     }
 
-static void translateText(OovStringRef const text, std::string &str)
+SvgOutput::~SvgOutput()
     {
-    str = StringMakeXml(text);
+#if(USE_ZLIB)
+    if(mCompress && mCompressInitOk)
+        {
+        deflateEnd(&mZStream);
+        }
+#endif
     }
 
-OovStatusReturn SvgDrawer::writeFile()
+OovStatusReturn SvgOutput::write(char const *buf, size_t size)
     {
-    if(mSuccess.ok())
+    OovStatus status(true, SC_File);
+    // Plain text is not written to a file that should be compressed.
+    if(!mCompressInitOk)
         {
-        mSuccess = mFile.putString("</svg>");
+        status.set(false, SC_File);
         }
-    return mSuccess;
+#if(USE_ZLIB)
+    else if(mCompress)
+        {
+        mZStream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(buf));
+        mZStream.avail_in = static_cast<uInt>(size);
+        status = compress(Z_NO_FLUSH);
+        }
+#endif
+    else
+        {
+        status = mFile.write(buf, static_cast<int>(size));
+        }
+    return status;
     }
 
-void SvgDrawer::setDiagramSize(GraphSize size)
+OovStatusReturn SvgOutput::finish()
     {
-    mDrawingSize = size;
-    mOutputHeader = true;
+    OovStatus status(true, SC_File);
+    if(!mCompressInitOk)
+        {
+        status.set(false, SC_File);
+        }
+#if(USE_ZLIB)
+    else if(mCompress)
+        {
+        mZStream.next_in = Z_NULL;
+        mZStream.avail_in = 0;
+        status = compress(Z_FINISH);
+        }
+#endif
+    return status;
     }
 
-void SvgDrawer::setCurrentDrawingFontSize(double size)
+#if(USE_ZLIB)
+OovStatusReturn SvgOutput::compress(int flush)
     {
-    mOutputHeader = true;
-    DiagramDrawer::setCurrentDrawingFontSize(size);
+    OovStatus status(true, SC_File);
+    // Keep compressing while the output buffer gets filled, since the
+    // input may not be used up yet.
+    do
+        {
+        mZStream.next_out = reinterpret_cast<Bytef*>(&mCompressBuf[0]);
+        mZStream.avail_out = static_cast<uInt>(mCompressBuf.size());
+        int ret = deflate(&mZStream, flush);
+        if(ret == Z_STREAM_ERROR)
+            {
+            status.set(false, SC_File);
+            }
+        size_t outSize = mCompressBuf.size() - mZStream.avail_out;
+        if(status.ok() && outSize > 0)
+            {
+            status = mFile.write(&mCompressBuf[0], static_cast<int>(outSize));
+            }
+        } while(status.ok() && mZStream.avail_out == 0);
+    return status;
     }
+#endif
+
 
-static void appendColorInt(OovString &str, int rgbColor)
+void SvgDrawer::appendArg(char const *argName, char const *argVal)
     {
-    str.appendInt(rgbColor, 16, 0, 6);
+    mBuf += ' ';
+    mBuf += argName;
+    mBuf += "=\"";
+    mBuf += argVal;
+    mBuf += '\"';
     }
 
-static void outArg(OovStringRef argName, OovStringRef argVal, OovString &outStr)
+void SvgDrawer::appendArgInt(char const *argName, int argVal)
     {
-    outStr += ' ';
-    outStr += argName;
-    outStr += "=\"";
-    outStr += argVal;
-    outStr += '\"';
+    mBuf += ' ';
+    mBuf += argName;
+    mBuf += "=\"";
+    mBuf.appendInt(argVal);
+    mBuf += '\"';
     }
 
-static void outArgInt(OovStringRef argName, int argVal, OovString &outStr)
+void SvgDrawer::appendXmlText(char const *text)
     {
-    OovString argValStr;
-    argValStr.appendInt(argVal);
-    outArg(argName, argValStr, outStr);
+    for(char const *p = text; *p; p++)
+        {
+        switch(*p)
+            {
+            case '>':   mBuf += "&gt;";         break;
+            case '<':   mBuf += "&lt;";         break;
+            case '&':   mBuf += "&amp;";        break;
+            case '\'':  mBuf += "&apos;";       break;
+            case '\"':  mBuf += "&quot;";       break;
+            default:    mBuf += *p;             break;
+            }
+        }
     }
 
-static void outArgFloat(OovStringRef argName, double argVal, int precision, OovString &outStr)
+void SvgDrawer::flushBuffer(bool force)
     {
-    OovString argValStr;
-    argValStr.appendFloat(argVal, precision);
-    outArg(argName, argValStr, outStr);
+    if(mBuf.length() > 0 && (force || mBuf.length() >= FlushSize))
+        {
+        if(mSuccess.ok())
+            {
+            mSuccess = mOutput.write(mBuf.getStr(), mBuf.length());
+            }
+        // This keeps the reserved memory.
+        mBuf.clear();
+        }
     }
 
-static void outArg4Int(OovStringRef argName, int argVal1, int argVal2,
-    int argVal3, int argVal4, OovString &outStr)
+OovStatusReturn SvgDrawer::writeFile()
     {
-    OovString argValStr;
-    argValStr.appendInt(argVal1);
-    argValStr += " ";
-    argValStr.appendInt(argVal2);
-    argValStr += " ";
-    argValStr.appendInt(argVal3);
-    argValStr += " ";
-    argValStr.appendInt(argVal4);
-    outArg(argName, argValStr, outStr);
+    if(mSuccess.ok())
+        {
+        mBuf += "</svg>";
+        flushBuffer(true);
+        }
+    if(mSuccess.ok())
+        {
+        mSuccess = mOutput.finish();
+        }
+    return mSuccess;
+    }
+
+void SvgDrawer::setDiagramSize(GraphSize size)
+    {
+    mDrawingSize = size;
+    mOutputHeader = true;
+    }
+
+void SvgDrawer::setCurrentDrawingFontSize(double size)
+    {
+    mOutputHeader = true;
+    DiagramDrawer::setCurrentDrawingFontSize(size);
     }
 
 void SvgDrawer::maybeOutputHeader()
@@ -103,14 +201,19 @@ void SvgDrawer::maybeOutputHeader()
     if(mOutputHeader && mSuccess.ok())
         {
         const char *fontFamily = "Arial, Helvetica, sans-serif";
-        OovString str = "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\"\n";
-        outArg("font-family", fontFamily, str);
-        outArgFloat("font-size", getCurrentDrawingFontSize(), 2, str);
-        outArgInt("width", mDrawingSize.x, str);
-        outArgInt("height", mDrawingSize.y, str);
-        outArg4Int("viewbox", 0, 0, mDrawingSize.x, mDrawingSize.y, str);
-        str += ">\n";
-        mSuccess = mFile.putString(str);
+        mBuf += "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\"\n";
+        appendArg("font-family", fontFamily);
+        mBuf += " font-size=\"";
+        mBuf.appendFloat(getCurrentDrawingFontSize(), 2);
+        mBuf += '\"';
+        appendArgInt("width", mDrawingSize.x);
+        appendArgInt("height", mDrawingSize.y);
+        mBuf += " viewbox=\"0 0 ";
+        mBuf.appendInt(mDrawingSize.x);
+        mBuf += ' ';
+        mBuf.appendInt(mDrawingSize.y);
+        mBuf += "\">\n";
+        flushBuffer();
         mOutputHeader = false;
         }
     }
@@ -120,13 +223,13 @@ void SvgDrawer::drawRect(const GraphRect &rect)
     maybeOutputHeader();
     if(mSuccess.ok())
         {
-        OovString str = "<rect";
-        outArgInt("x", rect.start.x, str);
-        outArgInt("y", rect.start.y, str);
-        outArgInt("width", rect.size.x, str);
-        outArgInt("height", rect.size.y, str);
-        str += " />\n";
-        mSuccess = mFile.putString(str);
+        mBuf += "<rect";
+        appendArgInt("x", rect.start.x);
+        appendArgInt("y", rect.start.y);
+        appendArgInt("width", rect.size.x);
+        appendArgInt("height", rect.size.y);
+        mBuf += " />\n";
+        flushBuffer();
         }
     }
 
@@ -135,17 +238,17 @@ void SvgDrawer::drawLine(const GraphPoint &p1, const GraphPoint &p2, bool dashed
     maybeOutputHeader();
     if(mSuccess.ok())
         {
-        OovString str = "<line";
-        outArgInt("x1", p1.x, str);
-        outArgInt("y1", p1.y, str);
-        outArgInt("x2", p2.x, str);
-        outArgInt("y2", p2.y, str);
+        mBuf += "<line";
+        appendArgInt("x1", p1.x);
+        appendArgInt("y1", p1.y);
+        appendArgInt("x2", p2.x);
+        appendArgInt("y2", p2.y);
         if(dashed)
             {
-            str += " style=\"stroke-dasharray: 4, 4 \"";
+            mBuf += " style=\"stroke-dasharray: 4, 4 \"";
             }
-        str += " />\n";
-        mSuccess = mFile.putString(str);
+        mBuf += " />\n";
+        flushBuffer();
         }
     }
 
@@ -154,18 +257,15 @@ void SvgDrawer::drawCircle(const GraphPoint &p, int radius, Color fillColor)
     maybeOutputHeader();
     if(mSuccess.ok())
         {
-        OovString str = "<circle";
-        outArgInt("cx", p.x, str);
-        outArgInt("cy", p.y, str);
-        outArgInt("r", radius, str);
-
-        OovString style = " style=\"fill:#";
-        appendColorInt(style, fillColor.getRGB());
-        style += '\"';
-
-        str += style;
-        str += " />\n";
-        mSuccess = mFile.putString(str);
+        mBuf += "<circle";
+        appendArgInt("cx", p.x);
+        appendArgInt("cy", p.y);
+        appendArgInt("r", radius);
+        mBuf += " style=\"fill:#";
+        mBuf.appendInt(fillColor.getRGB(), 16, 0, 6);
+        mBuf += '\"';
+        mBuf += " />\n";
+        flushBuffer();
         }
     }
 
@@ -176,39 +276,34 @@ void SvgDrawer::drawEllipse(const GraphRect &rect)
     maybeOutputHeader();
     if(mSuccess.ok())
         {
-        OovString str = "<ellipse";
-        outArgInt("cx", rect.start.x+halfX, str);
-        outArgInt("cy", rect.start.y+halfY, str);
-        outArgInt("rx", halfX, str);
-        outArgInt("ry", halfY, str);
-        str += " />\n";
-        mSuccess = mFile.putString(str);
+        mBuf += "<ellipse";
+        appendArgInt("cx", rect.start.x+halfX);
+        appendArgInt("cy", rect.start.y+halfY);
+        appendArgInt("rx", halfX);
+        appendArgInt("ry", halfY);
+        mBuf += " />\n";
+        flushBuffer();
         }
     }
 
 void SvgDrawer::drawPoly(const OovPolygon &poly, Color fillColor)
     {
-    std::string pointsStr;
-    for(size_t i=0; i<poly.size(); i++)
-        {
-        char str[10];
-        snprintf(str, sizeof(str), "%d,", poly[i].x);
-        pointsStr += str;
-        snprintf(str, sizeof(str), "%d ", poly[i].y);
-        pointsStr += str;
-        }
     maybeOutputHeader();
     if(mSuccess.ok())
         {
-        OovString str = "<polygon";
-        outArg("points", pointsStr, str);
-
-        OovString styleArg = "fill:#";
-        appendColorInt(styleArg, fillColor.getRGB());
-        addArg(str, "style", styleArg);
-
-        str += " />\n";
-        mSuccess = mFile.putString(str);
+        mBuf += "<polygon points=\"";
+        for(size_t i=0; i<poly.size(); i++)
+            {
+            mBuf.appendInt(poly[i].x);
+            mBuf += ',';
+            mBuf.appendInt(poly[i].y);
+            mBuf += ' ';
+            }
+        mBuf += "\" style=\"fill:#";
+        mBuf.appendInt(fillColor.getRGB(), 16, 0, 6);
+        mBuf += '\"';
+        mBuf += " />\n";
+        flushBuffer();
         }
     }
 
@@ -219,23 +314,19 @@ void SvgDrawer::groupShapes(bool start, Color lineColor, Color fillColor)
         {
         if(start)
             {
-            std::string argStr;
-            char temp[40];
-            snprintf(temp, sizeof(temp), "#%06x", fillColor.getRGB());
-            addArg(argStr, "fill", temp);
-            snprintf(temp, sizeof(temp), "#%06x", lineColor.getRGB());
-            addArg(argStr, "stroke", temp);
-            addArg(argStr, "style", "stroke-width:1");
-
-            OovString str = "<g ";
-            str += argStr;
-            str += ">\n";
-            mSuccess = mFile.putString(str);
+            mBuf += "<g fill=\"#";
+            mBuf.appendInt(fillColor.getRGB(), 16, 0, 6);
+            mBuf += "\" stroke=\"#";
+            mBuf.appendInt(lineColor.getRGB(), 16, 0, 6);
+            mBuf += '\"';
+            appendArg("style", "stroke-width:1");
+            mBuf += ">\n";
             }
         else
             {
-            mSuccess = mFile.putString("</g>\n");
+            mBuf += "</g>\n";
             }
+        flushBuffer();
         }
     }
 
@@ -247,18 +338,18 @@ void SvgDrawer::groupText(bool start, bool italic)
         if(start)
             {
             // stroke none means no outline, only fill
-            OovString str = "<g stroke=\"none\"";
+            mBuf += "<g stroke=\"none\"";
             if(italic)
                 {
-                str += " font-style=\"italic\"";
+                mBuf += " font-style=\"italic\"";
                 }
-            str += ">\n";
-            mSuccess = mFile.putString(str);
+            mBuf += ">\n";
             }
         else
             {
-            mSuccess = mFile.putString("</g>\n");
+            mBuf += "</g>\n";
             }
+        flushBuffer();
         }
     }
 
@@ -267,30 +358,22 @@ void SvgDrawer::drawText(const GraphPoint &p, OovStringRef const text)
     maybeOutputHeader();
     if(mSuccess.ok())
         {
-        std::string textStr;
-        translateText(text, textStr);
-
-        OovString str = "<text";
-        outArgInt("x", p.x, str);
-        outArgInt("y", p.y, str);
-        str += '>';
-        str += textStr;
-        str += "</text>\n";
-        mSuccess = mFile.putString(str);
+        mBuf += "<text";
+        appendArgInt("x", p.x);
+        appendArgInt("y", p.y);
+        mBuf += '>';
+        appendXmlText(text);
+        mBuf += "</text>\n";
+        flushBuffer();
         }
     }
 
 float SvgDrawer::getTextExtentWidth(OovStringRef const name) const
     {
-    cairo_text_extents_t extents;
-    cairo_text_extents(cr, name, &extents);
-    return extents.width;
+    return getCairoTextExtent(cr, name).width;
     }
 
 float SvgDrawer::getTextExtentHeight(OovStringRef const name) const
     {
-    cairo_text_extents_t extents;
-    cairo_text_extents(cr, name, &extents);
-    return extents.height;
+    return getCairoTextExtent(cr, name).height;
     }
-
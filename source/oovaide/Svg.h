@@ -9,16 +9,49 @@
 #include "File.h"
 #include "OovError.h"
 #include <stdio.h>
+#include <vector>
 #include <cairo.h>
+#if(USE_ZLIB)
+#include <zlib.h>
+#endif
+
+/// Writes the SVG text to a file. The text can be compressed in gzip
+/// format for .svgz files when built with zlib (USE_ZLIB).
+class SvgOutput
+    {
+    public:
+        SvgOutput(File &file, bool compress);
+        ~SvgOutput();
+        OovStatusReturn write(char const *buf, size_t size);
+        /// This must be called after all writes to write any remaining
+        /// compressed data.
+        OovStatusReturn finish();
+
+    private:
+        File &mFile;
+        bool mCompress;
+        /// This is false if the compression could not be started.
+        bool mCompressInitOk;
+#if(USE_ZLIB)
+        z_stream mZStream;
+        std::vector<char> mCompressBuf;
+
+        OovStatusReturn compress(int flush);
+#endif
+    };
 
 /// Defines functions to write to an SVG file.
+/// The elements are formatted into a single reused buffer, and the buffer is
+/// written to the file in large blocks, so that exporting huge diagrams does
+/// not allocate memory for each element.
 class SvgDrawer:public DiagramDrawer
     {
     public:
-        SvgDrawer(Diagram &diagram, File &file, cairo_t *c):
-            DiagramDrawer(diagram), mFile(file), mSuccess(true, SC_File),
-            cr(c), mOutputHeader(true)
-            {}
+        /// @param compress Set to true to write gzip format (.svgz).
+        SvgDrawer(Diagram &diagram, File &file, cairo_t *c, bool compress):
+            DiagramDrawer(diagram), mOutput(file, compress),
+            mSuccess(true, SC_File), cr(c), mOutputHeader(true)
+            { mBuf.reserve(FlushSize * 2); }
         /// This finishes up writing the file, and indicates if any errors
         /// occurred during writing.
         OovStatusReturn writeFile();
@@ -42,11 +75,18 @@ class SvgDrawer:public DiagramDrawer
         virtual float getTextExtentHeight(OovStringRef const name) const override;
 
     private:
-        File &mFile;
+        SvgOutput mOutput;
         OovStatus mSuccess;
         cairo_t *cr;
         GraphSize mDrawingSize;
         bool mOutputHeader;
+        OovString mBuf;
+        static const size_t FlushSize = 64*1024;
 
         void maybeOutputHeader();
+        void appendArg(char const *argName, char const *argVal);
+        void appendArgInt(char const *argName, int argVal);
+        void appendXmlText(char const *text);
+        /// Writes the buffer to the file if it is large, or if forced.
+        void flushBuffer(bool force=false);
     };
@@ -129,16 +129,25 @@ ZoneDiagramListener::~ZoneDiagramListener()
 void ZoneDiagramView::drawToDrawingArea()
     {
     setCairoContext();
-    CairoDrawer cairoDrawer(mZoneDiagram, mCairoContext.getCairo());
-    cairoDrawer.clearAndSetDefaults();
-
-    mZoneDiagram.drawDiagram(cairoDrawer);
+    if(mGuiOptions.getValueBool(OptGuiDiagramTileCache))
+        {
+        mTileCache.draw(mCairoContext.getCairo(), mZoneDiagram, *this);
+        }
+    else
+        {
+        // The diagram could be changed while the cache is not used.
+        mTileCache.invalidate();
+        CairoDrawer cairoDrawer(mZoneDiagram, mCairoContext.getCairo());
+        cairoDrawer.clearAndSetDefaults();
+        cairoDrawer.setVisibleRectFromClip();
+        mZoneDiagram.drawDiagram(cairoDrawer);
+        }
     updateDrawingAreaSize();
     }
 
-OovStatusReturn ZoneDiagramView::drawSvgDiagram(File &file)
+OovStatusReturn ZoneDiagramView::drawSvgDiagram(File &file, bool compress)
     {
-    SvgDrawer svgDrawer(mZoneDiagram, file, mCairoContext.getCairo());
+    SvgDrawer svgDrawer(mZoneDiagram, file, mCairoContext.getCairo(), compress);
     mZoneDiagram.drawDiagram(svgDrawer);
     return svgDrawer.writeFile();
     }
@@ -68,7 +68,7 @@ class ZoneDiagramList
     };
 
 
-class ZoneDiagramView
+class ZoneDiagramView:public DiagramTileListener
     {
     public:
         ZoneDiagramView(GuiOptions const &guiOptions):
@@ -103,7 +103,7 @@ class ZoneDiagramView
             { return mZoneDiagram.getDrawOptions(); }
 
         void drawToDrawingArea();
-        OovStatusReturn drawSvgDiagram(File &file);
+        OovStatusReturn drawSvgDiagram(File &file, bool compress);
 
         void gotoClass(OovStringRef const className);
         void showChildComponents(bool show);
@@ -115,6 +115,7 @@ class ZoneDiagramView
         void updateGraphAndRequestRedraw()
             {
             mZoneDiagram.updateGraph(mNullDrawer);
+            mTileCache.invalidate();
             gtk_widget_queue_draw(getDiagramWidget());
             }
         void handleDrawingAreaLostPointer()
@@ -125,6 +126,7 @@ class ZoneDiagramView
             {
             mZoneDiagram.setDiagramBaseAndGlobalFontSize(size);
             mNullDrawer.setCurrentDrawingFontSize(size);
+            mTileCache.invalidate();
             }
         int getFontSize()
             { return mZoneDiagram.getDiagramBaseFontSize(); }
@@ -137,6 +139,11 @@ class ZoneDiagramView
         GtkCairoContext mCairoContext;
         NullDrawer mNullDrawer;
         ZoneClassInfoToolTipWindow mToolTipWindow;
+        // Large zone diagrams are slow to draw, so scrolling only draws the
+        // newly exposed parts of the diagram.
+        DiagramTileCache mTileCache;
+        virtual void drawTile(CairoDrawer &drawer) override
+            { mZoneDiagram.drawDiagram(drawer); }
         void setCairoContext()
             {
             mCairoContext.setContext(getDiagramWidget());
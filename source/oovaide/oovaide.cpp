@@ -477,8 +477,17 @@ void oovGui::runSrcManager(OovStringRef const buildConfigName,
         }
     if(str)
         {
+        // The file that is selected in the component list is copied with
+        // the coverage counts.
+        OovStringVec covSrcFiles;
+        std::string selectedFn = mContexts.getSelectedComponentFile();
+        if(smo == PM_CovStats && selectedFn.length() > 0)
+            {
+            covSrcFiles.push_back(Project::getSrcRootDirRelativeSrcFileName(
+                selectedFn));
+            }
         mWindowBuildListener.onStdOut(str, std::string(str).length());
-        mProject.runSrcManager(buildConfigName, str, smo);
+        mProject.runSrcManager(buildConfigName, str, smo, covSrcFiles);
         }
     updateMenuEnables(mProject.getProjectStatus());
     }
@@ -794,12 +803,12 @@ void oovGui::openProject()
 class DrawingFile:public File
     {
     public:
-        DrawingFile(OovStringRef fn, bool write)
+        DrawingFile(OovStringRef fn, bool write, bool binary=false)
             {
             FilePath fileName(fn, FP_File);
             if(write)
                 {
-                OovStatus status = open(fileName, "w");
+                OovStatus status = open(fileName, binary ? "wb" : "w");
                 if(status.needReport())
                     {
                     status.report(ET_Error, "Unable to save drawing");
@@ -892,15 +901,18 @@ void oovGui::exportDrawingAs()
     PathChooser ch;
     FilePath fn(getDiagramName("svg"), FP_File);
     ch.setDefaultPath(fn);
-    if(ch.ChoosePath(Gui::getMainWindow(), "Export Drawing (.SVG)",
+    if(ch.ChoosePath(Gui::getMainWindow(), "Export Drawing (.SVG, .SVGZ)",
             GTK_FILE_CHOOSER_ACTION_SAVE, fn))
         {
         if(!fn.hasExtension())
             {
             fn.appendExtension("svg");
             }
-        DrawingFile svg(fn, true);
-        OovStatus status = exportFile(svg);
+        // The svgz extension is gzip compressed svg.
+        bool compress = (StringCompareNoCase(fn.getExtension().getStr(),
+            ".svgz") == 0);
+        DrawingFile svg(fn, true, compress);
+        OovStatus status = exportFile(svg, compress);
         if(!status.ok())
             {
             status.reported();
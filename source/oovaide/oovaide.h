@@ -177,8 +177,8 @@ class oovGui:public OovErrorListener, private GlobalSettingsListener
             { return mContexts.loadFile(drawFile); }
         OovStatusReturn saveFile(File &drawFile)
             { return mContexts.saveFile(drawFile); }
-        OovStatusReturn exportFile(File &svgFile)
-            { return mContexts.exportFile(svgFile); }
+        OovStatusReturn exportFile(File &svgFile, bool compress)
+            { return mContexts.exportFile(svgFile, compress); }
         std::string getDiagramName(OovStringRef ext) const;
         void setDiagramName(OovStringRef name);
         ProjectStatus const &getLastProjectStatus() const
@@ -0,0 +1,95 @@
+/*
+ * CovOverheadBench.cpp
+ *
+ *  \copyright 2015 DCBlaha.  Distributed under the GPL.
+ */
+
+// Runs the sample program without coverage, and then in each coverage runtime
+// mode, and shows how much slower each mode is. The instrumented programs
+// must print the same result as the program without coverage.
+//
+// The arguments are pairs of a mode name and a program. The first pair is
+// the program without coverage. The test fails if a mode is slower than the
+// budget.
+
+#include "PerfBench.h"
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+// Each program is run this many times, and the fastest time is used.
+static const int NumRuns = 3;
+// The most that the instrumented programs can be slower than the program
+// without coverage.
+static const double BudgetRatio = 3.0;
+
+// Returns false if the program could not be run.
+static bool runProgram(PerfBench &bench, char const *program, double &seconds,
+        std::string &output)
+    {
+    bool success = true;
+    seconds = 0;
+    for(int i=0; i<NumRuns && success; i++)
+        {
+        output.clear();
+        bench.start();
+        FILE *fp = popen(program, "r");
+        success = (fp != nullptr);
+        if(success)
+            {
+            char buf[200];
+            while(fgets(buf, sizeof(buf), fp))
+                {
+                output += buf;
+                }
+            success = (pclose(fp) == 0);
+            }
+        double runTime = bench.getSeconds();
+        if(i == 0 || runTime < seconds)
+            {
+            seconds = runTime;
+            }
+        }
+    return success;
+    }
+
+int main(int argc, char const * const argv[])
+    {
+    PerfBench bench;
+    bool success = (argc >= 5 && (argc-1) % 2 == 0);
+    if(!success)
+        {
+        bench.fail(argv[0], "args are: baseName baseProgram modeName modeProgram...");
+        }
+    double baseSeconds = 0;
+    std::string baseOutput;
+    for(int argI=1; argI+1<argc && success; argI+=2)
+        {
+        double seconds;
+        std::string output;
+        success = runProgram(bench, argv[argI+1], seconds, output);
+        if(success && argI == 1)
+            {
+            baseSeconds = seconds;
+            baseOutput = output;
+            }
+        else if(success)
+            {
+            success = (output == baseOutput);
+            }
+        if(success)
+            {
+            bench.checkRatio(argv[argI], seconds, baseSeconds, BudgetRatio);
+            }
+        else
+            {
+            bench.fail(argv[argI], "failed or gave a different result");
+            }
+        }
+    return bench.getExitCode();
+    }
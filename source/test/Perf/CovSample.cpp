@@ -0,0 +1,69 @@
+/*
+ * CovSample.cpp
+ *
+ *  \copyright 2015 DCBlaha.  Distributed under the GPL.
+ */
+
+// A multithreaded program that is instrumented by oovCovInstr to measure the
+// overhead of the coverage counters. All threads run the same functions, so
+// they all update the same counters. Most probes are decision outcomes.
+
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+static const int NumThreads = 8;
+static const unsigned int NumIterations = 10000000;
+
+static unsigned int step(unsigned int val)
+    {
+    unsigned int next = val * 1103515245 + 12345;
+    if(next & 1)
+        {
+        next ^= next >> 7;
+        }
+    switch(next >> 30)
+        {
+        case 0:
+            next += 3;
+            break;
+
+        case 1:
+            next ^= 0x5555;
+            break;
+
+        default:
+            break;
+        }
+    return next;
+    }
+
+static void work(unsigned int seed, unsigned int *result)
+    {
+    unsigned int val = seed;
+    unsigned int sum = 0;
+    for(unsigned int i=0; i<NumIterations; i++)
+        {
+        val = step(val);
+        sum += val >> 16;
+        }
+    *result = sum;
+    }
+
+int main()
+    {
+    std::vector<unsigned int> results(NumThreads);
+    std::vector<std::thread> threads;
+    for(int i=0; i<NumThreads; i++)
+        {
+        threads.push_back(std::thread(work, i + 1, &results[i]));
+        }
+    unsigned int total = 0;
+    for(int i=0; i<NumThreads; i++)
+        {
+        threads[i].join();
+        total += results[i];
+        }
+    printf("%u\n", total);
+    return 0;
+    }
@@ -0,0 +1,36 @@
+/*
+ * PerfBench.cpp
+ *
+ *  \copyright 2015 DCBlaha.  Distributed under the GPL.
+ */
+
+#include "PerfBench.h"
+#include <stdio.h>
+
+
+void PerfBench::checkTime(char const *name, double seconds, double budgetSeconds)
+    {
+    printf("%-20s %8.3f s  (budget %.3f s)\n", name, seconds, budgetSeconds);
+    if(seconds > budgetSeconds)
+        {
+        fail(name, "is over the budget");
+        }
+    }
+
+void PerfBench::checkRatio(char const *name, double seconds, double baseSeconds,
+        double budgetRatio)
+    {
+    double ratio = seconds / baseSeconds;
+    printf("%-20s %8.3f s  %6.2fx  (budget %.2fx)\n", name, seconds, ratio,
+        budgetRatio);
+    if(ratio > budgetRatio)
+        {
+        fail(name, "is over the budget");
+        }
+    }
+
+void PerfBench::fail(char const *name, char const *error)
+    {
+    fprintf(stderr, "%s %s\n", name, error);
+    mPassed = false;
+    }
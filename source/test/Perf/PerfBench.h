@@ -0,0 +1,48 @@
+/*
+ * PerfBench.h
+ *
+ *  \copyright 2015 DCBlaha.  Distributed under the GPL.
+ */
+
+#ifndef PERFBENCH_H_
+#define PERFBENCH_H_
+
+#include <chrono>
+
+/// This is the timing and reporting that is shared by the benchmarks. Each
+/// measurement is printed with its budget, and the benchmark fails its test
+/// if any measurement is over its budget.
+class PerfBench
+    {
+    public:
+        PerfBench():
+            mPassed(true)
+            {}
+        /// Restarts the timer.
+        void start()
+            { mStartTime = std::chrono::steady_clock::now(); }
+        /// Returns the seconds since start was called.
+        double getSeconds() const
+            {
+            return std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - mStartTime).count();
+            }
+        /// Prints the time, and fails the benchmark if the time is over the
+        /// budget.
+        void checkTime(char const *name, double seconds, double budgetSeconds);
+        /// Prints the time and how many times slower it is than the base
+        /// time, and fails the benchmark if that is over the budget ratio.
+        void checkRatio(char const *name, double seconds, double baseSeconds,
+            double budgetRatio);
+        /// Prints the error and fails the benchmark.
+        void fail(char const *name, char const *error);
+        /// Returns the exit code of the benchmark program.
+        int getExitCode() const
+            { return(mPassed ? 0 : 1); }
+
+    private:
+        std::chrono::steady_clock::time_point mStartTime;
+        bool mPassed;
+    };
+
+#endif /* PERFBENCH_H_ */
@@ -0,0 +1,104 @@
+/*
+ * SvgExportBench.cpp
+ *
+ *  \copyright 2015 DCBlaha.  Distributed under the GPL.
+ */
+
+// Exports a diagram with 20000 elements to .svg and to .svgz, and checks
+// that the export time is within the budget and that the uncompressed
+// .svgz matches the .svg file.
+
+#include "Svg.h"
+#include "PerfBench.h"
+#include <string>
+#include <stdio.h>
+
+static const int NumNodes = 5000;       // Each node makes four elements.
+static const double BudgetSeconds = 2.0;
+
+static bool exportDiagram(char const *fn, bool compress)
+    {
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+    cairo_t *cr = cairo_create(surface);
+    Diagram diagram;
+    File file;
+    OovStatus status = file.open(fn, "wb");
+    if(status.ok())
+        {
+        SvgDrawer drawer(diagram, file, cr, compress);
+        drawer.setDiagramSize(GraphSize(NumNodes * 10, 2000));
+        for(int i=0; i<NumNodes; i++)
+            {
+            GraphRect rect(i * 10, (i % 100) * 20, 80, 16);
+            OovString name = "Class<std::string&>";
+            name.appendInt(i);
+            drawer.drawRect(rect);
+            drawer.drawText(GraphPoint(rect.start.x + 2, rect.endy() - 2), name);
+            drawer.drawLine(rect.getCenter(), GraphPoint(rect.start.x, 0), i % 2);
+            OovPolygon arrow;
+            arrow.push_back(GraphPoint(rect.start.x, rect.start.y));
+            arrow.push_back(GraphPoint(rect.start.x + 5, rect.start.y - 8));
+            arrow.push_back(GraphPoint(rect.start.x - 5, rect.start.y - 8));
+            drawer.drawPoly(arrow, Color(255, 255, 255));
+            }
+        status = drawer.writeFile();
+        }
+    file.close();
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+    if(!status.ok())
+        {
+        status.reported();
+        }
+    return status.ok();
+    }
+
+static void timeExport(PerfBench &bench, char const *fn, bool compress)
+    {
+    bench.start();
+    if(exportDiagram(fn, compress))
+        {
+        bench.checkTime(fn, bench.getSeconds(), BudgetSeconds);
+        }
+    else
+        {
+        bench.fail(fn, "could not be exported");
+        }
+    }
+
+// Reading with zlib also reads the uncompressed file as is.
+static bool readFile(char const *fn, std::string &str)
+    {
+    gzFile fp = gzopen(fn, "rb");
+    if(fp)
+        {
+        char buf[64*1024];
+        int size;
+        while((size = gzread(fp, buf, sizeof(buf))) > 0)
+            {
+            str.append(buf, size);
+            }
+        gzclose(fp);
+        }
+    return(fp != nullptr);
+    }
+
+int main()
+    {
+    PerfBench bench;
+    printf("SVG export of %d elements\n", NumNodes * 4);
+    timeExport(bench, "SvgExportBench.svg", false);
+    timeExport(bench, "SvgExportBench.svgz", true);
+    std::string svgText;
+    std::string svgzText;
+    bool match = readFile("SvgExportBench.svg", svgText) &&
+        readFile("SvgExportBench.svgz", svgzText) &&
+        svgText.length() > 0 && svgText == svgzText;
+    printf("SVG size: %zu bytes, compressed data matches: %s\n",
+        svgText.length(), match ? "yes" : "no");
+    if(!match)
+        {
+        bench.fail("SvgExportBench.svgz", "does not match the .svg file");
+        }
+    return bench.getExitCode();
+    }